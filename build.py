@@ -254,6 +254,8 @@ def core_cmake_args(components, backends, install_dir):
         cmake_enable('http' in FLAGS.endpoint)))
     cargs.append('-DTRITON_ENABLE_SAGEMAKER:BOOL={}'.format(
         cmake_enable('sagemaker' in FLAGS.endpoint)))
+    cargs.append('-DTRITON_ENABLE_SHM_RING:BOOL={}'.format(
+        cmake_enable('shm_ring' in FLAGS.endpoint)))
 
     cargs.append('-DTRITON_ENABLE_GCS:BOOL={}'.format(
         cmake_enable('gcs' in FLAGS.filesystem)))
@@ -560,6 +562,7 @@ RUN apt-get update && \
             libboost-dev \
             libcurl4-openssl-dev \
             libb64-dev \
+            liblz4-dev \
             patchelf \
             python3-dev \
             python3-pip \
@@ -569,6 +572,7 @@ RUN apt-get update && \
             unzip \
             wget \
             zlib1g-dev \
+            libzstd-dev \
             libarchive-dev \
             pkg-config \
             uuid-dev && \
@@ -1200,7 +1204,7 @@ if __name__ == '__main__':
         action='append',
         required=False,
         help=
-        'Include specified endpoint in build. Allowed values are "grpc", "http" and "sagemaker".'
+        'Include specified endpoint in build. Allowed values are "grpc", "http", "sagemaker" and "shm_ring".'
     )
     parser.add_argument(
         '--filesystem',
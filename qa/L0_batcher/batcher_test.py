@@ -1332,5 +1332,42 @@ class BatcherTest(tu.TestResultCollector):
             self.assertTrue(False, "unexpected error {}".format(ex))
 
 
+    def test_multi_batch_shape_buckets(self):
+        # Send requests of two different shapes, interleaved, to a
+        # model that batches requests in per-shape buckets. Use
+        # TRITONSERVER_DELAY_SCHEDULER in the environment so that
+        # requests can be queued up before scheduler starts
+        # servicing. Without buckets the shape changes with every
+        # request and each request is executed alone, with buckets the
+        # requests of each shape are batched at the preferred size.
+        for trial in _trials:
+            try:
+                model_name = tu.get_model_name(trial, np.float32, np.float32,
+                                               np.float32)
+
+                self.check_setup(model_name)
+
+                # Need scheduler to wait for queue to contain 8 requests
+                self.assertTrue("TRITONSERVER_DELAY_SCHEDULER" in os.environ)
+                self.assertEqual(
+                    int(os.environ["TRITONSERVER_DELAY_SCHEDULER"]), 8)
+
+                threads = []
+                for i in range(8):
+                    threads.append(
+                        threading.Thread(
+                            target=self.check_response,
+                            args=(trial, 1, (3000, None)),
+                            kwargs={'input_size': 16 if (i % 2) == 0 else 8}))
+                for t in threads:
+                    t.start()
+                for t in threads:
+                    t.join()
+                self.check_deferred_exception()
+                self.check_status(model_name, {2: 4}, 8, 8)
+            except Exception as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+
 if __name__ == '__main__':
     unittest.main()
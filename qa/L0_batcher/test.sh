@@ -191,6 +191,25 @@ if [[ $BACKENDS == *"onnx"* ]]; then
                     dynamic_batching { preferred_batch_size: [ 2, 6 ], max_queue_delay_microseconds: 10000000 }" >> config.pbtxt)
 fi
 
+# Setup shape-bucketing model repository from the variable-size
+# models. Also setup a repository that pads the variable dimension to
+# a bucket length, which the variable-size models don't support
+# because their outputs are variable-size.
+rm -fr bucket_models && mkdir bucket_models
+rm -fr bucket_pad_models && mkdir bucket_pad_models
+for BACKEND in $BACKENDS; do
+    cp -r var_models/${BACKEND}_float32_float32_float32 bucket_models/. &&
+        (cd bucket_models/${BACKEND}_float32_float32_float32 && \
+            echo "parameters [" >> config.pbtxt && \
+            echo "{ key: \"shape_bucketing\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+            echo "]" >> config.pbtxt)
+    cp -r var_models/${BACKEND}_float32_float32_float32 bucket_pad_models/. &&
+        (cd bucket_pad_models/${BACKEND}_float32_float32_float32 && \
+            echo "parameters [" >> config.pbtxt && \
+            echo "{ key: \"shape_bucket_lengths\"; value: { string_value: \"8,16\" }}" >> config.pbtxt && \
+            echo "]" >> config.pbtxt)
+done
+
 # Need to launch the server for each test so that the model status is
 # reset (which is used to make sure the correctly batch size was used
 # for execution). Test everything with fixed-tensor-size models and
@@ -423,6 +442,84 @@ for i in \
     set -e
 done
 
+# Tests that run on the shape-bucketing models and that require
+# TRITONSERVER_DELAY_SCHEDULER so that the scheduler is delayed and
+# requests can collect in the queue.
+export BATCHER_TYPE=VARIABLE
+for i in \
+        test_multi_batch_shape_buckets ; do
+    export TRITONSERVER_DELAY_SCHEDULER=8
+    SERVER_ARGS="--model-repository=$MODELDIR/bucket_models ${SERVER_ARGS_EXTRA}"
+    SERVER_LOG="./$i.BUCKET.serverlog"
+
+    if [ "$TEST_VALGRIND" -eq 1 ]; then
+        LEAKCHECK_LOG="./$i.BUCKET.valgrind.log"
+        LEAKCHECK_ARGS="$LEAKCHECK_ARGS_BASE --log-file=$LEAKCHECK_LOG"
+        run_server_leakcheck
+    elif [[ "$(< /proc/sys/kernel/osrelease)" == *Microsoft ]]; then
+        # We rely on HTTP endpoint in run_server so until HTTP is
+        # implemented for win we do this hack...
+        run_server_nowait
+        sleep 60
+    else
+        run_server
+    fi
+
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    echo "Test: $i" >>$CLIENT_LOG
+
+    set +e
+    python3 $BATCHER_TEST BatcherTest.$i >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    else
+        check_test_results $TEST_RESULT_FILE 1
+        if [ $? -ne 0 ]; then
+            cat $CLIENT_LOG
+            echo -e "\n***\n*** Test Result Verification Failed\n***"
+            RET=1
+        fi
+    fi
+    set -e
+
+    unset TRITONSERVER_DELAY_SCHEDULER
+    kill_server
+
+    set +e
+    if [ "$TEST_VALGRIND" -eq 1 ]; then
+        python3 ../common/check_valgrind_log.py -f $LEAKCHECK_LOG
+        if [ $? -ne 0 ]; then
+            RET=1
+        fi
+    fi
+    set -e
+done
+
+# Padding the variable-size models to bucket lengths must fail to
+# load since the outputs would have the padded shape.
+SERVER_ARGS="--model-repository=$MODELDIR/bucket_pad_models ${SERVER_ARGS_EXTRA}"
+SERVER_LOG="./bucket_pad.serverlog"
+run_server
+if [ "$SERVER_PID" != "0" ]; then
+    echo -e "\n***\n*** Unexpected success loading bucket_pad_models\n***"
+    kill_server
+    RET=1
+fi
+
+set +e
+if [ `grep -c "'shape_bucket_lengths' is not supported" $SERVER_LOG` == "0" ]; then
+    echo -e "\n***\n*** Failed. Expected shape_bucket_lengths load error\n***"
+    cat $SERVER_LOG
+    RET=1
+fi
+set -e
+
 # Test that verify the 'preserve_ordering' option in dynamic batcher
 # Run the test scheme with and without preserve ordering, verify behavior
 # by comparing the "response send" timestamps.
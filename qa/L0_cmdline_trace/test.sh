@@ -28,6 +28,7 @@
 SIMPLE_HTTP_CLIENT=../clients/simple_http_infer_client
 SIMPLE_GRPC_CLIENT=../clients/simple_grpc_infer_client
 TRACE_SUMMARY=../common/trace_summary.py
+TRACE_CONVERT=/opt/tritonserver/bin/trace_convert
 
 REPO_VERSION=${NVIDIA_TRITON_SERVER_VERSION}
 if [ "$#" -ge 1 ]; then
@@ -148,6 +149,68 @@ fi
 
 set -e
 
+# trace-format=binary, the converted trace must hold every request
+SERVER_ARGS="--trace-file=trace_binary.bin --trace-format=binary \
+             --trace-level=MIN --trace-rate=1 --model-repository=$MODELSDIR"
+SERVER_LOG="./inference_server_binary.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+set +e
+
+for p in {1..10}; do
+    $SIMPLE_HTTP_CLIENT >> client_binary.log 2>&1
+    if [ $? -ne 0 ]; then
+        RET=1
+    fi
+
+    $SIMPLE_GRPC_CLIENT >> client_binary.log 2>&1
+    if [ $? -ne 0 ]; then
+        RET=1
+    fi
+done
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+set +e
+
+$TRACE_CONVERT trace_binary.bin trace_binary.log > convert_binary.log 2>&1
+if [ $? -ne 0 ]; then
+    cat convert_binary.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+# No record may be dropped at this request rate
+if [ `grep -c "dropped" convert_binary.log` != "0" ]; then
+    cat convert_binary.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+$TRACE_SUMMARY -t trace_binary.log > summary_binary.log
+
+if [ `grep -c "COMPUTE_INPUT_END" summary_binary.log` != "20" ]; then
+    cat summary_binary.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+if [ `grep -c ^simple summary_binary.log` != "20" ]; then
+    cat summary_binary.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+set -e
+
 # trace-rate == 6, trace-level=MIN
 SERVER_ARGS="--http-thread-count=1 --trace-file=trace_6.log \
              --trace-level=MIN --trace-rate=6 --model-repository=$MODELSDIR"
@@ -0,0 +1,78 @@
+#!/bin/bash
+# Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+REQUEST_BENCHMARK=/opt/tritonserver/bin/request_benchmark
+CLIENT_LOG="./client.log"
+
+# Must explicitly set LD_LIBRARY_PATH so that request_benchmark can
+# find libtritonserver.so.
+LD_LIBRARY_PATH=/opt/tritonserver/lib:$LD_LIBRARY_PATH
+
+rm -f *.log
+
+# A model without dynamic batching with 4 instances that each take 1
+# second to execute a request.
+rm -fr models && mkdir -p models/custom_identity_int32/1 && \
+    cp ../L0_client_timeout/models/custom_identity_int32/config.pbtxt \
+        models/custom_identity_int32/. && \
+    (cd models/custom_identity_int32 && \
+        sed -i "s/max_batch_size:.*/max_batch_size: 8/" config.pbtxt && \
+        sed -i "s/^instance_group.*/instance_group [ { kind: KIND_CPU count: 4 } ]/" config.pbtxt && \
+        sed -i "s/string_value: \"3000\"/string_value: \"1000\"/" config.pbtxt)
+
+RET=0
+
+set +e
+
+# A group of 4 requests submitted together must be executed by the 4
+# instances at the same time, it takes at least 4 seconds if the
+# requests are executed one at a time.
+$REQUEST_BENCHMARK -r `pwd`/models -m custom_identity_int32 \
+    -p "submit multiple" -n 4 -b 4 >$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    DURATION=`grep "^submit multiple:" $CLIENT_LOG | awk '{print $6}'`
+    if [ -z "$DURATION" ] || \
+            [ `awk -v d=$DURATION 'BEGIN {print (d >= 2.5)}'` -eq 1 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Failed: group took $DURATION sec, expected the requests to execute concurrently\n***"
+        RET=1
+    fi
+fi
+
+set -e
+
+if [ $RET -eq 0 ]; then
+    echo -e "\n***\n*** Test Passed\n***"
+else
+    echo -e "\n***\n*** Test FAILED\n***"
+fi
+
+exit $RET
@@ -1875,6 +1875,116 @@ class LifeCycleTest(tu.TestResultCollector):
             self.assertTrue(False, "unexpected error {}".format(ex))
         self._infer_success_identity(model_base, (1,), np.int32, model_shape)
 
+    def test_model_load_on_demand(self):
+        model_shape = (1, 16)
+        onnx_name = tu.get_model_name('onnx', np.float32, np.float32,
+                                      np.float32)
+        plan_name = tu.get_model_name('plan', np.float32, np.float32,
+                                      np.float32)
+
+        # Make sure no models are loaded
+        try:
+            triton_client = httpclient.InferenceServerClient("localhost:8000",
+                                                             verbose=True)
+            self.assertTrue(triton_client.is_server_live())
+            self.assertTrue(triton_client.is_server_ready())
+            self.assertFalse(triton_client.is_model_ready(onnx_name, "1"))
+            self.assertFalse(triton_client.is_model_ready(plan_name, "1"))
+        except Exception as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
+        # An inference request loads the model. Only one model may be
+        # resident so each load evicts the other model.
+        load_sequence = (("onnx", onnx_name, plan_name),
+                         ("plan", plan_name, onnx_name),
+                         ("onnx", onnx_name, plan_name))
+        for model_base, model_name, evicted_name in load_sequence:
+            try:
+                iu.infer_exact(self,
+                               model_base,
+                               model_shape,
+                               1,
+                               np.float32,
+                               np.float32,
+                               np.float32,
+                               model_version=1)
+                triton_client = httpclient.InferenceServerClient(
+                    "localhost:8000", verbose=True)
+                self.assertTrue(triton_client.is_model_ready(model_name, "1"))
+                self.assertFalse(
+                    triton_client.is_model_ready(evicted_name, "1"))
+            except Exception as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+        # A readiness request does not load the model
+        try:
+            triton_client = grpcclient.InferenceServerClient("localhost:8001",
+                                                             verbose=True)
+            self.assertFalse(triton_client.is_model_ready(plan_name, "1"))
+            self.assertTrue(triton_client.is_model_ready(onnx_name, "1"))
+        except Exception as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
+    def test_model_load_on_demand_nonblocking(self):
+        model_shape = (1, 16)
+        onnx_name = tu.get_model_name('onnx', np.float32, np.float32,
+                                      np.float32)
+        slow_name = "identity_zero_1_int32"
+
+        # Check whether or not to use grpc protocol
+        use_grpc = "TRITONSERVER_USE_GRPC" in os.environ
+
+        try:
+            triton_client = self._get_client(use_grpc)
+            self.assertTrue(triton_client.is_model_ready(onnx_name, "1"))
+            self.assertFalse(triton_client.is_model_ready(slow_name, "1"))
+        except Exception as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
+        # The inference request for the slow model loads it on demand,
+        # which takes longer than the model creation delay.
+        def slow_infer():
+            iu.infer_zero(self,
+                          "identity",
+                          1,
+                          np.int32, (16,), (16,),
+                          use_http=not use_grpc,
+                          use_grpc=use_grpc,
+                          use_http_json_tensors=False,
+                          use_streaming=False)
+
+        thread = threading.Thread(target=slow_infer)
+        thread.start()
+        # wait for time < model creation delay to ensure the load started
+        time.sleep(3)
+
+        # A request for a loaded model is not delayed by the load, even
+        # though the server has a single HTTP thread.
+        infer_start = time.time()
+        iu.infer_exact(self,
+                       'onnx',
+                       model_shape,
+                       1,
+                       np.float32,
+                       np.float32,
+                       np.float32,
+                       model_version=1,
+                       use_http=not use_grpc,
+                       use_grpc=use_grpc,
+                       use_http_json_tensors=False,
+                       use_streaming=False)
+        infer_end = time.time()
+        self.assertTrue((infer_end - infer_start) < 5,
+                        "server was waiting unexpectly, waited {}".format(
+                            (infer_end - infer_start)))
+
+        thread.join()
+        try:
+            triton_client = self._get_client(use_grpc)
+            self.assertTrue(triton_client.is_model_ready(slow_name, "1"))
+        except Exception as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
     def test_multiple_model_repository_control_startup_models(self):
         model_shape = (1, 16)
         onnx_name = tu.get_model_name('onnx', np.float32, np.float32,
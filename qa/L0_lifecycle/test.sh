@@ -1176,6 +1176,99 @@ wait $SERVER_PID
 
 LOG_IDX=$((LOG_IDX+1))
 
+# LifeCycleTest.test_model_load_on_demand
+rm -fr models config.pbtxt.*
+mkdir models
+for i in onnx plan ; do
+    cp -r $DATADIR/qa_model_repository/${i}_float32_float32_float32 models/.
+    sed -i "s/max_batch_size:.*/max_batch_size: 1/" models/${i}_float32_float32_float32/config.pbtxt
+done
+
+SERVER_ARGS="--model-repository=`pwd`/models --model-control-mode=explicit \
+             --model-load-on-demand=true --model-residency-max-models=1 \
+             --exit-timeout-secs=5 --strict-model-config=false \
+             --strict-readiness=false"
+SERVER_LOG="./inference_server_$LOG_IDX.log"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+set +e
+python $LC_TEST LifeCycleTest.test_model_load_on_demand >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+if [ `grep -c "evicting model 'plan_float32_float32_float32'" $SERVER_LOG` != "1" ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Failed. Expected plan model to be evicted once\n***"
+    RET=1
+fi
+
+LOG_IDX=$((LOG_IDX+1))
+
+# LifeCycleTest.test_model_load_on_demand_nonblocking
+for protocol in grpc http; do
+    if [[ $protocol == "grpc" ]]; then
+       export TRITONSERVER_USE_GRPC=1
+    fi
+    rm -fr models config.pbtxt.*
+    mkdir models
+    cp -r identity_zero_1_int32 models/. && mkdir -p models/identity_zero_1_int32/1
+    cp -r $DATADIR/qa_model_repository/onnx_float32_float32_float32 models/.
+    sed -i "s/max_batch_size:.*/max_batch_size: 1/" models/onnx_float32_float32_float32/config.pbtxt
+
+    SERVER_ARGS="--model-repository=`pwd`/models --model-control-mode=explicit \
+                 --model-load-on-demand=true --http-thread-count=1 \
+                 --load-model=onnx_float32_float32_float32 \
+                 --exit-timeout-secs=5 --strict-model-config=false \
+                 --strict-readiness=false"
+    SERVER_LOG="./inference_server_$LOG_IDX.log"
+    run_server
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    set +e
+    python $LC_TEST LifeCycleTest.test_model_load_on_demand_nonblocking >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    else
+        check_test_results $TEST_RESULT_FILE 1
+        if [ $? -ne 0 ]; then
+            cat $CLIENT_LOG
+            echo -e "\n***\n*** Test Result Verification Failed\n***"
+            RET=1
+        fi
+    fi
+    set -e
+
+    kill $SERVER_PID
+    wait $SERVER_PID
+
+    unset TRITONSERVER_USE_GRPC
+
+    LOG_IDX=$((LOG_IDX+1))
+done
+
 # LifeCycleTest.test_load_same_model_different_platform
 for protocol in grpc http; do
     if [[ $protocol == "grpc" ]]; then
@@ -28,10 +28,13 @@ import sys
 sys.path.append("../common")
 
 from builtins import range
+import json
+import socket
 import time
 import threading
 import unittest
 import numpy as np
+import requests as httpreq
 import infer_util as iu
 import test_util as tu
 from tritonclientutils import InferenceServerException
@@ -469,5 +472,413 @@ class ModelQueueTest(tu.TestResultCollector):
                 self.assertTrue(False, "unexpected error {}".format(ex))
 
 
+    def test_edf_ordering(self):
+        # Send a request with a preferred batch size that executes
+        # immediately. While it executes send two requests that can't
+        # be batched together, the second one with a shorter timeout.
+        # Expect the requests to be executed in order of their
+        # timeout, so the second request is executed first.
+        dtype = np.float32
+        shapes = ([16],)
+        for trial in self.trials_:
+            if trial["base"] != "custom":
+                continue
+            threads = []
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(8, dtype, shapes, 0, 0, (1999, 1000)),
+                                 kwargs=trial))
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(20, dtype, shapes, 0, 0, (3800, 2000)),
+                                 kwargs=trial))
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(20, dtype, shapes, 0, 3000000,
+                                       (2500, 1000)),
+                                 kwargs=trial))
+            for t in threads:
+                t.start()
+                time.sleep(0.2)
+
+            for t in threads:
+                t.join()
+
+            try:
+                self.check_deferred_exception()
+            except InferenceServerException as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+    def test_edf_predictive_reject(self):
+        # Send a request to measure the execution time of the model.
+        # Then send a request that executes immediately and, while it
+        # executes, a request whose timeout expires before the model
+        # could execute it after the first request. Expect that request
+        # to be rejected as soon as the model is available, before its
+        # timeout, and a request with the default timeout to succeed.
+        dtype = np.float32
+        shapes = ([16],)
+        for trial in self.trials_:
+            if trial["base"] != "custom":
+                continue
+            self.check_response(8, dtype, shapes, 0, 0, (1999, 1000), **trial)
+            self.check_deferred_exception()
+
+            preceding_thread = threading.Thread(
+                target=self.check_response,
+                args=(8, dtype, shapes, 0, 0, (1999, 1000)),
+                kwargs=trial)
+            reject_thread = threading.Thread(
+                target=self.check_response,
+                args=(1, dtype, shapes, 0, 1500000, (None, None)),
+                kwargs=trial)
+            default_thread = threading.Thread(
+                target=self.check_response,
+                args=(1, dtype, shapes, 0, 0, (2500, 1000)),
+                kwargs=trial)
+            preceding_thread.start()
+            time.sleep(0.2)
+            start_ms = int(round(time.time() * 1000))
+            reject_thread.start()
+            default_thread.start()
+            reject_thread.join()
+            end_ms = int(round(time.time() * 1000))
+            preceding_thread.join()
+            default_thread.join()
+
+            self.assertTrue((end_ms - start_ms) < 1500,
+                            "expected rejection before the timeout, got " +
+                            str(end_ms - start_ms) + " ms")
+
+            # Expect only one error for rejection
+            try:
+                self.check_deferred_exception()
+            except InferenceServerException as ex:
+                self.assertTrue(
+                    "Request timeout expired" in ex.message(),
+                    "Expected error message \"Request timeout expired\", got: {}"
+                    .format(ex))
+
+            try:
+                self.check_deferred_exception()
+            except InferenceServerException as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+    def get_shed_count(self, model_name):
+        metrics = httpreq.get('http://localhost:8002/metrics')
+        shed_str = 'nv_inference_request_shed{model="' + model_name + \
+            '",version="1"}'
+        for line in metrics.text.splitlines():
+            if line.startswith(shed_str):
+                return float(line[len(shed_str):])
+        return None
+
+    def test_queue_latency_slo(self):
+        # Send a request to measure the execution time per inference of
+        # the model. Then send a request that executes immediately and,
+        # while it executes, two requests that are queued behind it, so
+        # that the predicted queue delay exceeds the SLO. Expect the
+        # next request to be rejected immediately and the shed count
+        # to be reported.
+        dtype = np.float32
+        shapes = ([16],)
+        shed_count = 0
+        for trial in self.trials_:
+            if trial["base"] != "custom":
+                continue
+            self.check_response(8, dtype, shapes, 0, 0, (1999, 1000), **trial)
+            self.check_deferred_exception()
+
+            threads = []
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(8, dtype, shapes, 0, 0, (1999, 1000)),
+                                 kwargs=trial))
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(8, dtype, shapes, 0, 0, (2999, 1000)),
+                                 kwargs=trial))
+            threads.append(
+                threading.Thread(target=self.check_response,
+                                 args=(8, dtype, shapes, 0, 0, (3999, 2000)),
+                                 kwargs=trial))
+            for t in threads:
+                t.start()
+                time.sleep(0.2)
+
+            start_ms = int(round(time.time() * 1000))
+            self.check_response(1, dtype, shapes, 0, 0, (None, None), **trial)
+            end_ms = int(round(time.time() * 1000))
+            for t in threads:
+                t.join()
+
+            self.assertTrue((end_ms - start_ms) < 500,
+                            "expected immediate rejection, got " +
+                            str(end_ms - start_ms) + " ms")
+
+            # Expect only one error for rejection
+            try:
+                self.check_deferred_exception()
+                self.assertTrue(False, "expected rejection")
+            except InferenceServerException as ex:
+                self.assertTrue(
+                    "exceeds the queue latency SLO" in ex.message(),
+                    "Expected error message \"exceeds the queue latency SLO\", got: {}"
+                    .format(ex))
+
+            try:
+                self.check_deferred_exception()
+            except InferenceServerException as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+            shed_count += 1
+            self.assertEqual(self.get_shed_count("custom_zero_1_float32"),
+                             shed_count)
+
+    def get_execution_count(self, model_name):
+        stats = httpreq.get('http://localhost:8000/v2/models/' + model_name +
+                            '/stats').json()
+        return stats["model_stats"][0]["execution_count"]
+
+    def test_client_disconnect(self):
+        # Send a request that executes immediately and, while it
+        # executes, a request that is queued behind it from a client
+        # that disconnects before the response is sent. Expect the
+        # queued request to be cancelled instead of executed, so the
+        # model executes only once.
+        dtype = np.float32
+        shapes = ([16],)
+        model_name = "custom_zero_1_float32"
+        execution_count = self.get_execution_count(model_name)
+
+        thread = threading.Thread(target=self.check_response,
+                                  args=(8, dtype, shapes, 0, 0, (1999, 1000)),
+                                  kwargs={
+                                      "base": "custom",
+                                      "is_http_trial": True
+                                  })
+        thread.start()
+        time.sleep(0.2)
+
+        body = {
+            "inputs": [{
+                "name": "INPUT0",
+                "datatype": "FP32",
+                "shape": [1, 16],
+                "data": [0.0] * 16
+            }]
+        }
+        try:
+            httpreq.post('http://localhost:8000/v2/models/' + model_name +
+                         '/infer',
+                         json=body,
+                         timeout=0.3)
+            self.assertTrue(False, "expected the request to time out")
+        except httpreq.exceptions.Timeout:
+            pass
+
+        thread.join()
+        self.check_deferred_exception()
+
+        # Give the scheduler time to execute the queued request if it
+        # wasn't cancelled.
+        time.sleep(2)
+        self.assertEqual(self.get_execution_count(model_name),
+                         execution_count + 1)
+
+    def test_bucket_max_queue_size(self):
+        # Send 3 requests that wait in the same shape bucket for the
+        # maximum queue delay. Expect the requests in the bucket to
+        # count toward the maximum queue size of 2, so the third
+        # request is rejected.
+        dtype = np.float32
+        shapes = ([16],)
+        for trial in self.trials_:
+            if trial["base"] != "custom":
+                continue
+            threads = []
+            for i in range(3):
+                threads.append(
+                    threading.Thread(target=self.check_response,
+                                     args=(1, dtype, shapes, 0, 0, (None,
+                                                                    None)),
+                                     kwargs=trial))
+            for t in threads:
+                t.start()
+                time.sleep(0.1)
+
+            for t in threads:
+                t.join()
+
+            # Expect only one error for exceeding the max queue size
+            try:
+                self.check_deferred_exception()
+                self.assertTrue(False, "expected a rejected request")
+            except InferenceServerException as ex:
+                self.assertTrue(
+                    "Exceeds maximum queue size" in ex.message(),
+                    "Expected error message \"Exceeds maximum queue size\", got: {}"
+                    .format(ex))
+
+            try:
+                self.check_deferred_exception()
+            except InferenceServerException as ex:
+                self.assertTrue(False, "unexpected error {}".format(ex))
+
+    def test_client_half_close(self):
+        # Same as test_client_disconnect but the client only shuts down
+        # the sending side of its connection and waits for the
+        # response. A half-close can't be told apart from a close, so
+        # expect the queued request to be cancelled and the client to
+        # receive the cancellation error.
+        dtype = np.float32
+        shapes = ([16],)
+        model_name = "custom_zero_1_float32"
+        execution_count = self.get_execution_count(model_name)
+
+        thread = threading.Thread(target=self.check_response,
+                                  args=(8, dtype, shapes, 0, 0, (1999, 1000)),
+                                  kwargs={
+                                      "base": "custom",
+                                      "is_http_trial": True
+                                  })
+        thread.start()
+        time.sleep(0.2)
+
+        body = json.dumps({
+            "inputs": [{
+                "name": "INPUT0",
+                "datatype": "FP32",
+                "shape": [1, 16],
+                "data": [0.0] * 16
+            }]
+        })
+        request = ("POST /v2/models/" + model_name + "/infer HTTP/1.1\r\n"
+                   "Host: localhost:8000\r\n"
+                   "Content-Type: application/json\r\n"
+                   "Content-Length: " + str(len(body)) + "\r\n"
+                   "\r\n" + body)
+        sock = socket.create_connection(("localhost", 8000))
+        try:
+            sock.sendall(request.encode())
+            time.sleep(0.1)
+            sock.shutdown(socket.SHUT_WR)
+            response = b""
+            while True:
+                data = sock.recv(4096)
+                if not data:
+                    break
+                response += data
+        finally:
+            sock.close()
+        self.assertTrue(response.startswith(b"HTTP/1.1 400"),
+                        "unexpected response {}".format(response))
+        self.assertIn(b"Request was cancelled", response)
+
+        thread.join()
+        self.check_deferred_exception()
+
+        time.sleep(2)
+        self.assertEqual(self.get_execution_count(model_name),
+                         execution_count + 1)
+
+    def test_bucket_client_disconnect(self):
+        # Send a request that waits in a shape bucket for the maximum
+        # queue delay from a client that disconnects before the delay
+        # is exceeded. Expect the request to be cancelled instead of
+        # executed.
+        model_name = "custom_zero_1_float32"
+        execution_count = self.get_execution_count(model_name)
+
+        body = {
+            "inputs": [{
+                "name": "INPUT0",
+                "datatype": "FP32",
+                "shape": [1, 16],
+                "data": [0.0] * 16
+            }]
+        }
+        try:
+            httpreq.post('http://localhost:8000/v2/models/' + model_name +
+                         '/infer',
+                         json=body,
+                         timeout=0.3)
+            self.assertTrue(False, "expected the request to time out")
+        except httpreq.exceptions.Timeout:
+            pass
+
+        # Give the scheduler time to execute the bucketed request if it
+        # wasn't cancelled.
+        time.sleep(3)
+        self.assertEqual(self.get_execution_count(model_name),
+                         execution_count)
+
+    def test_bucket_starvation(self):
+        # Keep requests of shape [16] pending, which always form the
+        # largest batch, and send one request of shape [8]. Without a
+        # maximum queue delay expect the bucket with the oldest request
+        # to be executed first, so the request of shape [8] completes
+        # within a few executions instead of after the requests of
+        # shape [16] stop.
+        dtype = np.float32
+        deadline = time.time() + 6
+
+        def send_requests():
+            while time.time() < deadline:
+                self.check_response(2, dtype, ([16],), 0, 0, (None, None),
+                                    base="custom",
+                                    is_http_trial=True)
+
+        threads = []
+        for _ in range(4):
+            threads.append(threading.Thread(target=send_requests))
+        for t in threads:
+            t.start()
+
+        time.sleep(0.5)
+        self.check_response(1, dtype, ([8],), 0, 0, (3500, None),
+                            base="custom",
+                            is_http_trial=True)
+
+        for t in threads:
+            t.join()
+        self.check_deferred_exception()
+
+    def test_instance_autoscale(self):
+        # Keep more requests queued than the single instance of the
+        # model can execute, so that the autoscaler adds instances.
+        # Then stop sending requests so that the autoscaler removes
+        # the added instances. The server log is checked for the
+        # changes of the instance count.
+        dtype = np.float32
+        shapes = ([16],)
+        model_name = "custom_zero_1_float32"
+        execution_count = self.get_execution_count(model_name)
+
+        deadline = time.time() + 5
+
+        def send_requests():
+            while time.time() < deadline:
+                self.check_response(8, dtype, shapes, 0, 0, (None, None),
+                                    base="custom",
+                                    is_http_trial=True)
+
+        threads = []
+        for _ in range(8):
+            threads.append(threading.Thread(target=send_requests))
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.check_deferred_exception()
+        self.assertTrue(self.get_execution_count(model_name) > execution_count)
+
+        # Give the autoscaler time to remove the idle instances.
+        time.sleep(5)
+        self.check_response(8, dtype, shapes, 0, 0, (None, None),
+                            base="custom",
+                            is_http_trial=True)
+        self.check_deferred_exception()
+
 if __name__ == '__main__':
     unittest.main()
@@ -337,6 +337,361 @@ set -e
 kill $SERVER_PID
 wait $SERVER_PID
 
+# test_edf_ordering and test_edf_predictive_reject
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "    default_queue_policy {" >> config.pbtxt && \
+        echo "        allow_timeout_override: true" >> config.pbtxt && \
+        echo "        default_timeout_microseconds: 10000000" >> config.pbtxt && \
+        echo "    }" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"1000\" }}," >> config.pbtxt && \
+        echo "{ key: \"earliest_deadline_first\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+for TEST_CASE in test_edf_ordering test_edf_predictive_reject; do
+    SERVER_LOG="./$TEST_CASE.serverlog"
+    run_server
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+    set +e
+    python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    else
+        check_test_results $TEST_RESULT_FILE 1
+        if [ $? -ne 0 ]; then
+            cat $CLIENT_LOG
+            echo -e "\n***\n*** Test Result Verification Failed\n***"
+            RET=1
+        fi
+    fi
+    set -e
+
+    kill $SERVER_PID
+    wait $SERVER_PID
+done
+
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"1000\" }}," >> config.pbtxt && \
+        echo "{ key: \"queue_latency_slo_microseconds\"; value: { string_value: \"1500000\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_queue_latency_slo
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# test_client_disconnect, test_client_half_close
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"1000\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+for TEST_CASE in test_client_disconnect test_client_half_close; do
+    SERVER_LOG="./$TEST_CASE.serverlog"
+    run_server
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+    set +e
+    python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    else
+        check_test_results $TEST_RESULT_FILE 1
+        if [ $? -ne 0 ]; then
+            cat $CLIENT_LOG
+            echo -e "\n***\n*** Test Result Verification Failed\n***"
+            RET=1
+        fi
+    fi
+    set -e
+
+    kill $SERVER_PID
+    wait $SERVER_PID
+done
+
+# test_policy_reject with shape bucketing, the timed-out request
+# must be rejected while it waits in its bucket
+rm -fr models && mkdir models && \
+    cp -r ensemble_zero_1_float32 models/. && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "    max_queue_delay_microseconds: 10000000" >> config.pbtxt && \
+        echo "    default_queue_policy {" >> config.pbtxt && \
+        echo "        default_timeout_microseconds: 100000" >> config.pbtxt && \
+        echo "    }" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"shape_bucketing\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_policy_reject
+SERVER_LOG="./${TEST_CASE}_bucketing.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# test_bucket_max_queue_size
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 8 ]" >> config.pbtxt && \
+        echo "    max_queue_delay_microseconds: 2000000" >> config.pbtxt && \
+        echo "    default_queue_policy {" >> config.pbtxt && \
+        echo "        max_queue_size: 2" >> config.pbtxt && \
+        echo "    }" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"shape_bucketing\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_bucket_max_queue_size
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# test_bucket_client_disconnect
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 8 ]" >> config.pbtxt && \
+        echo "    max_queue_delay_microseconds: 2000000" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"shape_bucketing\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_bucket_client_disconnect
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# test_bucket_starvation
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"1000\" }}," >> config.pbtxt && \
+        echo "{ key: \"shape_bucketing\"; value: { string_value: \"true\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_bucket_starvation
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+# test_instance_autoscale
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"300\" }}," >> config.pbtxt && \
+        echo "{ key: \"instance_autoscale\"; value: { string_value: \"true\" }}," >> config.pbtxt && \
+        echo "{ key: \"instance_autoscale_interval_ms\"; value: { string_value: \"200\" }}," >> config.pbtxt && \
+        echo "{ key: \"instance_count_max\"; value: { string_value: \"3\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_instance_autoscale
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+else
+    check_test_results $TEST_RESULT_FILE 1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Result Verification Failed\n***"
+        RET=1
+    fi
+fi
+
+grep "added instance custom_zero_1_float32_0_1 to model 'custom_zero_1_float32'" $SERVER_LOG
+if [ $? -ne 0 ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Failed. Expected an instance to be added\n***"
+    RET=1
+fi
+grep "removed instance custom_zero_1_float32_0_1 from model 'custom_zero_1_float32', 1 instances" $SERVER_LOG
+if [ $? -ne 0 ]; then
+    cat $SERVER_LOG
+    echo -e "\n***\n*** Failed. Expected the added instances to be removed\n***"
+    RET=1
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
 if [ $RET -eq 0 ]; then
     echo -e "\n***\n*** Test Passed\n***"
 else
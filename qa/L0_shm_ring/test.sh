@@ -0,0 +1,118 @@
+#!/bin/bash
+# Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+REPO_VERSION=${NVIDIA_TRITON_SERVER_VERSION}
+if [ "$#" -ge 1 ]; then
+    REPO_VERSION=$1
+fi
+if [ -z "$REPO_VERSION" ]; then
+    echo -e "Repository version must be specified"
+    echo -e "\n***\n*** Test Failed\n***"
+    exit 1
+fi
+
+DATADIR=/data/inferenceserver/${REPO_VERSION}/qa_model_repository
+
+SHM_RING_BENCHMARK=/opt/tritonserver/bin/shm_ring_benchmark
+PERF_ANALYZER=../clients/perf_analyzer
+REQUEST_COUNT=${REQUEST_COUNT:=20000}
+
+SERVER=/opt/tritonserver/bin/tritonserver
+SERVER_ARGS="--model-repository=`pwd`/models --shm-ring-name=/l0_shm_ring"
+SERVER_LOG="./inference_server.log"
+source ../common/util.sh
+
+export CUDA_VISIBLE_DEVICES=0
+
+rm -f *.log
+rm -fr models && mkdir -p models/simple/1 && \
+    cp -r $DATADIR/graphdef_int32_int32_int32/1/* models/simple/1/. && \
+    cp $DATADIR/graphdef_int32_int32_int32/config.pbtxt models/simple/. && \
+    (cd models/simple && \
+            sed -i "s/^name:.*/name: \"simple\"/" config.pbtxt && \
+            sed -i "s/label_filename:.*//" config.pbtxt)
+
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+RET=0
+
+set +e
+
+# Latency through the shared-memory request ring.
+$SHM_RING_BENCHMARK -s /l0_shm_ring -m simple -n $REQUEST_COUNT >shm_ring.log 2>&1
+if [ $? -ne 0 ]; then
+    cat shm_ring.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+# Two clients sharing the ring.
+$SHM_RING_BENCHMARK -s /l0_shm_ring -m simple -n $REQUEST_COUNT >shm_ring.0.log 2>&1 &
+CLIENT_PID=$!
+$SHM_RING_BENCHMARK -s /l0_shm_ring -m simple -n $REQUEST_COUNT >shm_ring.1.log 2>&1
+if [ $? -ne 0 ]; then
+    cat shm_ring.1.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+wait $CLIENT_PID
+if [ $? -ne 0 ]; then
+    cat shm_ring.0.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+# Latency of the same model through GRPC on localhost, with the
+# tensors in system shared memory as for the ring.
+$PERF_ANALYZER -i grpc -m simple -b 1 --concurrency-range 1 \
+    --shared-memory=system --percentile=99 >grpc.log 2>&1
+if [ $? -ne 0 ]; then
+    cat grpc.log
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+cat shm_ring.log
+grep "Avg latency\|p50 latency\|p90 latency\|p99 latency\|Throughput" grpc.log
+
+if [ $RET -eq 0 ]; then
+    echo -e "\n***\n*** Test Passed\n***"
+else
+    echo -e "\n***\n*** Test Failed\n***"
+fi
+
+exit $RET
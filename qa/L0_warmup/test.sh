@@ -155,6 +155,52 @@ for BACKEND in ${BACKENDS}; do
     kill $SERVER_PID
     wait $SERVER_PID
 
+    # Initialize the instances concurrently, each instance must still
+    # run the shared warmup samples. The plan backend doesn't use the
+    # backend API so its instances are always initialized one at a time.
+    if [ "$BACKEND" != "plan" ]; then
+        (cd models/${BACKEND}_float32_float32_float32 && \
+            echo "instance_group [{ count: 4 }]" >> config.pbtxt)
+
+        SAVED_SERVER_ARGS=$SERVER_ARGS
+        SERVER_ARGS="$SERVER_ARGS --model-instance-init-concurrency=4"
+        run_server
+        SERVER_ARGS=$SAVED_SERVER_ARGS
+        if [ "$SERVER_PID" == "0" ]; then
+            echo -e "\n***\n*** Failed to start $SERVER\n***"
+            cat $SERVER_LOG
+            exit 1
+        fi
+
+        set +e
+
+        grep "initializing 4 instances of ${BACKEND}_float32_float32_float32 with concurrency 4" $SERVER_LOG
+        if [ $? -ne 0 ]; then
+            echo -e "\n***\n*** Failed. Expected concurrent instance initialization\n***"
+            RET=1
+        fi
+        grep "warming up 4 instances of ${BACKEND}_float32_float32_float32 with concurrency 4" $SERVER_LOG
+        if [ $? -ne 0 ]; then
+            echo -e "\n***\n*** Failed. Expected concurrent instance warmup\n***"
+            RET=1
+        fi
+        WARMUP_CNT=`grep -c "is running warmup sample 'regular sample'" $SERVER_LOG`
+        if [ "$WARMUP_CNT" -lt 4 ]; then
+            echo -e "\n***\n*** Failed. Expected warmup for each instance, got $WARMUP_CNT\n***"
+            RET=1
+        fi
+        grep "warmup error" $SERVER_LOG
+        if [ $? -eq 0 ]; then
+            echo -e "\n***\n*** Failed. Expected no warmup error\n***"
+            RET=1
+        fi
+
+        set -e
+
+        kill $SERVER_PID
+        wait $SERVER_PID
+    fi
+
     # Test for variable-size data type (string)
     rm -fr models && mkdir models
     SUPPORT_STRING=0 && ([[ $BACKEND == "savedmodel" ]] || [[ $BACKEND == "onnx" ]] || [[ $BACKEND == "savedmodel" ]]) && SUPPORT_STRING=1
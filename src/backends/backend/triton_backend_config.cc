@@ -26,6 +26,10 @@
 
 #include "src/backends/backend/triton_backend_config.h"
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <thread>
 #include "src/core/logging.h"
 #include "src/core/model_config.h"
 #include "src/core/status.h"
@@ -144,6 +148,247 @@ BackendConfigurationAutoCompleteConfig(
   return Status::Success;
 }
 
+Status
+BackendConfigurationLocalizeCache(
+    const BackendCmdlineConfigMap& config_map, std::string* dir,
+    uint64_t* byte_size)
+{
+  dir->clear();
+  *byte_size = 0;
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  if (!BackendConfiguration(itr->second, "localize-cache-directory", dir)
+           .IsOk()) {
+    return Status::Success;
+  }
+
+  std::string byte_size_str;
+  if (BackendConfiguration(
+          itr->second, "localize-cache-byte-size", &byte_size_str)
+          .IsOk()) {
+    try {
+      *byte_size = std::stoull(byte_size_str);
+    }
+    catch (...) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to parse localize cache byte size '" + byte_size_str + "'");
+    }
+  }
+
+  return Status::Success;
+}
+
+Status
+BackendConfigurationResponseCacheByteSize(
+    const BackendCmdlineConfigMap& config_map, uint64_t* byte_size)
+{
+  *byte_size = 0;
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  std::string byte_size_str;
+  if (BackendConfiguration(
+          itr->second, "response-cache-byte-size", &byte_size_str)
+          .IsOk()) {
+    try {
+      *byte_size = std::stoull(byte_size_str);
+    }
+    catch (...) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to parse response cache byte size '" + byte_size_str + "'");
+    }
+  }
+
+  return Status::Success;
+}
+
+Status
+BackendConfigurationModelInstanceInitConcurrency(
+    const BackendCmdlineConfigMap& config_map, uint32_t* count)
+{
+  *count = 1;
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  std::string count_str;
+  if (BackendConfiguration(
+          itr->second, "model-instance-init-concurrency", &count_str)
+          .IsOk()) {
+    unsigned long parsed_count = 0;
+    try {
+      parsed_count = std::stoul(count_str);
+    }
+    catch (...) {
+      parsed_count = 0;
+    }
+    if ((parsed_count == 0) ||
+        (parsed_count > std::numeric_limits<uint32_t>::max())) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to parse model instance initialization concurrency '" +
+              count_str + "', expected a positive integer");
+    }
+    *count = parsed_count;
+  }
+
+  return Status::Success;
+}
+
+Status
+BackendConfigurationModelResidency(
+    const BackendCmdlineConfigMap& config_map, bool* load_on_demand,
+    uint32_t* max_model_count, uint64_t* host_memory_byte_size,
+    uint64_t* gpu_memory_byte_size)
+{
+  *load_on_demand = false;
+  *max_model_count = 0;
+  *host_memory_byte_size = 0;
+  *gpu_memory_byte_size = 0;
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  std::string value_str;
+  if (BackendConfiguration(itr->second, "model-load-on-demand", &value_str)
+          .IsOk()) {
+    RETURN_IF_ERROR(
+        BackendConfigurationParseStringToBool(value_str, load_on_demand));
+  }
+
+  const std::vector<std::pair<std::string, uint64_t*>> limits{
+      {"model-residency-host-memory-byte-size", host_memory_byte_size},
+      {"model-residency-gpu-memory-byte-size", gpu_memory_byte_size}};
+  for (const auto& limit : limits) {
+    if (BackendConfiguration(itr->second, limit.first, &value_str).IsOk()) {
+      try {
+        *limit.second = std::stoull(value_str);
+      }
+      catch (...) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "unable to parse " + limit.first + " '" + value_str + "'");
+      }
+    }
+  }
+
+  if (BackendConfiguration(
+          itr->second, "model-residency-max-models", &value_str)
+          .IsOk()) {
+    unsigned long parsed_count = 0;
+    try {
+      parsed_count = std::stoul(value_str);
+    }
+    catch (...) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to parse model residency max models '" + value_str + "'");
+    }
+    *max_model_count = std::min(
+        parsed_count,
+        static_cast<unsigned long>(std::numeric_limits<uint32_t>::max()));
+  }
+
+  return Status::Success;
+}
+
+Status
+BackendConfigurationSharedCpuExecutor(
+    const BackendCmdlineConfigMap& config_map, uint32_t* thread_cnt)
+{
+  *thread_cnt = 0;
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  std::string value_str;
+  bool enabled = false;
+  if (BackendConfiguration(itr->second, "shared-cpu-executor", &value_str)
+          .IsOk()) {
+    RETURN_IF_ERROR(BackendConfigurationParseStringToBool(value_str, &enabled));
+  }
+  if (!enabled) {
+    return Status::Success;
+  }
+
+  if (BackendConfiguration(
+          itr->second, "shared-cpu-executor-thread-count", &value_str)
+          .IsOk()) {
+    unsigned long parsed_count = 0;
+    try {
+      parsed_count = std::stoul(value_str);
+    }
+    catch (...) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to parse shared CPU executor thread count '" + value_str +
+              "'");
+    }
+    *thread_cnt = std::min(
+        parsed_count,
+        static_cast<unsigned long>(std::numeric_limits<uint32_t>::max()));
+  }
+
+  // By default the executor has a thread for each CPU core.
+  if (*thread_cnt == 0) {
+    *thread_cnt = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  return Status::Success;
+}
+
+Status
+BackendConfigurationMetricsLatencyBuckets(
+    const BackendCmdlineConfigMap& config_map, bool* specified,
+    std::vector<double>* buckets)
+{
+  *specified = false;
+  buckets->clear();
+
+  const auto& itr = config_map.find(std::string());
+  if (itr == config_map.end()) {
+    return Status::Success;
+  }
+
+  std::string buckets_str;
+  if (!BackendConfiguration(
+           itr->second, "metrics-latency-buckets", &buckets_str)
+           .IsOk()) {
+    return Status::Success;
+  }
+
+  *specified = true;
+  if (buckets_str == "none") {
+    return Status::Success;
+  }
+
+  std::stringstream ss(buckets_str);
+  std::string bucket_str;
+  while (std::getline(ss, bucket_str, ',')) {
+    double bucket;
+    RETURN_IF_ERROR(
+        BackendConfigurationParseStringToDouble(bucket_str, &bucket));
+    buckets->push_back(bucket);
+  }
+
+  return Status::Success;
+}
+
 Status
 BackendConfigurationSpecializeBackendName(
     const BackendCmdlineConfigMap& config_map, const std::string& backend_name,
@@ -25,6 +25,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <vector>
 #include "src/core/model_config.h"
 #include "src/core/status.h"
 
@@ -55,6 +56,50 @@ Status BackendConfigurationMinComputeCapability(
 Status BackendConfigurationAutoCompleteConfig(
     const BackendCmdlineConfigMap& config_map, bool* acc);
 
+/// Get the localize cache directory and byte size from the backend
+/// configuration. 'dir' is returned empty if the localize cache is not
+/// enabled.
+Status BackendConfigurationLocalizeCache(
+    const BackendCmdlineConfigMap& config_map, std::string* dir,
+    uint64_t* byte_size);
+
+/// Get the byte size of the response cache from the backend
+/// configuration. 'byte_size' is returned 0 if the response cache is
+/// not enabled.
+Status BackendConfigurationResponseCacheByteSize(
+    const BackendCmdlineConfigMap& config_map, uint64_t* byte_size);
+
+/// Get the maximum number of instances of a model that are
+/// initialized concurrently from the backend configuration. 'count'
+/// is returned 1 if the configuration does not specify it.
+Status BackendConfigurationModelInstanceInitConcurrency(
+    const BackendCmdlineConfigMap& config_map, uint32_t* count);
+
+/// Get the model residency settings from the backend configuration.
+/// 'load_on_demand' is returned true if models are loaded when they
+/// are requested. The limits on the number of resident models and
+/// on the host and GPU memory they use are returned 0 if not limited.
+Status BackendConfigurationModelResidency(
+    const BackendCmdlineConfigMap& config_map, bool* load_on_demand,
+    uint32_t* max_model_count, uint64_t* host_memory_byte_size,
+    uint64_t* gpu_memory_byte_size);
+
+/// Get the number of threads of the executor shared by the CPU model
+/// instances from the backend configuration. 'thread_cnt' is returned
+/// 0 if the shared CPU executor is not enabled, and is the number of
+/// CPU cores if the configuration enables the executor but does not
+/// specify the number of threads.
+Status BackendConfigurationSharedCpuExecutor(
+    const BackendCmdlineConfigMap& config_map, uint32_t* thread_cnt);
+
+/// Get the latency histogram bucket boundaries, in microseconds,
+/// from the backend configuration. 'specified' is returned false if
+/// the configuration does not specify the buckets. An empty 'buckets'
+/// indicates that latency histograms are disabled.
+Status BackendConfigurationMetricsLatencyBuckets(
+    const BackendCmdlineConfigMap& config_map, bool* specified,
+    std::vector<double>* buckets);
+
 /// Convert a backend name to the specialized version of that name
 /// based on the backend configuration. For example, "tensorflow" will
 /// convert to either "tensorflow1" or "tensorflow2" depending on how
@@ -89,7 +89,8 @@ TritonBackend::TritonBackend(
     const TritonServerMessage& backend_config)
     : name_(name), dir_(dir), libpath_(libpath),
       backend_config_(backend_config),
-      exec_policy_(TRITONBACKEND_EXECUTION_BLOCKING), state_(nullptr),
+      exec_policy_(TRITONBACKEND_EXECUTION_BLOCKING),
+      model_instance_init_serialized_(false), state_(nullptr),
       unload_enabled_(false)
 {
   ClearHandles();
@@ -262,6 +263,15 @@ TRITONBACKEND_BackendSetExecutionPolicy(
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+TRITONBACKEND_BackendSetModelInstanceInitSerialized(
+    TRITONBACKEND_Backend* backend, bool serialized)
+{
+  TritonBackend* tb = reinterpret_cast<TritonBackend*>(backend);
+  tb->SetModelInstanceInitSerialized(serialized);
+  return nullptr;  // success
+}
+
 TRITONSERVER_Error*
 TRITONBACKEND_BackendArtifacts(
     TRITONBACKEND_Backend* backend, TRITONBACKEND_ArtifactType* artifact_type,
@@ -71,6 +71,15 @@ class TritonBackend {
     exec_policy_ = policy;
   }
 
+  bool ModelInstanceInitSerialized() const
+  {
+    return model_instance_init_serialized_;
+  }
+  void SetModelInstanceInitSerialized(const bool serialized)
+  {
+    model_instance_init_serialized_ = serialized;
+  }
+
   void* State() { return state_; }
   void SetState(void* state) { state_ = state; }
 
@@ -132,6 +141,11 @@ class TritonBackend {
   // Execution policy
   TRITONBACKEND_ExecutionPolicy exec_policy_;
 
+  // If true the instances of a model must be initialized one at a
+  // time because the backend's instance initialization is not
+  // thread-safe.
+  bool model_instance_init_serialized_;
+
   // Opaque state associated with the backend.
   void* state_;
 
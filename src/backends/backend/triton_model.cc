@@ -26,6 +26,7 @@
 
 #include "src/backends/backend/triton_model.h"
 
+#include <chrono>
 #include <vector>
 #include "src/backends/backend/triton_backend_config.h"
 #include "src/backends/backend/triton_model_instance.h"
@@ -39,6 +40,60 @@
 
 namespace nvidia { namespace inferenceserver {
 
+namespace {
+
+// Model configuration parameters that set the range of the instance
+// count when it is changed at runtime, and that enable and tune the
+// instance autoscaler.
+constexpr char kInstanceCountMinParameter[] = "instance_count_min";
+constexpr char kInstanceCountMaxParameter[] = "instance_count_max";
+constexpr char kInstanceAutoscaleParameter[] = "instance_autoscale";
+constexpr char kInstanceAutoscaleIntervalParameter[] =
+    "instance_autoscale_interval_ms";
+
+// The autoscaler adds an instance when requests are waiting and the
+// instances were executing for at least 'kScaleUpUtilization' of the
+// last interval. It removes an instance when no requests are waiting
+// and, for 'kScaleDownIntervals' consecutive intervals, the load fits
+// in one instance fewer executing for at most 'kScaleDownUtilization'
+// of the time.
+constexpr double kScaleUpUtilization = 0.8;
+constexpr double kScaleDownUtilization = 0.5;
+constexpr uint32_t kScaleDownIntervals = 5;
+
+Status
+GetPositiveParameter(
+    const inference::ModelConfig& config, const std::string& name,
+    const uint64_t default_value, uint64_t* value)
+{
+  *value = default_value;
+  const auto& itr = config.parameters().find(name);
+  if (itr != config.parameters().end()) {
+    int64_t parsed_value;
+    RETURN_IF_ERROR(ParseLongLongParameter(
+        name, itr->second.string_value(), &parsed_value));
+    if (parsed_value <= 0) {
+      return Status(
+          Status::Code::INVALID_ARG, "'" + name +
+                                         "' must be a positive integer for "
+                                         "model '" +
+                                         config.name() + "'");
+    }
+    *value = parsed_value;
+  }
+  return Status::Success;
+}
+
+uint64_t
+SteadyClockNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
 Status
 TritonModel::Create(
     InferenceServer* server, const std::string& model_repository_path,
@@ -78,6 +133,10 @@ TritonModel::Create(
   RETURN_IF_ERROR(BackendConfigurationMinComputeCapability(
       backend_cmdline_config_map, &min_compute_capability));
 
+  uint32_t instance_init_concurrency = 1;
+  RETURN_IF_ERROR(BackendConfigurationModelInstanceInitConcurrency(
+      backend_cmdline_config_map, &instance_init_concurrency));
+
   std::string specialized_backend_name;
   RETURN_IF_ERROR(BackendConfigurationSpecializeBackendName(
       backend_cmdline_config_map, model_config.backend(),
@@ -169,19 +228,38 @@ TritonModel::Create(
   local_model->initialized_ = true;
 
   // Create and initialize the model instances for this model.
+  std::vector<TritonModelInstance::Setting> settings;
   RETURN_IF_ERROR(TritonModelInstance::CreateInstances(
-      raw_local_model, host_policy_map, model_config));
+      raw_local_model, host_policy_map, model_config,
+      &instance_init_concurrency, &settings));
+  for (const auto& setting : settings) {
+    if (!setting.passive_) {
+      local_model->instance_settings_.push_back(setting);
+    }
+  }
+  RETURN_IF_ERROR(local_model->InitInstanceScaling(model_config));
+  local_model->runner_instances_.reset(
+      new std::atomic<TritonModelInstance*>[local_model->max_instance_cnt_]);
+  for (uint32_t idx = 0; idx < local_model->max_instance_cnt_; ++idx) {
+    local_model->runner_instances_[idx].store(
+        (idx < local_model->instances_.size())
+            ? local_model->instances_[idx].get()
+            : nullptr);
+  }
 
   // Create a scheduler with 1 thread per instance. The backend is
   // already initialized so there is no need to have the scheduler
-  // thread call any initialization.
+  // thread call any initialization. The instances are warmed up with
+  // the same concurrency as they were initialized.
   RETURN_IF_ERROR(local_model->SetConfiguredScheduler(
       local_model->instances_.size() /* runner_cnt */,
+      instance_init_concurrency /* warmup_concurrency */,
       /* Initialization callback */
       [raw_local_model](uint32_t runner_idx) -> Status {
         // Get the device kind and id of the associated instance to
         // set NUMA config for the thread
-        const auto& instance = raw_local_model->instances_[runner_idx];
+        const TritonModelInstance* instance =
+            raw_local_model->RunnerInstance(runner_idx);
         RETURN_IF_ERROR(SetNumaConfigOnThread(instance->HostPolicy()));
         return Status::Success;
       },
@@ -200,7 +278,7 @@ TritonModel::Create(
 
         TRITONBACKEND_ModelInstance* triton_model_instance =
             reinterpret_cast<TRITONBACKEND_ModelInstance*>(
-                raw_local_model->instances_[runner_idx].get());
+                raw_local_model->RunnerInstance(runner_idx));
         TritonBackend::TritonModelInstanceExecFn_t inst_exec_fn =
             backend->ModelInstanceExecFn();
 
@@ -225,6 +303,11 @@ TritonModel::Create(
         return Status::Success;
       }));
 
+  if (local_model->autoscale_) {
+    local_model->autoscaler_thread_.reset(
+        new std::thread([raw_local_model]() { raw_local_model->Autoscale(); }));
+  }
+
   *model = std::move(local_model);
   return Status::Success;
 }
@@ -287,7 +370,7 @@ TritonModel::WarmUp(uint32_t runner_idx, WarmupData& sample)
   }
   TRITONBACKEND_ModelInstance* triton_model_instance =
       reinterpret_cast<TRITONBACKEND_ModelInstance*>(
-          instances_[runner_idx].get());
+          RunnerInstance(runner_idx));
   TritonBackend::TritonModelInstanceExecFn_t inst_exec_fn =
       backend_->ModelInstanceExecFn();
 
@@ -309,6 +392,225 @@ TritonModel::WarmUp(uint32_t runner_idx, WarmupData& sample)
   }
 }
 
+Status
+TritonModel::SetInstanceCount(const uint32_t count)
+{
+  if ((count < min_instance_cnt_) || (count > max_instance_cnt_)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "instance count " + std::to_string(count) + " for model '" + Name() +
+            "' must be in range [" + std::to_string(min_instance_cnt_) +
+            ", " + std::to_string(max_instance_cnt_) + "]");
+  }
+
+  std::lock_guard<std::mutex> lock(scale_mu_);
+  while (instances_.size() < count) {
+    RETURN_IF_ERROR(AddReplica());
+  }
+  while (instances_.size() > count) {
+    RETURN_IF_ERROR(RetireInstance(false /* autoscaler */));
+  }
+
+  return Status::Success;
+}
+
+Status
+TritonModel::InitInstanceScaling(const inference::ModelConfig& config)
+{
+  const auto& params = config.parameters();
+  const bool scaling_configured =
+      (params.find(kInstanceCountMinParameter) != params.end()) ||
+      (params.find(kInstanceCountMaxParameter) != params.end()) ||
+      (params.find(kInstanceAutoscaleParameter) != params.end());
+
+  // The instance count of a model without non-passive instances or
+  // with the sequence batcher, which assigns sequences to instances,
+  // can't be changed.
+  const uint32_t instance_cnt = instances_.size();
+  min_instance_cnt_ = instance_cnt;
+  max_instance_cnt_ = instance_cnt;
+  if (instance_settings_.empty() || config.has_sequence_batching()) {
+    if (scaling_configured) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "instance count can't be changed for model '" + config.name() +
+              "'");
+    }
+    return Status::Success;
+  }
+
+  uint64_t min_cnt, max_cnt;
+  RETURN_IF_ERROR(
+      GetPositiveParameter(config, kInstanceCountMinParameter, 1, &min_cnt));
+  RETURN_IF_ERROR(GetPositiveParameter(
+      config, kInstanceCountMaxParameter, instance_cnt, &max_cnt));
+  if ((min_cnt > instance_cnt) || (max_cnt < instance_cnt)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        std::string("'") + kInstanceCountMinParameter + "' and '" +
+            kInstanceCountMaxParameter + "' must include the " +
+            std::to_string(instance_cnt) + " instances of model '" +
+            config.name() + "'");
+  }
+  min_instance_cnt_ = min_cnt;
+  max_instance_cnt_ = max_cnt;
+
+  const auto& itr = params.find(kInstanceAutoscaleParameter);
+  if (itr != params.end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kInstanceAutoscaleParameter, itr->second.string_value(),
+        &autoscale_));
+  }
+  RETURN_IF_ERROR(GetPositiveParameter(
+      config, kInstanceAutoscaleIntervalParameter, 1000,
+      &autoscale_interval_ms_));
+
+  return Status::Success;
+}
+
+Status
+TritonModel::AddReplica()
+{
+  const size_t runner_idx = instances_.size();
+  const auto& setting =
+      instance_settings_[runner_idx % instance_settings_.size()];
+  std::unique_ptr<TritonModelInstance> instance;
+  RETURN_IF_ERROR(TritonModelInstance::CreateReplica(
+      this, setting, runner_idx / instance_settings_.size(), &instance));
+
+  // The runner reads its instance from 'runner_instances_', which is
+  // set before the runner starts.
+  runner_instances_[runner_idx].store(instance.get());
+  instances_.emplace_back(std::move(instance));
+  Status status = BackendScheduler()->AddRunner(runner_idx);
+  if (!status.IsOk()) {
+    runner_instances_[runner_idx].store(nullptr);
+    instances_.pop_back();
+    return status;
+  }
+
+  LOG_INFO << "added instance " << instances_.back()->Name() << " to model '"
+           << Name() << "', " << instances_.size() << " instances";
+  return Status::Success;
+}
+
+Status
+TritonModel::RetireInstance(const bool autoscaler)
+{
+  const uint32_t runner_idx = instances_.size() - 1;
+  std::shared_future<void> removed;
+  Status status = BackendScheduler()->RemoveRunner(runner_idx, &removed);
+  if (status.IsOk()) {
+    // Wait for the scheduler thread to finish executing its current
+    // batch. The autoscaler must not wait if the model is being
+    // destroyed since the destructor may be running on that thread.
+    while (removed.wait_for(std::chrono::milliseconds(100)) !=
+           std::future_status::ready) {
+      if (autoscaler && AutoscalerExiting()) {
+        return Status(
+            Status::Code::UNAVAILABLE,
+            "model '" + Name() + "' is being unloaded");
+      }
+    }
+  } else if (status.StatusCode() != Status::Code::NOT_FOUND) {
+    // The scheduler doesn't have a runner for an instance that failed
+    // to initialize its scheduler thread, such an instance is just
+    // finalized.
+    return status;
+  }
+
+  const std::string instance_name = instances_.back()->Name();
+  runner_instances_[runner_idx].store(nullptr);
+  instances_.pop_back();
+
+  LOG_INFO << "removed instance " << instance_name << " from model '"
+           << Name() << "', " << instances_.size() << " instances";
+  return Status::Success;
+}
+
+void
+TritonModel::Autoscale()
+{
+  size_t pending_cnt;
+  uint32_t runner_cnt;
+  uint64_t last_exec_ns;
+  Status status =
+      BackendScheduler()->Load(&pending_cnt, &runner_cnt, &last_exec_ns);
+  if (!status.IsOk()) {
+    LOG_ERROR << "instance autoscaling disabled for model '" << Name()
+              << "': " << status.Message();
+    return;
+  }
+  uint64_t last_ns = SteadyClockNs();
+  uint32_t idle_interval_cnt = 0;
+
+  std::unique_lock<std::mutex> lock(autoscaler_mu_);
+  while (!autoscaler_exit_) {
+    autoscaler_cv_.wait_for(
+        lock, std::chrono::milliseconds(autoscale_interval_ms_));
+    if (autoscaler_exit_) {
+      break;
+    }
+    lock.unlock();
+
+    // The fraction of the interval that the instances were executing
+    // requests.
+    uint64_t exec_ns;
+    BackendScheduler()->Load(&pending_cnt, &runner_cnt, &exec_ns);
+    const uint64_t now_ns = SteadyClockNs();
+    const double utilization =
+        ((runner_cnt == 0) || (now_ns == last_ns))
+            ? 0
+            : static_cast<double>(exec_ns - last_exec_ns) /
+                  ((now_ns - last_ns) * runner_cnt);
+    last_exec_ns = exec_ns;
+    last_ns = now_ns;
+
+    LOG_VERBOSE(2) << "model '" << Name() << "' has " << pending_cnt
+                   << " pending requests, " << runner_cnt
+                   << " instances, utilization " << utilization;
+
+    {
+      std::lock_guard<std::mutex> scale_lock(scale_mu_);
+      const uint32_t instance_cnt = instances_.size();
+      status = Status::Success;
+      if ((pending_cnt > 0) && (utilization >= kScaleUpUtilization) &&
+          (instance_cnt < max_instance_cnt_)) {
+        idle_interval_cnt = 0;
+        LOG_VERBOSE(1) << "scaling model '" << Name() << "' to "
+                       << (instance_cnt + 1) << " instances";
+        status = AddReplica();
+      } else if (
+          (pending_cnt == 0) && (instance_cnt > min_instance_cnt_) &&
+          ((utilization * runner_cnt) <=
+           (kScaleDownUtilization * (runner_cnt - 1.0)))) {
+        if (++idle_interval_cnt >= kScaleDownIntervals) {
+          idle_interval_cnt = 0;
+          LOG_VERBOSE(1) << "scaling model '" << Name() << "' to "
+                         << (instance_cnt - 1) << " instances";
+          status = RetireInstance(true /* autoscaler */);
+        }
+      } else {
+        idle_interval_cnt = 0;
+      }
+    }
+
+    if (!status.IsOk() && !AutoscalerExiting()) {
+      LOG_ERROR << "failed to scale model '" << Name()
+                << "': " << status.Message();
+    }
+
+    lock.lock();
+  }
+}
+
+bool
+TritonModel::AutoscalerExiting()
+{
+  std::lock_guard<std::mutex> lock(autoscaler_mu_);
+  return autoscaler_exit_;
+}
+
 TritonModel::TritonModel(
     InferenceServer* server,
     const std::shared_ptr<LocalizedDirectory>& localized_model_dir,
@@ -317,12 +619,27 @@ TritonModel::TritonModel(
     : InferenceBackend(min_compute_capability), server_(server),
       auto_complete_config_(auto_complete_config),
       localized_model_dir_(localized_model_dir), backend_(backend),
-      state_(nullptr), initialized_(false)
+      state_(nullptr), initialized_(false), min_instance_cnt_(0),
+      max_instance_cnt_(0), autoscale_(false), autoscale_interval_ms_(0),
+      autoscaler_exit_(false)
 {
 }
 
 TritonModel::~TritonModel()
 {
+  // Stop the autoscaler before the scheduler and the instances it
+  // changes are destroyed.
+  if (autoscaler_thread_ != nullptr) {
+    {
+      std::lock_guard<std::mutex> lock(autoscaler_mu_);
+      autoscaler_exit_ = true;
+    }
+    autoscaler_cv_.notify_all();
+    if (autoscaler_thread_->joinable()) {
+      autoscaler_thread_->join();
+    }
+  }
+
   // Need to explicitly delete the scheduler from InferenceBackend
   // base class to make sure that all scheduler threads have returned
   // from running in the backend code... This convoluted flow will be
@@ -473,6 +790,15 @@ TRITONBACKEND_RequestCorrelationId(TRITONBACKEND_Request* request, uint64_t* id)
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+TRITONBACKEND_RequestIsCancelled(
+    TRITONBACKEND_Request* request, bool* is_cancelled)
+{
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
+  *is_cancelled = tr->IsCancelled();
+  return nullptr;  // success
+}
+
 TRITONSERVER_Error*
 TRITONBACKEND_RequestInputCount(TRITONBACKEND_Request* request, uint32_t* count)
 {
@@ -498,20 +824,7 @@ TRITONBACKEND_RequestInputName(
             .c_str());
   }
 
-  // The request inputs are not allowed to change once the request
-  // makes it to the backend, so it is ok to just iterate through the
-  // map. This linear search is the best we can do given the need for
-  // the inputs to be in a map and given the typical small number of
-  // inputs is better than having every request maintain the inputs as
-  // both map and vector.
-  uint32_t cnt = 0;
-  for (const auto& pr : inputs) {
-    if (cnt++ == index) {
-      InferenceRequest::Input* in = pr.second;
-      *input_name = in->Name().c_str();
-      break;
-    }
-  }
+  *input_name = inputs[index]->Name().c_str();
 
   return nullptr;  // success
 }
@@ -522,19 +835,17 @@ TRITONBACKEND_RequestInput(
     TRITONBACKEND_Input** input)
 {
   InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
-  const auto& inputs = tr->ImmutableInputs();
-  const auto& itr = inputs.find(name);
-  if (itr == inputs.end()) {
-    *input = nullptr;
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_INVALID_ARG,
-        (std::string("unknown request input name ") + name).c_str());
+  for (InferenceRequest::Input* in : tr->ImmutableInputs()) {
+    if (in->Name() == name) {
+      *input = reinterpret_cast<TRITONBACKEND_Input*>(in);
+      return nullptr;  // success
+    }
   }
 
-  InferenceRequest::Input* in = itr->second;
-  *input = reinterpret_cast<TRITONBACKEND_Input*>(in);
-
-  return nullptr;  // success
+  *input = nullptr;
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_INVALID_ARG,
+      (std::string("unknown request input name ") + name).c_str());
 }
 
 TRITONSERVER_Error*
@@ -552,20 +863,7 @@ TRITONBACKEND_RequestInputByIndex(
             .c_str());
   }
 
-  // The request inputs are not allowed to change once the request
-  // makes it to the backend, so it is ok to just iterate through the
-  // map. This linear search is the best we can do given the need for
-  // the inputs to be in a map and given the typical small number of
-  // inputs is better than having every request maintain the inputs as
-  // both map and vector.
-  uint32_t cnt = 0;
-  for (const auto& pr : inputs) {
-    if (cnt++ == index) {
-      InferenceRequest::Input* in = pr.second;
-      *input = reinterpret_cast<TRITONBACKEND_Input*>(in);
-      break;
-    }
-  }
+  *input = reinterpret_cast<TRITONBACKEND_Input*>(inputs[index]);
 
   return nullptr;  // success
 }
@@ -25,10 +25,16 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "model_config.pb.h"
 #include "src/backends/backend/triton_backend_manager.h"
+#include "src/backends/backend/triton_model_instance.h"
 #include "src/core/backend.h"
 #include "src/core/filesystem.h"
 #include "src/core/infer_request.h"
@@ -37,7 +43,6 @@
 namespace nvidia { namespace inferenceserver {
 
 class InferenceServer;
-class TritonModelInstance;
 
 //
 // Represents a model.
@@ -73,6 +78,8 @@ class TritonModel : public InferenceBackend {
 
   void WarmUp(uint32_t runner_idx, WarmupData& sample) override;
 
+  Status SetInstanceCount(const uint32_t count) override;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TritonModel);
 
@@ -82,6 +89,33 @@ class TritonModel : public InferenceBackend {
       const std::shared_ptr<TritonBackend>& backend,
       const double min_compute_capability, const bool auto_complete_config);
 
+  // Read the range of the instance count and the autoscaler settings
+  // from the model configuration.
+  Status InitInstanceScaling(const inference::ModelConfig& config);
+
+  // Add an instance that replicates one of the instances created for
+  // the instance groups and start executing requests on it. Must be
+  // called with 'scale_mu_' held.
+  Status AddReplica();
+
+  // Stop executing requests on the last instance and finalize it once
+  // the scheduler no longer uses it. If 'autoscaler' is true the wait
+  // is abandoned when the autoscaler is signaled to exit, in which
+  // case the instance is finalized when the model is destroyed. Must
+  // be called with 'scale_mu_' held.
+  Status RetireInstance(const bool autoscaler);
+
+  // The instance executed by runner 'runner_idx'.
+  TritonModelInstance* RunnerInstance(const uint32_t runner_idx) const
+  {
+    return runner_instances_[runner_idx].load();
+  }
+
+  // The autoscaler thread function, and whether the autoscaler is
+  // signaled to exit.
+  void Autoscale();
+  bool AutoscalerExiting();
+
   // The server object that owns this model. The model holds this as a
   // raw pointer because the lifetime of the server is guaranteed to
   // be longer than the lifetime of a model owned by the server.
@@ -98,15 +132,42 @@ class TritonModel : public InferenceBackend {
   // Backend used by this model.
   std::shared_ptr<TritonBackend> backend_;
 
-  // The model instances for this model.
+  // The model instances for this model. After the model is created
+  // 'instances_' is only accessed with 'scale_mu_' held.
   std::vector<std::unique_ptr<TritonModelInstance>> instances_;
   std::vector<std::unique_ptr<TritonModelInstance>> passive_instances_;
 
+  // The instance of each runner, with room for 'max_instance_cnt_'
+  // runners. The array is never resized so the runners read their
+  // instance without a lock while instances are added and removed.
+  std::unique_ptr<std::atomic<TritonModelInstance*>[]> runner_instances_;
+
   // Opaque state associated with this model.
   void* state_;
 
   // Whether the model is initialized.
   bool initialized_;
+
+  // The settings of the non-passive instances created for the
+  // instance groups. Instances added at runtime replicate these in
+  // round-robin order.
+  std::vector<TritonModelInstance::Setting> instance_settings_;
+
+  // The range of the instance count when it is changed at runtime.
+  // 'scale_mu_' serializes the changes to the instance count.
+  uint32_t min_instance_cnt_;
+  uint32_t max_instance_cnt_;
+  std::mutex scale_mu_;
+
+  // The autoscaler that changes the instance count based on the load
+  // of the model every 'autoscale_interval_ms_'. 'autoscaler_exit_'
+  // is protected by 'autoscaler_mu_'.
+  bool autoscale_;
+  uint64_t autoscale_interval_ms_;
+  std::unique_ptr<std::thread> autoscaler_thread_;
+  std::mutex autoscaler_mu_;
+  std::condition_variable autoscaler_cv_;
+  bool autoscaler_exit_;
 };
 
 }}  // namespace nvidia::inferenceserver
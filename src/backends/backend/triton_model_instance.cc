@@ -26,10 +26,14 @@
 
 #include "src/backends/backend/triton_model_instance.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "model_config.pb.h"
 #include "src/backends/backend/triton_model.h"
 #include "src/core/logging.h"
 #include "src/core/metrics.h"
+#include "src/core/model_config_utils.h"
 #include "src/core/numa_utils.h"
 #include "src/core/shared_library.h"
 
@@ -70,22 +74,31 @@ TritonModelInstance::~TritonModelInstance()
   }
 }
 
+namespace {
+
+// The model configuration parameter that sets the maximum number of
+// instances of the model that are initialized concurrently. It
+// overrides the server-wide setting.
+constexpr char kInstanceInitConcurrencyParameter[] =
+    "instance_init_concurrency";
+
+}  // namespace
+
 Status
 TritonModelInstance::CreateInstances(
     TritonModel* model, const HostPolicyCmdlineConfigMap& host_policy_map,
-    const inference::ModelConfig& model_config)
+    const inference::ModelConfig& model_config, uint32_t* init_concurrency,
+    std::vector<Setting>* settings)
 {
-  static HostPolicyCmdlineConfig empty_host_policy;
+  // The setting of each instance, in the order the instances appear
+  // in the model configuration.
+  settings->clear();
   for (const auto& group : model_config.instance_group()) {
     std::vector<std::string> profile_names;
     for (const auto& profile_name : group.profile()) {
       profile_names.push_back(profile_name);
     }
     for (int32_t c = 0; c < group.count(); ++c) {
-      std::string instance_name{group.count() > 1
-                                    ? group.name() + "_" + std::to_string(c)
-                                    : group.name()};
-      const bool passive = group.passive();
       std::vector<
           std::tuple<std::string, TRITONSERVER_InstanceGroupKind, int32_t>>
           instance_setting;
@@ -111,34 +124,152 @@ TritonModelInstance::CreateInstances(
                 ModelInstanceGroup_Kind_Name(group.kind()) + " not supported");
       }
       for (const auto is : instance_setting) {
-        const std::string& policy_name = std::get<0>(is);
-        const HostPolicyCmdlineConfig* host_policy;
-        const auto policy_it = host_policy_map.find(policy_name);
+        settings->emplace_back();
+        Setting& setting = settings->back();
+        setting.group_name_ = group.name();
+        setting.group_count_ = group.count();
+        setting.index_ = c;
+        setting.kind_ = std::get<1>(is);
+        setting.device_id_ = std::get<2>(is);
+        setting.profile_names_ = profile_names;
+        setting.passive_ = group.passive();
+        setting.host_policy_name_ = std::get<0>(is);
+        const auto policy_it = host_policy_map.find(setting.host_policy_name_);
         if (policy_it != host_policy_map.end()) {
-          host_policy = &policy_it->second;
-        } else {
-          host_policy = &empty_host_policy;
+          setting.host_policy_ = policy_it->second;
         }
-        RETURN_IF_ERROR(SetNumaConfigOnThread(*host_policy));
-        auto err = CreateInstance(
-            model, instance_name, c, std::get<1>(is), std::get<2>(is),
-            profile_names, passive, policy_name, *host_policy);
-        RETURN_IF_ERROR(ResetNumaMemoryPolicy());
-        RETURN_IF_ERROR(err);
       }
     }
   }
 
+  // Initialize up to 'concurrency' instances at a time. Instances can
+  // only be initialized concurrently if the backend allows it.
+  uint64_t concurrency = *init_concurrency;
+  const auto& itr =
+      model_config.parameters().find(kInstanceInitConcurrencyParameter);
+  if (itr != model_config.parameters().end()) {
+    int64_t parsed_concurrency;
+    RETURN_IF_ERROR(ParseLongLongParameter(
+        kInstanceInitConcurrencyParameter, itr->second.string_value(),
+        &parsed_concurrency));
+    if (parsed_concurrency <= 0) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          std::string("'") + kInstanceInitConcurrencyParameter +
+              "' must be a positive integer for model '" +
+              model_config.name() + "'");
+    }
+    concurrency = parsed_concurrency;
+  }
+  if ((model->Backend()->ModelInstanceInitFn() == nullptr) ||
+      model->Backend()->ModelInstanceInitSerialized()) {
+    concurrency = 1;
+  }
+  *init_concurrency = concurrency;
+  concurrency = std::min(concurrency, static_cast<uint64_t>(settings->size()));
+
+  std::vector<std::unique_ptr<TritonModelInstance>> instances(
+      settings->size());
+  std::vector<Status> statuses(settings->size());
+  const bool concurrent_init = (concurrency > 1);
+  auto create_instance = [&](const size_t idx) {
+    statuses[idx] = CreateInstance(
+        model, (*settings)[idx], concurrent_init, &instances[idx]);
+    return statuses[idx].IsOk();
+  };
+
+  if (concurrency <= 1) {
+    for (size_t idx = 0; idx < settings->size(); ++idx) {
+      if (!create_instance(idx)) {
+        break;
+      }
+    }
+  } else {
+    LOG_VERBOSE(1) << "initializing " << settings->size() << " instances of "
+                   << model_config.name() << " with concurrency "
+                   << concurrency;
+
+    // Each thread initializes the next instance that is not yet
+    // initialized, until all instances are initialized or one of
+    // them fails.
+    std::atomic<size_t> next_idx(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < concurrency; ++t) {
+      threads.emplace_back([&]() {
+        while (!failed) {
+          const size_t idx = next_idx++;
+          if (idx >= settings->size()) {
+            break;
+          }
+          if (!create_instance(idx)) {
+            failed = true;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Add the instances to the model in the order of the model
+  // configuration, which is the order of the runners that execute
+  // them. If any instance failed the instances already initialized
+  // are released with the model.
+  for (size_t idx = 0; idx < settings->size(); ++idx) {
+    RETURN_IF_ERROR(statuses[idx]);
+    if (instances[idx] == nullptr) {
+      break;
+    }
+    model->AddInstance(std::move(instances[idx]), (*settings)[idx].passive_);
+  }
+
   return Status::Success;
 }
 
+Status
+TritonModelInstance::CreateReplica(
+    TritonModel* model, const Setting& setting, const size_t replica,
+    std::unique_ptr<TritonModelInstance>* instance)
+{
+  Setting replica_setting = setting;
+  replica_setting.index_ += replica * setting.group_count_;
+  return CreateInstance(
+      model, replica_setting, false /* concurrent_init */, instance);
+}
+
+Status
+TritonModelInstance::CreateInstance(
+    TritonModel* model, const Setting& setting, const bool concurrent_init,
+    std::unique_ptr<TritonModelInstance>* instance)
+{
+  // Replicas of the instances of a group are numbered after the
+  // instances of the group.
+  const std::string name =
+      ((setting.group_count_ > 1) ||
+       (setting.index_ >= static_cast<size_t>(setting.group_count_)))
+          ? setting.group_name_ + "_" + std::to_string(setting.index_)
+          : setting.group_name_;
+
+  RETURN_IF_ERROR(SetNumaConfigOnThread(setting.host_policy_));
+  Status status = CreateInstance(
+      model, name, setting.index_, setting.kind_, setting.device_id_,
+      setting.profile_names_, setting.passive_, setting.host_policy_name_,
+      setting.host_policy_, concurrent_init, instance);
+  RETURN_IF_ERROR(ResetNumaMemoryPolicy());
+
+  return status;
+}
+
 Status
 TritonModelInstance::CreateInstance(
     TritonModel* model, const std::string& name, const size_t index,
     const TRITONSERVER_InstanceGroupKind kind, const int32_t device_id,
     const std::vector<std::string>& profile_names, const bool passive,
     const std::string& host_policy_name,
-    const HostPolicyCmdlineConfig& host_policy)
+    const HostPolicyCmdlineConfig& host_policy, const bool concurrent_init,
+    std::unique_ptr<TritonModelInstance>* instance)
 {
   // Create the JSON representation of the backend configuration.
   triton::common::TritonJson::Value host_policy_json(
@@ -163,19 +294,33 @@ TritonModelInstance::CreateInstance(
   // Instance initialization is optional... We must set set shared
   // library path to point to the backend directory in case the
   // backend library attempts to load additional shared libaries.
+  // Instances are initialized while holding the process-wide shared
+  // library lock unless concurrent initialization was requested for
+  // the model. The library path is process-wide on Windows so there
+  // the lock is always held.
   if (model->Backend()->ModelInstanceInitFn() != nullptr) {
     std::unique_ptr<SharedLibrary> slib;
-    RETURN_IF_ERROR(SharedLibrary::Acquire(&slib));
-    RETURN_IF_ERROR(slib->SetLibraryDirectory(model->Backend()->Directory()));
+#ifdef _WIN32
+    const bool hold_library_lock = true;
+#else
+    const bool hold_library_lock = !concurrent_init;
+#endif  // _WIN32
+    if (hold_library_lock) {
+      RETURN_IF_ERROR(SharedLibrary::Acquire(&slib));
+      RETURN_IF_ERROR(
+          slib->SetLibraryDirectory(model->Backend()->Directory()));
+    }
 
     TRITONSERVER_Error* err =
         model->Backend()->ModelInstanceInitFn()(triton_instance);
 
-    RETURN_IF_ERROR(slib->ResetLibraryDirectory());
+    if (slib != nullptr) {
+      RETURN_IF_ERROR(slib->ResetLibraryDirectory());
+    }
     RETURN_IF_TRITONSERVER_ERROR(err);
   }
 
-  model->AddInstance(std::move(local_instance), passive);
+  *instance = std::move(local_instance);
 
   return Status::Success;
 }
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include "model_config.pb.h"
 #include "src/core/constants.h"
 #include "src/core/metric_model_reporter.h"
@@ -42,9 +43,38 @@ class TritonModel;
 //
 class TritonModelInstance {
  public:
+  // The setting of an instance, derived from the instance group that
+  // the instance belongs to.
+  struct Setting {
+    std::string group_name_;
+    int32_t group_count_;
+    size_t index_;
+    TRITONSERVER_InstanceGroupKind kind_;
+    int32_t device_id_;
+    std::vector<std::string> profile_names_;
+    bool passive_;
+    std::string host_policy_name_;
+    HostPolicyCmdlineConfig host_policy_;
+  };
+
+  // Create the instances of 'model' for the instance groups of
+  // 'model_config'. Up to 'init_concurrency' instances are
+  // initialized concurrently, unless the model configuration or the
+  // backend overrides it. Return in 'init_concurrency' the concurrency
+  // that applies to the model and in 'settings' the setting of each
+  // instance.
   static Status CreateInstances(
       TritonModel* model, const HostPolicyCmdlineConfigMap& host_policy_map,
-      const inference::ModelConfig& model_config);
+      const inference::ModelConfig& model_config, uint32_t* init_concurrency,
+      std::vector<Setting>* settings);
+
+  // Create a replica of the instance with 'setting'. The 'replica'
+  // index must be greater than 0 and is used to give each replica of
+  // an instance a distinct index within its group. The replica is not
+  // added to the model.
+  static Status CreateReplica(
+      TritonModel* model, const Setting& setting, const size_t replica,
+      std::unique_ptr<TritonModelInstance>* instance);
   ~TritonModelInstance();
 
   const std::string& Name() const { return name_; }
@@ -74,12 +104,19 @@ class TritonModelInstance {
       const std::vector<std::string>& profile_names, const bool passive,
       const HostPolicyCmdlineConfig& host_policy,
       const TritonServerMessage& host_policy_message);
+  // Create the instance with 'setting'. If 'concurrent_init' is true
+  // other instances may be initialized at the same time and the
+  // instance is initialized without holding the shared library lock.
+  static Status CreateInstance(
+      TritonModel* model, const Setting& setting, const bool concurrent_init,
+      std::unique_ptr<TritonModelInstance>* instance);
   static Status CreateInstance(
       TritonModel* model, const std::string& name, const size_t index,
       const TRITONSERVER_InstanceGroupKind kind, const int32_t device_id,
       const std::vector<std::string>& profile_names, const bool passive,
       const std::string& host_policy_name,
-      const HostPolicyCmdlineConfig& host_policy);
+      const HostPolicyCmdlineConfig& host_policy, const bool concurrent_init,
+      std::unique_ptr<TritonModelInstance>* instance);
 
   // The TritonModel object that owns this instance. The instance
   // holds this as a raw pointer because the lifetime of the model is
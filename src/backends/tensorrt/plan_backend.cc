@@ -488,7 +488,7 @@ PlanBackend::CreateExecutionContexts(
   // assigned to the corresponding queue. For different scheduler type, the
   // context queue will be formed differently to fit the scheduler's need.
   RETURN_IF_ERROR(SetConfiguredScheduler(
-      available_context_queue_.size(),
+      available_context_queue_.size(), 1 /* warmup_concurrency */,
       [this](uint32_t runner_idx) -> Status {
         // Obtain any context as the next context for the corresponding runner
         next_context_[runner_idx] = available_context_queue_[runner_idx]->Get();
@@ -2454,8 +2454,8 @@ PlanBackend::DuplicateWarmupRequests(
       RETURN_IF_ERROR(linput->SetData(input_pair.second.Data()));
     }
     lrequest->PrepareForInference();
-    for (const auto& override_input_pair : request->OverrideInputs()) {
-      RETURN_IF_ERROR(lrequest->AddOverrideInput(override_input_pair.second));
+    for (const auto& override_input : request->OverrideInputs()) {
+      RETURN_IF_ERROR(lrequest->AddOverrideInput(override_input));
     }
 
     RETURN_IF_ERROR(lrequest->SetResponseCallback(
@@ -3349,9 +3349,8 @@ PlanBackend::Context::GetRequestShapeValues(
 {
   // Visit all the inputs and extract the shape values present in the request
   Status status;
-  for (const auto& pr : request->ImmutableInputs()) {
-    const std::string& input_name = pr.first;
-    const auto& repr_input = pr.second;
+  for (const auto repr_input : request->ImmutableInputs()) {
+    const std::string& input_name = repr_input->Name();
     const auto& batch1_shape = repr_input->Shape();
 
     int io_index = engine_->getBindingIndex(input_name.c_str());
@@ -3466,8 +3465,7 @@ PlanBackend::Context::EvaluateTensorRTContext(
     int64_t* error_distance)
 {
   *error_distance = 0;
-  for (const auto& pr : requests[0]->ImmutableInputs()) {
-    const auto input = pr.second;
+  for (const auto input : requests[0]->ImmutableInputs()) {
     int io_index = engine_->getBindingIndex(input->Name().c_str());
     auto& io_binding_info =
         io_binding_infos_[next_buffer_binding_set_][io_index];
@@ -26,15 +26,24 @@
 
 #include "src/core/backend.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <future>
+#include <sstream>
+#include <thread>
 #include "src/core/constants.h"
+#include "src/core/cuda_utils.h"
 #include "src/core/dynamic_batch_scheduler.h"
 #include "src/core/filesystem.h"
 #include "src/core/infer_request.h"
 #include "src/core/logging.h"
+#include "src/core/metric_model_reporter.h"
+#include "src/core/metrics.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/sequence_batch_scheduler.h"
+#include "src/core/shared_executor.h"
 
 namespace nvidia { namespace inferenceserver {
 
@@ -102,8 +111,486 @@ WarmupRequestComplete(
   }
 }
 
+// The model configuration parameters that enable the response cache
+// and the coalescing of identical requests for a model.
+constexpr char kResponseCacheParameter[] = "response_cache";
+constexpr char kRequestCoalescingParameter[] = "request_coalescing";
+
+// Return in 'value' the boolean model configuration parameter 'name',
+// or false if the parameter is not specified.
+Status
+GetBoolParameter(
+    const inference::ModelConfig& config, const std::string& name,
+    bool* value)
+{
+  *value = false;
+  const auto& itr = config.parameters().find(name);
+  if (itr == config.parameters().end()) {
+    return Status::Success;
+  }
+
+  return ParseBoolParameter(name, itr->second.string_value(), value);
+}
+
+// The model configuration parameter that makes the dynamic batcher
+// schedule the requests of each priority level in order of their
+// timeout.
+constexpr char kEarliestDeadlineFirstParameter[] = "earliest_deadline_first";
+
+// The model configuration parameter that sets the latency SLO of the
+// dynamic batcher queue, in microseconds. A request is rejected when
+// it is enqueued if its predicted queue delay exceeds the SLO.
+constexpr char kQueueLatencySloParameter[] = "queue_latency_slo_microseconds";
+
+// Return in 'value' the non-negative integer model configuration
+// parameter 'name', or 0 if the parameter is not specified.
+Status
+GetUInt64Parameter(
+    const inference::ModelConfig& config, const std::string& name,
+    uint64_t* value)
+{
+  *value = 0;
+  const auto& itr = config.parameters().find(name);
+  if (itr == config.parameters().end()) {
+    return Status::Success;
+  }
+
+  int64_t parsed_value;
+  RETURN_IF_ERROR(
+      ParseLongLongParameter(name, itr->second.string_value(), &parsed_value));
+  if (parsed_value < 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "'" + name + "' must be a non-negative integer for model '" +
+            config.name() + "'");
+  }
+
+  *value = parsed_value;
+  return Status::Success;
+}
+
+// The model configuration parameter that makes the instances of a
+// CPU model use dedicated scheduler threads even if the shared CPU
+// executor is enabled.
+constexpr char kDedicatedSchedulerThreadsParameter[] =
+    "dedicated_scheduler_threads";
+
+// Return the executor that the scheduler of the model with 'config'
+// should execute batches on, or nullptr if each instance should use
+// a dedicated scheduler thread. Only models whose instances all
+// execute on CPU and that are not sequence batched use the shared
+// CPU executor.
+Status
+GetSharedExecutor(
+    const inference::ModelConfig& config, SharedExecutor** executor)
+{
+  *executor = nullptr;
+  if ((SharedExecutor::Global() == nullptr) ||
+      config.has_sequence_batching() || (config.instance_group_size() == 0)) {
+    return Status::Success;
+  }
+
+  for (const auto& group : config.instance_group()) {
+    if (group.kind() != inference::ModelInstanceGroup::KIND_CPU) {
+      return Status::Success;
+    }
+  }
+
+  bool dedicated_threads;
+  RETURN_IF_ERROR(GetBoolParameter(
+      config, kDedicatedSchedulerThreadsParameter, &dedicated_threads));
+  if (!dedicated_threads) {
+    *executor = SharedExecutor::Global();
+  }
+
+  return Status::Success;
+}
+
+// The model configuration parameters that enable shape bucketing in
+// the dynamic batcher and that set the lengths that variable-size
+// dimensions are padded to.
+constexpr char kShapeBucketingParameter[] = "shape_bucketing";
+constexpr char kShapeBucketLengthsParameter[] = "shape_bucket_lengths";
+
+// Return in 'shape_bucketing' the shape bucketing of the dynamic
+// batcher for 'config', given the inputs that must have equal shapes
+// within a batch.
+Status
+GetShapeBucketing(
+    const inference::ModelConfig& config,
+    const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
+    DynamicBatchScheduler::ShapeBucketing* shape_bucketing)
+{
+  RETURN_IF_ERROR(GetBoolParameter(
+      config, kShapeBucketingParameter, &shape_bucketing->enabled_));
+
+  const auto& itr = config.parameters().find(kShapeBucketLengthsParameter);
+  if (itr != config.parameters().end()) {
+    std::stringstream ss(itr->second.string_value());
+    std::string length_str;
+    while (std::getline(ss, length_str, ',')) {
+      int64_t length;
+      RETURN_IF_ERROR(ParseLongLongParameter(
+          kShapeBucketLengthsParameter, length_str, &length));
+      if (length <= 0) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "'" + std::string(kShapeBucketLengthsParameter) +
+                "' must be positive integers for model '" + config.name() +
+                "'");
+      }
+      shape_bucketing->lengths_.insert(length);
+    }
+    shape_bucketing->enabled_ = true;
+  }
+
+  // Requests are bucketed only if they must have equal shapes to be
+  // batched together.
+  if (enforce_equal_shape_tensors.empty()) {
+    *shape_bucketing = DynamicBatchScheduler::ShapeBucketing();
+    return Status::Success;
+  }
+
+  if (shape_bucketing->lengths_.empty()) {
+    return Status::Success;
+  }
+
+  // Only the variable-size dimensions of inputs that are not shape
+  // tensors are padded.
+  for (const auto& input : config.input()) {
+    const auto eitr = enforce_equal_shape_tensors.find(input.name());
+    if ((eitr == enforce_equal_shape_tensors.end()) || eitr->second) {
+      continue;
+    }
+
+    const auto& dims =
+        input.has_reshape() ? input.reshape().shape() : input.dims();
+    std::vector<size_t> variable_dims;
+    for (int i = 0; i < dims.size(); ++i) {
+      if (dims[i] == -1) {
+        variable_dims.push_back(i);
+      }
+    }
+    if (variable_dims.empty()) {
+      continue;
+    }
+
+    if (input.data_type() == inference::DataType::TYPE_STRING) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "'" + std::string(kShapeBucketLengthsParameter) +
+              "' is not supported for model '" + config.name() +
+              "', which has variable-size input '" + input.name() +
+              "' of type TYPE_STRING");
+    }
+
+    shape_bucketing->variable_dims_.emplace(
+        input.name(), std::move(variable_dims));
+  }
+
+  // The outputs are computed from the padded inputs and are returned
+  // as computed, so padding is only allowed if no output shape can
+  // depend on the input shapes, that is if all outputs have fixed
+  // size.
+  if (!shape_bucketing->variable_dims_.empty()) {
+    for (const auto& output : config.output()) {
+      const auto& dims =
+          output.has_reshape() ? output.reshape().shape() : output.dims();
+      for (int i = 0; i < dims.size(); ++i) {
+        if (dims[i] == -1) {
+          return Status(
+              Status::Code::INVALID_ARG,
+              "'" + std::string(kShapeBucketLengthsParameter) +
+                  "' is not supported for model '" + config.name() +
+                  "', which has variable-size output '" + output.name() +
+                  "'");
+        }
+      }
+    }
+  }
+
+  return Status::Success;
+}
+
+// Return an error if the responses of 'config' can't be reused for
+// other requests. The response of a request must depend only on the
+// request's inputs for the response to be reused.
+Status
+ValidateResponseReuse(
+    const inference::ModelConfig& config, const std::string& parameter)
+{
+  if (config.has_sequence_batching() ||
+      config.model_transaction_policy().decoupled()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "'" + parameter + "' is not supported for model '" + config.name() +
+            "', which uses sequence batching or the decoupled transaction "
+            "policy");
+  }
+
+  return Status::Success;
+}
+
+template <typename F, typename T>
+void
+VisitRequestValue(F& fn, const T& value)
+{
+  fn(&value, sizeof(T));
+}
+
+template <typename F>
+void
+VisitRequestString(F& fn, const std::string& value)
+{
+  VisitRequestValue(fn, value.size());
+  fn(value.data(), value.size());
+}
+
+// Call 'fn' with each part of the normalized form of 'request' that
+// identifies the response of 'request'. Return false if the response
+// of 'request' can't be reused for other requests, in which case 'fn'
+// may have been called with only some of the parts.
+template <typename F>
+bool
+VisitRequest(const InferenceRequest& request, F& fn)
+{
+  // Requests that are part of a sequence may depend on the sequence
+  // state and so their responses are not reused.
+  if ((request.CorrelationId() != 0) || (request.Flags() != 0)) {
+    return false;
+  }
+
+  VisitRequestValue(fn, request.BatchSize());
+
+  // The inputs are in the order of the model configuration so the
+  // normalized form does not depend on the order in which the inputs
+  // were added to the request.
+  for (const InferenceRequest::Input* input : request.ImmutableInputs()) {
+    if (input->HasHostPolicySpecificData()) {
+      return false;
+    }
+
+    VisitRequestString(fn, input->Name());
+    VisitRequestValue(fn, input->DType());
+    VisitRequestValue(fn, input->Shape().size());
+    for (const auto dim : input->Shape()) {
+      VisitRequestValue(fn, dim);
+    }
+
+    VisitRequestValue(fn, input->Data()->TotalByteSize());
+    for (size_t idx = 0; idx < input->DataBufferCount(); ++idx) {
+      const void* base;
+      size_t byte_size;
+      TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+      int64_t memory_type_id = 0;
+      Status status = input->DataBuffer(
+          idx, &base, &byte_size, &memory_type, &memory_type_id);
+      if (!status.IsOk() || (memory_type == TRITONSERVER_MEMORY_GPU)) {
+        return false;
+      }
+      fn(base, byte_size);
+    }
+  }
+
+  for (const auto& name : request.ImmutableRequestedOutputs()) {
+    VisitRequestString(fn, name);
+  }
+
+  return true;
+}
+
+// 64-bit hash of the normalized form of a request, computed from the
+// parts of the normalized form. The hash depends only on the
+// concatenated parts and not on how the data is split into parts, so
+// input data split into several buffers hashes the same as the data
+// in a single buffer.
+class RequestHasher {
+ public:
+  RequestHasher() : hash_(0x9e3779b97f4a7c15ULL), length_(0), carry_size_(0)
+  {
+  }
+
+  void operator()(const void* base, size_t byte_size)
+  {
+    const char* data = reinterpret_cast<const char*>(base);
+    length_ += byte_size;
+
+    if (carry_size_ != 0) {
+      const size_t size = std::min(sizeof(carry_) - carry_size_, byte_size);
+      memcpy(carry_ + carry_size_, data, size);
+      carry_size_ += size;
+      data += size;
+      byte_size -= size;
+      if (carry_size_ < sizeof(carry_)) {
+        return;
+      }
+      MixCarry();
+    }
+
+    for (; byte_size >= sizeof(uint64_t); byte_size -= sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data, sizeof(uint64_t));
+      Mix(word);
+      data += sizeof(uint64_t);
+    }
+
+    memcpy(carry_, data, byte_size);
+    carry_size_ = byte_size;
+  }
+
+  uint64_t Hash()
+  {
+    if (carry_size_ != 0) {
+      memset(carry_ + carry_size_, 0, sizeof(carry_) - carry_size_);
+      MixCarry();
+    }
+    Mix(length_);
+
+    // Finalize so that every bit of the hash depends on every bit of
+    // the input.
+    uint64_t hash = hash_;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+ private:
+  void Mix(uint64_t word)
+  {
+    word *= 0x87c37b91114253d5ULL;
+    word = (word << 31) | (word >> 33);
+    hash_ ^= word * 0x4cf5ad432745937fULL;
+    hash_ = ((hash_ << 27) | (hash_ >> 37)) * 5 + 0x52dce729;
+  }
+
+  void MixCarry()
+  {
+    uint64_t word;
+    memcpy(&word, carry_, sizeof(uint64_t));
+    Mix(word);
+    carry_size_ = 0;
+  }
+
+  uint64_t hash_;
+  uint64_t length_;
+  char carry_[sizeof(uint64_t)];
+  size_t carry_size_;
+};
+
+// Compares the normalized form of a request, from its parts, with the
+// normalized form 'normalized' of another request.
+class RequestMatcher {
+ public:
+  explicit RequestMatcher(const std::string& normalized)
+      : normalized_(normalized), offset_(0), matched_(true)
+  {
+  }
+
+  void operator()(const void* base, size_t byte_size)
+  {
+    if (matched_) {
+      matched_ = ((normalized_.size() - offset_) >= byte_size) &&
+                 (memcmp(normalized_.data() + offset_, base, byte_size) == 0);
+      offset_ += byte_size;
+    }
+  }
+
+  bool Matched() const
+  {
+    return matched_ && (offset_ == normalized_.size());
+  }
+
+ private:
+  const std::string& normalized_;
+  size_t offset_;
+  bool matched_;
+};
+
+// Return in 'hash' the hash of the normalized form of 'request'.
+// Return false if the response of 'request' can't be reused for other
+// requests.
+bool
+HashRequest(const InferenceRequest& request, uint64_t* hash)
+{
+  RequestHasher hasher;
+  if (!VisitRequest(request, hasher)) {
+    return false;
+  }
+
+  *hash = hasher.Hash();
+  return true;
+}
+
+// Return in 'normalized' the normalized form of 'request', which must
+// be a request whose response can be reused.
+void
+NormalizeRequest(const InferenceRequest& request, std::string* normalized)
+{
+  normalized->clear();
+  auto append = [normalized](const void* base, size_t byte_size) {
+    normalized->append(reinterpret_cast<const char*>(base), byte_size);
+  };
+  VisitRequest(request, append);
+}
+
+// Return true if 'normalized' is the normalized form of 'request'.
+bool
+MatchRequest(const InferenceRequest& request, const std::string& normalized)
+{
+  RequestMatcher matcher(normalized);
+  return VisitRequest(request, matcher) && matcher.Matched();
+}
+
+// Copy the outputs of 'response' into 'copy'.
+Status
+CopyResponse(const InferenceResponse& response, ResponseCache::Response* copy)
+{
+  for (const auto& output : response.Outputs()) {
+    const void* base;
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    void* userp;
+    RETURN_IF_ERROR(output.DataBuffer(
+        &base, &byte_size, &memory_type, &memory_type_id, &userp));
+
+    copy->outputs_.emplace_back();
+    ResponseCache::Output& coutput = copy->outputs_.back();
+    coutput.name_ = output.Name();
+    coutput.datatype_ = output.DType();
+    coutput.shape_ = output.Shape();
+    if ((base == nullptr) || (byte_size == 0)) {
+      continue;
+    }
+
+    coutput.data_.resize(byte_size);
+    bool cuda_used = false;
+    RETURN_IF_ERROR(CopyBuffer(
+        output.Name(), memory_type, memory_type_id, TRITONSERVER_MEMORY_CPU,
+        0 /* dst_memory_type_id */, byte_size, base, &coutput.data_[0],
+        nullptr /* cuda_stream */, &cuda_used));
+#ifdef TRITON_ENABLE_GPU
+    if (cuda_used) {
+      cudaStreamSynchronize(nullptr);
+    }
+#endif  // TRITON_ENABLE_GPU
+  }
+
+  return Status::Success;
+}
+
 }  // namespace
 
+InferenceBackend::~InferenceBackend()
+{
+  if (response_cache_enabled_) {
+    ResponseCache::Global()->RemoveOwner(this);
+  }
+}
+
 Status
 InferenceBackend::GetInput(
     const std::string& name, const inference::ModelInput** input) const
@@ -151,6 +638,7 @@ InferenceBackend::SetModelConfig(
   model_dir_ = DirName(path);
   for (const auto& io : config.output()) {
     output_map_.insert(std::make_pair(io.name(), io));
+    output_names_.insert(io.name());
 
     if (!io.label_filename().empty()) {
       const auto label_path = JoinPath({model_dir_, io.label_filename()});
@@ -188,7 +676,8 @@ InferenceBackend::SetScheduler(std::unique_ptr<Scheduler> scheduler)
 
 Status
 InferenceBackend::SetConfiguredScheduler(
-    const uint32_t runner_cnt, const Scheduler::StandardInitFunc& OnInit,
+    const uint32_t runner_cnt, const uint32_t warmup_concurrency,
+    const Scheduler::StandardInitFunc& OnInit,
     const Scheduler::StandardRunFunc& OnRun)
 {
   std::unique_ptr<Scheduler> scheduler;
@@ -199,19 +688,30 @@ InferenceBackend::SetConfiguredScheduler(
   // change ModelReadyState, which is controlled by model manager, from within
   // the scheduler.
   // But running warmup synchronously allows us to use one set of warmup data
-  // for all contexts.
-  std::vector<std::vector<WarmupData>> samples{runner_cnt};
+  // for all contexts. The ownership of InferenceRequest will be transferred
+  // on model execution, so each runner has its own requests that refer to
+  // the shared data. Runners that are added to the scheduler after it is
+  // created generate their own samples.
+  auto samples =
+      std::make_shared<std::vector<std::vector<WarmupData>>>(runner_cnt);
   if (Config().model_warmup_size() != 0) {
-    // The ownership of InferenceRequest will be transferred on model execution,
-    // so must have unique set of samples for each runner
-    for (auto& runner_samples : samples) {
-      RETURN_IF_ERROR(GenerateWarmupData(&runner_samples));
-    }
+    RETURN_IF_ERROR(GenerateWarmupData(runner_cnt, samples.get()));
   }
 
-  auto OnWarmup = [this, &samples](uint32_t runner_idx) -> Status {
-    auto& runner_samples = samples[runner_idx];
-    for (auto& sample : runner_samples) {
+  auto OnWarmup = [this, samples](uint32_t runner_idx) -> Status {
+    std::vector<std::vector<WarmupData>> added_samples;
+    std::vector<WarmupData>* runner_samples;
+    if (runner_idx < samples->size()) {
+      runner_samples = &(*samples)[runner_idx];
+    } else {
+      if (Config().model_warmup_size() != 0) {
+        RETURN_IF_ERROR(GenerateWarmupData(1, &added_samples));
+      } else {
+        added_samples.resize(1);
+      }
+      runner_samples = &added_samples[0];
+    }
+    for (auto& sample : *runner_samples) {
       LOG_VERBOSE(1) << "model '" << sample.requests_.back()->ModelName()
                      << "' instance " << std::to_string(runner_idx)
                      << " is running warmup sample '" << sample.sample_name_
@@ -233,6 +733,44 @@ InferenceBackend::SetConfiguredScheduler(
     return Status::Success;
   };
 
+  // The scheduler starts its runners one at a time, so to warm up
+  // several runners at the same time each runner is initialized and
+  // warmed up here on a thread of its own, as the scheduler would.
+  // The scheduler then only picks up the status of the warmup, a
+  // runner whose warmup failed is not used.
+  Scheduler::StandardWarmupFunc OnSchedulerWarmup = OnWarmup;
+  if ((warmup_concurrency > 1) && (runner_cnt > 1) &&
+      (Config().model_warmup_size() != 0)) {
+    LOG_VERBOSE(1) << "warming up " << runner_cnt << " instances of "
+                   << Name() << " with concurrency " << warmup_concurrency;
+
+    auto warmup_statuses = std::make_shared<std::vector<Status>>(runner_cnt);
+    std::atomic<uint32_t> next_idx(0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < std::min(warmup_concurrency, runner_cnt); ++t) {
+      threads.emplace_back([&]() {
+        for (uint32_t idx = next_idx++; idx < runner_cnt; idx = next_idx++) {
+          Status status = OnInit(idx);
+          if (status.IsOk()) {
+            status = OnWarmup(idx);
+          }
+          (*warmup_statuses)[idx] = status;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    OnSchedulerWarmup = [OnWarmup,
+                         warmup_statuses](uint32_t runner_idx) -> Status {
+      if (runner_idx < warmup_statuses->size()) {
+        return (*warmup_statuses)[runner_idx];
+      }
+      return OnWarmup(runner_idx);
+    };
+  }
+
   // Need to enforce equal shape batches (i.e. non-ragged batches) if
   // the model 1) allows one or more variable-size input tensors that
   // are not marked as 'allow_ragged_batch' or 2) has one or more
@@ -248,34 +786,85 @@ InferenceBackend::SetConfiguredScheduler(
     }
   }
 
+  // The scheduler reports the requests pending for the model, and
+  // the number of executions in progress is reported around the run
+  // function. Use a reporter that is not specialized to a device since
+  // the scheduler serves all instances of the model.
+  std::shared_ptr<MetricModelReporter> metric_reporter;
+  Scheduler::StandardRunFunc OnRunWithMetric = OnRun;
+#ifdef TRITON_ENABLE_METRICS
+  if (Metrics::Enabled()) {
+    RETURN_IF_ERROR(MetricModelReporter::Create(
+        Name(), Version(), -1 /* device */, config_.metric_tags(),
+        &metric_reporter));
+  }
+  if ((metric_reporter != nullptr) &&
+      (metric_reporter->MetricInferenceExecutionInflightCount() != nullptr)) {
+    OnRunWithMetric =
+        [OnRun, metric_reporter](
+            uint32_t runner_idx,
+            std::vector<std::unique_ptr<InferenceRequest>>&& requests) {
+          // Hold a local reference as the run function may release
+          // the last reference to the backend, and so the scheduler
+          // that owns this function.
+          std::shared_ptr<MetricModelReporter> reporter = metric_reporter;
+          reporter->MetricInferenceExecutionInflightCount()->Increment();
+          OnRun(runner_idx, std::move(requests));
+          reporter->MetricInferenceExecutionInflightCount()->Decrement();
+        };
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  SharedExecutor* executor;
+  RETURN_IF_ERROR(GetSharedExecutor(config_, &executor));
+  if (executor != nullptr) {
+    LOG_VERBOSE(1) << "model '" << Name()
+                   << "' instances execute on the shared CPU executor";
+  }
+
   // If 'sequence_batching' is configured use the SequenceBatchScheduler,
   // otherwise use the default DynamicBatchScheduler.
   if (config_.has_sequence_batching()) {
     // Sequence batcher
     RETURN_IF_ERROR(SequenceBatchScheduler::Create(
-        config_, runner_cnt, OnInit, OnWarmup, OnRun,
-        enforce_equal_shape_tensors, &scheduler));
+        config_, runner_cnt, OnInit, OnSchedulerWarmup, OnRunWithMetric,
+        enforce_equal_shape_tensors, metric_reporter, &scheduler));
   } else if (config_.has_dynamic_batching()) {
     // Dynamic batcher
+    DynamicBatchScheduler::ShapeBucketing shape_bucketing;
+    RETURN_IF_ERROR(GetShapeBucketing(
+        config_, enforce_equal_shape_tensors, &shape_bucketing));
+    bool earliest_deadline_first;
+    RETURN_IF_ERROR(GetBoolParameter(
+        config_, kEarliestDeadlineFirstParameter, &earliest_deadline_first));
+    uint64_t queue_latency_slo_us;
+    RETURN_IF_ERROR(GetUInt64Parameter(
+        config_, kQueueLatencySloParameter, &queue_latency_slo_us));
     RETURN_IF_ERROR(DynamicBatchScheduler::Create(
         0 /* runner_id_start */, runner_cnt, GetCpuNiceLevel(config_), OnInit,
-        OnWarmup, OnRun, true /* dynamic_batching_enabled */,
-        config_.max_batch_size(), enforce_equal_shape_tensors,
-        config_.dynamic_batching(), &scheduler));
+        OnSchedulerWarmup, OnRunWithMetric,
+        true /* dynamic_batching_enabled */, config_.max_batch_size(),
+        enforce_equal_shape_tensors, config_.dynamic_batching(),
+        shape_bucketing, earliest_deadline_first, queue_latency_slo_us,
+        executor, metric_reporter, &scheduler));
   } else {
     // Default scheduler. Use dynamic batch scheduler (with batching
     // disabled) as the default scheduler.
     RETURN_IF_ERROR(DynamicBatchScheduler::Create(
         0 /* runner_id_start */, runner_cnt, GetCpuNiceLevel(config_), OnInit,
-        OnWarmup, OnRun, false /* dynamic_batching_enabled */,
-        1 /* max_batch_size */,
+        OnSchedulerWarmup, OnRunWithMetric,
+        false /* dynamic_batching_enabled */, 1 /* max_batch_size */,
         std::unordered_map<
             std::string, bool>() /* enforce_equal_shape_tensors */,
-        false /* preserve_ordering */,
-        std::set<int32_t>() /* preferred_batch_sizes */,
-        0 /* max_queue_delay_microseconds */, &scheduler));
+        inference::ModelDynamicBatching(),
+        DynamicBatchScheduler::ShapeBucketing(),
+        false /* earliest_deadline_first */, 0 /* queue_latency_slo_us */,
+        executor, metric_reporter, &scheduler));
   }
 
+  // The samples of the runners created with the scheduler are used.
+  samples->clear();
+
   return SetScheduler(std::move(scheduler));
 }
 
@@ -288,10 +877,405 @@ InferenceBackend::Init(
       ValidateModelConfig(config, platform, min_compute_capability_));
   RETURN_IF_ERROR(ValidateModelIOConfig(config));
   RETURN_IF_ERROR(SetModelConfig(path, config));
+  RETURN_IF_ERROR(InitResponseReuse());
 
   return Status::Success;
 }
 
+Status
+InferenceBackend::Enqueue(std::unique_ptr<InferenceRequest>& request)
+{
+  if (!response_cache_enabled_ && !request_coalescing_enabled_) {
+    return scheduler_->Enqueue(request);
+  }
+
+  INFER_STATS_DECL_TIMESTAMP(cache_start_ns);
+
+  // The request is identified by the hash of its normalized form. The
+  // normalized form itself is only built if the response is not
+  // cached, and is used to tell apart requests with the same hash.
+  uint64_t hash;
+  if (!HashRequest(*request, &hash)) {
+    return scheduler_->Enqueue(request);
+  }
+
+  if (response_cache_enabled_) {
+    const InferenceRequest& lrequest = *request;
+    std::shared_ptr<const ResponseCache::Response> cached;
+    ResponseCache::Global()->Lookup(
+        this, hash,
+        [&lrequest](const std::string& normalized) {
+          return MatchRequest(lrequest, normalized);
+        },
+        &cached);
+    if (cached != nullptr) {
+      // The request may be owned by an object that is released by the
+      // response callback (for example an ensemble step), so take
+      // ownership of the request before responding.
+      std::unique_ptr<InferenceRequest> lrequest = std::move(request);
+      RespondWithCopy(std::move(lrequest), *cached, false /* coalesced */);
+      return Status::Success;
+    }
+  }
+
+  // If an identical request is already queued or executing then the
+  // request waits for that response instead of executing the model
+  // again. Only requests with the same priority and timeout are
+  // coalesced, so the request that executes is scheduled no later
+  // than the requests waiting for its response would have been.
+  if (request_coalescing_enabled_) {
+    std::lock_guard<std::mutex> lock(coalesce_mu_);
+    auto range = coalesced_requests_.equal_range(hash);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+      const InflightState* leader = itr->second.leader_;
+      if ((leader->priority_ == request->Priority()) &&
+          (leader->timeout_us_ == request->TimeoutMicroseconds()) &&
+          MatchRequest(*request, leader->request_)) {
+        request->CaptureQueueStartNs();
+        itr->second.followers_.emplace_back(std::move(request));
+        return Status::Success;
+      }
+    }
+  }
+
+  std::string normalized;
+  NormalizeRequest(*request, &normalized);
+
+  // Intercept the response of the request so that it can be inserted
+  // into the cache and sent to the coalesced requests. The original
+  // response callback is restored when the request is released so
+  // that the request can be reused.
+  const InferenceResponseFactory& factory = request->ResponseFactory();
+  const ResponseAllocator* allocator = factory.Allocator();
+  void* alloc_userp = factory.AllocatorUserp();
+  TRITONSERVER_InferenceResponseCompleteFn_t response_fn = factory.ResponseFn();
+  void* response_userp = factory.ResponseUserp();
+
+  InflightState* state = new InflightState{
+      this,
+      hash,
+      std::move(normalized),
+      request->Priority(),
+      request->TimeoutMicroseconds(),
+      response_fn,
+      response_userp,
+      0};
+#ifdef TRITON_ENABLE_STATS
+  INFER_STATS_DECL_TIMESTAMP(cache_end_ns);
+  state->cache_duration_ns_ = cache_end_ns - cache_start_ns;
+#endif  // TRITON_ENABLE_STATS
+
+  // Identical requests received from now on wait for the response of
+  // this request. An identical request received since the lookup above
+  // is executed on its own.
+  if (request_coalescing_enabled_) {
+    std::lock_guard<std::mutex> lock(coalesce_mu_);
+    coalesced_requests_.emplace(hash, CoalescedRequests{state, {}});
+  }
+
+  InferenceRequest* raw_request = request.get();
+  request->SetResponseCallback(
+      allocator, alloc_userp, InflightResponseComplete, state);
+  request->AddInternalReleaseCallback(
+      [raw_request, allocator, alloc_userp, response_fn, response_userp]() {
+        raw_request->SetResponseCallback(
+            allocator, alloc_userp, response_fn, response_userp);
+      });
+
+  Status status = scheduler_->Enqueue(request);
+  if (!status.IsOk()) {
+    request->SetResponseCallback(
+        allocator, alloc_userp, response_fn, response_userp);
+    if (request_coalescing_enabled_) {
+      ReleaseCoalescedRequests(state, nullptr /* response */);
+    }
+    delete state;
+  }
+
+  return status;
+}
+
+Status
+InferenceBackend::Enqueue(
+    std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  if (!response_cache_enabled_ && !request_coalescing_enabled_) {
+    return scheduler_->EnqueueRequests(requests);
+  }
+
+  for (auto& request : requests) {
+    RETURN_IF_ERROR(Enqueue(request));
+  }
+
+  return Status::Success;
+}
+
+Status
+InferenceBackend::InitResponseReuse()
+{
+  bool response_cache = false;
+  RETURN_IF_ERROR(
+      GetBoolParameter(config_, kResponseCacheParameter, &response_cache));
+  bool request_coalescing = false;
+  RETURN_IF_ERROR(GetBoolParameter(
+      config_, kRequestCoalescingParameter, &request_coalescing));
+
+  if (response_cache) {
+    RETURN_IF_ERROR(ValidateResponseReuse(config_, kResponseCacheParameter));
+    if (ResponseCache::Global() == nullptr) {
+      LOG_WARNING << "response cache is enabled for model '" << Name()
+                  << "' but the server response cache is disabled, see "
+                     "--response-cache-byte-size";
+      response_cache = false;
+    }
+  }
+  if (request_coalescing) {
+    RETURN_IF_ERROR(
+        ValidateResponseReuse(config_, kRequestCoalescingParameter));
+  }
+  if (!response_cache && !request_coalescing) {
+    return Status::Success;
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if (Metrics::Enabled()) {
+    RETURN_IF_ERROR(MetricModelReporter::Create(
+        Name(), Version(), -1 /* device */, config_.metric_tags(),
+        &metric_reporter_));
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  if (response_cache) {
+    ResponseCache::Global()->AddOwner(this, [this]() {
+#ifdef TRITON_ENABLE_STATS
+      stats_aggregator_.UpdateCacheEviction(metric_reporter_.get());
+#endif  // TRITON_ENABLE_STATS
+    });
+    response_cache_enabled_ = true;
+    LOG_VERBOSE(1) << "response cache enabled for model '" << Name() << "'";
+  }
+  if (request_coalescing) {
+    request_coalescing_enabled_ = true;
+    LOG_VERBOSE(1) << "request coalescing enabled for model '" << Name()
+                   << "'";
+  }
+
+  return Status::Success;
+}
+
+void
+InferenceBackend::RespondWithCopy(
+    std::unique_ptr<InferenceRequest>&& request,
+    const ResponseCache::Response& copy, const bool coalesced)
+{
+  std::unique_ptr<InferenceResponse> response;
+  Status status = request->ResponseFactory().CreateResponse(&response);
+  if (!status.IsOk()) {
+    InferenceRequest::RespondIfError(request, status, true /* release */);
+    return;
+  }
+
+  for (const auto& coutput : copy.outputs_) {
+    InferenceResponse::Output* output;
+    status = response->AddOutput(
+        coutput.name_, coutput.datatype_, coutput.shape_, &output);
+    if (!status.IsOk()) {
+      break;
+    }
+    if (coutput.data_.empty()) {
+      continue;
+    }
+
+    void* buffer;
+    TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+    int64_t memory_type_id = 0;
+    status = output->AllocateDataBuffer(
+        &buffer, coutput.data_.size(), &memory_type, &memory_type_id);
+    if (!status.IsOk()) {
+      break;
+    }
+
+    bool cuda_used = false;
+    status = CopyBuffer(
+        coutput.name_, TRITONSERVER_MEMORY_CPU, 0 /* src_memory_type_id */,
+        memory_type, memory_type_id, coutput.data_.size(),
+        coutput.data_.data(), buffer, nullptr /* cuda_stream */, &cuda_used);
+    if (!status.IsOk()) {
+      break;
+    }
+#ifdef TRITON_ENABLE_GPU
+    if (cuda_used) {
+      cudaStreamSynchronize(nullptr);
+    }
+#endif  // TRITON_ENABLE_GPU
+  }
+
+  if (status.IsOk()) {
+    LOG_STATUS_ERROR(
+        InferenceResponse::Send(
+            std::move(response), TRITONSERVER_RESPONSE_COMPLETE_FINAL),
+        "failed to send copied response");
+  } else {
+    LOG_STATUS_ERROR(
+        InferenceResponse::SendWithStatus(
+            std::move(response), TRITONSERVER_RESPONSE_COMPLETE_FINAL,
+            status),
+        "failed to send copied response");
+  }
+
+  // Releasing the request may release the last reference to the
+  // backend, so report statistics first.
+#ifdef TRITON_ENABLE_STATS
+  INFER_STATS_DECL_TIMESTAMP(request_end_ns);
+  if (coalesced) {
+    stats_aggregator_.UpdateCoalesced(
+        metric_reporter_.get(), std::max(1U, request->BatchSize()),
+        request->RequestStartNs(), request_end_ns);
+  } else {
+    stats_aggregator_.UpdateCacheHit(
+        metric_reporter_.get(), std::max(1U, request->BatchSize()),
+        request->RequestStartNs(), request_end_ns);
+  }
+#endif  // TRITON_ENABLE_STATS
+
+  InferenceRequest::Release(
+      std::move(request), TRITONSERVER_REQUEST_RELEASE_ALL);
+}
+
+void
+InferenceBackend::ReleaseCoalescedRequests(
+    const InflightState* leader, const ResponseCache::Response* response)
+{
+  std::vector<std::unique_ptr<InferenceRequest>> requests;
+  {
+    std::lock_guard<std::mutex> lock(coalesce_mu_);
+    auto range = coalesced_requests_.equal_range(leader->hash_);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+      if (itr->second.leader_ == leader) {
+        requests.swap(itr->second.followers_);
+        coalesced_requests_.erase(itr);
+        break;
+      }
+    }
+  }
+
+  static Status rejected_status =
+      Status(Status::Code::UNAVAILABLE, "Request timeout expired");
+  static Status cancelled_status =
+      Status(Status::Code::UNAVAILABLE, "Request was cancelled");
+  const uint64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  for (auto& request : requests) {
+    // There is no client waiting for the response of a cancelled
+    // request.
+    if (request->IsCancelled()) {
+      InferenceRequest::RespondIfError(
+          request, cancelled_status, true /* release_request */);
+      continue;
+    }
+
+    // The request was received after the request whose response it
+    // shares and has the same timeout, so that request was scheduled
+    // before the timeout of this request expired.
+    if (response != nullptr) {
+      RespondWithCopy(std::move(request), *response, true /* coalesced */);
+      continue;
+    }
+
+    // There is no successful response to share so execute the request,
+    // within what is left of its timeout.
+    const uint64_t timeout_us = request->TimeoutMicroseconds();
+    if (timeout_us != 0) {
+      const uint64_t waited_us = (now_ns - request->QueueStartNs()) / 1000;
+      if (waited_us >= timeout_us) {
+        InferenceRequest::RespondIfError(
+            request, rejected_status, true /* release_request */);
+        continue;
+      }
+      request->SetTimeoutMicroseconds(timeout_us - waited_us);
+    }
+
+    Status status = scheduler_->Enqueue(request);
+    if (!status.IsOk()) {
+      InferenceRequest::RespondIfError(
+          request, status, true /* release_request */);
+    }
+  }
+}
+
+void
+InferenceBackend::InflightResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  InflightState* state = reinterpret_cast<InflightState*>(userp);
+  InferenceBackend* backend = state->backend_;
+  TRITONSERVER_InferenceResponseCompleteFn_t response_fn = state->response_fn_;
+  void* response_userp = state->response_userp_;
+
+  // Only the final response is reused. The backend is kept alive by
+  // the response.
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+    response_fn(response, flags, response_userp);
+    return;
+  }
+
+  std::shared_ptr<ResponseCache::Response> copy;
+  if (response != nullptr) {
+    INFER_STATS_DECL_TIMESTAMP(copy_start_ns);
+
+    const InferenceResponse* lresponse =
+        reinterpret_cast<InferenceResponse*>(response);
+    if (lresponse->ResponseStatus().IsOk()) {
+      copy = std::make_shared<ResponseCache::Response>();
+      Status status = CopyResponse(*lresponse, copy.get());
+      if (!status.IsOk()) {
+        LOG_VERBOSE(1) << "failed to copy response for model '"
+                       << backend->Name() << "': " << status.AsString();
+        copy.reset();
+      }
+    }
+
+    if ((copy != nullptr) && backend->response_cache_enabled_) {
+      // The normalized request is still needed to find the coalesced
+      // requests.
+      std::string normalized;
+      if (backend->request_coalescing_enabled_) {
+        normalized = state->request_;
+      } else {
+        normalized = std::move(state->request_);
+      }
+      Status status = ResponseCache::Global()->Insert(
+          backend, state->hash_, std::move(normalized),
+          std::shared_ptr<const ResponseCache::Response>(copy));
+      if (!status.IsOk()) {
+        LOG_VERBOSE(1) << "failed to cache response for model '"
+                       << backend->Name() << "': " << status.AsString();
+      }
+    }
+
+#ifdef TRITON_ENABLE_STATS
+    INFER_STATS_DECL_TIMESTAMP(copy_end_ns);
+    state->cache_duration_ns_ += copy_end_ns - copy_start_ns;
+#endif  // TRITON_ENABLE_STATS
+  }
+
+  if (backend->request_coalescing_enabled_) {
+    backend->ReleaseCoalescedRequests(state, copy.get());
+  }
+
+#ifdef TRITON_ENABLE_STATS
+  if (backend->response_cache_enabled_) {
+    backend->stats_aggregator_.UpdateCacheMiss(
+        backend->metric_reporter_.get(), state->cache_duration_ns_);
+  }
+#endif  // TRITON_ENABLE_STATS
+
+  delete state;
+  response_fn(response, flags, response_userp);
+}
+
 void
 InferenceBackend::Run(
     uint32_t runner_idx,
@@ -329,9 +1313,19 @@ InferenceBackend::WarmUp(uint32_t runner_idx, WarmupData& sample)
 }
 
 Status
-InferenceBackend::GenerateWarmupData(std::vector<WarmupData>* samples)
+InferenceBackend::SetInstanceCount(const uint32_t count)
+{
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "instance count can't be changed for model '" + Name() + "'");
+}
+
+Status
+InferenceBackend::GenerateWarmupData(
+    const uint32_t runner_cnt, std::vector<std::vector<WarmupData>>* samples)
 {
   samples->clear();
+  samples->resize(runner_cnt);
   for (const auto& warmup_setting : config_.model_warmup()) {
     if (warmup_setting.batch_size() == 0) {
       LOG_VERBOSE(1) << "Skipping batch 0 warmup sample '"
@@ -342,10 +1336,12 @@ InferenceBackend::GenerateWarmupData(std::vector<WarmupData>* samples)
                    << warmup_setting.name() << "'";
 
     // Two passes. First pass to get max byte size for synthetic
-    // data. Second pass to add original inputs and override inputs
-    // for control inputs.
+    // data and to read the data provided from files. Second pass to
+    // add original inputs and override inputs for control inputs.
     int64_t max_zero_byte_size = 0;
     int64_t max_random_byte_size = 0;
+    std::unordered_map<std::string, std::shared_ptr<std::string>>
+        provided_data;
     for (const auto& input_meta : warmup_setting.inputs()) {
       auto element_count = GetElementCount(input_meta.second.dims());
       if (element_count == -1) {
@@ -376,130 +1372,148 @@ InferenceBackend::GenerateWarmupData(std::vector<WarmupData>* samples)
           }
           break;
         }
+        case inference::ModelWarmup_Input::InputDataTypeCase::kInputDataFile: {
+          std::shared_ptr<std::string> input_data(new std::string());
+          RETURN_IF_ERROR(ReadTextFile(
+              JoinPath({model_dir_, kWarmupDataFolder,
+                        input_meta.second.input_data_file()}),
+              input_data.get()));
+          if ((input_meta.second.data_type() !=
+               inference::DataType::TYPE_STRING) &&
+              (((size_t)batch_byte_size) > input_data->size())) {
+            return Status(
+                Status::Code::INVALID_ARG,
+                "warmup setting expects " + std::to_string(batch_byte_size) +
+                    " bytes, but the data "
+                    "provided from " +
+                    input_meta.second.input_data_file() + "only has " +
+                    std::to_string(input_data->size()) + " bytes");
+          }
+          provided_data.emplace(input_meta.first, std::move(input_data));
+          break;
+        }
         default:
           break;
       }
     }
 
-    samples->emplace_back(warmup_setting.name());
-    auto& warmup_data = samples->back();
     // Create buffers for synthetic data
     TRITONSERVER_MemoryType type;
     int64_t type_id;
-    warmup_data.zero_data_.reset(new AllocatedMemory(
+    std::shared_ptr<AllocatedMemory> zero_data(new AllocatedMemory(
         max_zero_byte_size, TRITONSERVER_MEMORY_CPU_PINNED /* memory_type */,
         0 /* memory_type_id */));
-    char* zero_buffer = warmup_data.zero_data_->MutableBuffer(&type, &type_id);
+    char* zero_buffer = zero_data->MutableBuffer(&type, &type_id);
     memset(zero_buffer, 0, max_zero_byte_size);
 
-    warmup_data.random_data_.reset(new AllocatedMemory(
+    std::shared_ptr<AllocatedMemory> random_data(new AllocatedMemory(
         max_random_byte_size, TRITONSERVER_MEMORY_CPU_PINNED /* memory_type */,
         0 /* memory_type_id */));
-    char* random_buffer =
-        warmup_data.random_data_->MutableBuffer(&type, &type_id);
+    char* random_buffer = random_data->MutableBuffer(&type, &type_id);
     for (int64_t offset = 0; offset < max_random_byte_size; offset++) {
       random_buffer[offset] = rand();
     }
 
-    // Prepare the inference request for the specified sample.
-    for (size_t cnt = 0; cnt < warmup_setting.batch_size(); cnt++) {
-      warmup_data.requests_.emplace_back(new InferenceRequest(this, Version()));
-      auto& lrequest = warmup_data.requests_.back();
-
-      // Second pass to prepare original inputs.
-      std::vector<std::shared_ptr<InferenceRequest::Input>> input_sps;
-      for (const auto& input_meta : warmup_setting.inputs()) {
-        auto batch1_element_count = GetElementCount(input_meta.second.dims());
-        auto batch_byte_size =
-            batch1_element_count *
-            GetDataTypeByteSize(input_meta.second.data_type());
-        if (batch_byte_size == 0) {
-          batch_byte_size = batch1_element_count * sizeof(int32_t);
-        }
+    for (auto& runner_samples : *samples) {
+      runner_samples.emplace_back(warmup_setting.name());
+      auto& warmup_data = runner_samples.back();
+      warmup_data.zero_data_ = zero_data;
+      warmup_data.random_data_ = random_data;
+      for (const auto& pr : provided_data) {
+        warmup_data.provided_data_.push_back(pr.second);
+      }
+
+      // Prepare the inference request for the specified sample.
+      for (size_t cnt = 0; cnt < warmup_setting.batch_size(); cnt++) {
+        warmup_data.requests_.emplace_back(
+            new InferenceRequest(this, Version()));
+        auto& lrequest = warmup_data.requests_.back();
 
-        const char* allocated_ptr;
-        switch (input_meta.second.input_data_type_case()) {
-          case inference::ModelWarmup_Input::InputDataTypeCase::kZeroData:
-            allocated_ptr = zero_buffer;
-            break;
-          case inference::ModelWarmup_Input::InputDataTypeCase::kRandomData: {
-            if (input_meta.second.data_type() ==
-                inference::DataType::TYPE_STRING) {
+        // Second pass to prepare original inputs.
+        std::vector<std::shared_ptr<InferenceRequest::Input>> input_sps;
+        for (const auto& input_meta : warmup_setting.inputs()) {
+          auto batch1_element_count = GetElementCount(input_meta.second.dims());
+          auto batch_byte_size =
+              batch1_element_count *
+              GetDataTypeByteSize(input_meta.second.data_type());
+          if (batch_byte_size == 0) {
+            batch_byte_size = batch1_element_count * sizeof(int32_t);
+          }
+
+          const char* allocated_ptr;
+          switch (input_meta.second.input_data_type_case()) {
+            case inference::ModelWarmup_Input::InputDataTypeCase::kZeroData:
               allocated_ptr = zero_buffer;
-            } else {
-              allocated_ptr = random_buffer;
+              break;
+            case inference::ModelWarmup_Input::InputDataTypeCase::
+                kRandomData: {
+              if (input_meta.second.data_type() ==
+                  inference::DataType::TYPE_STRING) {
+                allocated_ptr = zero_buffer;
+              } else {
+                allocated_ptr = random_buffer;
+              }
+              break;
             }
-            break;
-          }
-          case inference::ModelWarmup_Input::InputDataTypeCase::
-              kInputDataFile: {
-            // For data provided from file, we can set buffer in first pass
-            warmup_data.provided_data_.emplace_back(new std::string());
-            auto input_data = warmup_data.provided_data_.back().get();
-            RETURN_IF_ERROR(ReadTextFile(
-                JoinPath({model_dir_, kWarmupDataFolder,
-                          input_meta.second.input_data_file()}),
-                input_data));
-            if (input_meta.second.data_type() ==
-                inference::DataType::TYPE_STRING) {
-              batch_byte_size = input_data->size();
-            } else if (((size_t)batch_byte_size) > input_data->size()) {
+            case inference::ModelWarmup_Input::InputDataTypeCase::
+                kInputDataFile: {
+              // The data provided from file is read in the first pass
+              const auto& input_data = provided_data[input_meta.first];
+              if (input_meta.second.data_type() ==
+                  inference::DataType::TYPE_STRING) {
+                batch_byte_size = input_data->size();
+              }
+              allocated_ptr = input_data->data();
+              break;
+            }
+            default:
               return Status(
                   Status::Code::INVALID_ARG,
-                  "warmup setting expects " + std::to_string(batch_byte_size) +
-                      " bytes, but the data "
-                      "provided from " +
-                      input_meta.second.input_data_file() + "only has " +
-                      std::to_string(input_data->size()) + " bytes");
-            }
-            allocated_ptr = input_data->data();
-            break;
+                  "warmup setting expects input '" + input_meta.first +
+                      "' to have input_data_type set");
           }
-          default:
-            return Status(
-                Status::Code::INVALID_ARG, "warmup setting expects input '" +
-                                               input_meta.first +
-                                               "' to have input_data_type set");
-        }
 
-        const inference::ModelInput* input_config;
-        bool is_original_input =
-            GetInput(input_meta.first, &input_config).IsOk();
-        InferenceRequest::Input* input = nullptr;
-        std::vector<int64_t> input_meta_shape;
-        // Append batch size only if the model supports batching
-        // and not control inpt.
-        if ((config_.max_batch_size() != 0) && is_original_input) {
-          input_meta_shape.push_back(1);
-        }
-        for (auto d : input_meta.second.dims()) {
-          input_meta_shape.push_back(d);
+          const inference::ModelInput* input_config;
+          bool is_original_input =
+              GetInput(input_meta.first, &input_config).IsOk();
+          InferenceRequest::Input* input = nullptr;
+          std::vector<int64_t> input_meta_shape;
+          // Append batch size only if the model supports batching
+          // and not control inpt.
+          if ((config_.max_batch_size() != 0) && is_original_input) {
+            input_meta_shape.push_back(1);
+          }
+          for (auto d : input_meta.second.dims()) {
+            input_meta_shape.push_back(d);
+          }
+          if (is_original_input) {
+            RETURN_IF_ERROR(lrequest->AddOriginalInput(
+                input_meta.first, input_meta.second.data_type(),
+                input_meta_shape, &input));
+          } else {
+            input_sps.emplace_back();
+            RETURN_IF_ERROR(lrequest->AddOverrideInput(
+                input_meta.first, input_meta.second.data_type(),
+                (config_.max_batch_size() != 0 ? 1 : 0), input_meta_shape,
+                &input_sps.back()));
+            input = input_sps.back().get();
+          }
+          RETURN_IF_ERROR(input->AppendData(
+              allocated_ptr, batch_byte_size,
+              TRITONSERVER_MEMORY_CPU /* memory_type */,
+              0 /* memory_type_id */));
         }
-        if (is_original_input) {
-          RETURN_IF_ERROR(lrequest->AddOriginalInput(
-              input_meta.first, input_meta.second.data_type(), input_meta_shape,
-              &input));
-        } else {
-          input_sps.emplace_back();
-          RETURN_IF_ERROR(lrequest->AddOverrideInput(
-              input_meta.first, input_meta.second.data_type(),
-              (config_.max_batch_size() != 0 ? 1 : 0), input_meta_shape,
-              &input_sps.back()));
-          input = input_sps.back().get();
+
+        RETURN_IF_ERROR(lrequest->PrepareForInference());
+        // Override inputs must be added after PrepareForInference() is
+        // called
+        for (const auto& sp : input_sps) {
+          RETURN_IF_ERROR(lrequest->AddOverrideInput(sp));
         }
-        RETURN_IF_ERROR(input->AppendData(
-            allocated_ptr, batch_byte_size,
-            TRITONSERVER_MEMORY_CPU /* memory_type */, 0 /* memory_type_id */));
-      }
 
-      RETURN_IF_ERROR(lrequest->PrepareForInference());
-      // Override inputs must be added after PrepareForInference() is called
-      for (const auto& sp : input_sps) {
-        RETURN_IF_ERROR(lrequest->AddOverrideInput(sp));
+        RETURN_IF_ERROR(lrequest->SetResponseCallback(
+            &warmup_allocator, nullptr, WarmupResponseComplete, nullptr));
       }
-
-      RETURN_IF_ERROR(lrequest->SetResponseCallback(
-          &warmup_allocator, nullptr, WarmupResponseComplete, nullptr));
     }
   }
 
@@ -25,10 +25,17 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "model_config.pb.h"
 #include "src/core/backend_context.h"
 #include "src/core/infer_stats.h"
 #include "src/core/label_provider.h"
+#include "src/core/response_cache.h"
 #include "src/core/scheduler.h"
 #include "src/core/status.h"
 
@@ -78,6 +85,7 @@ namespace nvidia { namespace inferenceserver {
 #endif  // TRITON_ENABLE_STATS
 
 class InferenceRequest;
+class MetricModelReporter;
 
 //
 // Interface for backends that handle inference requests.
@@ -85,10 +93,11 @@ class InferenceRequest;
 class InferenceBackend {
  public:
   explicit InferenceBackend(const double min_compute_capability)
-      : min_compute_capability_(min_compute_capability)
+      : min_compute_capability_(min_compute_capability),
+        response_cache_enabled_(false), request_coalescing_enabled_(false)
   {
   }
-  virtual ~InferenceBackend() {}
+  virtual ~InferenceBackend();
 
   // Get the name of model being served.
   const std::string& Name() const { return config_.name(); }
@@ -117,6 +126,9 @@ class InferenceBackend {
   Status GetOutput(
       const std::string& name, const inference::ModelOutput** output) const;
 
+  // Get the names of all the outputs of the model.
+  const std::set<std::string>& OutputNames() const { return output_names_; }
+
   // Get a label provider for the model.
   const std::shared_ptr<LabelProvider>& GetLabelProvider() const
   {
@@ -130,11 +142,22 @@ class InferenceBackend {
   // Enqueue a request for execution. If Status::Success is returned
   // then the backend has taken ownership of the request object and so
   // 'request' will be nullptr. If non-success is returned then the
-  // caller still retains ownership of 'request'.
-  Status Enqueue(std::unique_ptr<InferenceRequest>& request)
-  {
-    return scheduler_->Enqueue(request);
-  }
+  // caller still retains ownership of 'request'. If the model
+  // enables the response cache and the response for 'request' is
+  // cached, or if the model enables request coalescing and an
+  // identical request is in progress, then the request is responded
+  // to without being passed to the scheduler.
+  Status Enqueue(std::unique_ptr<InferenceRequest>& request);
+
+  // Enqueue a set of requests for execution. The backend takes
+  // ownership of each request that is enqueued, setting the
+  // corresponding entry of 'requests' to nullptr. If non-success is
+  // returned then the caller still retains ownership of the requests
+  // that were not enqueued. The requests are passed to the scheduler
+  // together unless the model enables the response cache or request
+  // coalescing, in which case each request is enqueued as described
+  // above.
+  Status Enqueue(std::vector<std::unique_ptr<InferenceRequest>>& requests);
 
   uint32_t DefaultPriorityLevel() const { return default_priority_level_; }
 
@@ -145,6 +168,11 @@ class InferenceBackend {
     return config_.model_transaction_policy().decoupled();
   }
 
+  // Change the number of instances that execute the model to 'count'
+  // without reloading the model. Returns UNSUPPORTED if the instance
+  // count of the model can't be changed.
+  virtual Status SetInstanceCount(const uint32_t count);
+
  protected:
   struct WarmupData {
     WarmupData(const std::string& sample_name) : sample_name_(sample_name) {}
@@ -152,10 +180,11 @@ class InferenceBackend {
     std::string sample_name_;
     std::vector<std::unique_ptr<InferenceRequest>> requests_;
 
-    // Placeholder for input data
-    std::unique_ptr<AllocatedMemory> zero_data_;
-    std::unique_ptr<AllocatedMemory> random_data_;
-    std::vector<std::unique_ptr<std::string>> provided_data_;
+    // Placeholder for input data. The data is read-only and is shared
+    // by the samples of all runners.
+    std::shared_ptr<AllocatedMemory> zero_data_;
+    std::shared_ptr<AllocatedMemory> random_data_;
+    std::vector<std::shared_ptr<std::string>> provided_data_;
   };
 
   // Run model on the context associated with 'runner_idx' to execute
@@ -178,9 +207,13 @@ class InferenceBackend {
   Status SetScheduler(std::unique_ptr<Scheduler> scheduler);
 
   // Set the scheduler based on the model configuration. The scheduler
-  // can only be set once for a backend.
+  // can only be set once for a backend. If 'warmup_concurrency' is
+  // greater than 1 up to that many runners are initialized and warmed
+  // up at the same time before the scheduler is created, so 'OnInit'
+  // may be called more than once for a runner.
   Status SetConfiguredScheduler(
-      const uint32_t runner_cnt, const Scheduler::StandardInitFunc& OnInit,
+      const uint32_t runner_cnt, const uint32_t warmup_concurrency,
+      const Scheduler::StandardInitFunc& OnInit,
       const Scheduler::StandardRunFunc& OnRun);
 
   // Get the raw pointer to the scheduler of this backend.
@@ -192,8 +225,59 @@ class InferenceBackend {
   std::unique_ptr<Scheduler> scheduler_;
 
  private:
-  // Generate warmup data
-  Status GenerateWarmupData(std::vector<WarmupData>* samples);
+  // The state of a request whose response is to be inserted into the
+  // response cache or sent to the requests coalesced with it.
+  struct InflightState {
+    InferenceBackend* backend_;
+    uint64_t hash_;
+    std::string request_;
+    uint32_t priority_;
+    uint64_t timeout_us_;
+    TRITONSERVER_InferenceResponseCompleteFn_t response_fn_;
+    void* response_userp_;
+    uint64_t cache_duration_ns_;
+  };
+
+  // Generate the warmup samples of each of 'runner_cnt' runners. The
+  // input data of a sample is generated once and shared by the
+  // samples of all runners, only the requests are created for each
+  // runner.
+  Status GenerateWarmupData(
+      const uint32_t runner_cnt,
+      std::vector<std::vector<WarmupData>>* samples);
+
+  // Enable the response cache and request coalescing if requested
+  // in the model configuration.
+  Status InitResponseReuse();
+
+  // Send a copy of a response as the response for 'request' and
+  // release 'request'. 'coalesced' indicates if the copy is from a
+  // coalesced request or from the response cache.
+  void RespondWithCopy(
+      std::unique_ptr<InferenceRequest>&& request,
+      const ResponseCache::Response& copy, const bool coalesced);
+
+  // The identical requests waiting for the response of the request
+  // of 'leader_'.
+  struct CoalescedRequests {
+    const InflightState* leader_;
+    std::vector<std::unique_ptr<InferenceRequest>> followers_;
+  };
+
+  // Respond to the requests coalesced with the request of 'leader'
+  // with 'response'. If 'response' is nullptr then pass the requests
+  // to the scheduler instead. Cancelled requests, and requests whose
+  // timeout expired while waiting, are rejected.
+  void ReleaseCoalescedRequests(
+      const InflightState* leader, const ResponseCache::Response* response);
+
+  // Response callback of requests passed to the scheduler when the
+  // response cache or request coalescing is enabled. Reuses the final
+  // response and then invokes the original response callback of the
+  // request.
+  static void InflightResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
 
   // The minimum supported CUDA compute capability.
   const double min_compute_capability_;
@@ -216,6 +300,9 @@ class InferenceBackend {
   // Map from output name to the model configuration for that output.
   std::unordered_map<std::string, inference::ModelOutput> output_map_;
 
+  // The names of all the outputs of the model.
+  std::set<std::string> output_names_;
+
   // Path to model
   std::string model_dir_;
 
@@ -224,6 +311,21 @@ class InferenceBackend {
 
   // The largest priority value for the backend.
   uint32_t max_priority_level_;
+
+  // Whether the responses of the model are cached in the global
+  // response cache.
+  bool response_cache_enabled_;
+
+  // Whether identical requests are coalesced, and the requests
+  // waiting for the response of an identical request that is queued
+  // or executing, keyed by the hash of the normalized request.
+  bool request_coalescing_enabled_;
+  std::mutex coalesce_mu_;
+  std::unordered_multimap<uint64_t, CoalescedRequests> coalesced_requests_;
+
+  // The reporter for the response cache and request coalescing
+  // metrics.
+  std::shared_ptr<MetricModelReporter> metric_reporter_;
 };
 
 }}  // namespace nvidia::inferenceserver
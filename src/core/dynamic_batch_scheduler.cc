@@ -31,16 +31,194 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <cstring>
 #include "src/core/constants.h"
+#include "src/core/cuda_utils.h"
 #include "src/core/logging.h"
+#include "src/core/memory.h"
 #include "src/core/model_config.h"
+#include "src/core/numa_utils.h"
 #include "src/core/nvtx.h"
+#include "src/core/timer_wheel.h"
 
 namespace nvidia { namespace inferenceserver {
 
+namespace {
+
+// Return in 'shape' the shape of 'input' with each dimension that is
+// listed for the input in 'shape_bucketing' rounded up to the smallest
+// bucket length that is not less than the dimension. Dimensions that
+// are larger than all bucket lengths are not changed.
+void
+BucketShape(
+    const DynamicBatchScheduler::ShapeBucketing& shape_bucketing,
+    const InferenceRequest::Input& input, std::vector<int64_t>* shape)
+{
+  *shape = input.Shape();
+  if (shape_bucketing.lengths_.empty()) {
+    return;
+  }
+
+  const auto itr = shape_bucketing.variable_dims_.find(input.Name());
+  if (itr == shape_bucketing.variable_dims_.end()) {
+    return;
+  }
+
+  for (const size_t dim : itr->second) {
+    if (dim < shape->size()) {
+      const auto litr = shape_bucketing.lengths_.lower_bound((*shape)[dim]);
+      if (litr != shape_bucketing.lengths_.end()) {
+        (*shape)[dim] = *litr;
+      }
+    }
+  }
+}
+
+// Copy the contents of 'input', whose shape including the batch
+// dimension is 'shape', into 'padded', whose shape is 'padded_shape',
+// and fill the padding with zeros.
+Status
+PadInput(
+    const InferenceRequest::Input& input, const std::vector<int64_t>& shape,
+    const std::vector<int64_t>& padded_shape, char* padded)
+{
+  const size_t element_size = GetDataTypeByteSize(input.DType());
+  const size_t byte_size = GetElementCount(shape) * element_size;
+  const size_t padded_byte_size = GetElementCount(padded_shape) * element_size;
+
+  // Use the input data directly if it is a single buffer in CPU
+  // memory, otherwise gather it into a contiguous buffer first.
+  const auto& data = input.Data();
+  const char* src = nullptr;
+  std::vector<char> gathered;
+  size_t src_byte_size = 0;
+  TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+  int64_t memory_type_id = 0;
+  if (data->BufferCount() == 1) {
+    src = data->BufferAt(0, &src_byte_size, &memory_type, &memory_type_id);
+  }
+  if ((data->BufferCount() != 1) ||
+      (memory_type == TRITONSERVER_MEMORY_GPU)) {
+    gathered.resize(data->TotalByteSize());
+    src_byte_size = 0;
+    bool cuda_used = false;
+    for (size_t idx = 0; idx < data->BufferCount(); ++idx) {
+      size_t buffer_byte_size;
+      const char* buffer =
+          data->BufferAt(idx, &buffer_byte_size, &memory_type, &memory_type_id);
+      bool buffer_cuda_used = false;
+      RETURN_IF_ERROR(CopyBuffer(
+          input.Name(), memory_type, memory_type_id, TRITONSERVER_MEMORY_CPU,
+          0 /* dst_memory_type_id */, buffer_byte_size, buffer,
+          &gathered[src_byte_size], nullptr /* cuda_stream */,
+          &buffer_cuda_used));
+      cuda_used |= buffer_cuda_used;
+      src_byte_size += buffer_byte_size;
+    }
+#ifdef TRITON_ENABLE_GPU
+    if (cuda_used) {
+      cudaStreamSynchronize(nullptr);
+    }
+#endif  // TRITON_ENABLE_GPU
+    src = gathered.data();
+  }
+
+  if (src_byte_size != byte_size) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "unexpected byte size " + std::to_string(src_byte_size) +
+            " for input '" + input.Name() + "', expecting " +
+            std::to_string(byte_size));
+  }
+
+  memset(padded, 0, padded_byte_size);
+  if (byte_size == 0) {
+    return Status::Success;
+  }
+
+  // Copy the input one innermost row at a time, to the offset of the
+  // row in the padded shape.
+  const size_t dims = shape.size();
+  std::vector<size_t> padded_strides(dims, element_size);
+  for (size_t i = dims - 1; i > 0; --i) {
+    padded_strides[i - 1] = padded_strides[i] * padded_shape[i];
+  }
+
+  const size_t row_byte_size = shape[dims - 1] * element_size;
+  const size_t row_cnt = byte_size / row_byte_size;
+  std::vector<int64_t> index(dims, 0);
+  for (size_t row = 0; row < row_cnt; ++row) {
+    size_t offset = 0;
+    for (size_t i = 0; i < dims - 1; ++i) {
+      offset += index[i] * padded_strides[i];
+    }
+    memcpy(padded + offset, src + row * row_byte_size, row_byte_size);
+
+    for (size_t i = dims - 1; i > 0; --i) {
+      if (++index[i - 1] < shape[i - 1]) {
+        break;
+      }
+      index[i - 1] = 0;
+    }
+  }
+
+  return Status::Success;
+}
+
+// Send an error response for each request rejected by the queue
+// policy or cancelled while in the queue.
+void
+RespondRejectedRequests(
+    const std::shared_ptr<
+        std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>&
+        rejected_requests)
+{
+  if (rejected_requests == nullptr) {
+    return;
+  }
+
+  static Status rejected_status =
+      Status(Status::Code::UNAVAILABLE, "Request timeout expired");
+  static Status cancelled_status =
+      Status(Status::Code::UNAVAILABLE, "Request was cancelled");
+  for (auto& rejected_queue : *rejected_requests) {
+    for (auto& rejected_request : rejected_queue) {
+      InferenceRequest::RespondIfError(
+          rejected_request,
+          rejected_request->IsCancelled() ? cancelled_status : rejected_status,
+          true);
+    }
+  }
+}
+
+uint64_t
+SteadyClockNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Order of the requests in a shape bucket, the same order in which the
+// queue batches requests: by priority level and, within a level, the
+// requests that timed-out and are delayed after the other requests.
+bool
+HeldRequestBefore(
+    const PriorityQueue::HeldRequest& lhs,
+    const PriorityQueue::HeldRequest& rhs)
+{
+  if (lhs.level_idx_ != rhs.level_idx_) {
+    return lhs.level_idx_ < rhs.level_idx_;
+  }
+  return !lhs.delayed_ && rhs.delayed_;
+}
+
+}  // namespace
+
 DynamicBatchScheduler::DynamicBatchScheduler(
-    const uint32_t runner_id_start, const uint32_t runner_cnt,
-    const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
+    const int nice, const StandardInitFunc& OnInit,
+    const StandardWarmupFunc& OnWarmup,
     const StandardRunFunc& OnSchedule, const bool dynamic_batching_enabled,
     const int32_t max_batch_size,
     const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
@@ -48,24 +226,42 @@ DynamicBatchScheduler::DynamicBatchScheduler(
     const std::set<int32_t>& preferred_batch_sizes,
     const uint64_t max_queue_delay_microseconds,
     const inference::ModelQueuePolicy& default_queue_policy,
-    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map)
+    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map,
+    const ShapeBucketing& shape_bucketing, const bool earliest_deadline_first,
+    const uint64_t queue_latency_slo_us, SharedExecutor* executor,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter)
     : OnInit_(OnInit), OnWarmup_(OnWarmup), OnSchedule_(OnSchedule),
-      dynamic_batching_enabled_(dynamic_batching_enabled),
-      scheduler_thread_cnt_(runner_cnt), idle_scheduler_thread_cnt_(0),
-      queue_(default_queue_policy, priority_levels, queue_policy_map),
+      dynamic_batching_enabled_(dynamic_batching_enabled), nice_(nice),
+      idle_scheduler_thread_cnt_(0),
+      queue_(
+          default_queue_policy, priority_levels, queue_policy_map,
+          earliest_deadline_first),
+      earliest_deadline_first_(earliest_deadline_first), expected_exec_ns_(0),
+      queue_latency_slo_ns_(queue_latency_slo_us * 1000),
+      expected_inference_ns_(0), runner_cnt_(0), cumulative_exec_ns_(0),
+      executor_(executor), executor_state_(std::make_shared<ExecutorState>()),
+      dispatch_deadline_ns_(0),
       max_batch_size_((size_t)std::max(1, max_batch_size)),
       preferred_batch_sizes_(preferred_batch_sizes),
       pending_batch_delay_ns_(max_queue_delay_microseconds * 1000),
       pending_batch_size_(0), queued_batch_size_(0),
       next_preferred_batch_size_(0),
       enforce_equal_shape_tensors_(enforce_equal_shape_tensors),
-      preserve_ordering_(preserve_ordering)
+      shape_bucketing_(shape_bucketing), bucketed_cnt_(0),
+      preserve_ordering_(preserve_ordering), metric_reporter_(metric_reporter),
+      reported_pending_cnt_(0)
 {
   max_preferred_batch_size_ = 0;
   for (const auto size : preferred_batch_sizes_) {
     max_preferred_batch_size_ =
         std::max(max_preferred_batch_size_, (size_t)size);
   }
+
+  for (const auto& pr : enforce_equal_shape_tensors_) {
+    if (pr.second) {
+      shape_tensors_.insert(pr);
+    }
+  }
 }
 
 Status
@@ -78,6 +274,7 @@ DynamicBatchScheduler::Create(
     const bool preserve_ordering,
     const std::set<int32_t>& preferred_batch_sizes,
     const uint64_t max_queue_delay_microseconds,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter,
     std::unique_ptr<Scheduler>* scheduler)
 {
   inference::ModelDynamicBatching batcher_config;
@@ -90,7 +287,9 @@ DynamicBatchScheduler::Create(
   return Create(
       runner_id_start, runner_cnt, nice, OnInit, OnWarmup, OnSchedule,
       dynamic_batching_enabled, max_batch_size, enforce_equal_shape_tensors,
-      batcher_config, scheduler);
+      batcher_config, ShapeBucketing(), false /* earliest_deadline_first */,
+      0 /* queue_latency_slo_us */, nullptr /* executor */, metric_reporter,
+      scheduler);
 }
 
 Status
@@ -101,6 +300,9 @@ DynamicBatchScheduler::Create(
     const int32_t max_batch_size,
     const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
     const inference::ModelDynamicBatching& batcher_config,
+    const ShapeBucketing& shape_bucketing, const bool earliest_deadline_first,
+    const uint64_t queue_latency_slo_us, SharedExecutor* executor,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter,
     std::unique_ptr<Scheduler>* scheduler)
 {
   std::set<int32_t> preferred_batch_sizes;
@@ -109,36 +311,28 @@ DynamicBatchScheduler::Create(
   }
 
   DynamicBatchScheduler* dyna_sched = new DynamicBatchScheduler(
-      runner_id_start, runner_cnt, OnInit, OnWarmup, OnSchedule,
+      nice, OnInit, OnWarmup, OnSchedule,
       dynamic_batching_enabled, max_batch_size, enforce_equal_shape_tensors,
       batcher_config.preserve_ordering(), preferred_batch_sizes,
       batcher_config.max_queue_delay_microseconds(),
       batcher_config.default_queue_policy(), batcher_config.priority_levels(),
-      batcher_config.priority_queue_policy());
+      batcher_config.priority_queue_policy(), shape_bucketing,
+      earliest_deadline_first, queue_latency_slo_us, executor,
+      metric_reporter);
   std::unique_ptr<DynamicBatchScheduler> sched(dyna_sched);
 
-  // Create one scheduler thread for each requested runner. Associate
-  // each scheduler thread with a runner.
-  for (uint32_t c = 0; c < sched->scheduler_thread_cnt_; ++c) {
-    const uint32_t runner_id = runner_id_start + c;
-    std::promise<bool> init_state;
-    auto thread_exit = std::make_shared<std::atomic<bool>>(false);
-    sched->scheduler_threads_exit_.emplace_back(thread_exit);
-    sched->scheduler_threads_.emplace_back(new std::thread(
-        [dyna_sched, runner_id, nice, thread_exit, &init_state]() {
-          dyna_sched->SchedulerThread(
-              runner_id, nice, thread_exit, &init_state);
-        }));
-    if (!init_state.get_future().get()) {
-      if (sched->scheduler_threads_.back()->joinable()) {
-        sched->scheduler_threads_.back()->join();
-      }
-      sched->scheduler_threads_exit_.pop_back();
-      sched->scheduler_threads_.pop_back();
+  // Create one scheduler thread for each requested runner, or add the
+  // runner to the executor. Associate each scheduler thread with a
+  // runner. A runner that fails to initialize is not used.
+  for (uint32_t c = 0; c < runner_cnt; ++c) {
+    if (executor != nullptr) {
+      sched->StartExecutorRunner(runner_id_start + c);
+    } else {
+      sched->StartSchedulerThread(runner_id_start + c);
     }
   }
 
-  if (sched->scheduler_threads_.empty()) {
+  if (sched->runner_cnt_ == 0) {
     return Status(
         Status::Code::INTERNAL,
         "Initialization failed for all dynamic-batch scheduler threads");
@@ -151,11 +345,38 @@ DynamicBatchScheduler::Create(
 
 DynamicBatchScheduler::~DynamicBatchScheduler()
 {
+  // Wait for the executor tasks that are using the scheduler. The
+  // scheduler may be destroyed by a task, when the batch it executes
+  // releases the last reference to the backend, so the tasks of this
+  // thread are not waited for. Those tasks no longer use the
+  // scheduler once they see it is destroyed.
+  if (executor_ != nullptr) {
+    std::unique_lock<std::mutex> lock(executor_state_->mu_);
+    executor_state_->destroyed_ = true;
+    const std::thread::id self = std::this_thread::get_id();
+    executor_state_->cv_.wait(lock, [this, &self]() {
+      for (const auto& thread_id : executor_state_->inflight_threads_) {
+        if (thread_id != self) {
+          return false;
+        }
+      }
+      return true;
+    });
+
+    // Release the waiters of the runners that were removed while
+    // executing a batch.
+    for (auto& runner : executor_runners_) {
+      if (runner.exit_) {
+        runner.stopped_->set_value();
+      }
+    }
+  }
+
   // Signal the scheduler threads to exit and then wait for them...
   {
     std::unique_lock<std::mutex> lock(mu_);
-    for (auto& ex : scheduler_threads_exit_) {
-      ex->store(true);
+    for (auto& info : scheduler_threads_) {
+      info.exit_->store(true);
     }
 
     cv_.notify_all();
@@ -167,15 +388,27 @@ DynamicBatchScheduler::~DynamicBatchScheduler()
   // DynamicBatchScheduler object. So we need to check for a scheduler
   // thread and not join it against itself. Instead we detach it so
   // there is not a problem when its thread object is destroyed.
-  for (auto& thd : scheduler_threads_) {
-    if (thd->get_id() != std::this_thread::get_id()) {
-      if (thd->joinable()) {
-        thd->join();
+  for (auto& info : scheduler_threads_) {
+    if (info.thread_->get_id() != std::this_thread::get_id()) {
+      if (info.thread_->joinable()) {
+        info.thread_->join();
       }
     } else {
-      thd->detach();
+      info.thread_->detach();
     }
   }
+
+  // Cancel the timers that would wake the scheduler threads.
+  TimerWheel::Global()->Cancel(this);
+
+#ifdef TRITON_ENABLE_METRICS
+  // Remove the requests that remain in the queue of this scheduler
+  // from the pending count.
+  if (reported_pending_cnt_ != 0) {
+    metric_reporter_->MetricInferencePendingCount()->Decrement(
+        reported_pending_cnt_);
+  }
+#endif  // TRITON_ENABLE_METRICS
 }
 
 Status
@@ -193,11 +426,15 @@ DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
   {
     std::lock_guard<std::mutex> lock(mu_);
 
-    queued_batch_size_ += std::max(1U, request->BatchSize());
+    RETURN_IF_ERROR(CheckQueueLatencySlo());
+
+    const uint32_t batch_size = std::max(1U, request->BatchSize());
 
     // Assuming no error is returned, this call takes ownership of
     // 'request' and so we can't use it after this point.
     RETURN_IF_ERROR(queue_.Enqueue(request->Priority(), request));
+    queued_batch_size_ += batch_size;
+    UpdatePendingCountMetric();
 
     // If there are any idle runners and the queued batch size is greater or
     // equal to next preferred batch size, then wake one up to service this
@@ -210,6 +447,10 @@ DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
     if (enforce_equal_shape_tensors_.empty()) {
       wake_runner &= (queued_batch_size_ >= next_preferred_batch_size_);
     }
+
+    if (executor_ != nullptr) {
+      DispatchToExecutor();
+    }
   }
 
   if (wake_runner) {
@@ -219,6 +460,230 @@ DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
   return Status::Success;
 }
 
+Status
+DynamicBatchScheduler::EnqueueRequests(
+    std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  for (auto& request : requests) {
+    request->CaptureQueueStartNs();
+    INFER_TRACE_ACTIVITY(
+        request->Trace(), TRITONSERVER_TRACE_QUEUE_START,
+        request->QueueStartNs());
+  }
+
+  // Enqueue all the requests while holding the lock once. With
+  // dynamic batching one runner is woken for the whole set and it
+  // wakes another idle runner if requests remain in the queue after
+  // it forms its batch. Without dynamic batching each request is
+  // executed on its own so wake a runner for each request, up to the
+  // number of idle runners.
+  Status enqueue_status;
+  size_t wake_runner_cnt = 0;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+
+    size_t enqueued_cnt = 0;
+    for (auto& request : requests) {
+      enqueue_status = CheckQueueLatencySlo();
+      if (!enqueue_status.IsOk()) {
+        break;
+      }
+
+      const uint32_t batch_size = std::max(1U, request->BatchSize());
+
+      // Assuming no error is returned, this call takes ownership of
+      // 'request' and so we can't use it after this point.
+      enqueue_status = queue_.Enqueue(request->Priority(), request);
+      if (!enqueue_status.IsOk()) {
+        break;
+      }
+
+      queued_batch_size_ += batch_size;
+      enqueued_cnt++;
+    }
+
+    UpdatePendingCountMetric();
+
+    if (!dynamic_batching_enabled_) {
+      wake_runner_cnt =
+          std::min((size_t)idle_scheduler_thread_cnt_, enqueued_cnt);
+    } else if (
+        (enqueued_cnt > 0) && (idle_scheduler_thread_cnt_ > 0) &&
+        (!enforce_equal_shape_tensors_.empty() ||
+         (queued_batch_size_ >= next_preferred_batch_size_))) {
+      wake_runner_cnt = 1;
+    }
+
+    if (executor_ != nullptr) {
+      DispatchToExecutor();
+    }
+  }
+
+  for (size_t i = 0; i < wake_runner_cnt; ++i) {
+    cv_.notify_one();
+  }
+
+  return enqueue_status;
+}
+
+Status
+DynamicBatchScheduler::AddRunner(const uint32_t runner_idx)
+{
+  JoinStoppedSchedulerThreads();
+
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    bool exists = false;
+    for (const auto& info : scheduler_threads_) {
+      exists |= ((info.runner_id_ == runner_idx) && !info.exit_->load());
+    }
+    for (const auto& runner : executor_runners_) {
+      exists |= ((runner.runner_id_ == runner_idx) && !runner.exit_);
+    }
+    if (exists) {
+      return Status(
+          Status::Code::ALREADY_EXISTS,
+          "dynamic-batch scheduler already has runner " +
+              std::to_string(runner_idx));
+    }
+  }
+
+  if (executor_ != nullptr) {
+    return StartExecutorRunner(runner_idx);
+  }
+  return StartSchedulerThread(runner_idx);
+}
+
+Status
+DynamicBatchScheduler::RemoveRunner(
+    const uint32_t runner_idx, std::shared_future<void>* removed)
+{
+  JoinStoppedSchedulerThreads();
+
+  std::lock_guard<std::mutex> lock(mu_);
+  for (auto& info : scheduler_threads_) {
+    if ((info.runner_id_ == runner_idx) && !info.exit_->load()) {
+      if (runner_cnt_ == 1) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "can't remove the last runner of dynamic-batch scheduler");
+      }
+
+      // The thread exits once it finishes executing its current
+      // batch, wake it in case it is waiting for requests.
+      info.exit_->store(true);
+      runner_cnt_--;
+      *removed = info.stopped_;
+      cv_.notify_all();
+      return Status::Success;
+    }
+  }
+  for (auto itr = executor_runners_.begin(); itr != executor_runners_.end();
+       ++itr) {
+    if ((itr->runner_id_ == runner_idx) && !itr->exit_) {
+      if (runner_cnt_ == 1) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "can't remove the last runner of dynamic-batch scheduler");
+      }
+
+      // A runner that is executing a batch is removed by the task
+      // once the batch is executed.
+      itr->exit_ = true;
+      runner_cnt_--;
+      *removed = itr->stopped_future_;
+      if (!itr->busy_) {
+        itr->stopped_->set_value();
+        executor_runners_.erase(itr);
+      }
+      return Status::Success;
+    }
+  }
+
+  return Status(
+      Status::Code::NOT_FOUND, "dynamic-batch scheduler doesn't have runner " +
+                                   std::to_string(runner_idx));
+}
+
+Status
+DynamicBatchScheduler::Load(
+    size_t* pending_cnt, uint32_t* runner_cnt, uint64_t* exec_ns)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  *pending_cnt = queue_.Size() + bucketed_cnt_;
+  *runner_cnt = runner_cnt_;
+  *exec_ns = cumulative_exec_ns_;
+  return Status::Success;
+}
+
+Status
+DynamicBatchScheduler::StartSchedulerThread(const uint32_t runner_id)
+{
+  SchedulerThreadInfo info;
+  info.runner_id_ = runner_id;
+  info.exit_ = std::make_shared<std::atomic<bool>>(false);
+  auto stopped = std::make_shared<std::promise<void>>();
+  info.stopped_ = stopped->get_future().share();
+
+  // The thread holds its own references to the exit flag and the
+  // stopped promise since the scheduler may be destroyed while the
+  // thread is executing a batch, see SchedulerThread().
+  std::promise<bool> init_state;
+  const int nice = nice_;
+  auto thread_exit = info.exit_;
+  info.thread_.reset(
+      new std::thread([this, runner_id, nice, thread_exit, stopped,
+                       &init_state]() {
+        SchedulerThread(runner_id, nice, thread_exit, &init_state);
+        stopped->set_value();
+      }));
+  if (!init_state.get_future().get()) {
+    if (info.thread_->joinable()) {
+      info.thread_->join();
+    }
+    return Status(
+        Status::Code::INTERNAL,
+        "Initialization failed for dynamic-batch scheduler thread " +
+            std::to_string(runner_id));
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  scheduler_threads_.emplace_back(std::move(info));
+  runner_cnt_++;
+
+  return Status::Success;
+}
+
+void
+DynamicBatchScheduler::JoinStoppedSchedulerThreads()
+{
+  std::vector<SchedulerThreadInfo> stopped_threads;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto it = scheduler_threads_.begin();
+         it != scheduler_threads_.end();) {
+      if (it->exit_->load() &&
+          (it->stopped_.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready)) {
+        stopped_threads.emplace_back(std::move(*it));
+        it = scheduler_threads_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  for (auto& info : stopped_threads) {
+    if (info.thread_->get_id() != std::this_thread::get_id()) {
+      if (info.thread_->joinable()) {
+        info.thread_->join();
+      }
+    } else {
+      info.thread_->detach();
+    }
+  }
+}
+
 void
 DynamicBatchScheduler::SchedulerThread(
     const uint32_t runner_id, const int nice,
@@ -286,7 +751,15 @@ DynamicBatchScheduler::SchedulerThread(
   // exit. See comment at end of function for explanation.
   std::shared_ptr<std::atomic<bool>> thread_exit = rthread_exit;
 
-  const uint64_t default_wait_microseconds = 500 * 1000;
+  // The time the run function took to execute the last batch of this
+  // thread and the batch size, which are added to the cumulative and
+  // expected execution times once the lock is held. Use a local copy
+  // of the settings since the object may be invalid after the run
+  // function returns, see comment at end of function.
+  const bool update_expected_exec =
+      earliest_deadline_first_ || (queue_latency_slo_ns_ != 0);
+  uint64_t exec_ns = 0;
+  size_t exec_batch_size = 0;
 
   while (!thread_exit->load()) {
     NVTX_RANGE(nvtx_, "DynamicBatchScheduler " + runner_id);
@@ -295,11 +768,17 @@ DynamicBatchScheduler::SchedulerThread(
     std::shared_ptr<std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>
         rejected_requests;
     bool wake_thread = false;
+    bool wait_for_requests = false;
     uint64_t wait_microseconds = 0;
 
     // Hold the lock for as short a time as possible.
     {
       std::unique_lock<std::mutex> lock(mu_);
+      if (exec_ns != 0) {
+        UpdateExecutionTime(exec_ns, exec_batch_size);
+        exec_ns = 0;
+      }
+
       if (delay_cnt > 0) {
         // Debugging/testing... wait until queue contains 'delay_cnt'
         // items...
@@ -310,111 +789,22 @@ DynamicBatchScheduler::SchedulerThread(
         LOG_VERBOSE(1) << "Delaying scheduler thread " << runner_id << " until "
                        << delay_cnt
                        << " queued requests, current total = " << queue_.Size();
-      } else if (queue_.Empty()) {
-        wait_microseconds = default_wait_microseconds;
-      } else if (dynamic_batching_enabled_) {
-        // Use dynamic batching to get request(s) to execute.
-        wait_microseconds = GetDynamicBatch(runner_id);
-
-        // Get requests that are rejected from searching dynamic batch.
-        queue_.ReleaseRejectedRequests(&rejected_requests);
-
-        // Extract batch only if there is pending batch
-        auto pending_batch_queue_cnt = queue_.PendingBatchCount();
-        if ((wait_microseconds == 0) && (pending_batch_queue_cnt != 0)) {
-          requests.reserve(pending_batch_queue_cnt);
-          for (size_t idx = 0; idx < pending_batch_queue_cnt; ++idx) {
-            std::unique_ptr<InferenceRequest> request;
-            auto status = queue_.Dequeue(&request);
-            if (status.IsOk()) {
-              requests.emplace_back(std::move(request));
-            } else {
-              // The queue is empty which conflicts with pending batch count.
-              // Send the current batch if any and reset related variables.
-              LOG_ERROR << "Failed to retrieve request from scheduler queue: "
-                        << status.Message();
-              queue_.ResetCursor();
-              queued_batch_size_ = 0;
-              pending_batch_size_ = 0;
-              break;
-            }
-          }
-          if (preserve_ordering_ && !requests.empty()) {
-            std::lock_guard<std::mutex> lock(completion_queue_mtx_);
-            for (auto& request : requests) {
-              completion_queue_.emplace_back();
-              auto queue_slot = &completion_queue_.back();
-              request->SetResponseDelegator(
-                  [this, queue_slot](
-                      std::unique_ptr<InferenceResponse>&& response,
-                      const uint32_t flags) {
-                    {
-                      std::lock_guard<std::mutex> lock(completion_queue_mtx_);
-                      queue_slot->emplace_back(std::move(response), flags);
-                    }
-                    FinalizeResponses();
-                  });
-            }
-          }
-
-          queued_batch_size_ -= pending_batch_size_;
-          // Set next preferred to be 0 so that enqueue thread will wake up
-          // runners when new request arrives. In the case where the queue
-          // becomes empty, this helps the runners to set up proper wait time
-          // instead of waiting for the default timer or actual next preferred
-          // batch size is reached.
-          next_preferred_batch_size_ = 0;
-
-          pending_batch_size_ = 0;
-          required_equal_inputs_.clear();
-
-          // If there are still requests in the queue after removing
-          // the pending batch and if there are any idle threads then
-          // wake one up to service the requests remaining in the
-          // queue. We need this special wake logic for the dynamic
-          // batching case because we may delay handling requests in
-          // the queue and so idle the threads that would normally be
-          // handling those requests. We do the actual wake outside of
-          // the lock to avoid having the woken thread immediately
-          // block on the lock.
-          wake_thread = !queue_.Empty() && (idle_scheduler_thread_cnt_ > 0);
-        }
+      } else if (queue_.Empty() && shape_buckets_.empty()) {
+        // Wait until a request is enqueued. Reset the next preferred
+        // batch size so that the enqueue wakes this thread.
+        next_preferred_batch_size_ = 0;
+        wait_for_requests = true;
       } else {
-        // No batching... execute next request
-        std::unique_ptr<InferenceRequest> request;
-        auto status = queue_.Dequeue(&request);
-        if (status.IsOk()) {
-          requests.emplace_back(std::move(request));
-          if (preserve_ordering_) {
-            std::lock_guard<std::mutex> lock(completion_queue_mtx_);
-            for (auto& request : requests) {
-              completion_queue_.emplace_back();
-              auto queue_slot = &completion_queue_.back();
-              request->SetResponseDelegator(
-                  [this, queue_slot](
-                      std::unique_ptr<InferenceResponse>&& response,
-                      const uint32_t flags) {
-                    {
-                      std::lock_guard<std::mutex> lock(completion_queue_mtx_);
-                      queue_slot->emplace_back(std::move(response), flags);
-                    }
-                    FinalizeResponses();
-                  });
-            }
-          }
-        } else {
-          LOG_ERROR << "Failed to retrieve request from scheduler queue: "
-                    << status.Message();
-        }
+        wait_microseconds = NextBatch(
+            runner_id, &requests, &rejected_requests, &wake_thread);
       }
 
+      UpdatePendingCountMetric();
+
       // If no requests are to be handled, wait for notification or
       // for the specified timeout before checking the queue again.
-      if (wait_microseconds > 0) {
-        idle_scheduler_thread_cnt_++;
-        std::chrono::microseconds wait_timeout(wait_microseconds);
-        cv_.wait_for(lock, wait_timeout);
-        idle_scheduler_thread_cnt_--;
+      if (wait_for_requests || (wait_microseconds > 0)) {
+        WaitForWork(lock, wait_microseconds);
       }
     }
 
@@ -422,9 +812,31 @@ DynamicBatchScheduler::SchedulerThread(
       cv_.notify_one();
     }
 
+    // Pad the inputs of the batch to the shape of its bucket, which
+    // may fail and respond to some of the requests.
+    if (!requests.empty() && !shape_bucketing_.lengths_.empty()) {
+      PadToShapeBuckets(&requests);
+    }
+
     if (!requests.empty()) {
+      if (update_expected_exec) {
+        exec_batch_size = 0;
+        for (const auto& request : requests) {
+          exec_batch_size += std::max(1U, request->BatchSize());
+        }
+      }
+      const uint64_t exec_start_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count();
+
       OnSchedule_(runner_id, std::move(requests));
 
+      exec_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count() -
+                exec_start_ns;
+
       // For testing we introduce a delay here to make the
       // "DynamicBatchScheduler destroyed by this thread" case
       // described in the comment below reproducible.
@@ -435,16 +847,7 @@ DynamicBatchScheduler::SchedulerThread(
     }
 
     // Finish rejected requests if any
-    if (rejected_requests != nullptr) {
-      static Status rejected_status =
-          Status(Status::Code::UNAVAILABLE, "Request timeout expired");
-      for (auto& rejected_queue : *rejected_requests) {
-        for (auto& rejected_request : rejected_queue) {
-          InferenceRequest::RespondIfError(
-              rejected_request, rejected_status, true);
-        }
-      }
-    }
+    RespondRejectedRequests(rejected_requests);
 
     // FIXME, this isn't really true anymore so needs to be revisited.
     //
@@ -466,6 +869,414 @@ DynamicBatchScheduler::SchedulerThread(
                  << "...";
 }
 
+uint64_t
+DynamicBatchScheduler::NextBatch(
+    const uint32_t runner_id, RequestBatch* requests,
+    std::shared_ptr<RejectedRequests>* rejected_requests, bool* wake_thread)
+{
+  // 'mu_' mutex must be held when this function is called. The queue
+  // or the shape buckets must not be empty. Return the number of
+  // microseconds to wait before checking for a batch again if no
+  // batch is ready to execute.
+  uint64_t wait_microseconds = 0;
+  if (dynamic_batching_enabled_ && shape_bucketing_.enabled_) {
+    // Use the pending batch of one of the shape buckets.
+    wait_microseconds = GetShapeBucketBatch(requests);
+    queue_.ReleaseRejectedRequests(rejected_requests);
+
+    if (!requests->empty()) {
+      next_preferred_batch_size_ = 0;
+
+      // Same as below, wake an idle thread to service the
+      // requests remaining in the queue and in the buckets.
+      *wake_thread = (!queue_.Empty() || !shape_buckets_.empty()) &&
+                     (idle_scheduler_thread_cnt_ > 0);
+    }
+  } else if (dynamic_batching_enabled_) {
+    // Use dynamic batching to get request(s) to execute.
+    wait_microseconds = GetDynamicBatch(runner_id);
+
+    // Get requests that are rejected from searching dynamic batch.
+    queue_.ReleaseRejectedRequests(rejected_requests);
+
+    // Extract batch only if there is pending batch
+    auto pending_batch_queue_cnt = queue_.PendingBatchCount();
+    if ((wait_microseconds == 0) && (pending_batch_queue_cnt != 0)) {
+      requests->reserve(pending_batch_queue_cnt);
+      for (size_t idx = 0; idx < pending_batch_queue_cnt; ++idx) {
+        std::unique_ptr<InferenceRequest> request;
+        auto status = queue_.Dequeue(&request);
+        if (status.IsOk()) {
+          requests->emplace_back(std::move(request));
+        } else {
+          // The queue is empty which conflicts with pending batch count.
+          // Send the current batch if any and reset related variables.
+          LOG_ERROR << "Failed to retrieve request from scheduler queue: "
+                    << status.Message();
+          queue_.ResetCursor();
+          queued_batch_size_ = 0;
+          pending_batch_size_ = 0;
+          break;
+        }
+      }
+      if (preserve_ordering_ && !requests->empty()) {
+        std::lock_guard<std::mutex> lock(completion_queue_mtx_);
+        for (auto& request : *requests) {
+          DelegateResponse(request);
+        }
+      }
+
+      queued_batch_size_ -= pending_batch_size_;
+      // Set next preferred to be 0 so that enqueue thread will wake up
+      // runners when new request arrives. In the case where the queue
+      // becomes empty, this helps the runners to set up proper wait time
+      // instead of waiting for the default timer or actual next preferred
+      // batch size is reached.
+      next_preferred_batch_size_ = 0;
+
+      pending_batch_size_ = 0;
+      required_equal_inputs_.clear();
+
+      // If there are still requests in the queue after removing
+      // the pending batch and if there are any idle threads then
+      // wake one up to service the requests remaining in the
+      // queue. We need this special wake logic for the dynamic
+      // batching case because we may delay handling requests in
+      // the queue and so idle the threads that would normally be
+      // handling those requests. We do the actual wake outside of
+      // the lock to avoid having the woken thread immediately
+      // block on the lock.
+      *wake_thread = !queue_.Empty() && (idle_scheduler_thread_cnt_ > 0);
+    }
+  } else {
+    // No batching... execute next request
+    std::unique_ptr<InferenceRequest> request;
+    auto status = queue_.Dequeue(&request);
+    if (status.IsOk()) {
+      requests->emplace_back(std::move(request));
+      if (preserve_ordering_) {
+        std::lock_guard<std::mutex> lock(completion_queue_mtx_);
+        for (auto& request : *requests) {
+          DelegateResponse(request);
+        }
+      }
+
+      // Wake an idle thread to execute the next request, in case
+      // more requests were enqueued than threads were woken.
+      *wake_thread = !queue_.Empty() && (idle_scheduler_thread_cnt_ > 0);
+    } else {
+      LOG_ERROR << "Failed to retrieve request from scheduler queue: "
+                << status.Message();
+    }
+  }
+
+  return wait_microseconds;
+}
+
+void
+DynamicBatchScheduler::UpdateExecutionTime(
+    const uint64_t exec_ns, const size_t batch_size)
+{
+  // 'mu_' mutex must be held when this function is called.
+  cumulative_exec_ns_ += exec_ns;
+  if (earliest_deadline_first_ || (queue_latency_slo_ns_ != 0)) {
+    expected_exec_ns_ = (expected_exec_ns_ == 0)
+                            ? exec_ns
+                            : (expected_exec_ns_ * 7 + exec_ns) / 8;
+    queue_.SetExpectedExecutionNs(expected_exec_ns_);
+    const uint64_t inference_ns = exec_ns / std::max((size_t)1, batch_size);
+    expected_inference_ns_ =
+        (expected_inference_ns_ == 0)
+            ? inference_ns
+            : (expected_inference_ns_ * 7 + inference_ns) / 8;
+  }
+}
+
+void
+DynamicBatchScheduler::WaitForWork(
+    std::unique_lock<std::mutex>& lock, const uint64_t wait_microseconds)
+{
+  // 'lock' must hold 'mu_'. Wait until the thread is notified or, if
+  // 'wait_microseconds' is not 0, until the timeout expires. The
+  // timeout is a timer of the global timer wheel instead of a timed
+  // wait so that threads of idle models don't wake periodically. A
+  // timer is not needed if an earlier timer will wake the thread,
+  // the thread then waits again for the remaining time.
+  if (wait_microseconds > 0) {
+    const uint64_t deadline_ns = SteadyClockNs() + (wait_microseconds * 1000);
+    if (wake_deadlines_ns_.empty() ||
+        (*wake_deadlines_ns_.begin() > deadline_ns)) {
+      wake_deadlines_ns_.insert(deadline_ns);
+      TimerWheel::Global()->Schedule(
+          this, wait_microseconds, [this, deadline_ns]() {
+            {
+              std::lock_guard<std::mutex> lock(mu_);
+              wake_deadlines_ns_.erase(wake_deadlines_ns_.find(deadline_ns));
+            }
+            cv_.notify_all();
+          });
+    }
+  }
+
+  idle_scheduler_thread_cnt_++;
+  cv_.wait(lock);
+  idle_scheduler_thread_cnt_--;
+}
+
+Status
+DynamicBatchScheduler::StartExecutorRunner(const uint32_t runner_id)
+{
+  // Initialize and warm up the runner on a thread of its own since
+  // the initialization may bind the thread to the NUMA node of the
+  // runner, which must not change the executor threads. The node the
+  // thread is bound to is the node of the tasks of the runner.
+  Status status;
+  int numa_node = -1;
+  std::thread init_thread([this, runner_id, &status, &numa_node]() {
+    LOG_VERBOSE(1) << "Initializing dynamic-batch scheduler runner "
+                   << runner_id << " for the shared executor...";
+    status = OnInit_(runner_id);
+    if (status.IsOk()) {
+      status = OnWarmup_(runner_id);
+    }
+    unsigned long node_mask = 0;
+    if (status.IsOk() && GetNumaMemoryPolicyNodeMask(&node_mask).IsOk()) {
+      for (int node = 0; node_mask != 0; ++node, node_mask >>= 1) {
+        if ((node_mask & 1) != 0) {
+          numa_node = node;
+          break;
+        }
+      }
+    }
+  });
+  init_thread.join();
+
+  if (!status.IsOk()) {
+    LOG_ERROR << "Initialization failed for dynamic-batch scheduler runner "
+              << runner_id << ": " << status.Message();
+    return Status(
+        Status::Code::INTERNAL,
+        "Initialization failed for dynamic-batch scheduler runner " +
+            std::to_string(runner_id));
+  }
+
+  ExecutorRunner runner;
+  runner.runner_id_ = runner_id;
+  runner.numa_node_ = numa_node;
+  runner.busy_ = false;
+  runner.exit_ = false;
+  runner.stopped_ = std::make_shared<std::promise<void>>();
+  runner.stopped_future_ = runner.stopped_->get_future().share();
+
+  std::lock_guard<std::mutex> lock(mu_);
+  executor_runners_.emplace_back(std::move(runner));
+  runner_cnt_++;
+
+  // Requests may have been enqueued while the runner was added.
+  DispatchToExecutor();
+
+  return Status::Success;
+}
+
+void
+DynamicBatchScheduler::DispatchToExecutor()
+{
+  // 'mu_' mutex must be held when this function is called. Form a
+  // batch for each idle runner, as a scheduler thread of the runner
+  // would, and submit it to the executor.
+  for (auto& runner : executor_runners_) {
+    if (queue_.Empty() && shape_buckets_.empty()) {
+      break;
+    }
+    if (runner.busy_ || runner.exit_) {
+      continue;
+    }
+
+    auto requests = std::make_shared<RequestBatch>();
+    std::shared_ptr<RejectedRequests> rejected_requests;
+    bool wake_thread = false;
+    const uint64_t wait_microseconds = NextBatch(
+        runner.runner_id_, requests.get(), &rejected_requests, &wake_thread);
+
+    ExecutorRunner* batch_runner = nullptr;
+    if (!requests->empty()) {
+      runner.busy_ = true;
+      batch_runner = &runner;
+    }
+    if ((batch_runner != nullptr) || (rejected_requests != nullptr)) {
+      DynamicBatchScheduler* scheduler = this;
+      auto state = executor_state_;
+      executor_->Submit(
+          runner.numa_node_, [scheduler, state, batch_runner, requests,
+                              rejected_requests]() {
+            ExecutorTask(
+                scheduler, state, batch_runner, requests, rejected_requests);
+          });
+    }
+
+    // The pending batch is delayed, check it again once the delay
+    // expires.
+    if (batch_runner == nullptr) {
+      if (wait_microseconds > 0) {
+        ScheduleDispatch(wait_microseconds);
+      }
+      break;
+    }
+  }
+
+  UpdatePendingCountMetric();
+}
+
+void
+DynamicBatchScheduler::ScheduleDispatch(const uint64_t wait_microseconds)
+{
+  // 'mu_' mutex must be held when this function is called. A dispatch
+  // that is already scheduled earlier than the delay also checks the
+  // pending batch.
+  const uint64_t deadline_ns = SteadyClockNs() + (wait_microseconds * 1000);
+  if ((dispatch_deadline_ns_ != 0) && (dispatch_deadline_ns_ <= deadline_ns)) {
+    return;
+  }
+
+  dispatch_deadline_ns_ = deadline_ns;
+  DynamicBatchScheduler* scheduler = this;
+  auto state = executor_state_;
+  executor_->SubmitAfter(
+      wait_microseconds, -1 /* numa_node */, [scheduler, state]() {
+        std::lock_guard<std::mutex> lock(state->mu_);
+        if (!state->destroyed_) {
+          std::lock_guard<std::mutex> slock(scheduler->mu_);
+          if (scheduler->dispatch_deadline_ns_ <= SteadyClockNs()) {
+            scheduler->dispatch_deadline_ns_ = 0;
+          }
+          scheduler->DispatchToExecutor();
+        }
+      });
+}
+
+void
+DynamicBatchScheduler::ExecutorTask(
+    DynamicBatchScheduler* scheduler,
+    const std::shared_ptr<ExecutorState>& state, ExecutorRunner* runner,
+    const std::shared_ptr<RequestBatch>& requests,
+    const std::shared_ptr<RejectedRequests>& rejected_requests)
+{
+  // The requests of the batch hold a reference to the backend and so
+  // the scheduler can only be destroyed by this task, while it
+  // executes the batch, or by a task of another batch. Once the
+  // scheduler is destroyed the task must not use it.
+  {
+    std::lock_guard<std::mutex> lock(state->mu_);
+    if (state->destroyed_) {
+      static Status destroyed_status = Status(
+          Status::Code::UNAVAILABLE, "Scheduler was destroyed");
+      if (requests != nullptr) {
+        for (auto& request : *requests) {
+          InferenceRequest::RespondIfError(request, destroyed_status, true);
+        }
+      }
+      RespondRejectedRequests(rejected_requests);
+      return;
+    }
+    state->inflight_threads_.push_back(std::this_thread::get_id());
+  }
+
+  uint64_t exec_ns = 0;
+  size_t exec_batch_size = 0;
+  if (runner != nullptr) {
+    if (!scheduler->shape_bucketing_.lengths_.empty()) {
+      scheduler->PadToShapeBuckets(requests.get());
+    }
+    if (!requests->empty()) {
+      for (const auto& request : *requests) {
+        exec_batch_size += std::max(1U, request->BatchSize());
+      }
+      const uint64_t exec_start_ns = SteadyClockNs();
+      scheduler->OnSchedule_(runner->runner_id_, std::move(*requests));
+      exec_ns = SteadyClockNs() - exec_start_ns;
+    }
+  }
+
+  RespondRejectedRequests(rejected_requests);
+
+  std::lock_guard<std::mutex> lock(state->mu_);
+  auto& threads = state->inflight_threads_;
+  threads.erase(
+      std::find(threads.begin(), threads.end(), std::this_thread::get_id()));
+  if (!state->destroyed_) {
+    std::lock_guard<std::mutex> slock(scheduler->mu_);
+    if (runner != nullptr) {
+      runner->busy_ = false;
+      if (runner->exit_) {
+        runner->stopped_->set_value();
+        for (auto itr = scheduler->executor_runners_.begin();
+             itr != scheduler->executor_runners_.end(); ++itr) {
+          if (&(*itr) == runner) {
+            scheduler->executor_runners_.erase(itr);
+            break;
+          }
+        }
+      }
+    }
+    if (exec_ns != 0) {
+      scheduler->UpdateExecutionTime(exec_ns, exec_batch_size);
+    }
+    scheduler->DispatchToExecutor();
+  }
+  state->cv_.notify_all();
+}
+
+Status
+DynamicBatchScheduler::CheckQueueLatencySlo()
+{
+  // 'mu_' mutex must be held when this function is called. All
+  // requests are admitted until a batch has been executed.
+  if ((queue_latency_slo_ns_ == 0) || (expected_inference_ns_ == 0)) {
+    return Status::Success;
+  }
+
+  // The queued requests are executed by all scheduler threads in
+  // parallel.
+  const uint64_t queue_delay_ns =
+      queued_batch_size_ * expected_inference_ns_ / std::max(1U, runner_cnt_);
+  if (queue_delay_ns <= queue_latency_slo_ns_) {
+    return Status::Success;
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter_ != nullptr) &&
+      (metric_reporter_->MetricInferenceShed() != nullptr)) {
+    metric_reporter_->MetricInferenceShed()->Increment(1);
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  return Status(
+      Status::Code::UNAVAILABLE,
+      "Predicted queue delay of " + std::to_string(queue_delay_ns / 1000) +
+          " us exceeds the queue latency SLO of " +
+          std::to_string(queue_latency_slo_ns_ / 1000) + " us");
+}
+
+void
+DynamicBatchScheduler::UpdatePendingCountMetric()
+{
+  // 'mu_' mutex must be held when this function is called.
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter_ != nullptr) &&
+      (metric_reporter_->MetricInferencePendingCount() != nullptr)) {
+    const size_t pending_cnt = queue_.Size() + bucketed_cnt_;
+    if (pending_cnt > reported_pending_cnt_) {
+      metric_reporter_->MetricInferencePendingCount()->Increment(
+          pending_cnt - reported_pending_cnt_);
+    } else if (pending_cnt < reported_pending_cnt_) {
+      metric_reporter_->MetricInferencePendingCount()->Decrement(
+          reported_pending_cnt_ - pending_cnt);
+    }
+    reported_pending_cnt_ = pending_cnt;
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
 uint64_t
 DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
 {
@@ -600,6 +1411,363 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
   return wait_ns / 1000;
 }
 
+uint64_t
+DynamicBatchScheduler::GetShapeBucketBatch(
+    std::vector<std::unique_ptr<InferenceRequest>>* requests)
+{
+  // 'mu_' mutex must be held when this function is called.
+
+  // Move the requests from the queue into the shape buckets, applying
+  // the queue policy to each request first, until the pending batch of
+  // a bucket can't grow any larger.
+  bool bucket_full = false;
+  for (const auto& bucket : shape_buckets_) {
+    bucket_full |= (bucket.batch_size_ >= max_batch_size_);
+  }
+  while (!bucket_full) {
+    queue_.ResetCursor();
+    queued_batch_size_ -= queue_.ApplyPolicyAtCursor();
+    if (queue_.CursorEnd()) {
+      break;
+    }
+
+    PriorityQueue::HeldRequest held;
+    auto status = queue_.Dequeue(&held);
+    if (!status.IsOk()) {
+      LOG_ERROR << "Failed to retrieve request from scheduler queue: "
+                << status.Message();
+      break;
+    }
+
+    bucket_full =
+        (AddToShapeBucket(std::move(held))->batch_size_ >= max_batch_size_);
+  }
+  queue_.ResetCursor();
+
+  // The bucketed requests are still held by the queue, apply the queue
+  // policy to them so that cancelled and timed-out requests are
+  // rejected, or delayed, while they wait in their bucket.
+  const uint64_t now_ns = SteadyClockNs();
+  uint64_t timeout_wake_ns = 0;
+  for (auto itr = shape_buckets_.begin(); itr != shape_buckets_.end();) {
+    ApplyPolicyToShapeBucket(&*itr, now_ns, &timeout_wake_ns);
+    if (itr->requests_.empty()) {
+      itr = shape_buckets_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+
+  // Find the pending batch of each bucket in the same way as
+  // GetDynamicBatch() does for the queue. Of the buckets that are
+  // ready to send their batch, send the bucket with the highest
+  // priority request, then the bucket whose oldest request has waited
+  // longer than the maximum queue delay, so that buckets with few
+  // requests are not starved, or else the largest batch. Without a
+  // maximum queue delay every bucket is ready and the bucket with the
+  // oldest request is sent.
+  auto selected = shape_buckets_.end();
+  size_t selected_cnt = 0;
+  size_t selected_size = 0;
+  size_t selected_level_idx = 0;
+  bool selected_expired = false;
+  uint64_t selected_enqueue_ns = 0;
+  uint64_t wait_ns = 0;
+  for (auto itr = shape_buckets_.begin(); itr != shape_buckets_.end(); ++itr) {
+    size_t cnt = 0;
+    size_t size = 0;
+    size_t preferred_cnt = 0;
+    size_t preferred_size = 0;
+    uint64_t enqueue_ns = 0;
+    for (const auto& held : itr->requests_) {
+      const size_t batch_size = std::max(1U, held.request_->BatchSize());
+      if ((size + batch_size) > max_batch_size_) {
+        break;
+      }
+
+      size += batch_size;
+      ++cnt;
+      if (preferred_batch_sizes_.find(size) != preferred_batch_sizes_.end()) {
+        preferred_cnt = cnt;
+        preferred_size = size;
+      }
+      const uint64_t request_enqueue_ns = held.request_->QueueStartNs();
+      if ((enqueue_ns == 0) || (request_enqueue_ns < enqueue_ns)) {
+        enqueue_ns = request_enqueue_ns;
+      }
+    }
+
+    const bool can_grow =
+        (cnt == itr->requests_.size()) && (size < max_batch_size_);
+    const uint64_t delay_ns = (now_ns > enqueue_ns) ? now_ns - enqueue_ns : 0;
+    const bool delay_is_exceeded = (delay_ns >= pending_batch_delay_ns_);
+    if ((preferred_size != 0) && !delay_is_exceeded) {
+      cnt = preferred_cnt;
+      size = preferred_size;
+    } else if (
+        can_grow && !delay_is_exceeded &&
+        (size < max_preferred_batch_size_)) {
+      const uint64_t bucket_wait_ns = pending_batch_delay_ns_ - delay_ns;
+      wait_ns = (wait_ns == 0) ? bucket_wait_ns
+                               : std::min(wait_ns, bucket_wait_ns);
+      continue;
+    }
+
+    const size_t level_idx = itr->requests_.front().level_idx_;
+    const bool expired = delay_is_exceeded;
+    bool better = false;
+    if (selected == shape_buckets_.end()) {
+      better = true;
+    } else if (level_idx != selected_level_idx) {
+      better = (level_idx < selected_level_idx);
+    } else if (expired != selected_expired) {
+      better = expired;
+    } else if (expired || (size == selected_size)) {
+      better = (enqueue_ns < selected_enqueue_ns);
+    } else {
+      better = (size > selected_size);
+    }
+
+    if (better) {
+      selected = itr;
+      selected_cnt = cnt;
+      selected_size = size;
+      selected_level_idx = level_idx;
+      selected_expired = expired;
+      selected_enqueue_ns = enqueue_ns;
+    }
+  }
+
+  // If no bucket is ready wait until the delay of the oldest request
+  // is exceeded, or until the next bucketed request times out. A new
+  // request wakes this thread to check the buckets again.
+  if (selected == shape_buckets_.end()) {
+    if (timeout_wake_ns != 0) {
+      const uint64_t timeout_wait_ns =
+          (timeout_wake_ns > now_ns) ? timeout_wake_ns - now_ns : 1;
+      wait_ns = (wait_ns == 0) ? timeout_wait_ns
+                               : std::min(wait_ns, timeout_wait_ns);
+    }
+    return (wait_ns == 0) ? 0 : std::max<uint64_t>(1, wait_ns / 1000);
+  }
+
+  requests->reserve(selected_cnt);
+  for (size_t idx = 0; idx < selected_cnt; ++idx) {
+    auto& held = selected->requests_.front();
+    queue_.Release(held);
+    requests->emplace_back(std::move(held.request_));
+    selected->requests_.pop_front();
+  }
+  selected->batch_size_ -= selected_size;
+  queued_batch_size_ -= selected_size;
+  bucketed_cnt_ -= selected_cnt;
+
+  if (selected->requests_.empty()) {
+    shape_buckets_.erase(selected);
+  } else {
+    InitRequiredEqualInputs(
+        selected->requests_.front().request_, shape_tensors_,
+        &selected->shape_tensors_);
+  }
+
+  return 0;
+}
+
+DynamicBatchScheduler::ShapeBucket*
+DynamicBatchScheduler::AddToShapeBucket(PriorityQueue::HeldRequest&& held)
+{
+  // 'mu_' mutex must be held when this function is called.
+
+  // Requests can be sent in a different order than they are dequeued
+  // so the response order must be recorded now.
+  if (preserve_ordering_) {
+    std::lock_guard<std::mutex> lock(completion_queue_mtx_);
+    DelegateResponse(held.request_);
+  }
+
+  const std::unique_ptr<InferenceRequest>& request = held.request_;
+  std::unordered_map<std::string, std::vector<int64_t>> shapes;
+  for (const InferenceRequest::Input* input : request->ImmutableInputs()) {
+    if (enforce_equal_shape_tensors_.find(input->Name()) !=
+        enforce_equal_shape_tensors_.end()) {
+      BucketShape(shape_bucketing_, *input, &shapes[input->Name()]);
+    }
+  }
+
+  ShapeBucket* bucket = nullptr;
+  for (auto& sb : shape_buckets_) {
+    if ((sb.shapes_ == shapes) &&
+        CompareWithRequiredEqualInputs(request, sb.shape_tensors_)) {
+      bucket = &sb;
+      break;
+    }
+  }
+
+  if (bucket == nullptr) {
+    shape_buckets_.emplace_back();
+    bucket = &shape_buckets_.back();
+    bucket->shapes_ = std::move(shapes);
+    bucket->batch_size_ = 0;
+  }
+
+  // A request of a higher priority level than the requests already in
+  // the bucket is batched before them.
+  bucket->batch_size_ += std::max(1U, request->BatchSize());
+  auto pos = std::upper_bound(
+      bucket->requests_.begin(), bucket->requests_.end(), held,
+      HeldRequestBefore);
+  const bool is_front = (pos == bucket->requests_.begin());
+  pos = bucket->requests_.insert(pos, std::move(held));
+  if (is_front) {
+    InitRequiredEqualInputs(
+        pos->request_, shape_tensors_, &bucket->shape_tensors_);
+  }
+  bucketed_cnt_++;
+
+  return bucket;
+}
+
+void
+DynamicBatchScheduler::ApplyPolicyToShapeBucket(
+    ShapeBucket* bucket, const uint64_t now_ns, uint64_t* wake_ns)
+{
+  // 'mu_' mutex must be held when this function is called.
+
+  // Remove the rejected requests, which are returned by the next
+  // ReleaseRejectedRequests() of the queue, and record in 'wake_ns'
+  // the closest time at which a held request will time out.
+  auto& held_requests = bucket->requests_;
+  bool reorder = false;
+  bool front_changed = false;
+  for (auto itr = held_requests.begin(); itr != held_requests.end();) {
+    const bool delayed = itr->delayed_;
+    size_t rejected_batch_size = 0;
+    if (!queue_.ApplyPolicy(&*itr, now_ns, &rejected_batch_size)) {
+      front_changed |= (itr == held_requests.begin());
+      bucket->batch_size_ -= rejected_batch_size;
+      queued_batch_size_ -= rejected_batch_size;
+      bucketed_cnt_--;
+      itr = held_requests.erase(itr);
+      continue;
+    }
+
+    reorder |= (itr->delayed_ != delayed);
+    if (itr->timeout_ns_ != 0) {
+      // With earliest-deadline-first the queue treats a request as
+      // timed-out once it can't complete before its timeout.
+      uint64_t timeout_ns = itr->timeout_ns_;
+      if (earliest_deadline_first_) {
+        timeout_ns =
+            (timeout_ns > expected_exec_ns_) ? timeout_ns - expected_exec_ns_
+                                             : 1;
+      }
+      if ((*wake_ns == 0) || (timeout_ns < *wake_ns)) {
+        *wake_ns = timeout_ns;
+      }
+    }
+    ++itr;
+  }
+
+  if (reorder) {
+    std::stable_sort(
+        held_requests.begin(), held_requests.end(), HeldRequestBefore);
+    front_changed = true;
+  }
+  if (front_changed && !held_requests.empty()) {
+    InitRequiredEqualInputs(
+        held_requests.front().request_, shape_tensors_,
+        &bucket->shape_tensors_);
+  }
+}
+
+void
+DynamicBatchScheduler::PadToShapeBuckets(
+    std::vector<std::unique_ptr<InferenceRequest>>* requests)
+{
+  for (auto& request : *requests) {
+    // Find the inputs that need padding before adding any override,
+    // which would change the inputs of the request.
+    std::vector<
+        std::pair<const InferenceRequest::Input*, std::vector<int64_t>>>
+        pad_inputs;
+    for (const InferenceRequest::Input* input : request->ImmutableInputs()) {
+      std::vector<int64_t> padded_shape;
+      BucketShape(shape_bucketing_, *input, &padded_shape);
+      if (padded_shape != input->Shape()) {
+        pad_inputs.emplace_back(input, std::move(padded_shape));
+      }
+    }
+
+    Status status;
+    const int64_t batch_size = std::max(1U, request->BatchSize());
+    for (const auto& pr : pad_inputs) {
+      const InferenceRequest::Input* input = pr.first;
+      std::vector<int64_t> shape{batch_size};
+      shape.insert(shape.end(), input->Shape().begin(), input->Shape().end());
+      std::vector<int64_t> padded_shape{batch_size};
+      padded_shape.insert(
+          padded_shape.end(), pr.second.begin(), pr.second.end());
+
+      const size_t padded_byte_size =
+          GetElementCount(padded_shape) * GetDataTypeByteSize(input->DType());
+      auto padded = std::make_shared<AllocatedMemory>(
+          padded_byte_size, TRITONSERVER_MEMORY_CPU, 0);
+      TRITONSERVER_MemoryType memory_type;
+      int64_t memory_type_id;
+      char* padded_ptr = padded->MutableBuffer(&memory_type, &memory_type_id);
+      if ((padded_ptr == nullptr) && (padded_byte_size != 0)) {
+        status = Status(
+            Status::Code::INTERNAL, "failed to allocate padded input '" +
+                                        input->Name() + "' in CPU memory");
+        break;
+      }
+
+      status = PadInput(*input, shape, padded_shape, padded_ptr);
+      if (!status.IsOk()) {
+        break;
+      }
+
+      std::shared_ptr<InferenceRequest::Input> override;
+      status = request->AddOverrideInput(
+          input->Name(), input->DType(), batch_size, pr.second, &override);
+      if (!status.IsOk()) {
+        break;
+      }
+      status = override->SetData(padded);
+      if (!status.IsOk()) {
+        break;
+      }
+    }
+
+    if (!status.IsOk()) {
+      InferenceRequest::RespondIfError(request, status, true);
+    }
+  }
+
+  requests->erase(
+      std::remove(requests->begin(), requests->end(), nullptr),
+      requests->end());
+}
+
+void
+DynamicBatchScheduler::DelegateResponse(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  // 'completion_queue_mtx_' mutex must be held when this function is
+  // called.
+  completion_queue_.emplace_back();
+  auto queue_slot = &completion_queue_.back();
+  request->SetResponseDelegator(
+      [this, queue_slot](
+          std::unique_ptr<InferenceResponse>&& response, const uint32_t flags) {
+        {
+          std::lock_guard<std::mutex> lock(completion_queue_mtx_);
+          queue_slot->emplace_back(std::move(response), flags);
+        }
+        FinalizeResponses();
+      });
+}
+
 void
 DynamicBatchScheduler::FinalizeResponses()
 {
@@ -29,15 +29,18 @@
 #include <condition_variable>
 #include <deque>
 #include <future>
+#include <list>
 #include <map>
 #include <mutex>
 #include <queue>
 #include <set>
 #include <thread>
 #include "model_config.pb.h"
+#include "src/core/metric_model_reporter.h"
 #include "src/core/model_config.h"
 #include "src/core/scheduler.h"
 #include "src/core/scheduler_utils.h"
+#include "src/core/shared_executor.h"
 #include "src/core/status.h"
 
 namespace nvidia { namespace inferenceserver {
@@ -45,8 +48,27 @@ namespace nvidia { namespace inferenceserver {
 // Scheduler that implements dynamic batching.
 class DynamicBatchScheduler : public Scheduler {
  public:
+  // Shape bucketing for models that require the inputs in
+  // 'enforce_equal_shape_tensors' to have equal shapes within a
+  // batch. If 'enabled_' the scheduler keeps a pending batch for each
+  // distinct shape found in the queue, instead of sending the pending
+  // batch as soon as a request with a different shape is found. If
+  // 'lengths_' is not empty, the dimensions of each input listed in
+  // 'variable_dims_' are padded with zeros up to the smallest length
+  // that is not less than the dimension, so that requests with
+  // similar shapes are batched together.
+  struct ShapeBucketing {
+    ShapeBucketing() : enabled_(false) {}
+
+    bool enabled_;
+    std::set<int64_t> lengths_;
+    std::unordered_map<std::string, std::vector<size_t>> variable_dims_;
+  };
+
   // Create a scheduler to support a given number of runners and a run
-  // function to call when a request is scheduled.
+  // function to call when a request is scheduled. If non-null,
+  // 'metric_reporter' is used to report the number of requests
+  // pending in the scheduler.
   static Status Create(
       const uint32_t runner_id_start, const uint32_t runner_cnt, const int nice,
       const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
@@ -56,11 +78,19 @@ class DynamicBatchScheduler : public Scheduler {
       const bool preserve_ordering,
       const std::set<int32_t>& preferred_batch_sizes,
       const uint64_t max_queue_delay_microseconds,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter,
       std::unique_ptr<Scheduler>* scheduler);
 
   // Create a scheduler to support a given number of runners and a run
   // function to call when a request is scheduled. And the scheduler also
   // supports different queue policies for different priority levels.
+  // If 'earliest_deadline_first' is true the requests of a priority
+  // level are scheduled in order of their timeout, and requests that
+  // can't finish executing before their timeout are timed-out early.
+  // If 'queue_latency_slo_us' is not 0, a request is rejected when it
+  // is enqueued if its predicted queue delay exceeds the SLO. If
+  // 'executor' is not nullptr the batches are executed by the
+  // executor instead of by a dedicated thread for each runner.
   static Status Create(
       const uint32_t runner_id_start, const uint32_t runner_cnt, const int nice,
       const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
@@ -68,6 +98,10 @@ class DynamicBatchScheduler : public Scheduler {
       const int32_t max_batch_size,
       const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
       const inference::ModelDynamicBatching& batcher_config,
+      const ShapeBucketing& shape_bucketing,
+      const bool earliest_deadline_first, const uint64_t queue_latency_slo_us,
+      SharedExecutor* executor,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter,
       std::unique_ptr<Scheduler>* scheduler);
 
   ~DynamicBatchScheduler();
@@ -75,11 +109,26 @@ class DynamicBatchScheduler : public Scheduler {
   // \see Scheduler::Enqueue()
   Status Enqueue(std::unique_ptr<InferenceRequest>& request) override;
 
+  // \see Scheduler::EnqueueRequests()
+  Status EnqueueRequests(
+      std::vector<std::unique_ptr<InferenceRequest>>& requests) override;
+
+  // \see Scheduler::AddRunner()
+  Status AddRunner(const uint32_t runner_idx) override;
+
+  // \see Scheduler::RemoveRunner()
+  Status RemoveRunner(
+      const uint32_t runner_idx, std::shared_future<void>* removed) override;
+
+  // \see Scheduler::Load()
+  Status Load(
+      size_t* pending_cnt, uint32_t* runner_cnt, uint64_t* exec_ns) override;
+
  private:
   DynamicBatchScheduler(
-      const uint32_t runner_id_start, const uint32_t runner_cnt,
-      const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
-      const StandardRunFunc& OnSchedule, const bool dynamic_batching_enabled,
+      const int nice, const StandardInitFunc& OnInit,
+      const StandardWarmupFunc& OnWarmup, const StandardRunFunc& OnSchedule,
+      const bool dynamic_batching_enabled,
       const int32_t max_batch_size,
       const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
       const bool preserve_ordering,
@@ -87,13 +136,103 @@ class DynamicBatchScheduler : public Scheduler {
       const uint64_t max_queue_delay_microseconds,
       const inference::ModelQueuePolicy& default_queue_policy,
       const uint32_t priority_levels,
-      const ModelQueuePolicyMap& queue_policy_map);
+      const ModelQueuePolicyMap& queue_policy_map,
+      const ShapeBucketing& shape_bucketing,
+      const bool earliest_deadline_first, const uint64_t queue_latency_slo_us,
+      SharedExecutor* executor,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter);
+
+  // A pending batch of requests whose inputs have equal shapes, after
+  // padding if the shapes are padded.
+  struct ShapeBucket {
+    // The shape of each input whose shape must be equal within a
+    // batch.
+    std::unordered_map<std::string, std::vector<int64_t>> shapes_;
+
+    // The shape tensors of the request at the front of the bucket,
+    // whose contents must also be equal within a batch.
+    RequiredEqualInputs shape_tensors_;
+
+    // The requests in the order they are batched, by priority level
+    // and with delayed requests after the other requests of a level.
+    std::deque<PriorityQueue::HeldRequest> requests_;
+    size_t batch_size_;
+  };
+
+  // A scheduler thread and the runner that it schedules requests
+  // to. 'exit_' signals the thread to exit and 'stopped_' is ready
+  // once the thread no longer calls the run function.
+  struct SchedulerThreadInfo {
+    uint32_t runner_id_;
+    std::unique_ptr<std::thread> thread_;
+    std::shared_ptr<std::atomic<bool>> exit_;
+    std::shared_future<void> stopped_;
+  };
+
+  // A runner whose batches are executed by the shared executor.
+  // 'busy_' is set while a batch of the runner is submitted to the
+  // executor so that the runner executes one batch at a time. 'exit_'
+  // is set when the runner is removed and 'stopped_' is set once the
+  // runner no longer executes a batch.
+  struct ExecutorRunner {
+    uint32_t runner_id_;
+    int numa_node_;
+    bool busy_;
+    bool exit_;
+    std::shared_ptr<std::promise<void>> stopped_;
+    std::shared_future<void> stopped_future_;
+  };
+
+  // State shared with the executor tasks of the scheduler, which may
+  // run after the scheduler is destroyed. 'destroyed_' is set by the
+  // destructor, which waits until no task on another thread is using
+  // the scheduler. 'inflight_threads_' holds the thread of each task
+  // that is using the scheduler. Protected by 'mu_'.
+  struct ExecutorState {
+    ExecutorState() : destroyed_(false) {}
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool destroyed_;
+    std::vector<std::thread::id> inflight_threads_;
+  };
+
+  using RequestBatch = std::vector<std::unique_ptr<InferenceRequest>>;
+  using RejectedRequests =
+      std::vector<std::deque<std::unique_ptr<InferenceRequest>>>;
+
+  Status StartSchedulerThread(const uint32_t runner_id);
+  void JoinStoppedSchedulerThreads();
   void SchedulerThread(
       const uint32_t runner_id, const int nice,
       const std::shared_ptr<std::atomic<bool>>& rthread_exit,
       std::promise<bool>* is_initialized);
+  Status StartExecutorRunner(const uint32_t runner_id);
+  void DispatchToExecutor();
+  void ScheduleDispatch(const uint64_t wait_microseconds);
+  static void ExecutorTask(
+      DynamicBatchScheduler* scheduler,
+      const std::shared_ptr<ExecutorState>& state, ExecutorRunner* runner,
+      const std::shared_ptr<RequestBatch>& requests,
+      const std::shared_ptr<RejectedRequests>& rejected_requests);
+  uint64_t NextBatch(
+      const uint32_t runner_id, RequestBatch* requests,
+      std::shared_ptr<RejectedRequests>* rejected_requests, bool* wake_thread);
+  void UpdateExecutionTime(const uint64_t exec_ns, const size_t batch_size);
+  void WaitForWork(
+      std::unique_lock<std::mutex>& lock, const uint64_t wait_microseconds);
   uint64_t GetDynamicBatch(const int64_t runner_id);
+  uint64_t GetShapeBucketBatch(
+      std::vector<std::unique_ptr<InferenceRequest>>* requests);
+  ShapeBucket* AddToShapeBucket(PriorityQueue::HeldRequest&& held);
+  void ApplyPolicyToShapeBucket(
+      ShapeBucket* bucket, const uint64_t now_ns, uint64_t* wake_ns);
+  void PadToShapeBuckets(
+      std::vector<std::unique_ptr<InferenceRequest>>* requests);
+  Status CheckQueueLatencySlo();
+  void DelegateResponse(std::unique_ptr<InferenceRequest>& request);
   void FinalizeResponses();
+  void UpdatePendingCountMetric();
 
   // Function the scheduler will call to initialize a runner.
   const StandardInitFunc OnInit_;
@@ -107,8 +246,8 @@ class DynamicBatchScheduler : public Scheduler {
   // True if dynamic batching is enabled.
   const bool dynamic_batching_enabled_;
 
-  // The number of scheduler threads.
-  const uint32_t scheduler_thread_cnt_;
+  // The nice level of the scheduler threads.
+  const int nice_;
 
   // The number of scheduler threads currently idle.
   uint32_t idle_scheduler_thread_cnt_;
@@ -117,13 +256,49 @@ class DynamicBatchScheduler : public Scheduler {
   std::mutex mu_;
   std::condition_variable cv_;
 
+  // The deadlines of the timers that will notify 'cv_' so that the
+  // idle scheduler threads check the queue again. Protected by 'mu_'.
+  std::multiset<uint64_t> wake_deadlines_ns_;
+
   // Map from priority level to queue holding inference requests for the model
   // represented by this scheduler. If priority queues are not supported by the
   // scheduler, then priority zero entry is used as the single queue.
   PriorityQueue queue_;
 
-  std::vector<std::unique_ptr<std::thread>> scheduler_threads_;
-  std::vector<std::shared_ptr<std::atomic<bool>>> scheduler_threads_exit_;
+  // If true the queue orders requests by timeout and
+  // 'expected_exec_ns_' is the moving average of the time the run
+  // function takes to execute a batch, which the queue uses to reject
+  // requests that would miss their timeout. Protected by 'mu_'.
+  const bool earliest_deadline_first_;
+  uint64_t expected_exec_ns_;
+
+  // If not 0, the latency SLO of the queue, in ns. A request is
+  // rejected if the requests already queued are predicted to take
+  // longer than the SLO to execute, using 'queued_batch_size_' and
+  // 'expected_inference_ns_', the moving average of the execution
+  // time per inference of a batch. Protected by 'mu_'.
+  const uint64_t queue_latency_slo_ns_;
+  uint64_t expected_inference_ns_;
+
+  // The scheduler threads, including the threads that are signaled
+  // to exit but have not been joined yet, and the number of threads
+  // that are not signaled to exit. 'cumulative_exec_ns_' is the total
+  // time the run function has taken to execute the batches of all
+  // threads. Protected by 'mu_'.
+  std::vector<SchedulerThreadInfo> scheduler_threads_;
+  uint32_t runner_cnt_;
+  uint64_t cumulative_exec_ns_;
+
+  // If not nullptr, the executor that executes the batches of the
+  // runners in 'executor_runners_' instead of the scheduler threads.
+  // Batches are formed by the thread that enqueues a request and by
+  // the task that finishes a batch. If the pending batch is delayed a
+  // dispatch is scheduled at 'dispatch_deadline_ns_', which is 0 if
+  // no dispatch is scheduled. Protected by 'mu_'.
+  SharedExecutor* const executor_;
+  std::shared_ptr<ExecutorState> executor_state_;
+  std::list<ExecutorRunner> executor_runners_;
+  uint64_t dispatch_deadline_ns_;
 
   size_t max_batch_size_;
   size_t max_preferred_batch_size_;
@@ -144,6 +319,18 @@ class DynamicBatchScheduler : public Scheduler {
   // the batch.
   const std::unordered_map<std::string, bool> enforce_equal_shape_tensors_;
 
+  // The shape bucketing of the pending batches and, if it is enabled,
+  // the pending batches in the order the buckets were created. The
+  // shape tensors in 'enforce_equal_shape_tensors_' are recorded in
+  // 'shape_tensors_'. Requests are moved from 'queue_' into the
+  // buckets, where they are still held by 'queue_' so that its policy
+  // and maximum queue size apply to them, 'bucketed_cnt_' is the
+  // number of requests in all buckets. Protected by 'mu_'.
+  const ShapeBucketing shape_bucketing_;
+  std::unordered_map<std::string, bool> shape_tensors_;
+  std::list<ShapeBucket> shape_buckets_;
+  size_t bucketed_cnt_;
+
   // If true the ordering of responses matches the order of requests
   // even when there are multiple scheduler threads.
   const bool preserve_ordering_;
@@ -154,6 +341,14 @@ class DynamicBatchScheduler : public Scheduler {
       completion_queue_;
   // Lock to protect the completion_queues_
   std::mutex completion_queue_mtx_;
+
+  // Reporter for the pending request count. The gauge may be shared
+  // with other schedulers of the same model so it is updated with the
+  // change in the number of requests in 'queue_' and in the shape
+  // buckets since the last report, which is recorded in
+  // 'reported_pending_cnt_'. Protected by 'mu_'.
+  std::shared_ptr<MetricModelReporter> metric_reporter_;
+  size_t reported_pending_cnt_;
 };
 
 }}  // namespace nvidia::inferenceserver
@@ -53,7 +53,13 @@ class RequestTracker {
       InferenceStatsAggregator* stats_aggregator)
       : inflight_request_counter_(1), request_(std::move(request)),
         compute_start_ns_(compute_start_ns), metric_reporter_(metric_reporter),
-        stats_aggregator_(stats_aggregator), status_(Status::Success)
+        stats_aggregator_(stats_aggregator),
+#ifdef TRITON_ENABLE_STATS
+        // The context statistics are collected for a single request
+        // and so do not need to be sharded.
+        context_stats_aggregator_(1 /* shard_cnt */),
+#endif  // TRITON_ENABLE_STATS
+        status_(Status::Success)
   {
   }
 
@@ -337,6 +343,20 @@ class EnsembleContext {
       allocator_;
 };
 
+// A response of a composing model that completed while ScheduleSteps()
+// was issuing the request with the context locked on the same thread,
+// for example because the response was served from the response cache.
+struct DeferredResponse {
+  TRITONSERVER_InferenceResponse* response_;
+  uint32_t flags_;
+  void* userp_;
+};
+
+// The context that ScheduleSteps() is issuing a request for on this
+// thread, and the responses deferred until it unlocks the context.
+thread_local EnsembleContext* scheduling_context_ = nullptr;
+thread_local std::vector<DeferredResponse>* deferred_responses_ = nullptr;
+
 EnsembleContext::EnsembleContext(
     MetricModelReporter* metric_reporter,
     InferenceStatsAggregator* stats_aggregator, InferenceServer* is,
@@ -436,8 +456,7 @@ EnsembleContext::EnsembleContext(
     priority_ = lrequest->Priority();
     timeout_ = lrequest->TimeoutMicroseconds();
 
-    for (const auto& pr : lrequest->ImmutableInputs()) {
-      const InferenceRequest::Input* input = pr.second;
+    for (const InferenceRequest::Input* input : lrequest->ImmutableInputs()) {
       auto it = tensor_data_.find(input->Name());
       if (it != tensor_data_.end()) {
         auto& tensor_data = it->second;
@@ -550,6 +569,15 @@ void
 EnsembleContext::ResponseComplete(
     TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
 {
+  // The context is locked by this thread if the response completed
+  // while the request was being issued, process the response once the
+  // context is unlocked.
+  if ((scheduling_context_ != nullptr) &&
+      (reinterpret_cast<Step*>(userp)->ctx_.get() == scheduling_context_)) {
+    deferred_responses_->push_back(DeferredResponse{response, flags, userp});
+    return;
+  }
+
   auto step_ptr = std::unique_ptr<Step>(reinterpret_cast<Step*>(userp));
   step_ptr->response_flags_ = flags;
 
@@ -722,6 +750,12 @@ EnsembleContext::PrepareSteps(
       StepList res;
       std::set<std::pair<std::string, IterationCount>> updated_tensors;
       ensemble_status_ = UpdateEnsembleState(completed_step, &updated_tensors);
+      // Don't schedule the remaining steps of a cancelled request.
+      if (ensemble_status_.IsOk() &&
+          request_tracker_->Request()->IsCancelled()) {
+        ensemble_status_ =
+            Status(Status::Code::UNAVAILABLE, "Request was cancelled");
+      }
       if (ensemble_status_.IsOk()) {
         ensemble_status_ = GetNextSteps(updated_tensors, ready_steps);
       }
@@ -1148,6 +1182,7 @@ EnsembleContext::ScheduleSteps(
 {
   for (auto& step : steps) {
     step->ctx_ = context;
+    std::vector<DeferredResponse> deferred_responses;
     {
       std::lock_guard<std::mutex> lock(context->mutex_);
 
@@ -1155,7 +1190,19 @@ EnsembleContext::ScheduleSteps(
       // is called only once.
       if (context->ensemble_status_.IsOk()) {
         context->request_tracker_->IncrementCounter();
+
+        // The composing model may send the response before InferAsync
+        // returns, in which case ResponseComplete() defers it to
+        // 'deferred_responses'. Steps may be scheduled recursively
+        // while processing deferred responses, so restore the previous
+        // context when done.
+        EnsembleContext* prev_context = scheduling_context_;
+        std::vector<DeferredResponse>* prev_responses = deferred_responses_;
+        scheduling_context_ = context.get();
+        deferred_responses_ = &deferred_responses;
         context->ensemble_status_ = context->is_->InferAsync(step->request_);
+        scheduling_context_ = prev_context;
+        deferred_responses_ = prev_responses;
         if (!context->ensemble_status_.IsOk()) {
           // The request is not sent to server properly, shouldn't expect its
           // release function get called.
@@ -1166,6 +1213,10 @@ EnsembleContext::ScheduleSteps(
       }
       step.release();
     }
+
+    for (const auto& deferred : deferred_responses) {
+      ResponseComplete(deferred.response_, deferred.flags_, deferred.userp_);
+    }
   }
 }
 
@@ -72,7 +72,9 @@
 #include <sys/types.h>
 #include <cerrno>
 #include <fstream>
+#include <unordered_map>
 #include "src/core/constants.h"
+#include "src/core/localize_cache.h"
 #include "src/core/logging.h"
 #include "src/core/status.h"
 
@@ -391,6 +393,86 @@ LocalFileSystem::DeleteDirectory(const std::string& path)
   return Status::Success;
 }
 
+#if !defined(_WIN32) && \
+    (defined(TRITON_ENABLE_GCS) || defined(TRITON_ENABLE_S3))
+#define TRITON_ENABLE_LOCALIZE_CACHE
+#endif
+
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+// The localize cache, nullptr if not enabled.
+std::unique_ptr<LocalizeCache> localize_cache_;
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+
+#if defined(TRITON_ENABLE_GCS) || defined(TRITON_ENABLE_S3)
+bool
+LocalizeCacheEnabled()
+{
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+  return (localize_cache_ != nullptr);
+#else
+  return false;
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+}
+
+// The content hash and byte size of a cloud storage object, as
+// reported when listing the objects of a directory.
+struct ObjectContent {
+  std::string hash_;
+  uint64_t byte_size_;
+};
+
+// The listed objects, keyed by object name.
+using ObjectContentMap = std::unordered_map<std::string, ObjectContent>;
+
+// Return the localize cache key for 'object', or empty string if the
+// localize cache is not enabled, 'object' is not in 'objects' or the
+// object can't be cached.
+std::string
+LocalizeCacheKey(
+    const std::string& scheme, const ObjectContentMap& objects,
+    const std::string& object)
+{
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+  if (LocalizeCacheEnabled()) {
+    const auto itr = objects.find(object);
+    if (itr != objects.end()) {
+      return LocalizeCache::Key(
+          scheme, itr->second.hash_, itr->second.byte_size_);
+    }
+  }
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+  return std::string();
+}
+
+// Create 'local_path' from the localize cache if 'key' is cached.
+Status
+LocalizeFromCache(
+    const std::string& key, const std::string& local_path, bool* hit)
+{
+  *hit = false;
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+  if (!key.empty()) {
+    RETURN_IF_ERROR(localize_cache_->Get(key, local_path, hit));
+  }
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+  return Status::Success;
+}
+
+// Add a downloaded file to the localize cache. Failure is not fatal
+// to localization so it is only logged.
+void
+AddToLocalizeCache(const std::string& key, const std::string& local_path)
+{
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+  if (!key.empty()) {
+    LOG_STATUS_ERROR(
+        localize_cache_->Put(key, local_path),
+        "failed to add " + local_path + " to localize cache");
+  }
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+}
+#endif  // TRITON_ENABLE_GCS || TRITON_ENABLE_S3
+
 #if defined(TRITON_ENABLE_GCS) || defined(TRITON_ENABLE_S3) || \
     defined(TRITON_ENABLE_AZURE_STORAGE)
 // Helper function to take care of lack of trailing slashes
@@ -439,6 +521,11 @@ class GCSFileSystem : public FileSystem {
       const std::string path, bool* exists,
       google::cloud::StatusOr<gcs::ObjectMetadata>* metadata);
 
+  // Return in 'objects' the content hash and byte size of every
+  // object under the directory 'path', from a single listing of the
+  // objects.
+  Status ListObjectContents(const std::string& path, ObjectContentMap* objects);
+
   google::cloud::StatusOr<gcs::Client> client_;
 };
 
@@ -616,6 +703,33 @@ GCSFileSystem::GetDirectoryContents(
   return Status::Success;
 }
 
+Status
+GCSFileSystem::ListObjectContents(
+    const std::string& path, ObjectContentMap* objects)
+{
+  std::string bucket, dir_path;
+  RETURN_IF_ERROR(ParsePath(path, &bucket, &dir_path));
+
+  // Without a delimiter the listing includes the objects in all the
+  // subdirectories. GCS only reports a content hash for non-composite
+  // objects.
+  for (auto&& object_metadata :
+       client_->ListObjects(bucket, gcs::Prefix(AppendSlash(dir_path)))) {
+    if (!object_metadata) {
+      return Status(
+          Status::Code::INTERNAL, "Could not list contents of directory at " +
+                                      path + " : " +
+                                      object_metadata.status().message());
+    }
+
+    ObjectContent& content = (*objects)[object_metadata->name()];
+    content.hash_ = object_metadata->md5_hash();
+    content.byte_size_ = object_metadata->size();
+  }
+
+  return Status::Success;
+}
+
 Status
 GCSFileSystem::GetDirectorySubdirs(
     const std::string& path, std::set<std::string>* subdirs)
@@ -711,6 +825,15 @@ GCSFileSystem::LocalizeDirectory(
 
   localized->reset(new LocalizedDirectory(path, tmp_folder));
 
+  // List the content hash of all the objects at once to find the
+  // cached files, instead of requesting the metadata of each object.
+  ObjectContentMap object_contents;
+  if (LocalizeCacheEnabled()) {
+    LOG_STATUS_ERROR(
+        ListObjectContents(path, &object_contents),
+        "failed to list objects for localize cache");
+  }
+
   std::set<std::string> contents, filenames;
   RETURN_IF_ERROR(GetDirectoryContents(path, &filenames));
   for (auto itr = filenames.begin(); itr != filenames.end(); ++itr) {
@@ -755,6 +878,19 @@ GCSFileSystem::LocalizeDirectory(
         std::string file_bucket, file_object;
         RETURN_IF_ERROR(ParsePath(gcs_fpath, &file_bucket, &file_object));
 
+        std::string gcs_removed_path = (*iter).substr(path.size());
+        std::string local_file_path =
+            JoinPath({(*localized)->Path(), gcs_removed_path});
+
+        // Use the cached copy if the object content is unchanged.
+        const std::string cache_key =
+            LocalizeCacheKey("gcs", object_contents, file_object);
+        bool cached = false;
+        RETURN_IF_ERROR(LocalizeFromCache(cache_key, local_file_path, &cached));
+        if (cached) {
+          continue;
+        }
+
         // Send a request to read the object
         gcs::ObjectReadStream filestream =
             client_->ReadObject(file_bucket, file_object);
@@ -765,12 +901,11 @@ GCSFileSystem::LocalizeDirectory(
                                           filestream.status().message());
         }
 
-        std::string gcs_removed_path = (*iter).substr(path.size());
-        std::string local_file_path =
-            JoinPath({(*localized)->Path(), gcs_removed_path});
         std::ofstream output_file(local_file_path.c_str(), std::ios::binary);
         output_file << filestream.rdbuf();
         output_file.close();
+
+        AddToLocalizeCache(cache_key, local_file_path);
       }
     }
   }
@@ -1214,6 +1349,11 @@ class S3FileSystem : public FileSystem {
   Status ParsePath(
       const std::string& path, std::string* bucket, std::string* object);
   Status CleanPath(const std::string& s3_path, std::string* clean_path);
+
+  // Return in 'objects' the ETag and byte size of every object under
+  // the directory 'path', from a single listing of the objects.
+  Status ListObjectContents(const std::string& path, ObjectContentMap* objects);
+
   Aws::SDKOptions options_;
   s3::S3Client client_;
   re2::RE2 s3_regex_;
@@ -1546,6 +1686,47 @@ S3FileSystem::GetDirectoryContents(
   return Status::Success;
 }
 
+Status
+S3FileSystem::ListObjectContents(
+    const std::string& path, ObjectContentMap* objects)
+{
+  std::string bucket, dir_path;
+  RETURN_IF_ERROR(ParsePath(path, &bucket, &dir_path));
+
+  // Without a delimiter the listing includes the objects in all the
+  // subdirectories. Each response holds a limited number of objects,
+  // so continue after the last object until the listing is complete.
+  s3::Model::ListObjectsRequest objects_request;
+  objects_request.SetBucket(bucket.c_str());
+  objects_request.SetPrefix(AppendSlash(dir_path).c_str());
+  while (true) {
+    auto list_objects_outcome = client_.ListObjects(objects_request);
+    if (!list_objects_outcome.IsSuccess()) {
+      return Status(
+          Status::Code::INTERNAL,
+          "Could not list contents of directory at " + path +
+              " due to exception: " +
+              list_objects_outcome.GetError().GetExceptionName() +
+              ", error message: " +
+              list_objects_outcome.GetError().GetMessage());
+    }
+
+    const auto& result = list_objects_outcome.GetResult();
+    for (const auto& s3_object : result.GetContents()) {
+      ObjectContent& content = (*objects)[s3_object.GetKey().c_str()];
+      content.hash_ = s3_object.GetETag().c_str();
+      content.byte_size_ = s3_object.GetSize();
+    }
+
+    if (!result.GetIsTruncated() || result.GetContents().empty()) {
+      break;
+    }
+    objects_request.SetMarker(result.GetContents().back().GetKey());
+  }
+
+  return Status::Success;
+}
+
 Status
 S3FileSystem::GetDirectorySubdirs(
     const std::string& path, std::set<std::string>* subdirs)
@@ -1670,6 +1851,15 @@ S3FileSystem::LocalizeDirectory(
 
   localized->reset(new LocalizedDirectory(effective_path, tmp_folder));
 
+  // List the ETag of all the objects at once to find the cached
+  // files, instead of a HEAD request for each object.
+  ObjectContentMap object_contents;
+  if (LocalizeCacheEnabled()) {
+    LOG_STATUS_ERROR(
+        ListObjectContents(effective_path, &object_contents),
+        "failed to list objects for localize cache");
+  }
+
   std::set<std::string> contents, filenames;
   RETURN_IF_ERROR(GetDirectoryContents(effective_path, &filenames));
   for (auto itr = filenames.begin(); itr != filenames.end(); ++itr) {
@@ -1714,6 +1904,16 @@ S3FileSystem::LocalizeDirectory(
         std::string file_bucket, file_object;
         RETURN_IF_ERROR(ParsePath(s3_fpath, &file_bucket, &file_object));
 
+        // Use the cached copy if the object content, as identified by
+        // its ETag, is unchanged.
+        const std::string cache_key =
+            LocalizeCacheKey("s3", object_contents, file_object);
+        bool cached = false;
+        RETURN_IF_ERROR(LocalizeFromCache(cache_key, local_fpath, &cached));
+        if (cached) {
+          continue;
+        }
+
         s3::Model::GetObjectRequest object_request;
         object_request.SetBucket(file_bucket.c_str());
         object_request.SetKey(file_object.c_str());
@@ -1725,6 +1925,8 @@ S3FileSystem::LocalizeDirectory(
           std::ofstream output_file(local_fpath.c_str(), std::ios::binary);
           output_file << retrieved_file.rdbuf();
           output_file.close();
+
+          AddToLocalizeCache(cache_key, local_fpath);
         } else {
           return Status(
               Status::Code::INTERNAL,
@@ -2021,6 +2223,23 @@ LocalizeDirectory(
   return fs->LocalizeDirectory(path, localized);
 }
 
+Status
+SetLocalizeCache(const std::string& cache_dir, const uint64_t byte_size)
+{
+#ifdef TRITON_ENABLE_LOCALIZE_CACHE
+  if (localize_cache_ != nullptr) {
+    return Status(
+        Status::Code::ALREADY_EXISTS, "localize cache is already set");
+  }
+  return LocalizeCache::Create(cache_dir, byte_size, &localize_cache_);
+#else
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "localize cache requires GCS or S3 support and is not supported on "
+      "this platform");
+#endif  // TRITON_ENABLE_LOCALIZE_CACHE
+}
+
 Status
 WriteTextProto(const std::string& path, const google::protobuf::Message& msg)
 {
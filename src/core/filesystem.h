@@ -142,6 +142,19 @@ Status ReadTextFile(const std::string& path, std::string* contents);
 Status LocalizeDirectory(
     const std::string& path, std::shared_ptr<LocalizedDirectory>* localized);
 
+/// Enable a persistent local cache for the files that are downloaded
+/// when localizing a directory from cloud storage. Cached files are
+/// keyed by the content hash reported by the storage service and are
+/// hard-linked into each localized directory, so localizing unchanged
+/// files again (model reload, server restart) does not download them.
+/// Files are evicted in least-recently-used order when the total size
+/// of the cache exceeds 'byte_size'. Must be called before any
+/// directory is localized.
+/// \param cache_dir The local directory that holds the cached files.
+/// \param byte_size The maximum total byte size of the cached files.
+/// \return Error status
+Status SetLocalizeCache(const std::string& cache_dir, const uint64_t byte_size);
+
 /// Write a string to a file.
 /// \param path The path of the file.
 /// \param contents The contents to write to the file.
@@ -116,6 +116,26 @@ InferenceRequest::Run(std::unique_ptr<InferenceRequest>& request)
   return request->backend_raw_->Enqueue(request);
 }
 
+Status
+InferenceRequest::Run(std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  if (requests.empty()) {
+    return Status::Success;
+  }
+
+  InferenceBackend* backend = requests.front()->backend_raw_;
+  for (const auto& request : requests) {
+    if (request->backend_raw_ != backend) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "requests run together must use the same model version, found '" +
+              backend->Name() + "' and '" + request->ModelName() + "'");
+    }
+  }
+
+  return backend->Enqueue(requests);
+}
+
 void
 InferenceRequest::RespondIfError(
     std::unique_ptr<InferenceRequest>& request, const Status& status,
@@ -202,6 +222,7 @@ InferenceRequest::CopyAsNull(const InferenceRequest& from)
   lrequest->needs_normalization_ = false;
   lrequest->batch_size_ = from.batch_size_;
   lrequest->collect_stats_ = false;
+  lrequest->null_request_ = true;
 
   // Three passes: first to construct input for the shape tensors inputs, second
   // to obtain the max input byte size for allocating a large enough buffer for
@@ -328,9 +349,56 @@ InferenceRequest::CopyAsNull(const InferenceRequest& from)
   lrequest->SetReleaseCallback(NullRequestComplete, nullptr);
 
   // Must normalize inputs here...
+  lrequest->normalized_inputs_.reserve(lrequest->original_inputs_.size());
   for (auto& pr : lrequest->original_inputs_) {
-    lrequest->inputs_.emplace(
-        std::make_pair(pr.first, std::addressof(pr.second)));
+    lrequest->normalized_inputs_.push_back(std::addressof(pr.second));
+  }
+  lrequest->inputs_ = lrequest->normalized_inputs_;
+
+  return lrequest.release();
+}
+
+InferenceRequest*
+InferenceRequest::CopyWithoutData(const InferenceRequest& from)
+{
+  std::unique_ptr<InferenceRequest> lrequest(
+      new InferenceRequest(from.backend_raw_, from.requested_model_version_));
+  lrequest->backend_shared_ = from.backend_shared_;
+  lrequest->flags_ = from.flags_;
+  lrequest->correlation_id_ = from.correlation_id_;
+  lrequest->priority_ = from.priority_;
+  lrequest->timeout_us_ = from.timeout_us_;
+  lrequest->original_requested_outputs_ = from.original_requested_outputs_;
+  lrequest->original_inputs_.reserve(from.original_inputs_.size());
+
+  if (from.needs_normalization_) {
+    for (const auto& pr : from.original_inputs_) {
+      const auto& shape = pr.second.OriginalShape();
+      lrequest->AddOriginalInput(
+          pr.first, pr.second.DType(), shape.data(), shape.size());
+    }
+
+    return lrequest.release();
+  }
+
+  // Copy the normalized inputs in the same order so that the copy
+  // doesn't need to be normalized.
+  lrequest->normalized_inputs_.reserve(from.normalized_inputs_.size());
+  for (const Input* input : from.normalized_inputs_) {
+    const auto& shape = input->OriginalShape();
+    Input* new_input;
+    lrequest->AddOriginalInput(
+        input->Name(), input->DType(), shape.data(), shape.size(), &new_input);
+    *new_input->MutableShape() = input->Shape();
+    *new_input->MutableShapeWithBatchDim() = input->ShapeWithBatchDim();
+    new_input->SetIsShapeTensor(input->IsShapeTensor());
+    lrequest->normalized_inputs_.push_back(new_input);
+  }
+
+  lrequest->needs_normalization_ = false;
+  lrequest->batch_size_ = from.batch_size_;
+  if (from.requested_outputs_ != &from.original_requested_outputs_) {
+    lrequest->requested_outputs_ = from.requested_outputs_;
   }
 
   return lrequest.release();
@@ -356,15 +424,16 @@ Status
 InferenceRequest::ImmutableInput(
     const std::string& name, const InferenceRequest::Input** input) const
 {
-  auto itr = inputs_.find(name);
-  if (itr == inputs_.end()) {
-    return Status(
-        Status::Code::INVALID_ARG,
-        "input '" + name + "' does not exist in request");
+  for (const Input* in : inputs_) {
+    if (in->Name() == name) {
+      *input = in;
+      return Status::Success;
+    }
   }
 
-  *input = itr->second;
-  return Status::Success;
+  return Status(
+      Status::Code::INVALID_ARG,
+      "input '" + name + "' does not exist in request");
 }
 
 Status
@@ -451,16 +520,28 @@ InferenceRequest::AddOverrideInput(
   LOG_VERBOSE(1) << "adding input override for " << input->Name() << ": "
                  << *this;
 
-  const auto& pr =
-      override_inputs_.emplace(std::make_pair(input->Name(), input));
-  if (!pr.second) {
-    pr.first->second = input;
+  // Add or replace this override in the overrides and in the
+  // inputs...
+  auto oitr = override_inputs_.begin();
+  for (; oitr != override_inputs_.end(); ++oitr) {
+    if ((*oitr)->Name() == input->Name()) {
+      *oitr = input;
+      break;
+    }
+  }
+  if (oitr == override_inputs_.end()) {
+    override_inputs_.push_back(input);
   }
 
-  // Add or replace this override in the inputs...
-  const auto res = inputs_.emplace(std::make_pair(input->Name(), input.get()));
-  if (!res.second) {
-    res.first->second = input.get();
+  auto iitr = inputs_.begin();
+  for (; iitr != inputs_.end(); ++iitr) {
+    if ((*iitr)->Name() == input->Name()) {
+      *iitr = input.get();
+      break;
+    }
+  }
+  if (iitr == inputs_.end()) {
+    inputs_.push_back(input.get());
   }
 
   LOG_VERBOSE(1) << "added input override for " << input->Name() << ": "
@@ -511,9 +592,7 @@ InferenceRequest::PrepareForInference()
   // Initially show the actual inputs to be only the original
   // inputs. If overrides are added later they will be added to
   // 'inputs_'.
-  for (auto& pr : original_inputs_) {
-    inputs_.emplace(std::make_pair(pr.first, std::addressof(pr.second)));
-  }
+  inputs_ = normalized_inputs_;
 
   // Clear the timestamps
   queue_start_ns_ = 0;
@@ -534,12 +613,11 @@ InferenceRequest::Normalize()
   // Initialize the requested outputs to be used during inference. If
   // original_requested_outputs_ is empty assume all outputs specified
   // in model config are being requested.
-  requested_outputs_.clear();
-  if (original_requested_outputs_.size() == 0) {
-    for (const auto& output : model_config.output()) {
-      requested_outputs_.insert(output.name());
-    }
+  if (original_requested_outputs_.empty()) {
+    requested_outputs_ = &backend_raw_->OutputNames();
   } else {
+    requested_outputs_ = &original_requested_outputs_;
+
     // Validate if the original requested output name exists in the
     // model configuration.
     for (const auto& output_name : original_requested_outputs_) {
@@ -558,13 +636,34 @@ InferenceRequest::Normalize()
             " inputs for model '" + ModelName() + "'");
   }
 
+  // Resolve each input to the model configuration once, by index, so
+  // that the inputs are ordered as in the model configuration and the
+  // checks below don't need to look up the configuration by name.
+  normalized_inputs_.clear();
+  normalized_inputs_.reserve(model_config.input_size());
+  for (const auto& io : model_config.input()) {
+    auto itr = original_inputs_.find(io.name());
+    if (itr == original_inputs_.end()) {
+      // The request has the expected number of inputs so at least one
+      // of them is not a model input, report that input.
+      for (const auto& pr : original_inputs_) {
+        const inference::ModelInput* input_config;
+        RETURN_IF_ERROR(backend_raw_->GetInput(pr.first, &input_config));
+      }
+      return Status(
+          Status::Code::INVALID_ARG, "expected input '" + io.name() +
+                                         "' for model '" + ModelName() + "'");
+    }
+    normalized_inputs_.push_back(std::addressof(itr->second));
+  }
+
   // Determine the batch size and shape of each input.
   if (model_config.max_batch_size() == 0) {
     // Model does not support Triton-style batching so set as
     // batch-size 0 and leave the tensor shapes as they are.
     batch_size_ = 0;
-    for (auto& pr : original_inputs_) {
-      auto& input = pr.second;
+    for (auto input_ptr : normalized_inputs_) {
+      auto& input = *input_ptr;
       *input.MutableShape() = input.OriginalShape();
     }
   } else {
@@ -573,13 +672,12 @@ InferenceRequest::Normalize()
     // size. Adjust the shape of the input tensors to remove the batch
     // dimension.
     batch_size_ = 0;
-    for (auto& pr : original_inputs_) {
-      auto& input = pr.second;
+    for (size_t idx = 0; idx < normalized_inputs_.size(); ++idx) {
+      auto& input = *normalized_inputs_[idx];
 
       // For a shape tensor, keep the tensor's shape as it is and mark
       // that the input is a shape tensor.
-      const inference::ModelInput* input_config;
-      RETURN_IF_ERROR(backend_raw_->GetInput(pr.first, &input_config));
+      const inference::ModelInput* input_config = &model_config.input(idx);
       if (input_config->is_shape_tensor()) {
         *input.MutableShape() = input.OriginalShape();
         input.SetIsShapeTensor(true);
@@ -621,11 +719,10 @@ InferenceRequest::Normalize()
 
   // Verify that each input shape is valid for the model, make
   // adjustments for reshapes and find the total tensor size.
-  for (auto& pr : original_inputs_) {
-    const inference::ModelInput* input_config;
-    RETURN_IF_ERROR(backend_raw_->GetInput(pr.first, &input_config));
+  for (size_t idx = 0; idx < normalized_inputs_.size(); ++idx) {
+    const inference::ModelInput* input_config = &model_config.input(idx);
 
-    auto& input = pr.second;
+    auto& input = *normalized_inputs_[idx];
     auto shape = input.MutableShape();
 
     if (input.DType() != input_config->data_type()) {
@@ -648,7 +745,7 @@ InferenceRequest::Normalize()
       }
       return Status(
           Status::Code::INVALID_ARG,
-          "unexpected shape for input '" + pr.first + "' for model '" +
+          "unexpected shape for input '" + input.Name() + "' for model '" +
               ModelName() + "'. Expected " + DimsListToString(full_dims) +
               ", got " + DimsListToString(input.OriginalShape()));
     }
@@ -936,13 +1033,13 @@ operator<<(std::ostream& out, const InferenceRequest& request)
   }
 
   out << "override inputs:" << std::endl;
-  for (const auto& itr : request.OverrideInputs()) {
-    out << "[0x" << itr.second.get() << "] " << *itr.second << std::endl;
+  for (const auto& input : request.OverrideInputs()) {
+    out << "[0x" << input.get() << "] " << *input << std::endl;
   }
 
   out << "inputs:" << std::endl;
-  for (const auto& itr : request.ImmutableInputs()) {
-    out << "[0x" << itr.second << "] " << *itr.second << std::endl;
+  for (const auto input : request.ImmutableInputs()) {
+    out << "[0x" << input << "] " << *input << std::endl;
   }
 
   out << "original requested outputs:" << std::endl;
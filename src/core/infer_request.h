@@ -25,6 +25,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -54,6 +55,15 @@ class MetricModelReporter;
 //
 class InferenceRequest {
  public:
+  class Input;
+
+  // The inputs used during inference. The inputs are kept in a small
+  // vector instead of a map keyed by name so that preparing a request
+  // does not allocate or hash for each input, and so that inputs can
+  // be accessed by index. Requests have a small number of inputs so
+  // name lookup is a linear search.
+  using InputVector = std::vector<Input*>;
+
   // Input tensor
   class Input {
    public:
@@ -215,7 +225,9 @@ class InferenceRequest {
       InferenceBackend* backend, const int64_t requested_model_version)
       : needs_normalization_(true), backend_raw_(backend),
         requested_model_version_(requested_model_version), flags_(0),
-        correlation_id_(0), batch_size_(0), timeout_us_(0), collect_stats_(true)
+        correlation_id_(0), batch_size_(0), timeout_us_(0),
+        cancelled_(false), requested_outputs_(&original_requested_outputs_),
+        collect_stats_(true), null_request_(false)
   {
     SetPriority(0);
   }
@@ -247,6 +259,14 @@ class InferenceRequest {
   uint64_t TimeoutMicroseconds() const { return timeout_us_; }
   void SetTimeoutMicroseconds(uint64_t t) { timeout_us_ = t; }
 
+  // Cancel the request, for example because the client that sent it
+  // has disconnected. A cancelled request that is still queued by the
+  // scheduler is released without being executed, and a backend
+  // executing the request may check IsCancelled() to stop early. A
+  // request can be cancelled from any thread.
+  bool IsCancelled() const { return cancelled_; }
+  void Cancel() { cancelled_ = true; }
+
 #ifdef TRITON_ENABLE_TRACING
   const std::unique_ptr<InferenceTrace>& Trace() const { return trace_; }
   std::unique_ptr<InferenceTrace>* MutableTrace() { return &trace_; }
@@ -284,27 +304,21 @@ class InferenceRequest {
   // an override input if it is being shared unless you want that
   // change to be reflected in all requests that hold that override
   // input. Override inputs within a specific request are not
-  // persisted across inference calls.
-  std::unordered_map<std::string, std::shared_ptr<Input>>*
-  MutableOverrideInputs()
-  {
-    return &override_inputs_;
-  }
-  const std::unordered_map<std::string, std::shared_ptr<Input>>&
-  OverrideInputs() const
+  // persisted across inference calls. There is at most one override
+  // input for each name.
+  const std::vector<std::shared_ptr<Input>>& OverrideInputs() const
   {
     return override_inputs_;
   }
 
   // Get an input taking into account both original inputs and
   // overrides. If an override input is available use it, otherwise
-  // use the original input. Accessing inputs via this method is not
-  // valid until after PrepareForInference is called.
+  // use the original input. The inputs are in the order of the inputs
+  // in the model configuration, followed by the override inputs that
+  // don't replace an original input. Accessing inputs via this method
+  // is not valid until after PrepareForInference is called.
   Status ImmutableInput(const std::string& name, const Input** input) const;
-  const std::unordered_map<std::string, Input*>& ImmutableInputs() const
-  {
-    return inputs_;
-  }
+  const InputVector& ImmutableInputs() const { return inputs_; }
 
   // The original requested outputs are the requested outputs added to
   // the request before the inference execution (that is before
@@ -322,8 +336,7 @@ class InferenceRequest {
   // after PrepareForInference is called.
   const std::set<std::string>& ImmutableRequestedOutputs() const
   {
-    return (requested_outputs_.empty()) ? original_requested_outputs_
-                                        : requested_outputs_;
+    return *requested_outputs_;
   }
 
   // Get the response factory.
@@ -419,6 +432,13 @@ class InferenceRequest {
   // ownership of 'request'.
   static Status Run(std::unique_ptr<InferenceRequest>& request);
 
+  // Run a set of inference requests that all use the same backend. The
+  // call takes ownership of each request that is run, setting the
+  // corresponding entry of 'requests' to nullptr. If non-success is
+  // returned then the caller still retains ownership of the requests
+  // that were not run.
+  static Status Run(std::vector<std::unique_ptr<InferenceRequest>>& requests);
+
   // Send an error response for this request. If 'status' is Success
   // then no response is sent and the request is not released (even if
   // 'release_request' is true). Because this is sending an error it
@@ -457,6 +477,17 @@ class InferenceRequest {
   // The statistics of the copy will not be collected.
   static InferenceRequest* CopyAsNull(const InferenceRequest& from);
 
+  // Create a copy of 'from' for the same model with the same inputs,
+  // without input data, and the same requested outputs, flags,
+  // correlation ID, priority and timeout. The copy has no ID,
+  // callbacks or trace. If 'from' is normalized then the copy is also
+  // normalized, so preparing the copy for inference doesn't normalize
+  // it again unless inputs or requested outputs are added or removed.
+  static InferenceRequest* CopyWithoutData(const InferenceRequest& from);
+
+  // Is this a "null" request created by CopyAsNull()?
+  bool IsNull() const { return null_request_; }
+
   uint64_t QueueStartNs() const { return queue_start_ns_; }
   uint64_t CaptureQueueStartNs()
   {
@@ -536,16 +567,23 @@ class InferenceRequest {
   uint32_t batch_size_;
   uint32_t priority_;
   uint64_t timeout_us_;
+  std::atomic<bool> cancelled_;
 
   std::unordered_map<std::string, Input> original_inputs_;
-  std::unordered_map<std::string, std::shared_ptr<Input>> override_inputs_;
-  std::unordered_map<std::string, Input*> inputs_;
+  std::vector<std::shared_ptr<Input>> override_inputs_;
+  InputVector inputs_;
   std::set<std::string> original_requested_outputs_;
 
-  // requested_outputs_ is to be used post-normalization. It will be
-  // empty unless it differs from original_requested_outputs_, so
+  // The original inputs in the order of the inputs in the model
+  // configuration. Set by normalization so that preparing the request
+  // only needs to copy the input pointers.
+  InputVector normalized_inputs_;
+
+  // requested_outputs_ is to be used post-normalization. It points to
+  // original_requested_outputs_ unless no outputs are requested, in
+  // which case it points to the names of all the model outputs, so
   // typically should access it through ImmutableRequestedOutputs.
-  std::set<std::string> requested_outputs_;
+  const std::set<std::string>* requested_outputs_;
 
   // The release function and user pointer for this request.
   TRITONSERVER_InferenceRequestReleaseFn_t release_fn_;
@@ -568,6 +606,9 @@ class InferenceRequest {
   // Whether the stats of the request should be collected.
   bool collect_stats_;
 
+  // Whether this is a "null" request created by CopyAsNull().
+  bool null_request_;
+
 #ifdef TRITON_ENABLE_STATS
   uint64_t request_start_ns_;
   InferenceStatsAggregator* secondary_stats_aggregator_ = nullptr;
@@ -68,6 +68,16 @@ class InferenceResponseFactory {
     return Status::Success;
   }
 
+  // The response allocator and callback of the responses created by
+  // this factory.
+  const ResponseAllocator* Allocator() const { return allocator_; }
+  void* AllocatorUserp() const { return alloc_userp_; }
+  TRITONSERVER_InferenceResponseCompleteFn_t ResponseFn() const
+  {
+    return response_fn_;
+  }
+  void* ResponseUserp() const { return response_userp_; }
+
   // Create a new response.
   Status CreateResponse(std::unique_ptr<InferenceResponse>* response) const;
 
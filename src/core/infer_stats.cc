@@ -27,6 +27,7 @@
 #include "src/core/infer_stats.h"
 
 #include <time.h>
+#include <algorithm>
 #include "src/core/logging.h"
 #include "src/core/metric_model_reporter.h"
 #include "src/core/metrics.h"
@@ -35,15 +36,129 @@ namespace nvidia { namespace inferenceserver {
 
 #ifdef TRITON_ENABLE_STATS
 
+InferenceStatsAggregator::InferenceStatsAggregator(const size_t shard_cnt)
+    : shard_cnt_(std::max((size_t)1, shard_cnt)),
+      shard_buffer_(new char[shard_cnt_ * sizeof(Shard) + alignof(Shard)])
+{
+  void* ptr = shard_buffer_.get();
+  size_t space = shard_cnt_ * sizeof(Shard) + alignof(Shard);
+  shards_ = static_cast<Shard*>(
+      std::align(alignof(Shard), shard_cnt_ * sizeof(Shard), ptr, space));
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    new (&shards_[i]) Shard();
+  }
+}
+
+InferenceStatsAggregator::~InferenceStatsAggregator()
+{
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    shards_[i].~Shard();
+  }
+}
+
+InferenceStatsAggregator::Shard&
+InferenceStatsAggregator::ThreadShard()
+{
+  // Assign shards to threads round-robin so that a small number of
+  // threads, for example one per model instance, each get a different
+  // shard.
+  static std::atomic<size_t> next_thread_idx(0);
+  static thread_local const size_t thread_idx = next_thread_idx++;
+  return shards_[thread_idx % shard_cnt_];
+}
+
+uint64_t
+InferenceStatsAggregator::LastInferenceMs() const
+{
+  uint64_t last_inference_ms = 0;
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu_);
+    last_inference_ms =
+        std::max(last_inference_ms, shards_[i].last_inference_ms_);
+  }
+  return last_inference_ms;
+}
+
+uint64_t
+InferenceStatsAggregator::InferenceCount() const
+{
+  uint64_t inference_count = 0;
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu_);
+    inference_count += shards_[i].inference_count_;
+  }
+  return inference_count;
+}
+
+uint64_t
+InferenceStatsAggregator::ExecutionCount() const
+{
+  uint64_t execution_count = 0;
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu_);
+    execution_count += shards_[i].execution_count_;
+  }
+  return execution_count;
+}
+
+InferenceStatsAggregator::InferStats
+InferenceStatsAggregator::ImmutableInferStats() const
+{
+  InferStats infer_stats;
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu_);
+    const InferStats& shard_stats = shards_[i].infer_stats_;
+    infer_stats.failure_count_ += shard_stats.failure_count_;
+    infer_stats.failure_duration_ns_ += shard_stats.failure_duration_ns_;
+    infer_stats.success_count_ += shard_stats.success_count_;
+    infer_stats.request_duration_ns_ += shard_stats.request_duration_ns_;
+    infer_stats.queue_duration_ns_ += shard_stats.queue_duration_ns_;
+    infer_stats.compute_input_duration_ns_ +=
+        shard_stats.compute_input_duration_ns_;
+    infer_stats.compute_infer_duration_ns_ +=
+        shard_stats.compute_infer_duration_ns_;
+    infer_stats.compute_output_duration_ns_ +=
+        shard_stats.compute_output_duration_ns_;
+    infer_stats.cache_hit_count_ += shard_stats.cache_hit_count_;
+    infer_stats.cache_hit_duration_ns_ += shard_stats.cache_hit_duration_ns_;
+    infer_stats.cache_miss_count_ += shard_stats.cache_miss_count_;
+    infer_stats.cache_miss_duration_ns_ += shard_stats.cache_miss_duration_ns_;
+    infer_stats.cache_eviction_count_ += shard_stats.cache_eviction_count_;
+    infer_stats.coalesced_count_ += shard_stats.coalesced_count_;
+    infer_stats.coalesced_duration_ns_ += shard_stats.coalesced_duration_ns_;
+  }
+  return infer_stats;
+}
+
+std::map<size_t, InferenceStatsAggregator::InferBatchStats>
+InferenceStatsAggregator::ImmutableInferBatchStats() const
+{
+  std::map<size_t, InferBatchStats> batch_stats;
+  for (size_t i = 0; i < shard_cnt_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu_);
+    for (const auto& pr : shards_[i].batch_stats_) {
+      InferBatchStats& stats = batch_stats[pr.first];
+      stats.count_ += pr.second.count_;
+      stats.compute_input_duration_ns_ += pr.second.compute_input_duration_ns_;
+      stats.compute_infer_duration_ns_ += pr.second.compute_infer_duration_ns_;
+      stats.compute_output_duration_ns_ +=
+          pr.second.compute_output_duration_ns_;
+    }
+  }
+  return batch_stats;
+}
+
 void
 InferenceStatsAggregator::UpdateFailure(
     MetricModelReporter* metric_reporter, const uint64_t request_start_ns,
     const uint64_t request_end_ns)
 {
-  std::lock_guard<std::mutex> lock(mu_);
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
 
-  infer_stats_.failure_count_++;
-  infer_stats_.failure_duration_ns_ += (request_end_ns - request_start_ns);
+  shard.infer_stats_.failure_count_++;
+  shard.infer_stats_.failure_duration_ns_ +=
+      (request_end_ns - request_start_ns);
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -84,16 +199,18 @@ InferenceStatsAggregator::UpdateSuccessWithDuration(
   const uint64_t request_duration_ns = request_end_ns - request_start_ns;
   const uint64_t queue_duration_ns = compute_start_ns - queue_start_ns;
 
-  std::lock_guard<std::mutex> lock(mu_);
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
 
-  inference_count_ += batch_size;
+  shard.inference_count_ += batch_size;
 
-  infer_stats_.success_count_++;
-  infer_stats_.request_duration_ns_ += request_duration_ns;
-  infer_stats_.queue_duration_ns_ += queue_duration_ns;
-  infer_stats_.compute_input_duration_ns_ += compute_input_duration_ns;
-  infer_stats_.compute_infer_duration_ns_ += compute_infer_duration_ns;
-  infer_stats_.compute_output_duration_ns_ += compute_output_duration_ns;
+  InferStats& infer_stats = shard.infer_stats_;
+  infer_stats.success_count_++;
+  infer_stats.request_duration_ns_ += request_duration_ns;
+  infer_stats.queue_duration_ns_ += queue_duration_ns;
+  infer_stats.compute_input_duration_ns_ += compute_input_duration_ns;
+  infer_stats.compute_infer_duration_ns_ += compute_infer_duration_ns;
+  infer_stats.compute_output_duration_ns_ += compute_output_duration_ns;
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -109,6 +226,125 @@ InferenceStatsAggregator::UpdateSuccessWithDuration(
         compute_infer_duration_ns / 1000);
     metric_reporter->MetricInferenceComputeOutputDuration().Increment(
         compute_output_duration_ns / 1000);
+    if (metric_reporter->MetricInferenceRequestLatency() != nullptr) {
+      metric_reporter->MetricInferenceRequestLatency()->Observe(
+          request_duration_ns / 1000);
+      metric_reporter->MetricInferenceQueueLatency()->Observe(
+          queue_duration_ns / 1000);
+      metric_reporter->MetricInferenceComputeInferLatency()->Observe(
+          compute_infer_duration_ns / 1000);
+    }
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+InferenceStatsAggregator::UpdateCacheHit(
+    MetricModelReporter* metric_reporter, const size_t batch_size,
+    const uint64_t request_start_ns, const uint64_t request_end_ns)
+{
+  const uint64_t request_duration_ns = request_end_ns - request_start_ns;
+
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
+
+  // A request served from the cache is a successful inference request
+  // that spends no time in the queue or in compute.
+  shard.inference_count_ += batch_size;
+
+  InferStats& infer_stats = shard.infer_stats_;
+  infer_stats.success_count_++;
+  infer_stats.request_duration_ns_ += request_duration_ns;
+  infer_stats.cache_hit_count_++;
+  infer_stats.cache_hit_duration_ns_ += request_duration_ns;
+
+#ifdef TRITON_ENABLE_METRICS
+  if (metric_reporter != nullptr) {
+    metric_reporter->MetricInferenceSuccess().Increment(1);
+    metric_reporter->MetricInferenceCount().Increment(batch_size);
+    metric_reporter->MetricInferenceRequestDuration().Increment(
+        request_duration_ns / 1000);
+    if (metric_reporter->MetricInferenceRequestLatency() != nullptr) {
+      metric_reporter->MetricInferenceRequestLatency()->Observe(
+          request_duration_ns / 1000);
+    }
+    if (metric_reporter->MetricCacheHitCount() != nullptr) {
+      metric_reporter->MetricCacheHitCount()->Increment(1);
+    }
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+InferenceStatsAggregator::UpdateCacheMiss(
+    MetricModelReporter* metric_reporter,
+    const uint64_t cache_miss_duration_ns)
+{
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
+
+  shard.infer_stats_.cache_miss_count_++;
+  shard.infer_stats_.cache_miss_duration_ns_ += cache_miss_duration_ns;
+
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter != nullptr) &&
+      (metric_reporter->MetricCacheMissCount() != nullptr)) {
+    metric_reporter->MetricCacheMissCount()->Increment(1);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+InferenceStatsAggregator::UpdateCacheEviction(
+    MetricModelReporter* metric_reporter)
+{
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
+
+  shard.infer_stats_.cache_eviction_count_++;
+
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter != nullptr) &&
+      (metric_reporter->MetricCacheEvictionCount() != nullptr)) {
+    metric_reporter->MetricCacheEvictionCount()->Increment(1);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+InferenceStatsAggregator::UpdateCoalesced(
+    MetricModelReporter* metric_reporter, const size_t batch_size,
+    const uint64_t request_start_ns, const uint64_t request_end_ns)
+{
+  const uint64_t request_duration_ns = request_end_ns - request_start_ns;
+
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
+
+  // A request responded to with the response of an identical request
+  // is a successful inference request that spends no time in the
+  // queue or in compute.
+  shard.inference_count_ += batch_size;
+
+  InferStats& infer_stats = shard.infer_stats_;
+  infer_stats.success_count_++;
+  infer_stats.request_duration_ns_ += request_duration_ns;
+  infer_stats.coalesced_count_++;
+  infer_stats.coalesced_duration_ns_ += request_duration_ns;
+
+#ifdef TRITON_ENABLE_METRICS
+  if (metric_reporter != nullptr) {
+    metric_reporter->MetricInferenceSuccess().Increment(1);
+    metric_reporter->MetricInferenceCount().Increment(batch_size);
+    metric_reporter->MetricInferenceRequestDuration().Increment(
+        request_duration_ns / 1000);
+    if (metric_reporter->MetricInferenceRequestLatency() != nullptr) {
+      metric_reporter->MetricInferenceRequestLatency()->Observe(
+          request_duration_ns / 1000);
+    }
+    if (metric_reporter->MetricInferenceCoalesced() != nullptr) {
+      metric_reporter->MetricInferenceCoalesced()->Increment(1);
+    }
   }
 #endif  // TRITON_ENABLE_METRICS
 }
@@ -140,17 +376,18 @@ InferenceStatsAggregator::UpdateInferBatchStatsWithDuration(
           std::chrono::system_clock::now().time_since_epoch())
           .count();
 
-  std::lock_guard<std::mutex> lock(mu_);
+  Shard& shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.mu_);
 
-  if (inference_ms > last_inference_ms_) {
-    last_inference_ms_ = inference_ms;
+  if (inference_ms > shard.last_inference_ms_) {
+    shard.last_inference_ms_ = inference_ms;
   }
 
-  execution_count_++;
+  shard.execution_count_++;
 
-  auto it = batch_stats_.find(batch_size);
-  if (it == batch_stats_.end()) {
-    it = batch_stats_.emplace(batch_size, InferBatchStats()).first;
+  auto it = shard.batch_stats_.find(batch_size);
+  if (it == shard.batch_stats_.end()) {
+    it = shard.batch_stats_.emplace(batch_size, InferBatchStats()).first;
   }
   it->second.count_++;
   it->second.compute_input_duration_ns_ += compute_input_duration_ns;
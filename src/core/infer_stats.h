@@ -26,6 +26,7 @@
 #pragma once
 
 #include <time.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -51,7 +52,10 @@ class InferenceStatsAggregator {
         : failure_count_(0), failure_duration_ns_(0), success_count_(0),
           request_duration_ns_(0), queue_duration_ns_(0),
           compute_input_duration_ns_(0), compute_infer_duration_ns_(0),
-          compute_output_duration_ns_(0)
+          compute_output_duration_ns_(0), cache_hit_count_(0),
+          cache_hit_duration_ns_(0), cache_miss_count_(0),
+          cache_miss_duration_ns_(0), cache_eviction_count_(0),
+          coalesced_count_(0), coalesced_duration_ns_(0)
     {
     }
     uint64_t failure_count_;
@@ -63,6 +67,15 @@ class InferenceStatsAggregator {
     uint64_t compute_input_duration_ns_;
     uint64_t compute_infer_duration_ns_;
     uint64_t compute_output_duration_ns_;
+
+    uint64_t cache_hit_count_;
+    uint64_t cache_hit_duration_ns_;
+    uint64_t cache_miss_count_;
+    uint64_t cache_miss_duration_ns_;
+    uint64_t cache_eviction_count_;
+
+    uint64_t coalesced_count_;
+    uint64_t coalesced_duration_ns_;
   };
 
   struct InferBatchStats {
@@ -77,20 +90,26 @@ class InferenceStatsAggregator {
     uint64_t compute_output_duration_ns_;
   };
 
-  // Create an aggregator for model statistics
-  InferenceStatsAggregator()
-      : last_inference_ms_(0), inference_count_(0), execution_count_(0)
-  {
-  }
-
-  uint64_t LastInferenceMs() const { return last_inference_ms_; }
-  uint64_t InferenceCount() const { return inference_count_; }
-  uint64_t ExecutionCount() const { return execution_count_; }
-  const InferStats& ImmutableInferStats() const { return infer_stats_; }
-  const std::map<size_t, InferBatchStats>& ImmutableInferBatchStats() const
-  {
-    return batch_stats_;
-  }
+  // Create an aggregator for model statistics. The statistics are
+  // accumulated in 'shard_cnt' independent shards so that threads
+  // reporting statistics at the same time do not contend on a single
+  // lock. The shards are merged when the statistics are read.
+  InferenceStatsAggregator() : InferenceStatsAggregator(kDefaultShardCount) {}
+  explicit InferenceStatsAggregator(const size_t shard_cnt);
+  ~InferenceStatsAggregator();
+
+  // Each read merges the shards one at a time, holding only the lock
+  // of the shard being merged, so the result is not an atomic
+  // snapshot of the statistics. An update to a shard that was already
+  // merged is missed by the read, and separate reads, for example
+  // InferenceCount() and ExecutionCount(), may not be consistent with
+  // each other. The statistics of a single update are always either
+  // all included or all missed.
+  uint64_t LastInferenceMs() const;
+  uint64_t InferenceCount() const;
+  uint64_t ExecutionCount() const;
+  InferStats ImmutableInferStats() const;
+  std::map<size_t, InferBatchStats> ImmutableInferBatchStats() const;
 
   // Add durations to Infer stats for a failed inference request.
   void UpdateFailure(
@@ -131,13 +150,62 @@ class InferenceStatsAggregator {
       const uint64_t compute_infer_duration_ns,
       const uint64_t compute_output_duration_ns);
 
+  // Add duration to infer stats for an inference request that was
+  // responded to from the response cache. The request is also counted
+  // as a successful inference request.
+  void UpdateCacheHit(
+      MetricModelReporter* metric_reporter, const size_t batch_size,
+      const uint64_t request_start_ns, const uint64_t request_end_ns);
+
+  // Add the time spent looking up and inserting into the response
+  // cache to infer stats for an inference request that was not found
+  // in the cache.
+  void UpdateCacheMiss(
+      MetricModelReporter* metric_reporter,
+      const uint64_t cache_miss_duration_ns);
+
+  // Count the eviction of a response cache entry.
+  void UpdateCacheEviction(MetricModelReporter* metric_reporter);
+
+  // Add duration to infer stats for an inference request that was
+  // responded to with the response of an identical request. The
+  // request is also counted as a successful inference request.
+  void UpdateCoalesced(
+      MetricModelReporter* metric_reporter, const size_t batch_size,
+      const uint64_t request_start_ns, const uint64_t request_end_ns);
+
  private:
-  std::mutex mu_;
-  uint64_t last_inference_ms_;
-  uint64_t inference_count_;
-  uint64_t execution_count_;
-  InferStats infer_stats_;
-  std::map<size_t, InferBatchStats> batch_stats_;
+  // The default number of shards. Backend threads are typically one
+  // per model instance so this allows that many instances to report
+  // without contention.
+  static constexpr size_t kDefaultShardCount = 16;
+
+  // The statistics accumulated by a subset of the reporting
+  // threads. Aligned so that shards used by different threads do not
+  // share a cache line.
+  struct alignas(64) Shard {
+    Shard() : last_inference_ms_(0), inference_count_(0), execution_count_(0)
+    {
+    }
+    mutable std::mutex mu_;
+    uint64_t last_inference_ms_;
+    uint64_t inference_count_;
+    uint64_t execution_count_;
+    InferStats infer_stats_;
+    std::map<size_t, InferBatchStats> batch_stats_;
+  };
+
+  // Return the shard that the calling thread reports to. A thread
+  // always reports to the same shard.
+  Shard& ThreadShard();
+
+  const size_t shard_cnt_;
+
+  // The shards are constructed in 'shard_buffer_', which is allocated
+  // with room to align them as new[] does not honor the alignment of
+  // over-aligned types before C++17.
+  std::unique_ptr<char[]> shard_buffer_;
+  Shard* shards_;
 #endif  // TRITON_ENABLE_STATS
 };
 
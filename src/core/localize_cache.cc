@@ -0,0 +1,301 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/localize_cache.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <vector>
+#include "src/core/constants.h"
+#include "src/core/filesystem.h"
+#include "src/core/logging.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+// Create 'dst_path' as a hard link to 'src_path'. Fall back to
+// copying the file if a link can't be created, for example because
+// the two paths are on different filesystems.
+Status
+LinkOrCopyFile(const std::string& src_path, const std::string& dst_path)
+{
+  if (link(src_path.c_str(), dst_path.c_str()) == 0) {
+    return Status::Success;
+  }
+
+  if ((errno != EXDEV) && (errno != EPERM) && (errno != EMLINK)) {
+    return Status(
+        Status::Code::INTERNAL, "failed to link " + src_path + " to " +
+                                    dst_path + ", errno:" + strerror(errno));
+  }
+
+  std::ifstream in(src_path, std::ios::in | std::ios::binary);
+  std::ofstream out(dst_path, std::ios::out | std::ios::binary);
+  if (!in || !out) {
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to copy " + src_path + " to " + dst_path);
+  }
+  out << in.rdbuf();
+  out.close();
+  if (!out) {
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to copy " + src_path + " to " + dst_path);
+  }
+
+  return Status::Success;
+}
+
+}  // namespace
+
+Status
+LocalizeCache::Create(
+    const std::string& cache_dir, const uint64_t byte_size,
+    std::unique_ptr<LocalizeCache>* cache)
+{
+  bool exists = false;
+  RETURN_IF_ERROR(FileExists(cache_dir, &exists));
+  if (!exists) {
+    if (mkdir(cache_dir.c_str(), S_IRWXU) != 0) {
+      return Status(
+          Status::Code::INTERNAL, "failed to create localize cache directory " +
+                                      cache_dir + ", errno:" + strerror(errno));
+    }
+  }
+
+  bool is_dir = false;
+  RETURN_IF_ERROR(IsDirectory(cache_dir, &is_dir));
+  if (!is_dir) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "localize cache path " + cache_dir + " is not a directory");
+  }
+
+  std::unique_ptr<LocalizeCache> lcache(
+      new LocalizeCache(cache_dir, byte_size));
+
+  // Index the files left by a previous run, ordered by last use.
+  std::set<std::string> contents;
+  RETURN_IF_ERROR(GetDirectoryContents(cache_dir, &contents));
+
+  std::vector<std::pair<int64_t, Entry>> found;
+  for (const auto& name : contents) {
+    const std::string path = JoinPath({cache_dir, name});
+    struct stat st;
+    if ((stat(path.c_str(), &st) != 0) || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+
+    // Remove partially added files.
+    if (name.find(".tmp") != std::string::npos) {
+      remove(path.c_str());
+      continue;
+    }
+
+    found.emplace_back(
+        TIMESPEC_TO_NANOS(st.st_mtim), Entry(name, st.st_size));
+  }
+
+  std::sort(
+      found.begin(), found.end(),
+      [](const std::pair<int64_t, Entry>& a,
+         const std::pair<int64_t, Entry>& b) { return a.first > b.first; });
+  for (const auto& pr : found) {
+    lcache->lru_.push_back(pr.second);
+    lcache->entries_.emplace(pr.second.key_, std::prev(lcache->lru_.end()));
+    lcache->byte_size_ += pr.second.byte_size_;
+  }
+
+  lcache->Evict();
+
+  LOG_INFO << "Using localize cache " << cache_dir << ": "
+           << lcache->entries_.size() << " files, " << lcache->byte_size_
+           << " of " << lcache->max_byte_size_ << " bytes";
+
+  *cache = std::move(lcache);
+  return Status::Success;
+}
+
+std::string
+LocalizeCache::Key(
+    const std::string& scheme, const std::string& hash,
+    const uint64_t byte_size)
+{
+  // Keep the key usable as a file name. Base64 hashes map '+' and '/'
+  // to '-' and '_', quotes and padding are dropped.
+  std::string sanitized;
+  for (const char c : hash) {
+    if (isalnum(c) || (c == '-') || (c == '_')) {
+      sanitized += c;
+    } else if (c == '+') {
+      sanitized += '-';
+    } else if (c == '/') {
+      sanitized += '_';
+    }
+  }
+
+  if (sanitized.empty()) {
+    return std::string();
+  }
+
+  return scheme + "_" + sanitized + "_" + std::to_string(byte_size);
+}
+
+Status
+LocalizeCache::Get(
+    const std::string& key, const std::string& dst_path, bool* hit)
+{
+  *hit = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto itr = entries_.find(key);
+    if (itr == entries_.end()) {
+      return Status::Success;
+    }
+
+    lru_.splice(lru_.begin(), lru_, itr->second);
+  }
+
+  const std::string cached_path = JoinPath({cache_dir_, key});
+  Status status = LinkOrCopyFile(cached_path, dst_path);
+  if (!status.IsOk()) {
+    // The file may have been evicted since it was found, or removed
+    // from outside of the server. Drop the entry if the file is gone
+    // so that the file is downloaded and cached again.
+    LOG_VERBOSE(1) << "localize cache miss for " << key << ": "
+                   << status.AsString();
+    if (access(cached_path.c_str(), F_OK) != 0) {
+      std::lock_guard<std::mutex> lock(mu_);
+      auto itr = entries_.find(key);
+      if (itr != entries_.end()) {
+        byte_size_ -= itr->second->byte_size_;
+        lru_.erase(itr->second);
+        entries_.erase(itr);
+      }
+    }
+    return Status::Success;
+  }
+
+  utime(cached_path.c_str(), nullptr);
+
+  *hit = true;
+  return Status::Success;
+}
+
+Status
+LocalizeCache::Put(const std::string& key, const std::string& src_path)
+{
+  struct stat st;
+  if (stat(src_path.c_str(), &st) != 0) {
+    return Status(Status::Code::INTERNAL, "failed to stat file " + src_path);
+  }
+
+  const uint64_t byte_size = st.st_size;
+  if (byte_size > max_byte_size_) {
+    return Status::Success;
+  }
+
+  // Add the file under a temporary name first so that another server
+  // sharing the cache directory never sees a partial file.
+  const std::string cached_path = JoinPath({cache_dir_, key});
+  std::string tmp_path;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (entries_.find(key) != entries_.end()) {
+      return Status::Success;
+    }
+
+    tmp_path = cached_path + ".tmp" + std::to_string(getpid()) + "_" +
+               std::to_string(tmp_cnt_++);
+  }
+
+  RETURN_IF_ERROR(LinkOrCopyFile(src_path, tmp_path));
+
+  std::lock_guard<std::mutex> lock(mu_);
+
+  // The same file may have been added while it was being copied.
+  if (entries_.find(key) != entries_.end()) {
+    remove(tmp_path.c_str());
+    return Status::Success;
+  }
+
+  if (rename(tmp_path.c_str(), cached_path.c_str()) != 0) {
+    const int rename_errno = errno;
+    remove(tmp_path.c_str());
+    return Status(
+        Status::Code::INTERNAL, "failed to add " + src_path +
+                                    " to localize cache, errno:" +
+                                    strerror(rename_errno));
+  }
+
+  lru_.emplace_front(key, byte_size);
+  entries_.emplace(key, lru_.begin());
+  byte_size_ += byte_size;
+
+  Evict();
+
+  return Status::Success;
+}
+
+size_t
+LocalizeCache::FileCount()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return entries_.size();
+}
+
+uint64_t
+LocalizeCache::ByteSize()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return byte_size_;
+}
+
+void
+LocalizeCache::Evict()
+{
+  while ((byte_size_ > max_byte_size_) && !lru_.empty()) {
+    const Entry& entry = lru_.back();
+    LOG_VERBOSE(1) << "evicting " << entry.key_ << " from localize cache";
+    remove(JoinPath({cache_dir_, entry.key_}).c_str());
+    byte_size_ -= entry.byte_size_;
+    entries_.erase(entry.key_);
+    lru_.pop_back();
+  }
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,110 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "src/core/status.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Persistent cache of the files downloaded when localizing a cloud
+// storage directory. Each file is stored under a name derived from
+// the content hash reported by the storage service, and is shared
+// with the localized directories by hard link so evicting a file from
+// the cache never affects a model that is still using it. The file
+// modification time records the last use so that the LRU order
+// survives a server restart.
+//
+class LocalizeCache {
+ public:
+  // Create a cache of at most 'byte_size' bytes in 'cache_dir',
+  // creating the directory if necessary. Files left in the directory
+  // by a previous run are part of the cache.
+  static Status Create(
+      const std::string& cache_dir, const uint64_t byte_size,
+      std::unique_ptr<LocalizeCache>* cache);
+
+  // Return the cache key for an object with the given content hash
+  // and size, or empty string if the object can't be cached.
+  static std::string Key(
+      const std::string& scheme, const std::string& hash,
+      const uint64_t byte_size);
+
+  // Create 'dst_path' from the cached file for 'key'. Return in 'hit'
+  // whether the file was found in the cache. A cached file that can't
+  // be used, for example because it was removed from outside of the
+  // server, is dropped from the cache and reported as a miss.
+  Status Get(const std::string& key, const std::string& dst_path, bool* hit);
+
+  // Add the file at 'src_path' to the cache as 'key'.
+  Status Put(const std::string& key, const std::string& src_path);
+
+  // Return the number and total byte size of the cached files.
+  size_t FileCount();
+  uint64_t ByteSize();
+
+ private:
+  struct Entry {
+    Entry(const std::string& key, const uint64_t byte_size)
+        : key_(key), byte_size_(byte_size)
+    {
+    }
+    std::string key_;
+    uint64_t byte_size_;
+  };
+
+  LocalizeCache(const std::string& cache_dir, const uint64_t byte_size)
+      : cache_dir_(cache_dir), max_byte_size_(byte_size), byte_size_(0),
+        tmp_cnt_(0)
+  {
+  }
+
+  // Remove least-recently-used files until the cache fits within its
+  // byte size. Must be called with 'mu_' held.
+  void Evict();
+
+  const std::string cache_dir_;
+  const uint64_t max_byte_size_;
+
+  // The files are linked or copied into and out of the cache without
+  // holding 'mu_', which only protects the index of the cached files.
+  std::mutex mu_;
+  uint64_t byte_size_;
+
+  // The cached files, most-recently-used first.
+  std::list<Entry> lru_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+
+  // Used to give each file being added a unique temporary name.
+  uint64_t tmp_cnt_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -36,67 +36,411 @@
 #include <unistd.h>
 #endif
 #include <algorithm>
-#include <iomanip>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 namespace nvidia { namespace inferenceserver {
 
+namespace {
+
+// Stream used to format the log messages of a thread. Constructing a
+// stringstream for each message is expensive so it is reused.
+struct ThreadLogStream {
+  ThreadLogStream() : in_use_(false), flags_(stream_.flags()) {}
+
+  std::stringstream stream_;
+  bool in_use_;
+  const std::ios_base::fmtflags flags_;
+};
+
+thread_local ThreadLogStream thread_log_stream_;
+
+#ifndef _WIN32
+// The date and time part of the message prefix only changes once per
+// second so it is formatted once per second per thread.
+struct ThreadTimestamp {
+  ThreadTimestamp() : sec_(-1) { prefix_[0] = '\0'; }
+
+  time_t sec_;
+  char prefix_[64];
+};
+
+thread_local ThreadTimestamp thread_timestamp_;
+#endif  // !_WIN32
+
+// Format the prefix of a log message into 'buf'. Return the length of
+// the prefix.
+size_t
+FormatPrefix(
+    char* buf, const size_t buf_size, const char level, const char* path,
+    const int line)
+{
+  int len;
+#ifdef _WIN32
+  SYSTEMTIME system_time;
+  GetSystemTime(&system_time);
+  len = snprintf(
+      buf, buf_size, "%c%02d%02d %02d:%02d:%02d.%06d %u %s:%d] ", level,
+      system_time.wMonth + 1, system_time.wDay, system_time.wHour,
+      system_time.wMinute, system_time.wSecond,
+      system_time.wMilliseconds * 1000,
+      static_cast<uint32_t>(GetCurrentProcessId()), path, line);
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  ThreadTimestamp& ts = thread_timestamp_;
+  if (ts.sec_ != tv.tv_sec) {
+    struct tm tm_time;
+    gmtime_r(((time_t*)&(tv.tv_sec)), &tm_time);
+    snprintf(
+        ts.prefix_, sizeof(ts.prefix_), "%02d%02d %02d:%02d:%02d",
+        tm_time.tm_mon + 1, tm_time.tm_mday, tm_time.tm_hour, tm_time.tm_min,
+        tm_time.tm_sec);
+    ts.sec_ = tv.tv_sec;
+  }
+  len = snprintf(
+      buf, buf_size, "%c%s.%06ld %u %s:%d] ", level, ts.prefix_,
+      static_cast<long>(tv.tv_usec), static_cast<uint32_t>(getpid()), path,
+      line);
+#endif
+  return (len < 0) ? 0 : std::min((size_t)len, buf_size - 1);
+}
+
+}  // namespace
+
+//
+// Background writer of log messages. Threads logging a message push it
+// to a bounded multi-producer queue (D. Vyukov's algorithm) without
+// taking a lock, the writer thread pops the messages and writes them
+// in batches.
+//
+class Logger::AsyncWriter {
+ public:
+  AsyncWriter(Logger* logger, const size_t queue_size);
+  ~AsyncWriter();
+
+  // Queue 'msg' to be written. Return false if the queue is full.
+  bool Enqueue(const std::string& msg);
+
+  // Wait until all messages queued before the call are written.
+  void Flush();
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence_;
+    std::string msg_;
+  };
+
+  // Return true if the message at the head of the queue is ready to
+  // be popped.
+  bool HeadReady() const;
+
+  // Pop the message at the head of the queue into 'batch'. Return
+  // false if the queue is empty.
+  bool Dequeue(std::string* batch);
+  void WriterThread();
+
+  Logger* logger_;
+  std::unique_ptr<Slot[]> slots_;
+  const size_t mask_;
+
+  std::atomic<size_t> enqueue_pos_;
+  size_t dequeue_pos_;
+
+  // Count of messages queued and written, for Flush().
+  std::atomic<uint64_t> enqueued_cnt_;
+  uint64_t written_cnt_;
+  uint64_t reported_dropped_cnt_;
+
+  std::mutex mu_;
+  std::condition_variable writer_cv_;
+  std::condition_variable flush_cv_;
+  std::atomic<bool> writer_sleeping_;
+  bool exiting_;
+  std::thread writer_;
+};
+
+Logger::AsyncWriter::AsyncWriter(Logger* logger, const size_t queue_size)
+    : logger_(logger), mask_(queue_size - 1), enqueue_pos_(0),
+      dequeue_pos_(0), enqueued_cnt_(0), written_cnt_(0),
+      reported_dropped_cnt_(0), writer_sleeping_(false), exiting_(false)
+{
+  slots_.reset(new Slot[queue_size]);
+  for (size_t i = 0; i < queue_size; ++i) {
+    slots_[i].sequence_.store(i, std::memory_order_relaxed);
+  }
+  writer_ = std::thread([this]() { WriterThread(); });
+}
+
+Logger::AsyncWriter::~AsyncWriter()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    exiting_ = true;
+  }
+  writer_cv_.notify_one();
+  writer_.join();
+}
+
+bool
+Logger::AsyncWriter::Enqueue(const std::string& msg)
+{
+  Slot* slot;
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const size_t seq = slot->sequence_.load(std::memory_order_acquire);
+    const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Assigning reuses the capacity of the string previously in the slot.
+  slot->msg_.assign(msg);
+  enqueued_cnt_.fetch_add(1, std::memory_order_relaxed);
+  // Sequentially consistent with the check of 'writer_sleeping_' so
+  // that the writer either sees the message or is woken up.
+  slot->sequence_.store(pos + 1, std::memory_order_seq_cst);
+  if (writer_sleeping_.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lk(mu_);
+    writer_cv_.notify_one();
+  }
+  return true;
+}
+
+bool
+Logger::AsyncWriter::HeadReady() const
+{
+  const Slot* slot = &slots_[dequeue_pos_ & mask_];
+  return (
+      slot->sequence_.load(std::memory_order_seq_cst) == (dequeue_pos_ + 1));
+}
+
+bool
+Logger::AsyncWriter::Dequeue(std::string* batch)
+{
+  if (!HeadReady()) {
+    return false;
+  }
+  Slot* slot = &slots_[dequeue_pos_ & mask_];
+  batch->append(slot->msg_);
+  batch->push_back('\n');
+  slot->sequence_.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+void
+Logger::AsyncWriter::Flush()
+{
+  const uint64_t target = enqueued_cnt_.load();
+  std::unique_lock<std::mutex> lk(mu_);
+  writer_cv_.notify_one();
+  flush_cv_.wait(lk, [this, target]() {
+    return (written_cnt_ >= target) || exiting_;
+  });
+}
+
+void
+Logger::AsyncWriter::WriterThread()
+{
+  // Write in batches so that many messages are written with one
+  // system call.
+  static constexpr size_t kBatchByteSize = 64 * 1024;
+
+  std::string batch;
+  batch.reserve(2 * kBatchByteSize);
+  while (true) {
+    uint64_t cnt = 0;
+    while ((batch.size() < kBatchByteSize) && Dequeue(&batch)) {
+      ++cnt;
+    }
+
+    const uint64_t dropped_cnt = logger_->dropped_cnt_.load();
+    if (dropped_cnt != reported_dropped_cnt_) {
+      char prefix[256];
+      const size_t len = FormatPrefix(
+          prefix, sizeof(prefix), 'W', "logging.cc", __LINE__);
+      batch.append(prefix, len);
+      batch.append(
+          "dropped " + std::to_string(dropped_cnt - reported_dropped_cnt_) +
+          " log messages, the asynchronous log queue is full\n");
+      reported_dropped_cnt_ = dropped_cnt;
+    }
+
+    if (!batch.empty()) {
+      batch.pop_back();  // Write() adds the last newline
+      logger_->Write(batch);
+      batch.clear();
+    }
+
+    std::unique_lock<std::mutex> lk(mu_);
+    written_cnt_ += cnt;
+    if (cnt != 0) {
+      flush_cv_.notify_all();
+      continue;
+    }
+
+    // The queue was empty, sleep until a message is queued or the
+    // writer exits. The queue is checked again after announcing the
+    // sleep so that a message queued concurrently is not missed,
+    // Enqueue() then notifies under 'mu_'.
+    if (exiting_) {
+      break;
+    }
+    writer_sleeping_.store(true, std::memory_order_seq_cst);
+    flush_cv_.notify_all();
+    writer_cv_.wait(lk, [this]() { return exiting_ || HeadReady(); });
+    writer_sleeping_.store(false, std::memory_order_relaxed);
+  }
+  flush_cv_.notify_all();
+}
+
 Logger gLogger_;
 
-Logger::Logger() : enables_{true, true, true}, vlevel_(0) {}
+Logger::Logger()
+    : enables_{true, true, true}, vlevel_(0), file_(nullptr), dropped_cnt_(0),
+      forward_(nullptr)
+{
+}
+
+Logger::~Logger()
+{
+  // Write out the queued messages before closing the log file
+  async_writer_.reset();
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+}
+
+bool
+Logger::SetLogFile(const std::string& path)
+{
+  FILE* file = nullptr;
+  if (!path.empty()) {
+    file = fopen(path.c_str(), "a");
+    if (file == nullptr) {
+      return false;
+    }
+  }
+
+  Flush();
+  std::lock_guard<std::mutex> lk(file_mu_);
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+  file_ = file;
+  return true;
+}
+
+void
+Logger::SetAsyncQueueSize(const size_t queue_size)
+{
+  async_writer_.reset();
+  if (queue_size > 0) {
+    // The queue size must be a power of 2
+    size_t size = 1;
+    while (size < queue_size) {
+      size <<= 1;
+    }
+    async_writer_.reset(new AsyncWriter(this, size));
+  }
+}
 
 void
 Logger::Log(const std::string& msg)
 {
-  std::cerr << msg << std::endl;
+  if (forward_ != nullptr) {
+    forward_(msg.c_str());
+  } else {
+    LogForwarded(msg);
+  }
 }
 
 void
-Logger::Flush()
+Logger::LogForwarded(const std::string& msg)
 {
-  std::cerr << std::flush;
+  if (async_writer_ != nullptr) {
+    if (!async_writer_->Enqueue(msg)) {
+      dropped_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    Write(msg);
+  }
 }
 
+void
+Logger::Write(const std::string& msg)
+{
+  std::lock_guard<std::mutex> lk(file_mu_);
+  if (file_ != nullptr) {
+    fwrite(msg.data(), 1, msg.size(), file_);
+    fputc('\n', file_);
+    fflush(file_);
+  } else {
+    std::cerr << msg << std::endl;
+  }
+}
+
+void
+Logger::Flush()
+{
+  if (async_writer_ != nullptr) {
+    async_writer_->Flush();
+  }
+  std::lock_guard<std::mutex> lk(file_mu_);
+  if (file_ != nullptr) {
+    fflush(file_);
+  } else {
+    std::cerr << std::flush;
+  }
+}
 
 const std::vector<char> LogMessage::level_name_{'E', 'W', 'I'};
 
 LogMessage::LogMessage(const char* file, int line, uint32_t level)
 {
-  std::string path(file);
-  size_t pos = path.rfind('/');
-  if (pos != std::string::npos) {
-    path = path.substr(pos + 1, std::string::npos);
+  ThreadLogStream& tls = thread_log_stream_;
+  if (!tls.in_use_) {
+    tls.in_use_ = true;
+    stream_ = &tls.stream_;
+    stream_->str(std::string());
+    stream_->clear();
+    stream_->flags(tls.flags_);
+    stream_->fill(' ');
+    stream_->precision(6);
+  } else {
+    owned_stream_.reset(new std::stringstream());
+    stream_ = owned_stream_.get();
   }
 
-#ifdef _WIN32
-  SYSTEMTIME system_time;
-  GetSystemTime(&system_time);
-  stream_ << level_name_[std::min(level, (uint32_t)Level::kINFO)]
-          << std::setfill('0') << std::setw(2) << (system_time.wMonth + 1)
-          << std::setw(2) << system_time.wDay << " " << std::setw(2)
-          << system_time.wHour << ':' << std::setw(2) << system_time.wMinute
-          << ':' << std::setw(2) << system_time.wSecond << "." << std::setw(6)
-          << system_time.wMilliseconds * 1000 << ' '
-          << static_cast<uint32_t>(GetCurrentProcessId()) << ' ' << path << ':'
-          << line << "] ";
-#else
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  struct tm tm_time;
-  gmtime_r(((time_t*)&(tv.tv_sec)), &tm_time);
-  stream_ << level_name_[std::min(level, (uint32_t)Level::kINFO)]
-          << std::setfill('0') << std::setw(2) << (tm_time.tm_mon + 1)
-          << std::setw(2) << tm_time.tm_mday << " " << std::setw(2)
-          << tm_time.tm_hour << ':' << std::setw(2) << tm_time.tm_min << ':'
-          << std::setw(2) << tm_time.tm_sec << "." << std::setw(6) << tv.tv_usec
-          << ' ' << static_cast<uint32_t>(getpid()) << ' ' << path << ':'
-          << line << "] ";
-#endif
+  const char* path = strrchr(file, '/');
+  path = (path != nullptr) ? (path + 1) : file;
+
+  char prefix[256];
+  const size_t len = FormatPrefix(
+      prefix, sizeof(prefix),
+      level_name_[std::min(level, (uint32_t)Level::kINFO)], path, line);
+  stream_->write(prefix, len);
 }
 
 LogMessage::~LogMessage()
 {
-  gLogger_.Log(stream_.str());
+  gLogger_.Log(stream_->str());
+  if (owned_stream_ == nullptr) {
+    thread_log_stream_.in_use_ = false;
+  }
 }
 
 }}  // namespace nvidia::inferenceserver
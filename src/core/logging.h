@@ -25,6 +25,10 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -40,17 +44,24 @@ class LogMessage {
   LogMessage(const char* file, int line, uint32_t level);
   ~LogMessage();
 
-  std::stringstream& stream() { return stream_; }
+  std::stringstream& stream() { return *stream_; }
 
  private:
   static const std::vector<char> level_name_;
-  std::stringstream stream_;
+
+  // The stream of the calling thread is reused for each message,
+  // unless it is already in use by a message logged while formatting
+  // another message, in which case the message has a stream of its
+  // own.
+  std::stringstream* stream_;
+  std::unique_ptr<std::stringstream> owned_stream_;
 };
 
 // Global logger for messages. Controls how log messages are reported.
 class Logger {
  public:
   Logger();
+  ~Logger();
 
   // Is a log level enabled.
   bool IsEnabled(LogMessage::Level level) const { return enables_[level]; }
@@ -67,15 +78,57 @@ class Logger {
   // Set the current verbose logging level.
   void SetVerboseLevel(uint32_t vlevel) { vlevel_ = vlevel; }
 
+  // Write log messages to the file at 'path', appending to it,
+  // instead of to stderr. An empty 'path' writes to stderr. Return
+  // false if the file cannot be opened.
+  bool SetLogFile(const std::string& path);
+
+  // Write log messages from a background thread. Messages are passed
+  // to the thread through a lock-free queue that holds up to
+  // 'queue_size' messages, messages logged while the queue is full are
+  // dropped and counted. Zero 'queue_size' writes messages
+  // synchronously. Must be set before messages are logged by multiple
+  // threads.
+  void SetAsyncQueueSize(const size_t queue_size);
+
+  // The number of messages dropped because the asynchronous queue was
+  // full.
+  uint64_t DroppedCount() const { return dropped_cnt_; }
+
+  // Pass each message to 'forward' instead of writing it, so that the
+  // messages of this logger are written by another logger, for example
+  // the messages of the frontend by the logger of the server. A null
+  // 'forward' writes the messages again. Must be set before messages
+  // are logged by multiple threads.
+  void SetForward(void (*forward)(const char* msg)) { forward_ = forward; }
+
   // Log a message.
   void Log(const std::string& msg);
 
-  // Flush the log.
+  // Log a message forwarded by another logger, see SetForward(). The
+  // message is written even if this logger forwards its own messages.
+  void LogForwarded(const std::string& msg);
+
+  // Flush the log. In asynchronous mode wait until the messages logged
+  // before the call are written.
   void Flush();
 
  private:
+  class AsyncWriter;
+
+  // Write a message to the log file or stderr.
+  void Write(const std::string& msg);
+
   std::vector<bool> enables_;
   uint32_t vlevel_;
+
+  std::mutex file_mu_;
+  FILE* file_;
+
+  std::unique_ptr<AsyncWriter> async_writer_;
+  std::atomic<uint64_t> dropped_cnt_;
+
+  void (*forward_)(const char* msg);
 };
 
 extern Logger gLogger_;
@@ -92,6 +145,11 @@ extern Logger gLogger_;
 #define LOG_SET_VERBOSE(L)                           \
   nvidia::inferenceserver::gLogger_.SetVerboseLevel( \
       static_cast<uint32_t>(std::max(0, (L))))
+#define LOG_SET_FILE(F) nvidia::inferenceserver::gLogger_.SetLogFile((F))
+#define LOG_SET_ASYNC_QUEUE_SIZE(S) \
+  nvidia::inferenceserver::gLogger_.SetAsyncQueueSize((S))
+#define LOG_SET_FORWARD(F) nvidia::inferenceserver::gLogger_.SetForward((F))
+#define LOG_FORWARDED(M) nvidia::inferenceserver::gLogger_.LogForwarded((M))
 
 #ifdef TRITON_ENABLE_LOGGING
 
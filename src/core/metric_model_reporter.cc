@@ -72,6 +72,14 @@ MetricModelReporter::Create(
 MetricModelReporter::MetricModelReporter(
     const std::string& model_name, const int64_t model_version,
     const int device, const MetricTagsMap& model_tags)
+    : metric_inf_request_latency_us_(nullptr),
+      metric_inf_queue_latency_us_(nullptr),
+      metric_inf_compute_infer_latency_us_(nullptr),
+      metric_inf_pending_request_count_(nullptr),
+      metric_inf_exec_inflight_count_(nullptr),
+      metric_cache_hit_count_(nullptr), metric_cache_miss_count_(nullptr),
+      metric_cache_eviction_count_(nullptr), metric_inf_coalesced_(nullptr),
+      metric_inf_shed_(nullptr)
 {
   std::map<std::string, std::string> labels;
   GetMetricLabels(&labels, model_name, model_version, device, model_tags);
@@ -94,6 +102,34 @@ MetricModelReporter::MetricModelReporter(
       Metrics::FamilyInferenceComputeInferDuration(), labels);
   metric_inf_compute_output_duration_us_ = CreateCounterMetric(
       Metrics::FamilyInferenceComputeOutputDuration(), labels);
+
+  if (!Metrics::LatencyBuckets().empty()) {
+    metric_inf_request_latency_us_ =
+        CreateHistogramMetric(Metrics::FamilyInferenceRequestLatency(), labels);
+    metric_inf_queue_latency_us_ =
+        CreateHistogramMetric(Metrics::FamilyInferenceQueueLatency(), labels);
+    metric_inf_compute_infer_latency_us_ = CreateHistogramMetric(
+        Metrics::FamilyInferenceComputeInferLatency(), labels);
+  }
+
+  // The scheduler gauges are only reported for the model as a whole,
+  // that is, with no GPU label.
+  if (labels.find(kMetricsLabelGpuUuid) == labels.end()) {
+    metric_inf_pending_request_count_ =
+        CreateGaugeMetric(Metrics::FamilyInferencePendingCount(), labels);
+    metric_inf_exec_inflight_count_ = CreateGaugeMetric(
+        Metrics::FamilyInferenceExecutionInflightCount(), labels);
+    metric_cache_hit_count_ =
+        CreateCounterMetric(Metrics::FamilyCacheHit(), labels);
+    metric_cache_miss_count_ =
+        CreateCounterMetric(Metrics::FamilyCacheMiss(), labels);
+    metric_cache_eviction_count_ =
+        CreateCounterMetric(Metrics::FamilyCacheEviction(), labels);
+    metric_inf_coalesced_ =
+        CreateCounterMetric(Metrics::FamilyInferenceCoalesced(), labels);
+    metric_inf_shed_ =
+        CreateCounterMetric(Metrics::FamilyInferenceShed(), labels);
+  }
 }
 
 MetricModelReporter::~MetricModelReporter()
@@ -111,6 +147,24 @@ MetricModelReporter::~MetricModelReporter()
       metric_inf_compute_infer_duration_us_);
   Metrics::FamilyInferenceComputeOutputDuration().Remove(
       metric_inf_compute_output_duration_us_);
+  if (metric_inf_request_latency_us_ != nullptr) {
+    Metrics::FamilyInferenceRequestLatency().Remove(
+        metric_inf_request_latency_us_);
+    Metrics::FamilyInferenceQueueLatency().Remove(metric_inf_queue_latency_us_);
+    Metrics::FamilyInferenceComputeInferLatency().Remove(
+        metric_inf_compute_infer_latency_us_);
+  }
+  if (metric_inf_pending_request_count_ != nullptr) {
+    Metrics::FamilyInferencePendingCount().Remove(
+        metric_inf_pending_request_count_);
+    Metrics::FamilyInferenceExecutionInflightCount().Remove(
+        metric_inf_exec_inflight_count_);
+    Metrics::FamilyCacheHit().Remove(metric_cache_hit_count_);
+    Metrics::FamilyCacheMiss().Remove(metric_cache_miss_count_);
+    Metrics::FamilyCacheEviction().Remove(metric_cache_eviction_count_);
+    Metrics::FamilyInferenceCoalesced().Remove(metric_inf_coalesced_);
+    Metrics::FamilyInferenceShed().Remove(metric_inf_shed_);
+  }
 }
 
 void
@@ -147,6 +201,22 @@ MetricModelReporter::CreateCounterMetric(
   return &family.Add(labels);
 }
 
+prometheus::Histogram*
+MetricModelReporter::CreateHistogramMetric(
+    prometheus::Family<prometheus::Histogram>& family,
+    const std::map<std::string, std::string>& labels)
+{
+  return &family.Add(labels, Metrics::LatencyBuckets());
+}
+
+prometheus::Gauge*
+MetricModelReporter::CreateGaugeMetric(
+    prometheus::Family<prometheus::Gauge>& family,
+    const std::map<std::string, std::string>& labels)
+{
+  return &family.Add(labels);
+}
+
 }}  // namespace nvidia::inferenceserver
 
 #endif  // TRITON_ENABLE_METRICS
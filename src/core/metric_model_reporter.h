@@ -86,6 +86,61 @@ class MetricModelReporter {
     return *metric_inf_compute_output_duration_us_;
   }
 
+  // Get the latency histograms for the model. Return nullptr if
+  // latency histograms are disabled.
+  prometheus::Histogram* MetricInferenceRequestLatency() const
+  {
+    return metric_inf_request_latency_us_;
+  }
+  prometheus::Histogram* MetricInferenceQueueLatency() const
+  {
+    return metric_inf_queue_latency_us_;
+  }
+  prometheus::Histogram* MetricInferenceComputeInferLatency() const
+  {
+    return metric_inf_compute_infer_latency_us_;
+  }
+
+  // Get the scheduler gauges for the model. The gauges are only
+  // created for a reporter that is not specialized to a GPU since
+  // requests are scheduled for a model and not for a specific
+  // device. Return nullptr if not available.
+  prometheus::Gauge* MetricInferencePendingCount() const
+  {
+    return metric_inf_pending_request_count_;
+  }
+  prometheus::Gauge* MetricInferenceExecutionInflightCount() const
+  {
+    return metric_inf_exec_inflight_count_;
+  }
+
+  // Get the response cache and request coalescing counters for the
+  // model. Like the scheduler
+  // gauges these are only created for a reporter that is not
+  // specialized to a GPU. Return nullptr if not available.
+  prometheus::Counter* MetricCacheHitCount() const
+  {
+    return metric_cache_hit_count_;
+  }
+  prometheus::Counter* MetricCacheMissCount() const
+  {
+    return metric_cache_miss_count_;
+  }
+  prometheus::Counter* MetricCacheEvictionCount() const
+  {
+    return metric_cache_eviction_count_;
+  }
+  prometheus::Counter* MetricInferenceCoalesced() const
+  {
+    return metric_inf_coalesced_;
+  }
+
+  // Get the counter of requests rejected by the scheduler because of
+  // the queue latency SLO. Like the scheduler gauges this is only
+  // created for a reporter that is not specialized to a GPU. Return
+  // nullptr if not available.
+  prometheus::Counter* MetricInferenceShed() const { return metric_inf_shed_; }
+
  private:
   MetricModelReporter(
       const std::string& model_name, const int64_t model_version,
@@ -98,6 +153,12 @@ class MetricModelReporter {
   prometheus::Counter* CreateCounterMetric(
       prometheus::Family<prometheus::Counter>& family,
       const std::map<std::string, std::string>& labels);
+  prometheus::Histogram* CreateHistogramMetric(
+      prometheus::Family<prometheus::Histogram>& family,
+      const std::map<std::string, std::string>& labels);
+  prometheus::Gauge* CreateGaugeMetric(
+      prometheus::Family<prometheus::Gauge>& family,
+      const std::map<std::string, std::string>& labels);
 
   prometheus::Counter* metric_inf_success_;
   prometheus::Counter* metric_inf_failure_;
@@ -108,6 +169,16 @@ class MetricModelReporter {
   prometheus::Counter* metric_inf_compute_input_duration_us_;
   prometheus::Counter* metric_inf_compute_infer_duration_us_;
   prometheus::Counter* metric_inf_compute_output_duration_us_;
+  prometheus::Histogram* metric_inf_request_latency_us_;
+  prometheus::Histogram* metric_inf_queue_latency_us_;
+  prometheus::Histogram* metric_inf_compute_infer_latency_us_;
+  prometheus::Gauge* metric_inf_pending_request_count_;
+  prometheus::Gauge* metric_inf_exec_inflight_count_;
+  prometheus::Counter* metric_cache_hit_count_;
+  prometheus::Counter* metric_cache_miss_count_;
+  prometheus::Counter* metric_cache_eviction_count_;
+  prometheus::Counter* metric_inf_coalesced_;
+  prometheus::Counter* metric_inf_shed_;
 #endif  // TRITON_ENABLE_METRICS
 };
 
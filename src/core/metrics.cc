@@ -29,6 +29,7 @@
 
 #include "src/core/metrics.h"
 
+#include <algorithm>
 #include <thread>
 #include "prometheus/detail/utils.h"
 #include "src/core/constants.h"
@@ -91,6 +92,79 @@ Metrics::Metrics()
               .Help("Cummulative inference compute output duration in "
                     "microseconds")
               .Register(*registry_)),
+      inf_request_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_request_latency_us")
+              .Help("Distribution of inference request duration in "
+                    "microseconds")
+              .Register(*registry_)),
+      inf_queue_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_queue_latency_us")
+              .Help("Distribution of inference queuing duration in "
+                    "microseconds")
+              .Register(*registry_)),
+      inf_compute_infer_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_compute_infer_latency_us")
+              .Help("Distribution of compute inference duration in "
+                    "microseconds")
+              .Register(*registry_)),
+      inf_pending_request_count_family_(
+          prometheus::BuildGauge()
+              .Name("nv_inference_pending_request_count")
+              .Help("Number of inference requests waiting in the scheduler")
+              .Register(*registry_)),
+      inf_exec_inflight_count_family_(
+          prometheus::BuildGauge()
+              .Name("nv_inference_exec_inflight_count")
+              .Help("Number of model executions in progress")
+              .Register(*registry_)),
+      cache_hit_family_(prometheus::BuildCounter()
+                            .Name("nv_cache_num_hits_per_model")
+                            .Help("Number of response cache hits per model")
+                            .Register(*registry_)),
+      cache_miss_family_(prometheus::BuildCounter()
+                             .Name("nv_cache_num_misses_per_model")
+                             .Help("Number of response cache misses per model")
+                             .Register(*registry_)),
+      cache_eviction_family_(
+          prometheus::BuildCounter()
+              .Name("nv_cache_num_evictions_per_model")
+              .Help("Number of response cache evictions per model")
+              .Register(*registry_)),
+      inf_coalesced_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_request_coalesced")
+              .Help("Number of inference requests responded to with the "
+                    "response of an identical request")
+              .Register(*registry_)),
+      inf_shed_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_request_shed")
+              .Help("Number of inference requests rejected because the "
+                    "predicted queue delay exceeds the queue latency SLO")
+              .Register(*registry_)),
+      model_load_on_demand_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_load_on_demand_count")
+              .Help("Number of times the model was loaded because it was "
+                    "requested while not loaded")
+              .Register(*registry_)),
+      model_load_on_demand_duration_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_load_on_demand_duration_us")
+              .Help("Cumulative duration of the on-demand loads of the model "
+                    "in microseconds")
+              .Register(*registry_)),
+      model_eviction_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_eviction_count")
+              .Help("Number of times the model was unloaded to keep the "
+                    "resident models within the model residency limits")
+              .Register(*registry_)),
+      latency_buckets_(
+          {100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000}),
 #ifdef TRITON_ENABLE_METRICS_GPU
       gpu_utilization_family_(prometheus::BuildGauge()
                                   .Name("nv_gpu_utilization")
@@ -170,6 +244,22 @@ Metrics::EnableMetrics()
   singleton->metrics_enabled_ = true;
 }
 
+void
+Metrics::SetLatencyBuckets(const std::vector<double>& buckets)
+{
+  auto singleton = GetSingleton();
+  singleton->latency_buckets_ = buckets;
+  std::sort(
+      singleton->latency_buckets_.begin(), singleton->latency_buckets_.end());
+}
+
+const prometheus::Histogram::BucketBoundaries&
+Metrics::LatencyBuckets()
+{
+  auto singleton = GetSingleton();
+  return singleton->latency_buckets_;
+}
+
 void
 Metrics::EnableGPUMetrics()
 {
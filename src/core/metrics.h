@@ -31,6 +31,7 @@
 #include <atomic>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include "prometheus/registry.h"
 #include "prometheus/serializer.h"
 #include "prometheus/text_serializer.h"
@@ -55,6 +56,16 @@ class Metrics {
   // Enable reporting of GPU metrics
   static void EnableGPUMetrics();
 
+  // Set the bucket boundaries, in microseconds, of the latency
+  // histograms. An empty 'buckets' disables the latency
+  // histograms. Must be called before any model is loaded, histograms
+  // already created are not changed.
+  static void SetLatencyBuckets(const std::vector<double>& buckets);
+
+  // Get the bucket boundaries, in microseconds, of the latency
+  // histograms. Empty if latency histograms are disabled.
+  static const prometheus::Histogram::BucketBoundaries& LatencyBuckets();
+
   // Get the prometheus registry
   static std::shared_ptr<prometheus::Registry> GetRegistry();
 
@@ -125,6 +136,86 @@ class Metrics {
     return GetSingleton()->inf_compute_output_duration_us_family_;
   }
 
+  // Metric family of the distribution of inference request, queuing
+  // and compute inference durations, in microseconds
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceRequestLatency()
+  {
+    return GetSingleton()->inf_request_latency_us_family_;
+  }
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceQueueLatency()
+  {
+    return GetSingleton()->inf_queue_latency_us_family_;
+  }
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceComputeInferLatency()
+  {
+    return GetSingleton()->inf_compute_infer_latency_us_family_;
+  }
+
+  // Metric family of the number of inference requests waiting in the
+  // scheduler for execution
+  static prometheus::Family<prometheus::Gauge>& FamilyInferencePendingCount()
+  {
+    return GetSingleton()->inf_pending_request_count_family_;
+  }
+
+  // Metric family of the number of model executions currently in
+  // progress
+  static prometheus::Family<prometheus::Gauge>&
+  FamilyInferenceExecutionInflightCount()
+  {
+    return GetSingleton()->inf_exec_inflight_count_family_;
+  }
+
+  // Metric families counting the response cache hits, misses and
+  // evictions of a model
+  static prometheus::Family<prometheus::Counter>& FamilyCacheHit()
+  {
+    return GetSingleton()->cache_hit_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyCacheMiss()
+  {
+    return GetSingleton()->cache_miss_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyCacheEviction()
+  {
+    return GetSingleton()->cache_eviction_family_;
+  }
+
+  // Metric family counting inference requests responded to with the
+  // response of an identical request
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceCoalesced()
+  {
+    return GetSingleton()->inf_coalesced_family_;
+  }
+
+  // Metric family counting inference requests rejected by the
+  // scheduler because of the queue latency SLO
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceShed()
+  {
+    return GetSingleton()->inf_shed_family_;
+  }
+
+  // Metric families counting the loads of a model caused by a request
+  // for the model while it is not loaded, the cumulative duration of
+  // those loads in microseconds, and the unloads of the model to keep
+  // the resident models within the model residency limits
+  static prometheus::Family<prometheus::Counter>& FamilyModelLoadOnDemand()
+  {
+    return GetSingleton()->model_load_on_demand_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilyModelLoadOnDemandDuration()
+  {
+    return GetSingleton()->model_load_on_demand_duration_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyModelEviction()
+  {
+    return GetSingleton()->model_eviction_family_;
+  }
+
  private:
   Metrics();
   virtual ~Metrics();
@@ -146,6 +237,22 @@ class Metrics {
       inf_compute_infer_duration_us_family_;
   prometheus::Family<prometheus::Counter>&
       inf_compute_output_duration_us_family_;
+  prometheus::Family<prometheus::Histogram>& inf_request_latency_us_family_;
+  prometheus::Family<prometheus::Histogram>& inf_queue_latency_us_family_;
+  prometheus::Family<prometheus::Histogram>&
+      inf_compute_infer_latency_us_family_;
+  prometheus::Family<prometheus::Gauge>& inf_pending_request_count_family_;
+  prometheus::Family<prometheus::Gauge>& inf_exec_inflight_count_family_;
+  prometheus::Family<prometheus::Counter>& cache_hit_family_;
+  prometheus::Family<prometheus::Counter>& cache_miss_family_;
+  prometheus::Family<prometheus::Counter>& cache_eviction_family_;
+  prometheus::Family<prometheus::Counter>& inf_coalesced_family_;
+  prometheus::Family<prometheus::Counter>& inf_shed_family_;
+  prometheus::Family<prometheus::Counter>& model_load_on_demand_family_;
+  prometheus::Family<prometheus::Counter>&
+      model_load_on_demand_duration_us_family_;
+  prometheus::Family<prometheus::Counter>& model_eviction_family_;
+  prometheus::Histogram::BucketBoundaries latency_buckets_;
 #ifdef TRITON_ENABLE_METRICS_GPU
   prometheus::Family<prometheus::Gauge>& gpu_utilization_family_;
   prometheus::Family<prometheus::Gauge>& gpu_memory_total_family_;
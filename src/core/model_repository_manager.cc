@@ -27,16 +27,24 @@
 
 #include "src/core/model_repository_manager.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include <algorithm>
+#include <chrono>
 #include <deque>
+#include <fstream>
 #include <future>
 #include <stdexcept>
 #include <thread>
+#include "src/backends/backend/triton_backend_config.h"
 #include "src/core/backend.h"
 #include "src/core/constants.h"
+#include "src/core/cuda_utils.h"
 #include "src/core/ensemble_utils.h"
 #include "src/core/filesystem.h"
 #include "src/core/logging.h"
+#include "src/core/metrics.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/triton_repo_agent.h"
 
@@ -350,6 +358,80 @@ struct BackendDeleter {
   std::function<void()> OnDestroyBackend_;
 };
 
+// The model configuration parameter that pins a model so that it is
+// not unloaded to keep the resident models within the residency
+// limits.
+constexpr char kResidencyPinnedParameter[] = "residency_pinned";
+
+// Return the host memory used by the process, in bytes, or 0 if it
+// can't be determined.
+uint64_t
+HostMemoryByteSize()
+{
+#ifndef _WIN32
+  // The second field of statm is the resident set size in pages.
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size_pages = 0, resident_pages = 0;
+  if (statm >> size_pages >> resident_pages) {
+    return resident_pages * sysconf(_SC_PAGESIZE);
+  }
+#endif  // !_WIN32
+  return 0;
+}
+
+// Return the memory used on 'gpus', in bytes.
+uint64_t
+GpuMemoryByteSize(const std::set<int>& gpus)
+{
+  uint64_t byte_size = 0;
+#ifdef TRITON_ENABLE_GPU
+  int current_device;
+  if (!gpus.empty() && (cudaGetDevice(&current_device) == cudaSuccess)) {
+    for (const int gpu : gpus) {
+      size_t free_bytes, total_bytes;
+      if ((cudaSetDevice(gpu) == cudaSuccess) &&
+          (cudaMemGetInfo(&free_bytes, &total_bytes) == cudaSuccess)) {
+        byte_size += total_bytes - free_bytes;
+      }
+    }
+    cudaSetDevice(current_device);
+  }
+#endif  // TRITON_ENABLE_GPU
+  return byte_size;
+}
+
+uint64_t
+SteadyClockUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// How long a failed on-demand load is remembered, during which
+// requests for the model fail without attempting to load it again.
+constexpr uint64_t kFailedLoadRetryUs = 1000 * 1000;
+
+// Return in 'exists' whether 'model_name' is in any of
+// 'repository_paths'. Unlike polling the model this only checks for
+// the model directory.
+Status
+ModelInRepository(
+    const std::set<std::string>& repository_paths,
+    const std::string& model_name, bool* exists)
+{
+  *exists = false;
+  for (const auto& repository_path : repository_paths) {
+    RETURN_IF_ERROR(
+        FileExists(JoinPath({repository_path, model_name}), exists));
+    if (*exists) {
+      break;
+    }
+  }
+
+  return Status::Success;
+}
+
 }  // namespace
 
 struct ModelRepositoryManager::ModelInfo {
@@ -1234,11 +1316,23 @@ ModelRepositoryManager::ModelRepositoryManager(
       polling_enabled_(polling_enabled),
       model_control_enabled_(model_control_enabled),
       min_compute_capability_(min_compute_capability),
-      backend_life_cycle_(std::move(life_cycle))
+      backend_life_cycle_(std::move(life_cycle)), load_on_demand_(false),
+      max_resident_model_cnt_(0), max_resident_host_byte_size_(0),
+      max_resident_gpu_byte_size_(0), on_demand_exit_(false)
 {
 }
 
-ModelRepositoryManager::~ModelRepositoryManager() {}
+ModelRepositoryManager::~ModelRepositoryManager()
+{
+  if (on_demand_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(residency_mu_);
+      on_demand_exit_ = true;
+    }
+    on_demand_cv_.notify_one();
+    on_demand_thread_.join();
+  }
+}
 
 Status
 ModelRepositoryManager::Create(
@@ -1269,6 +1363,25 @@ ModelRepositoryManager::Create(
         "cannot enable both polling and explicit model control");
   }
 
+  bool load_on_demand;
+  uint32_t max_resident_model_cnt;
+  uint64_t max_resident_host_byte_size, max_resident_gpu_byte_size;
+  RETURN_IF_ERROR(BackendConfigurationModelResidency(
+      backend_cmdline_config_map, &load_on_demand, &max_resident_model_cnt,
+      &max_resident_host_byte_size, &max_resident_gpu_byte_size));
+  if (load_on_demand && !model_control_enabled) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "loading models on demand requires explicit model control");
+  }
+  if (!load_on_demand &&
+      ((max_resident_model_cnt != 0) || (max_resident_host_byte_size != 0) ||
+       (max_resident_gpu_byte_size != 0))) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model residency limits require loading models on demand");
+  }
+
   BackendConfigMap backend_config_map;
 
   BuildBackendConfigMap(
@@ -1286,6 +1399,15 @@ ModelRepositoryManager::Create(
           repository_paths, backend_config_map, !strict_model_config,
           polling_enabled, model_control_enabled, min_compute_capability,
           std::move(life_cycle)));
+  local_manager->load_on_demand_ = load_on_demand;
+  local_manager->max_resident_model_cnt_ = max_resident_model_cnt;
+  local_manager->max_resident_host_byte_size_ = max_resident_host_byte_size;
+  local_manager->max_resident_gpu_byte_size_ = max_resident_gpu_byte_size;
+  if (load_on_demand) {
+    ModelRepositoryManager* manager = local_manager.get();
+    local_manager->on_demand_thread_ =
+        std::thread([manager]() { manager->OnDemandThread(); });
+  }
 
   bool all_models_polled = true;
   if (!model_control_enabled) {
@@ -1295,6 +1417,11 @@ ModelRepositoryManager::Create(
   } else {
     RETURN_IF_ERROR(local_manager->LoadUnloadModels(
         startup_models, ActionType::LOAD, false, &all_models_polled));
+    if (load_on_demand) {
+      std::lock_guard<std::mutex> lock(local_manager->poll_mu_);
+      local_manager->UpdateResidentModels(
+          std::string(), 0 /* host_byte_size */, 0 /* gpu_byte_size */);
+    }
   }
 
   *model_repository_manager = std::move(local_manager);
@@ -1461,9 +1588,26 @@ ModelRepositoryManager::LoadUnloadModel(
   // Serialize all operations that change model state
   std::lock_guard<std::mutex> lock(poll_mu_);
 
+  // The memory used by a model that is loaded on demand is
+  // approximated by the increase of the memory used by the process
+  // while it is loaded, which is accurate as long as no other large
+  // allocation happens at the same time.
+  MemoryUsage load_usage;
   bool polled = true;
-  RETURN_IF_ERROR(
-      LoadUnloadModels({model_name}, type, unload_dependents, &polled));
+  Status status = LoadUnloadModels(
+      {model_name}, type, unload_dependents, &polled,
+      load_on_demand_ ? &load_usage : nullptr);
+
+  if (load_on_demand_) {
+    UpdateResidentModels(
+        (type == ActionType::LOAD) ? model_name : std::string(),
+        load_usage.host_byte_size_, load_usage.gpu_byte_size_);
+    if ((type == ActionType::LOAD) && status.IsOk()) {
+      std::lock_guard<std::mutex> lock(residency_mu_);
+      failed_loads_.erase(model_name);
+    }
+  }
+  RETURN_IF_ERROR(status);
 
   // Check if model is loaded / unloaded properly
   const auto version_states = backend_life_cycle_->VersionStates(model_name);
@@ -1503,7 +1647,8 @@ ModelRepositoryManager::LoadUnloadModel(
 Status
 ModelRepositoryManager::LoadUnloadModels(
     const std::set<std::string>& model_names, const ActionType type,
-    const bool unload_dependents, bool* all_models_polled)
+    const bool unload_dependents, bool* all_models_polled,
+    MemoryUsage* load_usage)
 {
   auto status = Status::Success;
   *all_models_polled = true;
@@ -1581,9 +1726,35 @@ ModelRepositoryManager::LoadUnloadModels(
     backend_life_cycle_->AsyncUnload(name);
   }
 
+  // Only probe the GPUs that the models to be loaded use, probing a
+  // GPU creates a CUDA context on it.
+  std::set<int> load_gpus;
+  uint64_t host_byte_size = 0, gpu_byte_size = 0;
+  if ((load_usage != nullptr) && (type == ActionType::LOAD)) {
+    for (const auto models : {&added, &modified}) {
+      for (const auto& model_name : *models) {
+        const auto& config = infos_[model_name]->model_config_;
+        for (const auto& group : config.instance_group()) {
+          if (group.kind() == inference::ModelInstanceGroup::KIND_GPU) {
+            load_gpus.insert(group.gpus().begin(), group.gpus().end());
+          }
+        }
+      }
+    }
+    host_byte_size = HostMemoryByteSize();
+    gpu_byte_size = GpuMemoryByteSize(load_gpus);
+  }
+
   // load / unload the models affected, and check the load status of
   // the requested models
   const auto& load_status = LoadModelByDependency();
+  if ((load_usage != nullptr) && (type == ActionType::LOAD)) {
+    const uint64_t host_used = HostMemoryByteSize();
+    load_usage->host_byte_size_ =
+        host_used - std::min(host_byte_size, host_used);
+    const uint64_t gpu_used = GpuMemoryByteSize(load_gpus);
+    load_usage->gpu_byte_size_ = gpu_used - std::min(gpu_byte_size, gpu_used);
+  }
   if (status.IsOk() && (type == ActionType::LOAD)) {
     std::string load_error_message = "";
     for (const auto& model_name : model_names) {
@@ -1698,10 +1869,27 @@ ModelRepositoryManager::RepositoryIndex(
 Status
 ModelRepositoryManager::GetInferenceBackend(
     const std::string& model_name, const int64_t model_version,
-    std::shared_ptr<InferenceBackend>* backend)
+    std::shared_ptr<InferenceBackend>* backend, const bool load_on_demand)
 {
   Status status = backend_life_cycle_->GetInferenceBackend(
       model_name, model_version, backend);
+  if (load_on_demand && load_on_demand_) {
+    if (!status.IsOk()) {
+      status = LoadOnDemand(model_name, model_version);
+      if (status.IsOk()) {
+        status = backend_life_cycle_->GetInferenceBackend(
+            model_name, model_version, backend);
+      }
+    }
+    if (status.IsOk()) {
+      std::lock_guard<std::mutex> lock(residency_mu_);
+      auto itr = resident_models_.find(model_name);
+      if (itr != resident_models_.end()) {
+        resident_lru_.splice(
+            resident_lru_.begin(), resident_lru_, itr->second.lru_itr_);
+      }
+    }
+  }
   if (!status.IsOk()) {
     backend->reset();
     status = Status(
@@ -1711,6 +1899,311 @@ ModelRepositoryManager::GetInferenceBackend(
   return status;
 }
 
+Status
+ModelRepositoryManager::LoadModelOnDemand(
+    const std::string& model_name, const int64_t model_version,
+    std::function<void(const Status&)>&& on_complete, bool* ready)
+{
+  *ready = true;
+  if (!load_on_demand_) {
+    return Status::Success;
+  }
+  std::shared_ptr<InferenceBackend> backend;
+  if (backend_life_cycle_->GetInferenceBackend(
+          model_name, model_version, &backend)
+          .IsOk()) {
+    return Status::Success;
+  }
+
+  std::lock_guard<std::mutex> lock(residency_mu_);
+  auto fitr = failed_loads_.find(model_name);
+  if (fitr != failed_loads_.end()) {
+    if (SteadyClockUs() < fitr->second.retry_us_) {
+      return fitr->second.status_;
+    }
+    failed_loads_.erase(fitr);
+  }
+
+  // Requests that arrive while the model is being loaded wait for the
+  // same load.
+  auto& callbacks = pending_loads_[model_name];
+  if (callbacks.empty()) {
+    on_demand_loads_.push_back(model_name);
+    on_demand_cv_.notify_one();
+  }
+  callbacks.emplace_back(std::move(on_complete));
+  *ready = false;
+
+  return Status::Success;
+}
+
+Status
+ModelRepositoryManager::LoadOnDemand(
+    const std::string& model_name, const int64_t model_version)
+{
+  std::promise<Status> load_promise;
+  bool ready;
+  RETURN_IF_ERROR(LoadModelOnDemand(
+      model_name, model_version,
+      [&load_promise](const Status& status) { load_promise.set_value(status); },
+      &ready));
+  if (ready) {
+    return Status::Success;
+  }
+  return load_promise.get_future().get();
+}
+
+void
+ModelRepositoryManager::OnDemandThread()
+{
+  std::unique_lock<std::mutex> lock(residency_mu_);
+  while (true) {
+    on_demand_cv_.wait(lock, [this]() {
+      return on_demand_exit_ || !on_demand_loads_.empty() ||
+             !evictions_.empty();
+    });
+    if (on_demand_exit_) {
+      break;
+    }
+
+    // Unload the evicted models first to make room for the loads.
+    if (!evictions_.empty()) {
+      std::set<std::string> evicted_models;
+      evicted_models.swap(evictions_);
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> poll_lock(poll_mu_);
+        bool polled;
+        Status status = LoadUnloadModels(
+            evicted_models, ActionType::UNLOAD, false /* unload_dependents */,
+            &polled);
+        if (!status.IsOk()) {
+          LOG_ERROR << "failed to evict models: " << status.Message();
+        }
+      }
+      lock.lock();
+      continue;
+    }
+
+    const std::string model_name = on_demand_loads_.front();
+    on_demand_loads_.pop_front();
+    lock.unlock();
+    const Status status = RunOnDemandLoad(model_name);
+    lock.lock();
+
+    std::vector<std::function<void(const Status&)>> callbacks;
+    callbacks.swap(pending_loads_[model_name]);
+    pending_loads_.erase(model_name);
+
+    // Remember the failure so that requests for an unknown or broken
+    // model don't poll the model repository for every request.
+    if (!status.IsOk()) {
+      const uint64_t now_us = SteadyClockUs();
+      for (auto itr = failed_loads_.begin(); itr != failed_loads_.end();) {
+        if (itr->second.retry_us_ <= now_us) {
+          itr = failed_loads_.erase(itr);
+        } else {
+          ++itr;
+        }
+      }
+      failed_loads_[model_name] =
+          FailedLoad{status, now_us + kFailedLoadRetryUs};
+    }
+
+    lock.unlock();
+    for (auto& callback : callbacks) {
+      callback(status);
+    }
+    lock.lock();
+  }
+
+  // Complete the requests still waiting for a load.
+  const Status exit_status(
+      Status::Code::UNAVAILABLE, "model repository manager is shutting down");
+  std::unordered_map<
+      std::string, std::vector<std::function<void(const Status&)>>>
+      pending_loads;
+  pending_loads.swap(pending_loads_);
+  on_demand_loads_.clear();
+  lock.unlock();
+  for (auto& pending_load : pending_loads) {
+    for (auto& callback : pending_load.second) {
+      callback(exit_status);
+    }
+  }
+}
+
+Status
+ModelRepositoryManager::RunOnDemandLoad(const std::string& model_name)
+{
+  // Loading polls the model repository while holding 'poll_mu_', so
+  // first check without the lock that the model is in the repository
+  // at all.
+  bool exists = false;
+  Status status = ModelInRepository(repository_paths_, model_name, &exists);
+  if (status.IsOk() && !exists) {
+    status = Status(
+        Status::Code::NOT_FOUND,
+        "model '" + model_name + "' is not in the model repository");
+  }
+
+  const uint64_t start_us = SteadyClockUs();
+  if (status.IsOk()) {
+    LOG_INFO << "loading model '" << model_name << "' on demand";
+    status = LoadUnloadModel(
+        model_name, ActionType::LOAD, false /* unload_dependents */);
+  }
+  const uint64_t duration_us = SteadyClockUs() - start_us;
+  if (status.IsOk()) {
+    LOG_INFO << "loaded model '" << model_name << "' on demand in "
+             << (duration_us / 1000) << " ms";
+#ifdef TRITON_ENABLE_METRICS
+    if (Metrics::Enabled()) {
+      const std::map<std::string, std::string> labels{
+          {kMetricsLabelModelName, model_name}};
+      Metrics::FamilyModelLoadOnDemand().Add(labels).Increment();
+      Metrics::FamilyModelLoadOnDemandDuration().Add(labels).Increment(
+          duration_us);
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  return status;
+}
+
+void
+ModelRepositoryManager::UpdateResidentModels(
+    const std::string& loaded_model, const uint64_t host_byte_size,
+    const uint64_t gpu_byte_size)
+{
+  std::set<std::string> evicted_models;
+  {
+    std::lock_guard<std::mutex> lock(residency_mu_);
+
+    // Remove the models that are no longer loaded and add the models
+    // that are newly loaded as the most recently used. Models loaded
+    // as dependencies of 'loaded_model' are resident but are not
+    // charged any memory.
+    for (auto itr = resident_models_.begin(); itr != resident_models_.end();) {
+      const auto nitr = dependency_graph_.find(itr->first);
+      if ((nitr == dependency_graph_.end()) ||
+          nitr->second->loaded_versions_.empty()) {
+        resident_lru_.erase(itr->second.lru_itr_);
+        itr = resident_models_.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+    for (const auto& node : dependency_graph_) {
+      if (node.second->loaded_versions_.empty() ||
+          (resident_models_.find(node.first) != resident_models_.end())) {
+        continue;
+      }
+      ResidentModel resident;
+      resident.lru_itr_ =
+          resident_lru_.insert(resident_lru_.begin(), node.first);
+      resident.host_byte_size_ = 0;
+      resident.gpu_byte_size_ = 0;
+      resident.pinned_ = false;
+      const auto& params = node.second->model_config_.parameters();
+      const auto pitr = params.find(kResidencyPinnedParameter);
+      if (pitr != params.end()) {
+        Status status = ParseBoolParameter(
+            kResidencyPinnedParameter, pitr->second.string_value(),
+            &resident.pinned_);
+        if (!status.IsOk()) {
+          LOG_ERROR << "model '" << node.first << "': " << status.Message();
+        }
+      }
+      if (node.first == loaded_model) {
+        resident.host_byte_size_ = host_byte_size;
+        resident.gpu_byte_size_ = gpu_byte_size;
+      }
+      resident_models_.emplace(node.first, resident);
+    }
+
+    uint64_t total_host_byte_size = 0, total_gpu_byte_size = 0;
+    for (const auto& resident : resident_models_) {
+      total_host_byte_size += resident.second.host_byte_size_;
+      total_gpu_byte_size += resident.second.gpu_byte_size_;
+    }
+    LOG_VERBOSE(1) << resident_models_.size() << " resident models using "
+                   << total_host_byte_size << " bytes of host memory and "
+                   << total_gpu_byte_size << " bytes of GPU memory";
+
+    // Select the least recently used models to unload until the
+    // remaining models are within the limits. The model that was just
+    // loaded, pinned models and models that a loaded ensemble depends
+    // on are not unloaded.
+    auto within_limits = [&]() {
+      const size_t resident_cnt =
+          resident_models_.size() - evicted_models.size();
+      return ((max_resident_model_cnt_ == 0) ||
+              (resident_cnt <= max_resident_model_cnt_)) &&
+             ((max_resident_host_byte_size_ == 0) ||
+              (total_host_byte_size <= max_resident_host_byte_size_)) &&
+             ((max_resident_gpu_byte_size_ == 0) ||
+              (total_gpu_byte_size <= max_resident_gpu_byte_size_));
+    };
+    for (auto litr = resident_lru_.rbegin();
+         (litr != resident_lru_.rend()) && !within_limits(); ++litr) {
+      const auto& resident = resident_models_[*litr];
+      if ((*litr == loaded_model) || resident.pinned_) {
+        continue;
+      }
+      bool required = false;
+      for (const auto& downstream : dependency_graph_[*litr]->downstreams_) {
+        if (!downstream->loaded_versions_.empty()) {
+          required = true;
+          break;
+        }
+      }
+      if (required) {
+        continue;
+      }
+
+      evicted_models.emplace(*litr);
+      total_host_byte_size -= resident.host_byte_size_;
+      total_gpu_byte_size -= resident.gpu_byte_size_;
+    }
+    if (!within_limits()) {
+      LOG_WARNING << "resident models exceed the model residency limits "
+                  << "but the remaining models can not be unloaded";
+    }
+
+    for (const auto& model_name : evicted_models) {
+      auto itr = resident_models_.find(model_name);
+      resident_lru_.erase(itr->second.lru_itr_);
+      resident_models_.erase(itr);
+    }
+  }
+
+  if (evicted_models.empty()) {
+    return;
+  }
+
+  for (const auto& model_name : evicted_models) {
+    LOG_INFO << "evicting model '" << model_name
+             << "' to keep the resident models within the residency limits";
+#ifdef TRITON_ENABLE_METRICS
+    if (Metrics::Enabled()) {
+      Metrics::FamilyModelEviction()
+          .Add({{kMetricsLabelModelName, model_name}})
+          .Increment();
+    }
+#endif  // TRITON_ENABLE_METRICS
+  }
+
+  // The caller holds 'poll_mu_', which the unload needs, and may be
+  // handling a request, so the evicted models are unloaded by the
+  // on-demand thread.
+  {
+    std::lock_guard<std::mutex> lock(residency_mu_);
+    evictions_.insert(evicted_models.begin(), evicted_models.end());
+  }
+  on_demand_cv_.notify_one();
+}
+
 Status
 ModelRepositoryManager::Poll(
     const std::set<std::string>& models, std::set<std::string>* added,
@@ -26,9 +26,13 @@
 //
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <list>
 #include <map>
 #include <mutex>
+#include <thread>
 #include "model_config.pb.h"
 #include "src/core/model_config.h"
 #include "src/core/status.h"
@@ -203,10 +207,30 @@ class ModelRepositoryManager {
   /// \param model_name The model name of the backend handle.
   /// \param model_version The model version of the backend handle.
   /// \param backend Return the inference backend object.
+  /// \param load_on_demand If true and models are loaded on demand,
+  /// load the model if it is not loaded and mark it as the most
+  /// recently used resident model.
   /// \return error status.
   Status GetInferenceBackend(
       const std::string& model_name, const int64_t model_version,
-      std::shared_ptr<InferenceBackend>* backend);
+      std::shared_ptr<InferenceBackend>* backend,
+      const bool load_on_demand = false);
+
+  /// Start to load a model on demand without waiting for the load, so
+  /// that the requests for the model can be set aside until the model
+  /// is loaded instead of blocking the thread that handles them.
+  /// \param model_name The name of the model.
+  /// \param model_version The version of the model that is requested.
+  /// \param on_complete Called with the status of the load once it
+  /// completes, from the thread that loads the models on demand. Not
+  /// called if 'ready' returns true or if an error is returned.
+  /// \param ready Returns true if the model doesn't need to be loaded,
+  /// because the version is loaded or models are not loaded on demand.
+  /// \return error status. A recently failed on-demand load of the
+  /// model is not retried and its error is returned.
+  Status LoadModelOnDemand(
+      const std::string& model_name, const int64_t model_version,
+      std::function<void(const Status&)>&& on_complete, bool* ready);
 
  private:
   struct ModelInfo;
@@ -229,10 +253,22 @@ class ModelRepositoryManager {
   /// The internal function that are called in Create() and PollAndUpdate().
   Status PollAndUpdateInternal(bool* all_models_polled);
 
-  /// The internal function that load or unload a set of models.
+  /// The memory used by loading models, measured as the increase of
+  /// the memory used by the process while the models are loaded.
+  struct MemoryUsage {
+    MemoryUsage() : host_byte_size_(0), gpu_byte_size_(0) {}
+    uint64_t host_byte_size_;
+    uint64_t gpu_byte_size_;
+  };
+
+  /// The internal function that load or unload a set of models. If
+  /// 'load_usage' is non-null it returns the memory used by loading
+  /// the models, on the host and on the GPUs that the instance groups
+  /// of the loaded models use.
   Status LoadUnloadModels(
       const std::set<std::string>& models, const ActionType type,
-      const bool unload_dependents, bool* all_models_polled);
+      const bool unload_dependents, bool* all_models_polled,
+      MemoryUsage* load_usage = nullptr);
 
   /// Poll the requested models in the model repository and
   /// compare with the current set. Return the additions, deletions,
@@ -310,6 +346,38 @@ class ModelRepositoryManager {
   Status CircularcyCheck(
       DependencyNode* current_node, const DependencyNode* start_node);
 
+  /// Load a model that is requested while it is not loaded and wait
+  /// for the load, see LoadModelOnDemand().
+  /// \param model_name The name of the model.
+  /// \param model_version The version of the model that is requested.
+  /// \return The status of the load.
+  Status LoadOnDemand(
+      const std::string& model_name, const int64_t model_version);
+
+  /// The thread that loads the models on demand and unloads the
+  /// evicted models, so that neither blocks the threads that handle
+  /// requests.
+  void OnDemandThread();
+
+  /// Load a model on demand. A model that is not in the model
+  /// repository is not polled, and a failed load is not retried for
+  /// a short time.
+  /// \param model_name The name of the model.
+  /// \return The status of the load.
+  Status RunOnDemandLoad(const std::string& model_name);
+
+  /// Update the resident models to the loaded models and evict the
+  /// least recently used models that are not pinned until the
+  /// resident models are within the residency limits. The evicted
+  /// models are unloaded by OnDemandThread(). Must be called with
+  /// 'poll_mu_' held.
+  /// \param loaded_model The model that was just loaded, which is
+  /// charged 'host_byte_size' and 'gpu_byte_size' of memory if it
+  /// was not resident and is not unloaded.
+  void UpdateResidentModels(
+      const std::string& loaded_model, const uint64_t host_byte_size,
+      const uint64_t gpu_byte_size);
+
   const std::set<std::string> repository_paths_;
   const BackendConfigMap backend_config_map_;
   const bool autofill_;
@@ -326,6 +394,50 @@ class ModelRepositoryManager {
       missing_nodes_;
 
   std::unique_ptr<BackendLifeCycle> backend_life_cycle_;
+
+  // A loaded model when models are loaded on demand. 'lru_itr_' is the
+  // position of the model in 'resident_lru_'. The memory is the
+  // increase of the memory used by the process when the model was
+  // loaded. A pinned model is never unloaded to satisfy the limits.
+  struct ResidentModel {
+    std::list<std::string>::iterator lru_itr_;
+    uint64_t host_byte_size_;
+    uint64_t gpu_byte_size_;
+    bool pinned_;
+  };
+
+  // Whether models are loaded on demand, and the limits on the number
+  // of resident models and the memory they use. A limit of 0 means
+  // no limit.
+  bool load_on_demand_;
+  uint32_t max_resident_model_cnt_;
+  uint64_t max_resident_host_byte_size_;
+  uint64_t max_resident_gpu_byte_size_;
+
+  // An on-demand load that failed, and the time when the load may be
+  // attempted again.
+  struct FailedLoad {
+    Status status_;
+    uint64_t retry_us_;
+  };
+
+  // The resident models, in order from the most to the least recently
+  // used, the on-demand loads that failed recently, and the work of
+  // 'on_demand_thread_': the models to load in order, with the
+  // callbacks waiting for each load, and the models to unload.
+  // Protected by 'residency_mu_'.
+  std::mutex residency_mu_;
+  std::list<std::string> resident_lru_;
+  std::unordered_map<std::string, ResidentModel> resident_models_;
+  std::unordered_map<std::string, FailedLoad> failed_loads_;
+  std::deque<std::string> on_demand_loads_;
+  std::unordered_map<
+      std::string, std::vector<std::function<void(const Status&)>>>
+      pending_loads_;
+  std::set<std::string> evictions_;
+  bool on_demand_exit_;
+  std::condition_variable on_demand_cv_;
+  std::thread on_demand_thread_;
 };
 
 }}  // namespace nvidia::inferenceserver
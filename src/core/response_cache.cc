@@ -0,0 +1,197 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/response_cache.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+std::unique_ptr<ResponseCache> global_cache_;
+
+// Return the byte size charged to the cache for an entry.
+uint64_t
+EntryByteSize(
+    const std::string& request, const ResponseCache::Response& response)
+{
+  uint64_t byte_size = request.size();
+  for (const auto& output : response.outputs_) {
+    byte_size += output.name_.size() + output.data_.size() +
+                 (output.shape_.size() * sizeof(int64_t)) +
+                 sizeof(ResponseCache::Output);
+  }
+
+  return byte_size;
+}
+
+}  // namespace
+
+ResponseCache::ResponseCache(const uint64_t byte_size)
+    : byte_size_(byte_size), used_byte_size_(0)
+{
+}
+
+void
+ResponseCache::SetGlobalByteSize(const uint64_t byte_size)
+{
+  if (byte_size == 0) {
+    global_cache_.reset();
+  } else {
+    global_cache_.reset(new ResponseCache(byte_size));
+  }
+}
+
+ResponseCache*
+ResponseCache::Global()
+{
+  return global_cache_.get();
+}
+
+void
+ResponseCache::AddOwner(const void* owner, EvictionFn&& eviction_fn)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  owners_[owner].eviction_fn_ = std::move(eviction_fn);
+}
+
+void
+ResponseCache::RemoveOwner(const void* owner)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  auto itr = owners_.find(owner);
+  if (itr == owners_.end()) {
+    return;
+  }
+
+  for (auto& entry : itr->second.entries_) {
+    used_byte_size_ -= entry.second->byte_size_;
+    lru_.erase(entry.second);
+  }
+
+  owners_.erase(itr);
+}
+
+void
+ResponseCache::Lookup(
+    const void* owner, const uint64_t hash, const MatchFn& match,
+    std::shared_ptr<const Response>* response)
+{
+  response->reset();
+
+  std::lock_guard<std::mutex> lock(mu_);
+  auto oitr = owners_.find(owner);
+  if (oitr == owners_.end()) {
+    return;
+  }
+
+  auto range = oitr->second.entries_.equal_range(hash);
+  for (auto eitr = range.first; eitr != range.second; ++eitr) {
+    if (match(eitr->second->request_)) {
+      lru_.splice(lru_.begin(), lru_, eitr->second);
+      *response = eitr->second->response_;
+      return;
+    }
+  }
+}
+
+Status
+ResponseCache::Insert(
+    const void* owner, const uint64_t hash, std::string&& request,
+    std::shared_ptr<const Response>&& response)
+{
+  const uint64_t byte_size =
+      EntryByteSize(request, *response) + sizeof(Entry);
+  if (byte_size > byte_size_) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "response of " + std::to_string(byte_size) +
+            " bytes exceeds response cache byte size " +
+            std::to_string(byte_size_));
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  auto oitr = owners_.find(owner);
+  if (oitr == owners_.end()) {
+    return Status(
+        Status::Code::INTERNAL, "response cache owner is not registered");
+  }
+
+  // A concurrent identical request may have already inserted the
+  // response.
+  auto range = oitr->second.entries_.equal_range(hash);
+  for (auto eitr = range.first; eitr != range.second; ++eitr) {
+    if (eitr->second->request_ == request) {
+      return Status::Success;
+    }
+  }
+
+  while ((used_byte_size_ + byte_size) > byte_size_) {
+    EvictLeastRecentlyUsed();
+  }
+
+  lru_.emplace_front(
+      Entry{owner, hash, std::move(request), std::move(response), byte_size});
+  oitr->second.entries_.emplace(hash, lru_.begin());
+  used_byte_size_ += byte_size;
+
+  return Status::Success;
+}
+
+uint64_t
+ResponseCache::UsedByteSize() const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return used_byte_size_;
+}
+
+size_t
+ResponseCache::EntryCount() const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return lru_.size();
+}
+
+void
+ResponseCache::EvictLeastRecentlyUsed()
+{
+  Entry& entry = lru_.back();
+  auto& owner = owners_[entry.owner_];
+  auto range = owner.entries_.equal_range(entry.hash_);
+  for (auto eitr = range.first; eitr != range.second; ++eitr) {
+    if (&*eitr->second == &entry) {
+      owner.entries_.erase(eitr);
+      break;
+    }
+  }
+  used_byte_size_ -= entry.byte_size_;
+  if (owner.eviction_fn_) {
+    owner.eviction_fn_();
+  }
+
+  lru_.pop_back();
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,147 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "model_config.pb.h"
+#include "src/core/status.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Cache of inference responses. The models that enable response
+// caching share a single global cache. Each model is an owner of the
+// entries it inserts and looks up its entries by a hash of the
+// normalized request. Each entry holds the normalized request so that
+// requests with the same hash are told apart. The total byte size of
+// the entries is bounded, and entries are evicted in
+// least-recently-used order to make room for new entries.
+//
+class ResponseCache {
+ public:
+  // An output tensor of a cached response. The data is held in CPU
+  // memory.
+  struct Output {
+    std::string name_;
+    inference::DataType datatype_;
+    std::vector<int64_t> shape_;
+    std::string data_;
+  };
+
+  // A cached response.
+  struct Response {
+    std::vector<Output> outputs_;
+  };
+
+  // Function called when an entry of an owner is evicted. The
+  // function is called with the cache lock held and so must not call
+  // back into the cache.
+  using EvictionFn = std::function<void()>;
+
+  // Function that returns true if 'request', the normalized request of
+  // an entry with the hash being looked up, is the request being
+  // looked up. The function is called with the cache lock held and so
+  // must not call back into the cache.
+  using MatchFn = std::function<bool(const std::string& request)>;
+
+  explicit ResponseCache(const uint64_t byte_size);
+
+  // Set the byte size of the global cache. A byte size of 0 disables
+  // the global cache. Must be called before any model is loaded.
+  static void SetGlobalByteSize(const uint64_t byte_size);
+
+  // Return the global cache, or nullptr if the global cache is
+  // disabled.
+  static ResponseCache* Global();
+
+  // Register an owner of cache entries.
+  void AddOwner(const void* owner, EvictionFn&& eviction_fn);
+
+  // Remove an owner and all of its entries. The eviction function of
+  // the owner is not called for the removed entries.
+  void RemoveOwner(const void* owner);
+
+  // Return in 'response' the entry of 'owner' for the request with
+  // 'hash' that is accepted by 'match', or nullptr if there is no such
+  // entry. A returned entry becomes the most recently used entry.
+  void Lookup(
+      const void* owner, const uint64_t hash, const MatchFn& match,
+      std::shared_ptr<const Response>* response);
+
+  // Insert an entry for 'owner' and the normalized 'request' with
+  // 'hash', evicting least recently used entries as needed. Nothing is
+  // inserted if the owner already has an entry for 'request'. Return
+  // an error if the owner is not registered or if the entry is larger
+  // than the cache.
+  Status Insert(
+      const void* owner, const uint64_t hash, std::string&& request,
+      std::shared_ptr<const Response>&& response);
+
+  // Return the byte size of the cache and the total byte size of the
+  // entries currently in the cache.
+  uint64_t ByteSize() const { return byte_size_; }
+  uint64_t UsedByteSize() const;
+
+  // Return the number of entries currently in the cache.
+  size_t EntryCount() const;
+
+ private:
+  struct Entry {
+    const void* owner_;
+    uint64_t hash_;
+    std::string request_;
+    std::shared_ptr<const Response> response_;
+    uint64_t byte_size_;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  struct Owner {
+    EvictionFn eviction_fn_;
+    std::unordered_multimap<uint64_t, EntryList::iterator> entries_;
+  };
+
+  // Remove the least recently used entry. Must be called with 'mu_'
+  // held.
+  void EvictLeastRecentlyUsed();
+
+  const uint64_t byte_size_;
+
+  mutable std::mutex mu_;
+  uint64_t used_byte_size_;
+
+  // The entries, ordered from most to least recently used.
+  EntryList lru_;
+  std::unordered_map<const void*, Owner> owners_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -26,6 +26,9 @@
 #pragma once
 
 #include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 #include "src/core/infer_request.h"
 #include "src/core/status.h"
 
@@ -68,6 +71,56 @@ class Scheduler {
   // 'request' will be nullptr. If non-success is returned then the
   // caller still retains ownership of 'request'.
   virtual Status Enqueue(std::unique_ptr<InferenceRequest>& request) = 0;
+
+  // Enqueue a set of requests with the scheduler. The requests are
+  // enqueued in order and the scheduler takes ownership of each
+  // request that is enqueued, setting the corresponding entry of
+  // 'requests' to nullptr. If non-success is returned then the caller
+  // still retains ownership of the requests that were not
+  // enqueued. The default implementation enqueues the requests one at
+  // a time, schedulers that can enqueue them more efficiently should
+  // override it.
+  virtual Status EnqueueRequests(
+      std::vector<std::unique_ptr<InferenceRequest>>& requests)
+  {
+    for (auto& request : requests) {
+      RETURN_IF_ERROR(Enqueue(request));
+    }
+
+    return Status::Success;
+  }
+
+  // Add a runner with index 'runner_idx' to the scheduler and wait
+  // until the runner is initialized and warmed up. Schedulers that
+  // can't change their runners at runtime return UNSUPPORTED.
+  virtual Status AddRunner(const uint32_t runner_idx)
+  {
+    return Status(
+        Status::Code::UNSUPPORTED, "scheduler does not support adding runners");
+  }
+
+  // Remove the runner with index 'runner_idx' from the scheduler. The
+  // runner finishes executing the requests it was given but is not
+  // given new requests, the requests waiting in the scheduler are
+  // executed by the other runners. 'removed' returns a future that is
+  // ready once the scheduler no longer uses the runner.
+  virtual Status RemoveRunner(
+      const uint32_t runner_idx, std::shared_future<void>* removed)
+  {
+    return Status(
+        Status::Code::UNSUPPORTED,
+        "scheduler does not support removing runners");
+  }
+
+  // Return the number of requests waiting in the scheduler, the
+  // number of runners and the total time, in nanoseconds, that the
+  // runners have spent executing requests.
+  virtual Status Load(
+      size_t* pending_cnt, uint32_t* runner_cnt, uint64_t* exec_ns)
+  {
+    return Status(
+        Status::Code::UNSUPPORTED, "scheduler does not report its load");
+  }
 };
 
 }}  // namespace nvidia::inferenceserver
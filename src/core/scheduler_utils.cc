@@ -26,12 +26,35 @@
 
 #include "src/core/scheduler_utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include "src/core/constants.h"
 #include "src/core/logging.h"
 
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
 namespace nvidia { namespace inferenceserver {
 
+namespace {
+
+// Return the index of the lowest set bit of 'word', which must not be
+// 0.
+size_t
+LowestSetBit(const uint64_t word)
+{
+#ifdef _WIN32
+  unsigned long idx;
+  _BitScanForward64(&idx, word);
+  return idx;
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+}  // namespace
+
 Status
 InitRequiredEqualInputs(
     const std::unique_ptr<InferenceRequest>& request,
@@ -40,8 +63,7 @@ InitRequiredEqualInputs(
 {
   required_equal_inputs->clear();
 
-  for (const auto& pr : request->ImmutableInputs()) {
-    const InferenceRequest::Input* input = pr.second;
+  for (const InferenceRequest::Input* input : request->ImmutableInputs()) {
     const auto itr = enforce_equal_shape_tensors.find(input->Name());
     if (itr != enforce_equal_shape_tensors.end()) {
       required_equal_inputs->emplace(
@@ -58,8 +80,7 @@ CompareWithRequiredEqualInputs(
     const std::unique_ptr<InferenceRequest>& request,
     const RequiredEqualInputs& required_equal_inputs)
 {
-  for (const auto& pr : request->ImmutableInputs()) {
-    const InferenceRequest::Input* input = pr.second;
+  for (const InferenceRequest::Input* input : request->ImmutableInputs()) {
     const auto itr = required_equal_inputs.find(input->Name());
     if (itr != required_equal_inputs.end()) {
       // Make sure shape of input tensors is equal.
@@ -107,28 +128,49 @@ CompareWithRequiredEqualInputs(
 }
 
 Status
-PriorityQueue::PolicyQueue::Enqueue(std::unique_ptr<InferenceRequest>& request)
+PriorityQueue::PolicyQueue::Enqueue(
+    std::unique_ptr<InferenceRequest>& request, size_t* idx)
 {
-  if ((max_queue_size_ != 0) && (Size() >= max_queue_size_)) {
+  if ((max_queue_size_ != 0) && ((Size() + held_size_) >= max_queue_size_)) {
     return Status(Status::Code::UNAVAILABLE, "Exceeds maximum queue size");
   }
 
-  queue_.emplace_back(std::move(request));
   auto timeout_us = default_timeout_us_;
   if (allow_timeout_override_) {
-    auto override_timeout_us = queue_.back()->TimeoutMicroseconds();
+    auto override_timeout_us = request->TimeoutMicroseconds();
     if (override_timeout_us != 0 && override_timeout_us < timeout_us) {
       timeout_us = override_timeout_us;
     }
   }
+  uint64_t timeout_ns = 0;
   if (timeout_us != 0) {
-    timeout_timestamp_ns_.emplace_back(
-        std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::steady_clock::now().time_since_epoch())
-            .count() +
-        timeout_us * 1000);
+    timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count() +
+                 timeout_us * 1000;
+  }
+
+  // Place the request after the requests whose timeout is not later,
+  // so that requests with the same timeout stay in arrival order. A
+  // timeout of 0 is later than any other timeout.
+  *idx = queue_.size();
+  if (earliest_deadline_first_ && (timeout_ns != 0)) {
+    size_t lo = 0;
+    while (lo < *idx) {
+      const size_t mid = lo + (*idx - lo) / 2;
+      const uint64_t mid_timeout_ns = queue_[mid].timeout_ns_;
+      if ((mid_timeout_ns == 0) || (timeout_ns < mid_timeout_ns)) {
+        *idx = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+  }
+
+  if (*idx == queue_.size()) {
+    queue_.push_back(TimedRequest(timeout_ns, std::move(request)));
   } else {
-    timeout_timestamp_ns_.emplace_back(0);
+    queue_.insert(*idx, TimedRequest(timeout_ns, std::move(request)));
   }
 
   return Status::Success;
@@ -138,9 +180,8 @@ Status
 PriorityQueue::PolicyQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
 {
   if (!queue_.empty()) {
-    *request = std::move(queue_.front());
+    *request = std::move(queue_.front().request_);
     queue_.pop_front();
-    timeout_timestamp_ns_.pop_front();
   } else {
     *request = std::move(delayed_queue_.front());
     delayed_queue_.pop_front();
@@ -149,66 +190,144 @@ PriorityQueue::PolicyQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
   return Status::Success;
 }
 
+Status
+PriorityQueue::PolicyQueue::Dequeue(HeldRequest* held)
+{
+  if (!queue_.empty()) {
+    held->timeout_ns_ = queue_.front().timeout_ns_;
+    held->delayed_ = false;
+  } else {
+    held->timeout_ns_ = 0;
+    held->delayed_ = true;
+  }
+  RETURN_IF_ERROR(Dequeue(&held->request_));
+  held_size_++;
+
+  return Status::Success;
+}
+
 bool
 PriorityQueue::PolicyQueue::ApplyPolicy(
-    size_t idx, size_t* rejected_count, size_t* rejected_batch_size)
+    HeldRequest* held, const uint64_t now_ns, const uint64_t exec_ns,
+    size_t* rejected_count, size_t* rejected_batch_size)
+{
+  // The policy is the same as for the queued requests, see below.
+  const uint64_t check_ns = (earliest_deadline_first_) ? (now_ns + exec_ns)
+                                                       : now_ns;
+  const bool timed_out =
+      (held->timeout_ns_ != 0) && (check_ns > held->timeout_ns_);
+  if (timed_out && !held->request_->IsCancelled() &&
+      (timeout_action_ == inference::ModelQueuePolicy::DELAY)) {
+    held->timeout_ns_ = 0;
+    held->delayed_ = true;
+    return true;
+  }
+  if (!timed_out && !held->request_->IsCancelled()) {
+    return true;
+  }
+
+  Reject(std::move(held->request_), rejected_count, rejected_batch_size);
+  held_size_--;
+  return false;
+}
+
+bool
+PriorityQueue::PolicyQueue::ApplyPolicy(
+    size_t idx, const uint64_t exec_ns, size_t* rejected_count,
+    size_t* rejected_batch_size)
 {
   uint64_t now_nanoseconds =
       std::chrono::duration_cast<std::chrono::nanoseconds>(
           std::chrono::steady_clock::now().time_since_epoch())
           .count();
+
+  // When ordered by timeout, a request that can't finish before its
+  // timeout is timed-out now instead of after wasting the execution.
+  // The requests are sorted so the timed-out requests are still
+  // contiguous.
+  if (earliest_deadline_first_) {
+    now_nanoseconds += exec_ns;
+  }
   if (idx < queue_.size()) {
     size_t curr_idx = idx;
     while (curr_idx < queue_.size()) {
-      if ((timeout_timestamp_ns_[curr_idx] != 0) &&
-          (now_nanoseconds > timeout_timestamp_ns_[curr_idx])) {
+      const uint64_t timeout_ns = queue_[curr_idx].timeout_ns_;
+      // A cancelled request is rejected whatever the timeout action is,
+      // there is no client waiting for its response.
+      if (queue_[curr_idx].request_->IsCancelled()) {
+        Reject(
+            std::move(queue_[curr_idx].request_), rejected_count,
+            rejected_batch_size);
+      } else if ((timeout_ns != 0) && (now_nanoseconds > timeout_ns)) {
         if (timeout_action_ == inference::ModelQueuePolicy::DELAY) {
-          delayed_queue_.emplace_back(std::move(queue_[curr_idx]));
+          delayed_queue_.push_back(std::move(queue_[curr_idx].request_));
         } else {
-          rejected_queue_.emplace_back(std::move(queue_[curr_idx]));
-          *rejected_count += 1;
-          *rejected_batch_size +=
-              std::max(1U, rejected_queue_.back()->BatchSize());
+          Reject(
+              std::move(queue_[curr_idx].request_), rejected_count,
+              rejected_batch_size);
         }
-        curr_idx++;
       } else {
         break;
       }
+      curr_idx++;
     }
 
-    // Use range erasure on deque as all erasure functions are linear,
-    // this implies in the edge case where this function is always called on
-    // 'bad' index can be O(n^2). However, for data structures that are O(1)
-    // erasure, the traversal may not be as efficient due to cache miss
-    // (elements not stored contiguously).
-    queue_.erase(queue_.begin() + idx, queue_.begin() + curr_idx);
-    timeout_timestamp_ns_.erase(
-        timeout_timestamp_ns_.begin() + idx,
-        timeout_timestamp_ns_.begin() + curr_idx);
+    // Erase the timed-out requests as one range, which moves the
+    // requests on the shorter side of the range once. Usually 'idx' is
+    // the front of the queue and nothing is moved.
+    queue_.erase(idx, curr_idx);
 
     // Current idx is pointing to an item with unexpired timeout
     if (idx < queue_.size()) {
       return true;
     }
   }
+
   // At this point, idx is pointing to an item with expired timeout.
-  // If the item is in delayed queue, then return true. Otherwise, false
-  // meaning the queue has no item with this 'idx'.
-  return ((idx - queue_.size()) < delayed_queue_.size());
+  // If the item is in delayed queue, then return true after rejecting
+  // the cancelled requests in the delayed queue at and after the
+  // item. Otherwise, false meaning the queue has no item with this
+  // 'idx'.
+  const size_t delayed_idx = idx - queue_.size();
+  size_t curr_idx = delayed_idx;
+  while ((curr_idx < delayed_queue_.size()) &&
+         delayed_queue_[curr_idx]->IsCancelled()) {
+    Reject(
+        std::move(delayed_queue_[curr_idx]), rejected_count,
+        rejected_batch_size);
+    curr_idx++;
+  }
+  delayed_queue_.erase(delayed_idx, curr_idx);
+
+  return (delayed_idx < delayed_queue_.size());
+}
+
+void
+PriorityQueue::PolicyQueue::Reject(
+    std::unique_ptr<InferenceRequest>&& request, size_t* rejected_count,
+    size_t* rejected_batch_size)
+{
+  *rejected_count += 1;
+  *rejected_batch_size += std::max(1U, request->BatchSize());
+  rejected_queue_.push_back(std::move(request));
 }
 
 void
 PriorityQueue::PolicyQueue::ReleaseRejectedQueue(
     std::deque<std::unique_ptr<InferenceRequest>>* requests)
 {
-  rejected_queue_.swap(*requests);
+  requests->clear();
+  while (!rejected_queue_.empty()) {
+    requests->emplace_back(std::move(rejected_queue_.front()));
+    rejected_queue_.pop_front();
+  }
 }
 
 const std::unique_ptr<InferenceRequest>&
 PriorityQueue::PolicyQueue::At(size_t idx) const
 {
   if (idx < queue_.size()) {
-    return queue_[idx];
+    return queue_[idx].request_;
   } else {
     return delayed_queue_[idx - queue_.size()];
   }
@@ -218,39 +337,44 @@ uint64_t
 PriorityQueue::PolicyQueue::TimeoutAt(size_t idx)
 {
   if (idx < queue_.size()) {
-    return timeout_timestamp_ns_[idx];
+    return queue_[idx].timeout_ns_;
   } else {
     return 0;
   }
 }
 
 PriorityQueue::PriorityQueue()
-    : size_(0), front_priority_level_(0), last_priority_level_(0)
+    : level_offset_(0), size_(0), rejected_size_(0),
+      earliest_deadline_first_(false), expected_exec_ns_(0)
 {
   inference::ModelQueuePolicy default_policy;
-  queues_.emplace(0, PolicyQueue(default_policy));
-  front_priority_level_ = queues_.begin()->first;
+  queues_.emplace_back(default_policy, false /* earliest_deadline_first */);
+  non_empty_levels_.resize(1, 0);
   ResetCursor();
 }
 
 PriorityQueue::PriorityQueue(
     const inference::ModelQueuePolicy& default_queue_policy,
-    uint32_t priority_levels, const ModelQueuePolicyMap queue_policy_map)
-    : size_(0), last_priority_level_(priority_levels)
+    uint32_t priority_levels, const ModelQueuePolicyMap queue_policy_map,
+    const bool earliest_deadline_first)
+    : level_offset_((priority_levels == 0) ? 0 : 1), size_(0),
+      rejected_size_(0), earliest_deadline_first_(earliest_deadline_first),
+      expected_exec_ns_(0)
 {
   if (priority_levels == 0) {
-    queues_.emplace(0, PolicyQueue(default_queue_policy));
+    queues_.emplace_back(default_queue_policy, earliest_deadline_first);
   } else {
+    queues_.reserve(priority_levels);
     for (uint32_t level = 1; level <= priority_levels; level++) {
       auto it = queue_policy_map.find(level);
       if (it == queue_policy_map.end()) {
-        queues_.emplace(level, PolicyQueue(default_queue_policy));
+        queues_.emplace_back(default_queue_policy, earliest_deadline_first);
       } else {
-        queues_.emplace(level, PolicyQueue(it->second));
+        queues_.emplace_back(it->second, earliest_deadline_first);
       }
     }
   }
-  front_priority_level_ = queues_.begin()->first;
+  non_empty_levels_.resize((queues_.size() + 63) / 64, 0);
   ResetCursor();
 }
 
@@ -258,17 +382,27 @@ Status
 PriorityQueue::Enqueue(
     uint32_t priority_level, std::unique_ptr<InferenceRequest>& request)
 {
-  auto status = queues_[priority_level].Enqueue(request);
+  if ((priority_level < level_offset_) ||
+      ((priority_level - level_offset_) >= queues_.size())) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "invalid priority level " + std::to_string(priority_level));
+  }
+
+  const size_t level_idx = priority_level - level_offset_;
+  size_t idx;
+  auto status = queues_[level_idx].Enqueue(request, &idx);
   if (status.IsOk()) {
     size_++;
-    front_priority_level_ = std::min(front_priority_level_, priority_level);
+    non_empty_levels_[level_idx / 64] |= (uint64_t(1) << (level_idx % 64));
     // Invalidate the pending batch cursor if the enqueued item is placed
     // within the pending batch. At the same priority level the request is
     // guaranteed to be after pending batch if the batch hasn't reached
-    // delayed queue.
-    if ((priority_level < pending_cursor_.curr_it_->first) ||
-        ((priority_level == pending_cursor_.curr_it_->first) &&
-         (pending_cursor_.at_delayed_queue_))) {
+    // delayed queue, unless the request is ordered by its timeout.
+    if ((level_idx < pending_cursor_.level_idx_) ||
+        ((level_idx == pending_cursor_.level_idx_) &&
+         (pending_cursor_.at_delayed_queue_ ||
+          (idx < pending_cursor_.queue_idx_)))) {
       pending_cursor_.valid_ = false;
     }
   }
@@ -280,54 +414,132 @@ Status
 PriorityQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
 {
   pending_cursor_.valid_ = false;
-  while (true) {
-    if (!queues_[front_priority_level_].Empty()) {
-      RETURN_IF_ERROR(queues_[front_priority_level_].Dequeue(request));
-      size_--;
-      return Status::Success;
-    } else if (front_priority_level_ != last_priority_level_) {
-      front_priority_level_++;
-      continue;
-    }
+  const size_t level_idx = NextNonEmptyLevel(0);
+  if (level_idx < queues_.size()) {
+    RETURN_IF_ERROR(queues_[level_idx].Dequeue(request));
+    size_--;
+    UpdateNonEmptyLevel(level_idx);
+    return Status::Success;
+  }
 
-    // Control reach here if the queue for last priority level is also
-    // empty, then return error below.
-    break;
+  return Status(Status::Code::UNAVAILABLE, "dequeue on empty queue");
+}
+
+Status
+PriorityQueue::Dequeue(HeldRequest* held)
+{
+  pending_cursor_.valid_ = false;
+  const size_t level_idx = NextNonEmptyLevel(0);
+  if (level_idx < queues_.size()) {
+    RETURN_IF_ERROR(queues_[level_idx].Dequeue(held));
+    held->level_idx_ = level_idx;
+    size_--;
+    UpdateNonEmptyLevel(level_idx);
+    return Status::Success;
   }
 
   return Status(Status::Code::UNAVAILABLE, "dequeue on empty queue");
 }
 
+bool
+PriorityQueue::ApplyPolicy(
+    HeldRequest* held, const uint64_t now_ns, size_t* rejected_batch_size)
+{
+  size_t rejected_count = 0;
+  const bool is_held = queues_[held->level_idx_].ApplyPolicy(
+      held, now_ns, expected_exec_ns_, &rejected_count, rejected_batch_size);
+  rejected_size_ += rejected_count;
+  return is_held;
+}
+
+void
+PriorityQueue::Release(const HeldRequest& held)
+{
+  queues_[held.level_idx_].Release();
+}
+
 void
 PriorityQueue::ReleaseRejectedRequests(
     std::shared_ptr<std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>*
         requests)
 {
+  // Most batches don't reject any request, avoid allocating the
+  // per-level queues for them.
+  if (rejected_size_ == 0) {
+    requests->reset();
+    return;
+  }
+
   auto res = std::make_shared<
       std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>(
       queues_.size());
-  size_t idx = 0;
-  for (auto& queue : queues_) {
-    queue.second.ReleaseRejectedQueue(&((*res)[idx]));
-    idx++;
+  for (size_t idx = 0; idx < queues_.size(); idx++) {
+    queues_[idx].ReleaseRejectedQueue(&((*res)[idx]));
   }
+  rejected_size_ = 0;
 
   requests->swap(res);
 }
 
+size_t
+PriorityQueue::NextNonEmptyLevel(size_t level_idx) const
+{
+  size_t word_idx = level_idx / 64;
+  if (word_idx >= non_empty_levels_.size()) {
+    return queues_.size();
+  }
+
+  // Mask off the levels before 'level_idx' in the first word.
+  uint64_t word =
+      non_empty_levels_[word_idx] & (~uint64_t(0) << (level_idx % 64));
+  while (word == 0) {
+    if (++word_idx == non_empty_levels_.size()) {
+      return queues_.size();
+    }
+    word = non_empty_levels_[word_idx];
+  }
+
+  return (word_idx * 64) + LowestSetBit(word);
+}
+
+void
+PriorityQueue::UpdateNonEmptyLevel(size_t level_idx)
+{
+  const uint64_t bit = uint64_t(1) << (level_idx % 64);
+  if (queues_[level_idx].Empty()) {
+    non_empty_levels_[level_idx / 64] &= ~bit;
+  } else {
+    non_empty_levels_[level_idx / 64] |= bit;
+  }
+}
+
 bool
 PriorityQueue::IsCursorValid()
 {
   if (pending_cursor_.valid_) {
     return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
                std::chrono::steady_clock::now().time_since_epoch())
-               .count() < pending_cursor_.pending_batch_closest_timeout_ns_;
+               .count() < ClosestTimeout();
   }
   return false;
 }
 
-PriorityQueue::Cursor::Cursor(PriorityQueues::iterator start_it)
-    : curr_it_(start_it), queue_idx_(0), at_delayed_queue_(false),
+uint64_t
+PriorityQueue::ClosestTimeout()
+{
+  const uint64_t timeout_ns = pending_cursor_.pending_batch_closest_timeout_ns_;
+  if (!earliest_deadline_first_ || (timeout_ns == 0)) {
+    return timeout_ns;
+  }
+
+  // The pending batch must start executing early enough to finish
+  // before the timeout. Don't return 0, which means no timeout.
+  return (timeout_ns > expected_exec_ns_) ? (timeout_ns - expected_exec_ns_)
+                                          : 1;
+}
+
+PriorityQueue::Cursor::Cursor(size_t level_idx)
+    : level_idx_(level_idx), queue_idx_(0), at_delayed_queue_(false),
       pending_batch_closest_timeout_ns_(0),
       pending_batch_oldest_enqueue_time_ns_(0), pending_batch_count_(0),
       valid_(true)
@@ -339,12 +551,17 @@ PriorityQueue::ApplyPolicyAtCursor()
 {
   size_t rejected_batch_size = 0;
   size_t rejected_count = 0;
-  while (pending_cursor_.curr_it_ != queues_.end()) {
-    if (!(pending_cursor_.curr_it_->second.ApplyPolicy(
-            pending_cursor_.queue_idx_, &rejected_count,
-            &rejected_batch_size))) {
+  while (pending_cursor_.level_idx_ < queues_.size()) {
+    const size_t level_idx = pending_cursor_.level_idx_;
+    const bool at_request = queues_[level_idx].ApplyPolicy(
+        pending_cursor_.queue_idx_, expected_exec_ns_, &rejected_count,
+        &rejected_batch_size);
+    UpdateNonEmptyLevel(level_idx);
+    if (!at_request) {
       if (size_ > pending_cursor_.pending_batch_count_ + rejected_count) {
-        pending_cursor_.curr_it_++;
+        // Skip the empty priority levels, the remaining requests are
+        // in the levels after the cursor.
+        pending_cursor_.level_idx_ = NextNonEmptyLevel(level_idx + 1);
         pending_cursor_.queue_idx_ = 0;
         continue;
       }
@@ -354,6 +571,7 @@ PriorityQueue::ApplyPolicyAtCursor()
     break;
   }
   size_ -= rejected_count;
+  rejected_size_ += rejected_count;
   return rejected_batch_size;
 }
 
@@ -365,7 +583,7 @@ PriorityQueue::AdvanceCursor()
   }
 
   const auto& timeout_ns =
-      pending_cursor_.curr_it_->second.TimeoutAt(pending_cursor_.queue_idx_);
+      queues_[pending_cursor_.level_idx_].TimeoutAt(pending_cursor_.queue_idx_);
   if (timeout_ns != 0) {
     if (pending_cursor_.pending_batch_closest_timeout_ns_ != 0) {
       pending_cursor_.pending_batch_closest_timeout_ns_ = std::min(
@@ -376,7 +594,7 @@ PriorityQueue::AdvanceCursor()
   }
 
   uint64_t curr_enqueue_time_ns =
-      pending_cursor_.curr_it_->second.At(pending_cursor_.queue_idx_)
+      queues_[pending_cursor_.level_idx_].At(pending_cursor_.queue_idx_)
           ->QueueStartNs();
   if (pending_cursor_.pending_batch_oldest_enqueue_time_ns_ != 0) {
     pending_cursor_.pending_batch_oldest_enqueue_time_ns_ = std::min(
@@ -392,7 +610,7 @@ PriorityQueue::AdvanceCursor()
   // delayed queue.
   pending_cursor_.at_delayed_queue_ =
       (pending_cursor_.queue_idx_ >
-       pending_cursor_.curr_it_->second.UnexpiredSize());
+       queues_[pending_cursor_.level_idx_].UnexpiredSize());
 }
 
 }}  // namespace nvidia::inferenceserver
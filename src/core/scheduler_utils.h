@@ -25,8 +25,10 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <algorithm>
 #include <deque>
 #include <unordered_map>
+#include <vector>
 #include "src/core/scheduler.h"
 
 namespace nvidia { namespace inferenceserver {
@@ -59,9 +61,13 @@ class PriorityQueue {
   // Construct a queue with 'priority_levels', the priority starts from 1.
   // Different priority level may follow different queue policies given by
   // 'queue_policy_map', otherwise, the 'default_queue_policy' will be used.
+  // If 'earliest_deadline_first' is true the requests within a priority
+  // level are ordered by their timeout instead of their arrival, see
+  // SetExpectedExecutionNs().
   PriorityQueue(
       const inference::ModelQueuePolicy& default_queue_policy,
-      uint32_t priority_levels, const ModelQueuePolicyMap queue_policy_map);
+      uint32_t priority_levels, const ModelQueuePolicyMap queue_policy_map,
+      const bool earliest_deadline_first);
 
   // Enqueue a request with priority set to 'priority_level'. If
   // Status::Success is returned then the queue has taken ownership of
@@ -74,7 +80,45 @@ class PriorityQueue {
   // Dequeue the request at the front of the queue.
   Status Dequeue(std::unique_ptr<InferenceRequest>* request);
 
+  // A request that is dequeued to be held outside of the queue, for
+  // example while its batch is formed, instead of being executed
+  // right away. A held request still counts toward the maximum queue
+  // size of its priority level and ApplyPolicy() applies the queue
+  // policy of the level to it, until it is released with Release() or
+  // rejected.
+  struct HeldRequest {
+    HeldRequest() : level_idx_(0), timeout_ns_(0), delayed_(false) {}
+
+    // The index of the priority level that the request was queued at,
+    // lower is higher priority.
+    size_t level_idx_;
+
+    // The timeout timestamp of the request, in ns, 0 if the request
+    // doesn't have a timeout or has already timed-out and is delayed.
+    uint64_t timeout_ns_;
+
+    // Whether the request timed-out and the timeout action is DELAY.
+    bool delayed_;
+
+    std::unique_ptr<InferenceRequest> request_;
+  };
+
+  // Dequeue the request at the front of the queue to be held.
+  Status Dequeue(HeldRequest* held);
+
+  // Apply the queue policy to 'held' as of 'now_ns'. Return true if
+  // the request is still held. Otherwise the request is rejected, it
+  // is returned by the next ReleaseRejectedRequests() and its batch
+  // size is added to 'rejected_batch_size'.
+  bool ApplyPolicy(
+      HeldRequest* held, const uint64_t now_ns, size_t* rejected_batch_size);
+
+  // Release 'held' from the queue once it is executed.
+  void Release(const HeldRequest& held);
+
   // Retrieve the requests that are rejected based on the queue policies.
+  // 'requests' is set to nullptr if no request has been rejected since
+  // the last call.
   void ReleaseRejectedRequests(
       std::shared_ptr<
           std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>*
@@ -87,8 +131,17 @@ class PriorityQueue {
   // Is the queue is empty? Rejected requests are not included.
   bool Empty() { return Size() == 0; }
 
+  // Set the expected time to execute a batch, in ns. If the requests
+  // are ordered by timeout, a request times out as soon as it can no
+  // longer finish executing before its timeout, instead of when the
+  // timeout is reached.
+  void SetExpectedExecutionNs(const uint64_t exec_ns)
+  {
+    expected_exec_ns_ = exec_ns;
+  }
+
   // Reset the cursor such that it is representing an empty pending batch.
-  void ResetCursor() { pending_cursor_ = Cursor(queues_.begin()); }
+  void ResetCursor() { pending_cursor_ = Cursor(0 /* level_idx */); }
 
   // Record the current cursor. The cursor can be restored to recorded state
   // by invoking SetCursorToMark(). Note that Enqueue(), Dequeue(), and
@@ -106,7 +159,7 @@ class PriorityQueue {
   // Return the request at the cursor.
   const std::unique_ptr<InferenceRequest>& RequestAtCursor()
   {
-    return pending_cursor_.curr_it_->second.At(pending_cursor_.queue_idx_);
+    return queues_[pending_cursor_.level_idx_].At(pending_cursor_.queue_idx_);
   }
 
   // Advance the cursor for pending batch. This function will not trigger the
@@ -129,16 +182,112 @@ class PriorityQueue {
     return pending_cursor_.pending_batch_oldest_enqueue_time_ns_;
   }
 
-  // Return the closest timeout of requests in pending batch.
-  uint64_t ClosestTimeout()
-  {
-    return pending_cursor_.pending_batch_closest_timeout_ns_;
-  }
+  // Return the closest timeout of requests in pending batch, adjusted
+  // by the expected execution time if the requests are ordered by
+  // timeout.
+  uint64_t ClosestTimeout();
 
   // Return the number of requests in pending batch.
   size_t PendingBatchCount() { return pending_cursor_.pending_batch_count_; }
 
  private:
+  // A queue stored in a contiguous buffer that grows by doubling, so
+  // that pushing and popping at the ends doesn't allocate once the
+  // queue has reached its working size. Inserting or erasing in the
+  // middle moves the elements on the shorter side.
+  template <typename T>
+  class RingBuffer {
+   public:
+    RingBuffer() : head_(0), size_(0) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t idx) { return buf_[Slot(idx)]; }
+    const T& operator[](size_t idx) const { return buf_[Slot(idx)]; }
+    T& front() { return buf_[head_]; }
+    T& back() { return buf_[Slot(size_ - 1)]; }
+
+    void push_back(T&& value)
+    {
+      Reserve(size_ + 1);
+      buf_[Slot(size_)] = std::move(value);
+      size_++;
+    }
+
+    void pop_front()
+    {
+      buf_[head_] = T();
+      head_ = Slot(1);
+      size_--;
+    }
+
+    // Insert 'value' so that it is at 'idx'.
+    void insert(size_t idx, T&& value)
+    {
+      Reserve(size_ + 1);
+      if (idx < (size_ / 2)) {
+        head_ = (head_ + buf_.size() - 1) & (buf_.size() - 1);
+        for (size_t i = 0; i < idx; i++) {
+          (*this)[i] = std::move((*this)[i + 1]);
+        }
+      } else {
+        for (size_t i = size_; i > idx; i--) {
+          (*this)[i] = std::move((*this)[i - 1]);
+        }
+      }
+      (*this)[idx] = std::move(value);
+      size_++;
+    }
+
+    // Erase the elements in ['first', 'last').
+    void erase(size_t first, size_t last)
+    {
+      const size_t cnt = last - first;
+      if (cnt == 0) {
+        return;
+      }
+      if (first < (size_ - last)) {
+        for (size_t i = first; i > 0; i--) {
+          (*this)[i - 1 + cnt] = std::move((*this)[i - 1]);
+        }
+        for (size_t i = 0; i < cnt; i++) {
+          (*this)[i] = T();
+        }
+        head_ = Slot(cnt);
+      } else {
+        for (size_t i = last; i < size_; i++) {
+          (*this)[i - cnt] = std::move((*this)[i]);
+        }
+        for (size_t i = size_ - cnt; i < size_; i++) {
+          (*this)[i] = T();
+        }
+      }
+      size_ -= cnt;
+    }
+
+   private:
+    size_t Slot(size_t idx) const { return (head_ + idx) & (buf_.size() - 1); }
+
+    void Reserve(size_t cnt)
+    {
+      if (cnt <= buf_.size()) {
+        return;
+      }
+      std::vector<T> buf(std::max<size_t>(16, buf_.size() * 2));
+      for (size_t i = 0; i < size_; i++) {
+        buf[i] = std::move((*this)[i]);
+      }
+      buf_.swap(buf);
+      head_ = 0;
+    }
+
+    // The capacity, buf_.size(), is always 0 or a power of 2.
+    std::vector<T> buf_;
+    size_t head_;
+    size_t size_;
+  };
+
   class PolicyQueue {
    public:
     // Construct a policy queue with default policy, which will behave the same
@@ -146,30 +295,51 @@ class PriorityQueue {
     PolicyQueue()
         : timeout_action_(inference::ModelQueuePolicy::REJECT),
           default_timeout_us_(0), allow_timeout_override_(false),
-          max_queue_size_(0)
+          max_queue_size_(0), earliest_deadline_first_(false), held_size_(0)
     {
     }
 
-    // Construct a policy queue with given 'policy'.
-    PolicyQueue(const inference::ModelQueuePolicy& policy)
+    // Construct a policy queue with given 'policy'. If
+    // 'earliest_deadline_first' is true the requests are ordered by
+    // their timeout, and requests without timeout are placed after
+    // all requests with timeout.
+    PolicyQueue(
+        const inference::ModelQueuePolicy& policy,
+        const bool earliest_deadline_first)
         : timeout_action_(policy.timeout_action()),
           default_timeout_us_(policy.default_timeout_microseconds()),
           allow_timeout_override_(policy.allow_timeout_override()),
-          max_queue_size_(policy.max_queue_size())
+          max_queue_size_(policy.max_queue_size()),
+          earliest_deadline_first_(earliest_deadline_first), held_size_(0)
     {
     }
 
     // Enqueue a request and set up its timeout accordingly. If
     // Status::Success is returned then the queue has taken ownership
-    // of the request object and so 'request' will be nullptr. If
+    // of the request object and so 'request' will be nullptr, and
+    // 'idx' returns the position of the request in the queue. If
     // non-success is returned then the caller still retains ownership
     // of 'request'.
-    Status Enqueue(std::unique_ptr<InferenceRequest>& request);
+    Status Enqueue(std::unique_ptr<InferenceRequest>& request, size_t* idx);
 
     // Dequeue the request at the front of the queue.
     Status Dequeue(std::unique_ptr<InferenceRequest>* request);
 
-    // Apply the queue policy to the request at 'idx'.
+    // Dequeue the request at the front of the queue to be held.
+    Status Dequeue(HeldRequest* held);
+
+    // Apply the queue policy to 'held', see PriorityQueue::ApplyPolicy().
+    bool ApplyPolicy(
+        HeldRequest* held, const uint64_t now_ns, const uint64_t exec_ns,
+        size_t* rejected_count, size_t* rejected_batch_size);
+
+    // Release a held request that is executed.
+    void Release() { held_size_--; }
+
+    // Apply the queue policy to the request at 'idx'. If the requests
+    // are ordered by timeout, a request that would exceed its timeout
+    // after executing for 'exec_ns' is treated as timed-out. Cancelled
+    // requests are always rejected.
     // 'rejected_count' will be incremented by the number of the newly rejected
     // requets after applying the policy.
     // 'rejected_batch_size' will be incremented by the total batch size of the
@@ -177,7 +347,8 @@ class PriorityQueue {
     // Return true if the 'idx' still points to a request after applying the
     // policy, false otherwise.
     bool ApplyPolicy(
-        size_t idx, size_t* rejected_count, size_t* rejected_batch_size);
+        size_t idx, const uint64_t exec_ns, size_t* rejected_count,
+        size_t* rejected_batch_size);
 
     // Return the rejected requests held by the queue.
     void ReleaseRejectedQueue(
@@ -201,29 +372,53 @@ class PriorityQueue {
     size_t UnexpiredSize() { return queue_.size(); }
 
    private:
+    // Move 'request' to the rejected queue and increment
+    // 'rejected_count' and 'rejected_batch_size' accordingly.
+    void Reject(
+        std::unique_ptr<InferenceRequest>&& request, size_t* rejected_count,
+        size_t* rejected_batch_size);
+
+    // A request and its timeout timestamp, in ns. A timeout of 0
+    // indicates that the request doesn't specify a timeout.
+    struct TimedRequest {
+      TimedRequest() : timeout_ns_(0) {}
+      TimedRequest(
+          const uint64_t timeout_ns,
+          std::unique_ptr<InferenceRequest>&& request)
+          : timeout_ns_(timeout_ns), request_(std::move(request))
+      {
+      }
+
+      uint64_t timeout_ns_;
+      std::unique_ptr<InferenceRequest> request_;
+    };
+
     // Variables that define the policy for the queue
     const inference::ModelQueuePolicy::TimeoutAction timeout_action_;
     const uint64_t default_timeout_us_;
     const bool allow_timeout_override_;
     const uint32_t max_queue_size_;
+    const bool earliest_deadline_first_;
 
-    std::deque<uint64_t> timeout_timestamp_ns_;
-    std::deque<std::unique_ptr<InferenceRequest>> queue_;
-    std::deque<std::unique_ptr<InferenceRequest>> delayed_queue_;
-    std::deque<std::unique_ptr<InferenceRequest>> rejected_queue_;
+    RingBuffer<TimedRequest> queue_;
+    RingBuffer<std::unique_ptr<InferenceRequest>> delayed_queue_;
+    RingBuffer<std::unique_ptr<InferenceRequest>> rejected_queue_;
+
+    // The number of held requests, which count toward the maximum
+    // queue size.
+    size_t held_size_;
   };
-  using PriorityQueues = std::map<uint32_t, PolicyQueue>;
 
   // Cursor for tracking pending batch, the cursor points to the item after
   // the pending batch.
   struct Cursor {
     Cursor() = default;
-    Cursor(PriorityQueues::iterator start_it);
+    Cursor(size_t level_idx);
 
     Cursor(const Cursor& rhs) = default;
     Cursor& operator=(const Cursor& rhs) = default;
 
-    PriorityQueues::iterator curr_it_;
+    size_t level_idx_;
     size_t queue_idx_;
     bool at_delayed_queue_;
     uint64_t pending_batch_closest_timeout_ns_;
@@ -232,13 +427,33 @@ class PriorityQueue {
     bool valid_;
   };
 
-  PriorityQueues queues_;
+  // Return the index of the first priority level at or after
+  // 'level_idx' that has requests, or the number of priority levels
+  // if there is none.
+  size_t NextNonEmptyLevel(size_t level_idx) const;
+
+  // Set or clear the bit of priority level 'level_idx' in
+  // 'non_empty_levels_' according to whether the level has requests.
+  void UpdateNonEmptyLevel(size_t level_idx);
+
+  // The queue of each priority level, indexed by the priority level
+  // minus 'level_offset_'. If there are no priority levels then the
+  // single queue is priority level 0, otherwise the priority levels
+  // start from 1. Bit 'i' of 'non_empty_levels_' is set if
+  // 'queues_[i]' has requests so that the front of the queue is found
+  // without visiting the empty levels.
+  std::vector<PolicyQueue> queues_;
+  std::vector<uint64_t> non_empty_levels_;
+  uint32_t level_offset_;
   size_t size_;
 
-  // Keep track of the priority level that the first request in the queue
-  // is at to avoid traversing 'queues_'
-  uint32_t front_priority_level_;
-  uint32_t last_priority_level_;
+  // The number of rejected requests held by 'queues_'.
+  size_t rejected_size_;
+
+  // Whether the requests of each priority level are ordered by timeout,
+  // and the expected execution time used to reject them early.
+  bool earliest_deadline_first_;
+  uint64_t expected_exec_ns_;
 
   Cursor pending_cursor_;
   Cursor current_mark_;
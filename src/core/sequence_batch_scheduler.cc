@@ -35,6 +35,7 @@
 #include "src/core/dynamic_batch_scheduler.h"
 #include "src/core/logging.h"
 #include "src/core/model_config_utils.h"
+#include "src/core/timer_wheel.h"
 
 namespace nvidia { namespace inferenceserver {
 
@@ -44,9 +45,38 @@ SequenceBatchScheduler::Create(
     const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
     const StandardRunFunc& OnSchedule,
     const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter,
     std::unique_ptr<Scheduler>* scheduler)
 {
   std::unique_ptr<SequenceBatchScheduler> sched(new SequenceBatchScheduler());
+  sched->metric_reporter_ = metric_reporter;
+  sched->pending_cnt_ = 0;
+
+  // Requests stop being pending once they are passed to the run
+  // function, which happens in the SequenceBatch derivatives, so wrap
+  // the run function to report that. The "null" requests created by
+  // the batchers were never counted as pending.
+  StandardRunFunc OnScheduleWithMetric = OnSchedule;
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter != nullptr) &&
+      (metric_reporter->MetricInferencePendingCount() != nullptr)) {
+    SequenceBatchScheduler* base = sched.get();
+    OnScheduleWithMetric =
+        [OnSchedule, metric_reporter, base](
+            uint32_t runner_idx,
+            std::vector<std::unique_ptr<InferenceRequest>>&& requests) {
+          size_t cnt = 0;
+          for (const auto& request : requests) {
+            if (!request->IsNull()) {
+              cnt++;
+            }
+          }
+          base->pending_cnt_ -= cnt;
+          metric_reporter->MetricInferencePendingCount()->Decrement(cnt);
+          OnSchedule(runner_idx, std::move(requests));
+        };
+  }
+#endif  // TRITON_ENABLE_METRICS
 
   // For debugging and testing,
   const char* dstr = getenv("TRITONSERVER_BACKLOG_DELAY_SCHEDULER");
@@ -94,14 +124,14 @@ SequenceBatchScheduler::Create(
     // scheduling strategy.
     if (config.sequence_batching().has_oldest()) {
       sb.reset(new OldestSequenceBatch(
-          sched.get(), c, seq_slot_cnt, config, OnInit, OnWarmup, OnSchedule,
-          enforce_equal_shape_tensors, start, end, startend, cont, notready,
-          &init_state));
+          sched.get(), c, seq_slot_cnt, config, OnInit, OnWarmup,
+          OnScheduleWithMetric, enforce_equal_shape_tensors, start, end,
+          startend, cont, notready, &init_state));
     } else {
       sb.reset(new DirectSequenceBatch(
-          sched.get(), c, seq_slot_cnt, config, OnInit, OnWarmup, OnSchedule,
-          enforce_equal_shape_tensors, start, end, startend, cont, notready,
-          &init_state));
+          sched.get(), c, seq_slot_cnt, config, OnInit, OnWarmup,
+          OnScheduleWithMetric, enforce_equal_shape_tensors, start, end,
+          startend, cont, notready, &init_state));
     }
 
     if (init_state.get_future().get()) {
@@ -120,11 +150,14 @@ SequenceBatchScheduler::Create(
         "Initialization failed for all sequence-batch scheduler threads");
   }
 
-  // Create a reaper thread that watches for idle sequences. Run the
-  // reaper a lower priority.
+  // Create a reaper thread that reaps idle sequences when woken by
+  // the reaper timer, which is scheduled once requests are enqueued.
+  // Run the reaper a lower priority.
   SequenceBatchScheduler* raw = sched.release();
 
-  raw->reaper_thread_exit_ = false;
+  raw->reap_scheduled_ = false;
+  raw->reap_requested_ = false;
+  raw->reaper_exit_ = false;
   raw->reaper_thread_.reset(
       new std::thread([raw]() { raw->ReaperThread(10 /* nice */); }));
 
@@ -135,16 +168,31 @@ SequenceBatchScheduler::Create(
 
 SequenceBatchScheduler::~SequenceBatchScheduler()
 {
-  // Signal the reaper thread to exit...
+  // Signal the reaper thread to exit, which stops it from scheduling
+  // the reaper timer, and then cancel the timer.
   {
     std::unique_lock<std::mutex> lock(mu_);
-    reaper_thread_exit_ = true;
+    reaper_exit_ = true;
   }
 
   reaper_cv_.notify_one();
   if ((reaper_thread_ != nullptr) && reaper_thread_->joinable()) {
     reaper_thread_->join();
   }
+
+  TimerWheel::Global()->Cancel(this);
+
+  // Destroy the batchers so no more requests are run, and then remove
+  // the requests that are still pending from the count.
+  batchers_.clear();
+
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter_ != nullptr) &&
+      (metric_reporter_->MetricInferencePendingCount() != nullptr) &&
+      (pending_cnt_ != 0)) {
+    metric_reporter_->MetricInferencePendingCount()->Decrement(pending_cnt_);
+  }
+#endif  // TRITON_ENABLE_METRICS
 }
 
 namespace {
@@ -377,16 +425,29 @@ SequenceBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& irequest)
   }
 
   // Record the timestamp of this request for the correlation ID. The
-  // reaper thread will check to make sure that
-  // max_sequence_idle_microseconds value is not exceed for any
-  // sequence, and if it is it will release the sequence slot (if any)
-  // allocated to that sequence.
+  // reaper will check to make sure that max_sequence_idle_microseconds
+  // value is not exceed for any sequence, and if it is it will release
+  // the sequence slot (if any) allocated to that sequence. The reaper
+  // runs when the idle time of the sequences it tracks may expire, so
+  // schedule it if it is not tracking any sequence.
   {
     uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
                           std::chrono::steady_clock::now().time_since_epoch())
                           .count();
     correlation_id_timestamps_[correlation_id] = now_us;
+    if (!reap_scheduled_ && !reaper_exit_) {
+      ScheduleReaper(max_sequence_idle_microseconds_ + 1);
+    }
+  }
+
+  // From this point the request is always accepted by the scheduler.
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter_ != nullptr) &&
+      (metric_reporter_->MetricInferencePendingCount() != nullptr)) {
+    pending_cnt_++;
+    metric_reporter_->MetricInferencePendingCount()->Increment(1);
   }
+#endif  // TRITON_ENABLE_METRICS
 
   // If this request starts a new sequence but the correlation ID
   // already has an in-progress sequence then that previous sequence
@@ -473,11 +534,42 @@ SequenceBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& irequest)
   return Status::Success;
 }
 
+void
+SequenceBatchScheduler::RejectRequest(
+    std::unique_ptr<InferenceRequest>& request, const Status& status)
+{
+  if ((request == nullptr) || request->IsNull()) {
+    return;
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if ((metric_reporter_ != nullptr) &&
+      (metric_reporter_->MetricInferencePendingCount() != nullptr)) {
+    pending_cnt_--;
+    metric_reporter_->MetricInferencePendingCount()->Decrement(1);
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  InferenceRequest::RespondIfError(request, status, true /* release_request */);
+}
+
 uint64_t
 SequenceBatchScheduler::ReleaseSequenceSlot(
     const BatcherSequenceSlot& batcher_seq_slot,
     std::deque<std::unique_ptr<InferenceRequest>>* requests)
 {
+  // Any requests still in the queue are dropped when the slot is
+  // released, so reject them. These are requests that follow a
+  // sequence end or that race with the reaper force-ending the
+  // sequence.
+  for (auto& request : *requests) {
+    RejectRequest(
+        request, Status(
+                     Status::Code::UNAVAILABLE,
+                     "Request was dropped because its sequence ended"));
+  }
+  requests->clear();
+
   std::unique_lock<std::mutex> lock(mu_);
 
   // If there is a backlogged sequence and it is requested, return it
@@ -558,6 +650,22 @@ SequenceBatchScheduler::DelayScheduler(
   return false;
 }
 
+void
+SequenceBatchScheduler::ScheduleReaper(const uint64_t wait_microseconds)
+{
+  // The timer only wakes the reaper thread, the idle sequences are
+  // reaped on the reaper thread so that the timer thread is not
+  // delayed by the scan.
+  reap_scheduled_ = true;
+  TimerWheel::Global()->Schedule(this, wait_microseconds, [this]() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      reap_requested_ = true;
+    }
+    reaper_cv_.notify_one();
+  });
+}
+
 void
 SequenceBatchScheduler::ReaperThread(const int nice)
 {
@@ -576,12 +684,18 @@ SequenceBatchScheduler::ReaperThread(const int nice)
 
   const uint64_t backlog_idle_wait_microseconds = 50 * 1000;
 
-  while (!reaper_thread_exit_) {
+  while (true) {
     uint64_t wait_microseconds = max_sequence_idle_microseconds_;
     BatcherSequenceSlotMap force_end_sequences;
 
     {
       std::unique_lock<std::mutex> lock(mu_);
+      reaper_cv_.wait(
+          lock, [this]() { return reap_requested_ || reaper_exit_; });
+      if (reaper_exit_) {
+        break;
+      }
+      reap_requested_ = false;
 
       uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
                             std::chrono::steady_clock::now().time_since_epoch())
@@ -633,6 +747,16 @@ SequenceBatchScheduler::ReaperThread(const int nice)
           }
         }
       }
+
+      // Check again when the next idle timeout may expire. If no
+      // sequence is tracked the reaper is scheduled by the next
+      // enqueue.
+      reap_scheduled_ = false;
+      if (!correlation_id_timestamps_.empty()) {
+        LOG_VERBOSE(2) << "Reaper: sleeping for " << wait_microseconds
+                       << "us...";
+        ScheduleReaper(wait_microseconds);
+      }
     }
 
     // Enqueue force-ends outside of the lock.
@@ -652,14 +776,6 @@ SequenceBatchScheduler::ReaperThread(const int nice)
       batchers_[batcher_idx]->Enqueue(
           seq_slot, idle_correlation_id, null_request);
     }
-
-    // Wait until the next idle timeout needs to be checked
-    if (wait_microseconds > 0) {
-      std::unique_lock<std::mutex> lock(mu_);
-      LOG_VERBOSE(2) << "Reaper: sleeping for " << wait_microseconds << "us...";
-      std::chrono::microseconds wait_timeout(wait_microseconds);
-      reaper_cv_.wait_for(lock, wait_timeout);
-    }
   }
 
   LOG_VERBOSE(1) << "Stopping sequence-batch reaper thread...";
@@ -881,6 +997,9 @@ DirectSequenceBatch::~DirectSequenceBatch()
   } else {
     scheduler_thread_->detach();
   }
+
+  // Cancel the timers that would wake the scheduler thread.
+  TimerWheel::Global()->Cancel(this);
 }
 
 void
@@ -971,11 +1090,13 @@ DirectSequenceBatch::SchedulerThread(
     }
   }
 
-  const uint64_t default_wait_microseconds = 500 * 1000;
-
   while (!scheduler_thread_exit_) {
     std::vector<std::unique_ptr<InferenceRequest>> requests;
-    uint64_t wait_microseconds = default_wait_microseconds;
+
+    // Wait until a request is enqueued unless a batch is ready, or
+    // until 'wait_microseconds' if it is not 0.
+    bool wait_for_requests = true;
+    uint64_t wait_microseconds = 0;
 
     // Hold the lock for as short a time as possible.
     {
@@ -1074,7 +1195,7 @@ DirectSequenceBatch::SchedulerThread(
         if (max_seq_slot != -1) {
           if ((pending_batch_delay_ns_ == 0) ||
               (minimum_slot_utilization_ == 0.0)) {
-            wait_microseconds = 0;
+            wait_for_requests = false;
           } else {
             // Compare the age of the oldest pending request to the maximum
             // batch queuing delay, and the size of the ready requests in the
@@ -1090,7 +1211,7 @@ DirectSequenceBatch::SchedulerThread(
             if ((current_batch_delay_ns > pending_batch_delay_ns_) ||
                 (((float)ready_cnt) / max_batch_size_ >=
                  minimum_slot_utilization_)) {
-              wait_microseconds = 0;
+              wait_for_requests = false;
               LOG_VERBOSE(1)
                   << "start sequence batch execution. "
                   << "current batch delay: " << current_batch_delay_ns
@@ -1098,8 +1219,9 @@ DirectSequenceBatch::SchedulerThread(
                   << "slot utilization: " << ready_cnt << "/" << max_batch_size_
                   << "; utilization threshold: " << minimum_slot_utilization_;
             } else {
-              wait_microseconds =
-                  (pending_batch_delay_ns_ - current_batch_delay_ns) / 1000;
+              wait_microseconds = std::max(
+                  (uint64_t)1,
+                  (pending_batch_delay_ns_ - current_batch_delay_ns) / 1000);
               // reset 'max_seq_slot' so that not request is pulled from the
               // queues
               max_seq_slot = -1;
@@ -1179,9 +1301,8 @@ DirectSequenceBatch::SchedulerThread(
                            << seq_slot;
 
             // Should never be anything in a queue after the END
-            // marker. If it happens that means we will clobber
-            // that request if/when we swap in a backlog sequence
-            // in ReleaseSequenceSlot below.
+            // marker. If it happens that request is rejected by
+            // ReleaseSequenceSlot below.
             if (!queue.empty()) {
               LOG_ERROR << "internal: unexpected requests after sequence "
                            "end in slot "
@@ -1205,11 +1326,8 @@ DirectSequenceBatch::SchedulerThread(
 
       // If no requests are to be handled, wait for notification or
       // for the specified timeout before checking the queues again.
-      if (wait_microseconds > 0) {
-        scheduler_idle_ = true;
-        std::chrono::microseconds wait_timeout(wait_microseconds);
-        cv_.wait_for(lock, wait_timeout);
-        scheduler_idle_ = false;
+      if (wait_for_requests) {
+        WaitForWork(lock, wait_microseconds);
       }
     }
 
@@ -1246,6 +1364,39 @@ DirectSequenceBatch::SchedulerThread(
                  << batcher_idx_ << "...";
 }
 
+void
+DirectSequenceBatch::WaitForWork(
+    std::unique_lock<std::mutex>& lock, const uint64_t wait_microseconds)
+{
+  // 'lock' must hold 'mu_'. Wait until the thread is notified or, if
+  // 'wait_microseconds' is not 0, until the timeout expires. As in
+  // the dynamic batcher the timeout is a timer of the global timer
+  // wheel so that the thread of an idle model does not wake.
+  if (wait_microseconds > 0) {
+    const uint64_t deadline_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count() +
+        (wait_microseconds * 1000);
+    if (wake_deadlines_ns_.empty() ||
+        (*wake_deadlines_ns_.begin() > deadline_ns)) {
+      wake_deadlines_ns_.insert(deadline_ns);
+      TimerWheel::Global()->Schedule(
+          this, wait_microseconds, [this, deadline_ns]() {
+            {
+              std::lock_guard<std::mutex> lock(mu_);
+              wake_deadlines_ns_.erase(wake_deadlines_ns_.find(deadline_ns));
+            }
+            cv_.notify_one();
+          });
+    }
+  }
+
+  scheduler_idle_ = true;
+  cv_.wait(lock);
+  scheduler_idle_ = false;
+}
+
 OldestSequenceBatch::OldestSequenceBatch(
     SequenceBatchScheduler* base, const uint32_t batcher_idx,
     const size_t seq_slot_cnt, const inference::ModelConfig& config,
@@ -1292,7 +1443,7 @@ OldestSequenceBatch::OldestSequenceBatch(
       config.max_batch_size(), enforce_equal_shape_tensors_,
       true /* preserve_ordering */, preferred_batch_sizes,
       config.sequence_batching().oldest().max_queue_delay_microseconds(),
-      &dynamic_batcher_);
+      nullptr /* metric_reporter */, &dynamic_batcher_);
   if (!status.IsOk()) {
     LOG_ERROR << "failed creating dynamic sequence batcher for OldestFirst "
               << batcher_idx_ << ": " << status.Message();
@@ -1308,7 +1459,13 @@ OldestSequenceBatch::~OldestSequenceBatch() {}
 void
 OldestSequenceBatch::CompleteAndNext(const uint32_t seq_slot)
 {
-  std::lock_guard<std::mutex> lock(mu_);
+  // A request that the dynamic batcher fails to accept is rejected
+  // after releasing the lock, since releasing the request calls
+  // CompleteAndNext() again.
+  std::unique_ptr<InferenceRequest> rejected_request;
+  Status rejected_status;
+
+  std::unique_lock<std::mutex> lock(mu_);
 
   // We may enqueue 1 or more pending inferences triggered by the
   // completion. If the sequence has a pending inference then it needs
@@ -1363,7 +1520,14 @@ OldestSequenceBatch::CompleteAndNext(const uint32_t seq_slot)
         irequest->AddInternalReleaseCallback(
             [this, seq_slot]() { CompleteAndNext(seq_slot); });
 
-        dynamic_batcher_->Enqueue(irequest);
+        Status status = dynamic_batcher_->Enqueue(irequest);
+        if (!status.IsOk()) {
+          // Releasing the rejected request completes it like an
+          // executed request, which sends the next request of the
+          // sequence.
+          rejected_request = std::move(irequest);
+          rejected_status = status;
+        }
       }
 
       queue.pop_front();
@@ -1374,8 +1538,7 @@ OldestSequenceBatch::CompleteAndNext(const uint32_t seq_slot)
     // backlog).
     if (release_seq_slot) {
       // Should never be anything in a queue after the END marker. If it
-      // happens that means we will clobber that request if/when we swap
-      // in a backlog sequence in ReleaseSequenceSlot below.
+      // happens that request is rejected by ReleaseSequenceSlot below.
       if (!queue.empty()) {
         LOG_ERROR << "internal: unexpected requests after sequence end in slot "
                   << seq_slot;
@@ -1400,6 +1563,11 @@ OldestSequenceBatch::CompleteAndNext(const uint32_t seq_slot)
       }
     }
   }
+
+  lock.unlock();
+  if (rejected_request != nullptr) {
+    base_->RejectRequest(rejected_request, rejected_status);
+  }
 }
 
 void
@@ -31,9 +31,11 @@
 #include <future>
 #include <mutex>
 #include <queue>
+#include <set>
 #include <thread>
 #include <unordered_map>
 #include "model_config.pb.h"
+#include "src/core/metric_model_reporter.h"
 #include "src/core/model_config.h"
 #include "src/core/scheduler.h"
 #include "src/core/scheduler_utils.h"
@@ -53,12 +55,15 @@ class SequenceBatchScheduler : public Scheduler {
   ~SequenceBatchScheduler();
 
   // Create a scheduler to support a given number of runners and a run
-  // function to call when a request is scheduled.
+  // function to call when a request is scheduled. If non-null,
+  // 'metric_reporter' is used to report the number of requests
+  // pending in the scheduler.
   static Status Create(
       const inference::ModelConfig& config, const uint32_t runner_cnt,
       const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
       const StandardRunFunc& OnSchedule,
       const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter,
       std::unique_ptr<Scheduler>* scheduler);
 
   // \see Scheduler::Enqueue()
@@ -80,6 +85,12 @@ class SequenceBatchScheduler : public Scheduler {
       const BatcherSequenceSlot& seq_slot,
       std::deque<std::unique_ptr<InferenceRequest>>* requests);
 
+  // Respond to 'request', which was accepted by Enqueue() but can't
+  // be executed, with 'status' and release it. Nothing is done if
+  // 'request' is a null request or nullptr.
+  void RejectRequest(
+      std::unique_ptr<InferenceRequest>& request, const Status& status);
+
   // For debugging/testing, batcher reports how many waiting requests
   // and returns true if the batcher should continue waiting.
   bool DelayScheduler(
@@ -88,6 +99,10 @@ class SequenceBatchScheduler : public Scheduler {
  private:
   void ReaperThread(const int nice);
 
+  // Schedule the timer that wakes the reaper thread after
+  // 'wait_microseconds'. Must be called with 'mu_' held.
+  void ScheduleReaper(const uint64_t wait_microseconds);
+
   Status CreateBooleanControlTensors(
       const inference::ModelConfig& config,
       std::shared_ptr<ControlInputs>* start_input_overrides,
@@ -111,10 +126,18 @@ class SequenceBatchScheduler : public Scheduler {
   // Mutex
   std::mutex mu_;
 
-  // The reaper thread
+  // The reaper thread. The thread sleeps until a timer of the global
+  // timer wheel, which is scheduled while there are sequences whose
+  // idle time is tracked, wakes it to reap the idle sequences.
+  // 'reap_scheduled_' is true if the timer is scheduled,
+  // 'reap_requested_' is true once the timer has expired and
+  // 'reaper_exit_' is true once the scheduler is being destroyed.
+  // Protected by 'mu_'.
   std::unique_ptr<std::thread> reaper_thread_;
   std::condition_variable reaper_cv_;
-  bool reaper_thread_exit_;
+  bool reap_scheduled_;
+  bool reap_requested_;
+  bool reaper_exit_;
 
   // The SequenceBatchs being managed by this scheduler.
   std::vector<std::shared_ptr<SequenceBatch>> batchers_;
@@ -151,6 +174,14 @@ class SequenceBatchScheduler : public Scheduler {
   // Used for debugging/testing.
   size_t backlog_delay_cnt_;
   std::vector<size_t> queue_request_cnts_;
+
+  // Reporter for the pending request count. A request is pending from
+  // when it is accepted by Enqueue() until it is passed to the run
+  // function or rejected. 'pending_cnt_' is the number of pending
+  // requests, which are removed from the count when the scheduler is
+  // destroyed.
+  std::shared_ptr<MetricModelReporter> metric_reporter_;
+  std::atomic<uint64_t> pending_cnt_;
 };
 
 // Base class for a scheduler that implements a particular scheduling
@@ -253,6 +284,8 @@ class DirectSequenceBatch : public SequenceBatch {
 
  private:
   void SchedulerThread(const int nice, std::promise<bool>* is_initialized);
+  void WaitForWork(
+      std::unique_lock<std::mutex>& lock, const uint64_t wait_microseconds);
 
   // Function the scheduler will call to initialize a runner.
   const Scheduler::StandardInitFunc OnInit_;
@@ -272,6 +305,10 @@ class DirectSequenceBatch : public SequenceBatch {
   std::mutex mu_;
   std::condition_variable cv_;
 
+  // The deadlines of the timers that will notify 'cv_' so that the
+  // idle scheduler thread checks the queues again. Protected by 'mu_'.
+  std::multiset<uint64_t> wake_deadlines_ns_;
+
   // Queues holding inference requests. There are 'seq_slot_cnt'
   // queues, one for each sequence slot where requests assigned to
   // that slot are enqueued to wait for inferencing.
@@ -36,15 +36,20 @@
 #include <vector>
 
 #include "model_config.pb.h"
+#include "src/backends/backend/triton_backend_config.h"
 #include "src/backends/backend/triton_backend_manager.h"
 #include "src/core/backend.h"
 #include "src/core/constants.h"
 #include "src/core/cuda_utils.h"
+#include "src/core/filesystem.h"
 #include "src/core/logging.h"
+#include "src/core/metrics.h"
 #include "src/core/model_config.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/model_repository_manager.h"
 #include "src/core/pinned_memory_manager.h"
+#include "src/core/response_cache.h"
+#include "src/core/shared_executor.h"
 #include "src/core/triton_repo_agent.h"
 #include "triton/common/table_printer.h"
 
@@ -137,6 +142,65 @@ InferenceServer::Init()
     return status;
   }
 
+#ifdef TRITON_ENABLE_METRICS
+  // The latency histogram buckets must be set before any model is
+  // loaded as the histograms are created along with the model.
+  bool latency_buckets_specified;
+  std::vector<double> latency_buckets;
+  status = BackendConfigurationMetricsLatencyBuckets(
+      backend_cmdline_config_map_, &latency_buckets_specified,
+      &latency_buckets);
+  if (!status.IsOk()) {
+    ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+    return status;
+  }
+  if (latency_buckets_specified) {
+    Metrics::SetLatencyBuckets(latency_buckets);
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  // Models localized from cloud storage may share a persistent cache
+  // of downloaded files.
+  std::string localize_cache_dir;
+  uint64_t localize_cache_byte_size;
+  status = BackendConfigurationLocalizeCache(
+      backend_cmdline_config_map_, &localize_cache_dir,
+      &localize_cache_byte_size);
+  if (status.IsOk() && !localize_cache_dir.empty()) {
+    status = SetLocalizeCache(localize_cache_dir, localize_cache_byte_size);
+  }
+  if (!status.IsOk()) {
+    ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+    return status;
+  }
+
+  // The response cache is shared by all models that enable it and so
+  // must be created before any model is loaded.
+  uint64_t response_cache_byte_size;
+  status = BackendConfigurationResponseCacheByteSize(
+      backend_cmdline_config_map_, &response_cache_byte_size);
+  if (!status.IsOk()) {
+    ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+    return status;
+  }
+  ResponseCache::SetGlobalByteSize(response_cache_byte_size);
+
+  // The shared CPU executor is used by the schedulers of the models
+  // that are loaded and so must also be created before any model is
+  // loaded.
+  uint32_t shared_cpu_executor_thread_cnt;
+  status = BackendConfigurationSharedCpuExecutor(
+      backend_cmdline_config_map_, &shared_cpu_executor_thread_cnt);
+  if (!status.IsOk()) {
+    ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+    return status;
+  }
+  SharedExecutor::SetGlobalThreadCount(shared_cpu_executor_thread_cnt);
+  if (shared_cpu_executor_thread_cnt != 0) {
+    LOG_INFO << "Shared CPU executor with "
+             << shared_cpu_executor_thread_cnt << " threads";
+  }
+
   // Some backends have difficulty being loaded/unloaded dynamically,
   // for example, non-deterministic hanging while trying to initialize
   // a shared library. The hangs seems to be related to other
@@ -452,6 +516,26 @@ InferenceServer::InferAsync(std::unique_ptr<InferenceRequest>& request)
   return InferenceRequest::Run(request);
 }
 
+Status
+InferenceServer::InferAsync(
+    std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  if (ready_state_ != ServerReadyState::SERVER_READY) {
+    return Status(Status::Code::UNAVAILABLE, "Server not ready");
+  }
+
+#ifdef TRITON_ENABLE_STATS
+  for (auto& request : requests) {
+    request->CaptureRequestStartNs();
+    INFER_TRACE_ACTIVITY(
+        request->Trace(), TRITONSERVER_TRACE_REQUEST_START,
+        request->RequestStartNs());
+  }
+#endif  // TRITON_ENABLE_STATS
+
+  return InferenceRequest::Run(requests);
+}
+
 Status
 InferenceServer::LoadModel(const std::string& model_name)
 {
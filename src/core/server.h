@@ -28,6 +28,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <atomic>
+#include <functional>
 #include <map>
 #include <string>
 #include <thread>
@@ -113,6 +114,13 @@ class InferenceServer {
   // ownership of 'request'.
   Status InferAsync(std::unique_ptr<InferenceRequest>& request);
 
+  // Inference for a set of requests that all use the same model. This
+  // function takes ownership of each request that is run, setting the
+  // corresponding entry of 'requests' to nullptr. If non-success is
+  // returned then the caller still retains ownership of the requests
+  // that were not run.
+  Status InferAsync(std::vector<std::unique_ptr<InferenceRequest>>& requests);
+
   // Load the corresponding model. Reload the model if it has been loaded.
   Status LoadModel(const std::string& model_name);
 
@@ -227,16 +235,32 @@ class InferenceServer {
   float TensorFlowGPUMemoryFraction() const { return tf_gpu_memory_fraction_; }
   void SetTensorFlowGPUMemoryFraction(float f) { tf_gpu_memory_fraction_ = f; }
 
-  // Return the requested InferenceBackend object.
+  // Return the requested InferenceBackend object. If 'load_on_demand'
+  // is true and the server loads models on demand, the model is loaded
+  // if it is not already.
   Status GetInferenceBackend(
       const std::string& model_name, const int64_t model_version,
-      std::shared_ptr<InferenceBackend>* backend)
+      std::shared_ptr<InferenceBackend>* backend,
+      const bool load_on_demand = false)
   {
     if (ready_state_ != ServerReadyState::SERVER_READY) {
       return Status(Status::Code::UNAVAILABLE, "Server not ready");
     }
     return model_repository_manager_->GetInferenceBackend(
-        model_name, model_version, backend);
+        model_name, model_version, backend, load_on_demand);
+  }
+
+  // Start to load a model on demand without waiting for the load, see
+  // ModelRepositoryManager::LoadModelOnDemand().
+  Status LoadModelOnDemand(
+      const std::string& model_name, const int64_t model_version,
+      std::function<void(const Status&)>&& on_complete, bool* ready)
+  {
+    if (ready_state_ != ServerReadyState::SERVER_READY) {
+      return Status(Status::Code::UNAVAILABLE, "Server not ready");
+    }
+    return model_repository_manager_->LoadModelOnDemand(
+        model_name, model_version, std::move(on_complete), ready);
   }
 
  private:
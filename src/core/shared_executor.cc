@@ -0,0 +1,367 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/shared_executor.h"
+
+#ifndef _WIN32
+#include <numa.h>
+#endif
+#include <algorithm>
+#include "src/core/logging.h"
+#include "src/core/timer_wheel.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+std::unique_ptr<SharedExecutor> global_executor_;
+
+// The executor and the index of the worker running on the current
+// thread, if the current thread is a worker.
+thread_local SharedExecutor* current_executor_ = nullptr;
+thread_local size_t current_worker_ = 0;
+
+// Return the NUMA nodes of the host that have CPUs and the number of
+// CPUs of each node. Return no nodes if the host has a single node or
+// NUMA is not available, in which case the workers are not bound to
+// any node.
+std::vector<std::pair<int, size_t>>
+NumaNodeCpuCounts()
+{
+  std::vector<std::pair<int, size_t>> nodes;
+#ifndef _WIN32
+  if ((numa_available() == -1) || (numa_num_configured_nodes() <= 1)) {
+    return nodes;
+  }
+
+  struct bitmask* cpus = numa_allocate_cpumask();
+  for (int node = 0; node <= numa_max_node(); ++node) {
+    if (numa_node_to_cpus(node, cpus) == 0) {
+      const size_t cpu_cnt = numa_bitmask_weight(cpus);
+      if (cpu_cnt > 0) {
+        nodes.emplace_back(node, cpu_cnt);
+      }
+    }
+  }
+  numa_free_cpumask(cpus);
+
+  if (nodes.size() <= 1) {
+    nodes.clear();
+  }
+#endif  // !_WIN32
+  return nodes;
+}
+
+}  // namespace
+
+SharedExecutor::SharedExecutor(const uint32_t thread_cnt)
+    : any_queued_cnt_(0), next_worker_(0), exiting_(false)
+{
+  // Distribute the workers over the NUMA nodes in proportion to the
+  // number of CPUs of each node. A node without workers is not used,
+  // its tasks are executed by any worker.
+  const auto nodes = NumaNodeCpuCounts();
+  if (nodes.empty()) {
+    node_groups_.emplace_back(new NodeGroup());
+    for (uint32_t w = 0; w < thread_cnt; ++w) {
+      node_groups_[0]->workers_.push_back(w);
+    }
+  } else {
+    size_t total_cpu_cnt = 0;
+    for (const auto& node : nodes) {
+      total_cpu_cnt += node.second;
+    }
+    size_t assigned_cnt = 0;
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      size_t worker_cnt = (thread_cnt * nodes[n].second) / total_cpu_cnt;
+      if (n == (nodes.size() - 1)) {
+        worker_cnt = thread_cnt - assigned_cnt;
+      } else if ((worker_cnt == 0) && (assigned_cnt < thread_cnt)) {
+        worker_cnt = 1;
+      }
+      worker_cnt = std::min(worker_cnt, thread_cnt - assigned_cnt);
+      if (worker_cnt == 0) {
+        continue;
+      }
+
+      node_groups_.emplace_back(new NodeGroup());
+      node_groups_.back()->numa_node_ = nodes[n].first;
+      for (size_t w = 0; w < worker_cnt; ++w) {
+        node_groups_.back()->workers_.push_back(assigned_cnt + w);
+      }
+      assigned_cnt += worker_cnt;
+    }
+  }
+
+  for (size_t g = 0; g < node_groups_.size(); ++g) {
+    for (const size_t w : node_groups_[g]->workers_) {
+      workers_.emplace_back(new Worker());
+      workers_[w]->node_idx_ = g;
+    }
+  }
+
+  LOG_VERBOSE(1) << "Starting shared executor with " << workers_.size()
+                 << " threads on " << node_groups_.size() << " NUMA node(s)";
+
+  for (size_t w = 0; w < workers_.size(); ++w) {
+    workers_[w]->thread_.reset(
+        new std::thread([this, w]() { WorkerThread(w); }));
+  }
+}
+
+SharedExecutor::~SharedExecutor()
+{
+  // Drop the delayed tasks that have not been submitted.
+  TimerWheel::Global()->Cancel(this);
+
+  exiting_ = true;
+  for (auto& group : node_groups_) {
+    std::lock_guard<std::mutex> lock(group->mu_);
+    group->cv_.notify_all();
+  }
+
+  for (auto& worker : workers_) {
+    if (worker->thread_->joinable()) {
+      worker->thread_->join();
+    }
+  }
+}
+
+void
+SharedExecutor::SetGlobalThreadCount(const uint32_t thread_cnt)
+{
+  if (thread_cnt == 0) {
+    global_executor_.reset();
+  } else {
+    global_executor_.reset(new SharedExecutor(thread_cnt));
+  }
+}
+
+SharedExecutor*
+SharedExecutor::Global()
+{
+  return global_executor_.get();
+}
+
+void
+SharedExecutor::Submit(const int numa_node, Task&& task)
+{
+  if (workers_.empty()) {
+    return;
+  }
+
+  size_t node_idx = node_groups_.size();
+  if ((numa_node >= 0) && (node_groups_.size() > 1)) {
+    for (size_t g = 0; g < node_groups_.size(); ++g) {
+      if (node_groups_[g]->numa_node_ == numa_node) {
+        node_idx = g;
+        break;
+      }
+    }
+  }
+
+  if (node_idx < node_groups_.size()) {
+    NodeGroup& group = *node_groups_[node_idx];
+    size_t worker_idx;
+    if ((current_executor_ == this) &&
+        (workers_[current_worker_]->node_idx_ == node_idx)) {
+      worker_idx = current_worker_;
+    } else {
+      worker_idx =
+          group.workers_[group.next_worker_++ % group.workers_.size()];
+    }
+    {
+      Worker& worker = *workers_[worker_idx];
+      std::lock_guard<std::mutex> lock(worker.mu_);
+      worker.node_tasks_.emplace_back(std::move(task));
+      group.queued_cnt_++;
+    }
+    WakeWorker(node_idx, false /* any_node */);
+  } else {
+    // Prefer the queue of the current worker so that a task submitted
+    // by a task is executed on the same CPU unless it is stolen.
+    const size_t worker_idx = (current_executor_ == this)
+                                  ? current_worker_
+                                  : (next_worker_++ % workers_.size());
+    Worker& worker = *workers_[worker_idx];
+    {
+      std::lock_guard<std::mutex> lock(worker.mu_);
+      worker.any_tasks_.emplace_back(std::move(task));
+      any_queued_cnt_++;
+    }
+    WakeWorker(worker.node_idx_, true /* any_node */);
+  }
+}
+
+void
+SharedExecutor::SubmitAfter(
+    const uint64_t delay_us, const int numa_node, Task&& task)
+{
+  if (delay_us == 0) {
+    Submit(numa_node, std::move(task));
+    return;
+  }
+
+  // The timer callback must be copyable, so share the task with it.
+  std::shared_ptr<Task> delayed_task =
+      std::make_shared<Task>(std::move(task));
+  TimerWheel::Global()->Schedule(
+      this, delay_us, [this, numa_node, delayed_task]() {
+        Submit(numa_node, std::move(*delayed_task));
+      });
+}
+
+void
+SharedExecutor::WakeWorker(const size_t node_idx, const bool any_node)
+{
+  // The queued count was incremented before this call so a worker
+  // that is not waiting yet will find the task before it waits.
+  {
+    NodeGroup& group = *node_groups_[node_idx];
+    std::lock_guard<std::mutex> lock(group.mu_);
+    if (group.idle_cnt_ > 0) {
+      group.cv_.notify_one();
+      return;
+    }
+  }
+
+  // A task for any node can be stolen by an idle worker of another
+  // node.
+  if (any_node) {
+    for (size_t g = 1; g < node_groups_.size(); ++g) {
+      NodeGroup& group = *node_groups_[(node_idx + g) % node_groups_.size()];
+      std::lock_guard<std::mutex> lock(group.mu_);
+      if (group.idle_cnt_ > 0) {
+        group.cv_.notify_one();
+        return;
+      }
+    }
+  }
+}
+
+bool
+SharedExecutor::StealTask(Worker& victim, const bool any_only, Task* task)
+{
+  // Take the most recently submitted task of the victim, which is
+  // the least likely to be executed soon by the victim.
+  std::lock_guard<std::mutex> lock(victim.mu_);
+  if (!any_only && !victim.node_tasks_.empty()) {
+    *task = std::move(victim.node_tasks_.back());
+    victim.node_tasks_.pop_back();
+    node_groups_[victim.node_idx_]->queued_cnt_--;
+    return true;
+  }
+  if (!victim.any_tasks_.empty()) {
+    *task = std::move(victim.any_tasks_.back());
+    victim.any_tasks_.pop_back();
+    any_queued_cnt_--;
+    return true;
+  }
+
+  return false;
+}
+
+bool
+SharedExecutor::PopTask(const size_t worker_idx, Task* task)
+{
+  Worker& self = *workers_[worker_idx];
+  NodeGroup& group = *node_groups_[self.node_idx_];
+  {
+    std::lock_guard<std::mutex> lock(self.mu_);
+    if (!self.node_tasks_.empty()) {
+      *task = std::move(self.node_tasks_.front());
+      self.node_tasks_.pop_front();
+      group.queued_cnt_--;
+      return true;
+    }
+    if (!self.any_tasks_.empty()) {
+      *task = std::move(self.any_tasks_.front());
+      self.any_tasks_.pop_front();
+      any_queued_cnt_--;
+      return true;
+    }
+  }
+
+  // Steal from the other workers of the same node first, then steal
+  // the tasks for any node from the workers of the other nodes.
+  if ((group.queued_cnt_ > 0) || (any_queued_cnt_ > 0)) {
+    for (size_t i = 1; i < group.workers_.size(); ++i) {
+      const size_t victim_idx =
+          group.workers_[(worker_idx + i) % group.workers_.size()];
+      if (StealTask(*workers_[victim_idx], false /* any_only */, task)) {
+        return true;
+      }
+    }
+  }
+  if (any_queued_cnt_ > 0) {
+    for (size_t i = 1; i < workers_.size(); ++i) {
+      const size_t victim_idx = (worker_idx + i) % workers_.size();
+      if ((workers_[victim_idx]->node_idx_ != self.node_idx_) &&
+          StealTask(*workers_[victim_idx], true /* any_only */, task)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void
+SharedExecutor::WorkerThread(const size_t worker_idx)
+{
+  NodeGroup& group = *node_groups_[workers_[worker_idx]->node_idx_];
+#ifndef _WIN32
+  if (group.numa_node_ >= 0) {
+    if (numa_run_on_node(group.numa_node_) != 0) {
+      LOG_WARNING << "unable to bind shared executor thread " << worker_idx
+                  << " to NUMA node " << group.numa_node_;
+    }
+  }
+#endif  // !_WIN32
+
+  current_executor_ = this;
+  current_worker_ = worker_idx;
+
+  while (true) {
+    Task task;
+    if (PopTask(worker_idx, &task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(group.mu_);
+    if (exiting_) {
+      break;
+    }
+    group.idle_cnt_++;
+    group.cv_.wait(lock, [this, &group]() {
+      return exiting_ || (group.queued_cnt_ > 0) || (any_queued_cnt_ > 0);
+    });
+    group.idle_cnt_--;
+  }
+}
+
+}}  // namespace nvidia::inferenceserver
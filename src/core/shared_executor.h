@@ -0,0 +1,133 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Pool of threads shared by the schedulers of CPU model instances,
+// so that a model instance does not need a dedicated scheduler
+// thread. Each worker thread has its own queue of tasks and an idle
+// worker steals tasks from the queues of the other workers. If the
+// host has more than one NUMA node the workers are partitioned by
+// node and run on the CPUs of their node. A task submitted for a node
+// is only executed by the workers of that node, a task submitted
+// without a node may be executed by any worker.
+//
+// The executor does not serialize tasks, a scheduler that submits
+// tasks for a model instance must not submit a task for the instance
+// while the previous one is executing.
+//
+class SharedExecutor {
+ public:
+  using Task = std::function<void()>;
+
+  // Create an executor with 'thread_cnt' worker threads.
+  explicit SharedExecutor(const uint32_t thread_cnt);
+  ~SharedExecutor();
+
+  // Create the global executor with 'thread_cnt' worker threads. A
+  // 'thread_cnt' of 0 disables the global executor. Must be called
+  // before any model is loaded.
+  static void SetGlobalThreadCount(const uint32_t thread_cnt);
+
+  // Return the global executor, or nullptr if the global executor is
+  // disabled.
+  static SharedExecutor* Global();
+
+  // Return the number of worker threads.
+  size_t ThreadCount() const { return workers_.size(); }
+
+  // Submit a task to be executed on a worker of NUMA node
+  // 'numa_node', or on any worker if 'numa_node' is -1 or is not a
+  // node of the host.
+  void Submit(const int numa_node, Task&& task);
+
+  // Submit a task after 'delay_us' microseconds. The delay is timed
+  // by the global timer wheel.
+  void SubmitAfter(const uint64_t delay_us, const int numa_node, Task&& task);
+
+ private:
+  struct Worker {
+    Worker() : node_idx_(0) {}
+
+    // The index of the NUMA node group of the worker.
+    size_t node_idx_;
+
+    // The tasks that must be executed on the node of the worker and
+    // the tasks that may be executed on any node. Protected by 'mu_'.
+    std::mutex mu_;
+    std::deque<Task> node_tasks_;
+    std::deque<Task> any_tasks_;
+
+    std::unique_ptr<std::thread> thread_;
+  };
+
+  // The workers of a NUMA node. Workers wait on 'cv_' when there is
+  // no task they can execute. 'queued_cnt_' is the number of tasks
+  // queued for the node. 'idle_cnt_' is the number of waiting
+  // workers and is protected by 'mu_'.
+  struct NodeGroup {
+    NodeGroup()
+        : numa_node_(-1), next_worker_(0), queued_cnt_(0), idle_cnt_(0)
+    {
+    }
+
+    int numa_node_;
+    std::vector<size_t> workers_;
+    std::atomic<size_t> next_worker_;
+    std::atomic<size_t> queued_cnt_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    size_t idle_cnt_;
+  };
+
+  void WorkerThread(const size_t worker_idx);
+  bool PopTask(const size_t worker_idx, Task* task);
+  bool StealTask(Worker& victim, const bool any_only, Task* task);
+  void WakeWorker(const size_t node_idx, const bool any_node);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<NodeGroup>> node_groups_;
+
+  // The number of queued tasks that may be executed on any node.
+  std::atomic<size_t> any_queued_cnt_;
+  std::atomic<size_t> next_worker_;
+  std::atomic<bool> exiting_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,348 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/timer_wheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+// The longest delay of a timer, about 12 days. A longer delay is
+// shortened to it.
+constexpr uint64_t kMaxDelayUs = uint64_t(1) << 40;
+
+uint64_t
+SteadyClockNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+constexpr uint64_t TimerWheel::kTickNs;
+
+TimerWheel::TimerWheel()
+    : exiting_(false), current_tick_(SteadyClockNs() / kTickNs), wake_tick_(0),
+      next_id_(1), running_owner_(nullptr)
+{
+  level_timer_cnts_.fill(0);
+  timer_thread_.reset(new std::thread([this]() { TimerThread(); }));
+}
+
+TimerWheel::~TimerWheel()
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    exiting_ = true;
+  }
+  cv_.notify_all();
+  if (timer_thread_->joinable()) {
+    timer_thread_->join();
+  }
+}
+
+TimerWheel*
+TimerWheel::Global()
+{
+  // The global timer wheel is never destroyed so that it can be used
+  // by objects that are destroyed when the process exits.
+  static TimerWheel* global_wheel = new TimerWheel();
+  return global_wheel;
+}
+
+void
+TimerWheel::Schedule(
+    const void* owner, const uint64_t delay_us, Callback&& callback)
+{
+  // Round the deadline up to a tick so that the callback is never
+  // called before the delay expires.
+  const uint64_t deadline_ns =
+      SteadyClockNs() + (std::min(delay_us, kMaxDelayUs) * 1000);
+  const uint64_t tick = (deadline_ns + kTickNs - 1) / kTickNs;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    const uint64_t id = next_id_++;
+    Timer& timer = timers_[id];
+    timer.owner_ = owner;
+    timer.tick_ = tick;
+    timer.callback_ = std::move(callback);
+    Insert(id, timer);
+    owner_timers_[owner].insert(id);
+
+    // Wake the timer thread if it is sleeping past the new timer.
+    wake = (wake_tick_ == 0) || (std::max(tick, current_tick_) < wake_tick_);
+  }
+
+  if (wake) {
+    cv_.notify_one();
+  }
+}
+
+void
+TimerWheel::Cancel(const void* owner)
+{
+  // Destroy the callbacks outside of the lock as they may hold
+  // objects whose destruction uses the timer wheel.
+  std::vector<Callback> cancelled;
+
+  std::unique_lock<std::mutex> lock(mu_);
+
+  // Wait for the callback of 'owner' that is being called, unless
+  // this is that callback, before removing the timers since the
+  // callback may schedule another timer.
+  if (std::this_thread::get_id() != timer_thread_->get_id()) {
+    running_cv_.wait(lock, [this, owner]() { return running_owner_ != owner; });
+  }
+
+  auto itr = owner_timers_.find(owner);
+  if (itr != owner_timers_.end()) {
+    for (const auto id : itr->second) {
+      auto timer_itr = timers_.find(id);
+      Remove(timer_itr->second);
+      cancelled.emplace_back(std::move(timer_itr->second.callback_));
+      timers_.erase(timer_itr);
+    }
+    owner_timers_.erase(itr);
+  }
+}
+
+size_t
+TimerWheel::TimerCount()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return timers_.size();
+}
+
+void
+TimerWheel::Insert(const uint64_t id, Timer& timer)
+{
+  // A timer whose tick has been processed expires at the next tick.
+  const uint64_t tick = std::max(timer.tick_, current_tick_);
+
+  // Use the lowest level that has a slot for the tick, which is the
+  // lowest level whose current rotation includes the tick.
+  for (size_t level = 0; level < kLevelCount; ++level) {
+    const size_t rotation_shift = kSlotBits * (level + 1);
+    if ((tick >> rotation_shift) == (current_tick_ >> rotation_shift)) {
+      auto& slot = levels_[level][(tick >> (kSlotBits * level)) & kSlotMask];
+      timer.level_ = level;
+      timer.slot_ = &slot;
+      timer.pos_ = slot.insert(slot.end(), id);
+      level_timer_cnts_[level]++;
+      return;
+    }
+  }
+
+  timer.level_ = kOverflowLevel;
+  timer.slot_ = &overflow_;
+  timer.pos_ = overflow_.insert(overflow_.end(), id);
+}
+
+void
+TimerWheel::Remove(Timer& timer)
+{
+  // An expired timer is only in 'expired_', which skips the timers
+  // that no longer exist.
+  if (timer.level_ != kExpiredLevel) {
+    timer.slot_->erase(timer.pos_);
+    if (timer.level_ < kLevelCount) {
+      level_timer_cnts_[timer.level_]--;
+    }
+  }
+}
+
+void
+TimerWheel::Cascade()
+{
+  // The slots of level 'n' are reached when the ticks of the levels
+  // below it wrap around. Move the timers of the highest level first
+  // so that those moved to the level below are moved again with the
+  // timers of that level.
+  size_t top_level = 0;
+  while ((top_level < kLevelCount) &&
+         ((current_tick_ &
+           ((uint64_t(1) << (kSlotBits * (top_level + 1))) - 1)) == 0)) {
+    top_level++;
+  }
+
+  for (size_t level = top_level; level > 0; --level) {
+    std::list<uint64_t> ids;
+    if (level == kOverflowLevel) {
+      ids.swap(overflow_);
+    } else {
+      auto& slot =
+          levels_[level][(current_tick_ >> (kSlotBits * level)) & kSlotMask];
+      level_timer_cnts_[level] -= slot.size();
+      ids.swap(slot);
+    }
+
+    for (const auto id : ids) {
+      Insert(id, timers_[id]);
+    }
+  }
+}
+
+void
+TimerWheel::Advance(const uint64_t now_tick)
+{
+  while (current_tick_ <= now_tick) {
+    size_t level = 0;
+    while ((level < kLevelCount) && (level_timer_cnts_[level] == 0)) {
+      level++;
+    }
+    if ((level == kLevelCount) && overflow_.empty()) {
+      current_tick_ = now_tick + 1;
+      break;
+    }
+
+    Cascade();
+
+    level = 0;
+    while ((level < kLevelCount) && (level_timer_cnts_[level] == 0)) {
+      level++;
+    }
+
+    if (level == 0) {
+      auto& slot = levels_[0][current_tick_ & kSlotMask];
+      for (const auto id : slot) {
+        timers_[id].level_ = kExpiredLevel;
+        expired_.push_back(id);
+      }
+      level_timer_cnts_[0] -= slot.size();
+      slot.clear();
+      current_tick_++;
+    } else {
+      // The levels below 'level' have no timers, so skip to the tick
+      // at which the next slot of 'level' is reached.
+      const size_t shift = kSlotBits * level;
+      current_tick_ =
+          std::min(((current_tick_ >> shift) + 1) << shift, now_tick + 1);
+    }
+  }
+}
+
+uint64_t
+TimerWheel::NextTick() const
+{
+  uint64_t next_tick = 0;
+  for (size_t level = 0; level < kLevelCount; ++level) {
+    if (level_timer_cnts_[level] == 0) {
+      continue;
+    }
+
+    // The slots of the level before the slot of the current tick
+    // have already been reached, so the first slot that has timers
+    // is found by searching from the slot of the current tick.
+    const size_t shift = kSlotBits * level;
+    const uint64_t rotation_start_tick =
+        (current_tick_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+    for (uint64_t idx = (current_tick_ >> shift) & kSlotMask; idx < kSlotCount;
+         ++idx) {
+      if (!levels_[level][idx].empty()) {
+        const uint64_t tick =
+            std::max(rotation_start_tick + (idx << shift), current_tick_);
+        if ((next_tick == 0) || (tick < next_tick)) {
+          next_tick = tick;
+        }
+        break;
+      }
+    }
+  }
+
+  if (!overflow_.empty()) {
+    const size_t shift = kSlotBits * kLevelCount;
+    const uint64_t tick = ((current_tick_ >> shift) + 1) << shift;
+    if ((next_tick == 0) || (tick < next_tick)) {
+      next_tick = tick;
+    }
+  }
+
+  return next_tick;
+}
+
+void
+TimerWheel::TimerThread()
+{
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!exiting_) {
+    Advance(SteadyClockNs() / kTickNs);
+
+    while (!expired_.empty() && !exiting_) {
+      const uint64_t id = expired_.front();
+      expired_.pop_front();
+      auto itr = timers_.find(id);
+      if (itr == timers_.end()) {
+        continue;
+      }
+
+      const void* owner = itr->second.owner_;
+      Callback callback = std::move(itr->second.callback_);
+      timers_.erase(itr);
+      auto owner_itr = owner_timers_.find(owner);
+      owner_itr->second.erase(id);
+      if (owner_itr->second.empty()) {
+        owner_timers_.erase(owner_itr);
+      }
+
+      // Call the callback outside of the lock so that it can schedule
+      // timers. The owner is recorded so that a cancellation of its
+      // timers waits for the callback to return.
+      running_owner_ = owner;
+      lock.unlock();
+      callback();
+      callback = nullptr;
+      lock.lock();
+      running_owner_ = nullptr;
+      running_cv_.notify_all();
+    }
+
+    if (exiting_) {
+      break;
+    }
+
+    wake_tick_ = NextTick();
+    if (wake_tick_ == 0) {
+      cv_.wait(lock);
+    } else {
+      cv_.wait_until(
+          lock, std::chrono::steady_clock::time_point(
+                    std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(
+                        std::chrono::nanoseconds(wake_tick_ * kTickNs))));
+    }
+    wake_tick_ = 0;
+  }
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,161 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Timer service shared by the schedulers so that a scheduler thread
+// that has nothing to do can sleep until it is notified instead of
+// waking periodically to check for work, and so that deadlines that
+// are not tied to a scheduler thread, like the idle timeout of a
+// sequence, don't need a thread of their own.
+//
+// The timers are kept in a hierarchical timing wheel: level 0 has a
+// slot for each tick of the next 256 ticks, and each higher level
+// has a slot for each 256 slots of the level below it. A timer is
+// moved to a lower level when the time of its slot is reached, so
+// adding and cancelling a timer is constant time. The timer thread
+// sleeps until the next slot that has timers, so it does not wake
+// when there are no timers.
+//
+// Timers are owned by an opaque 'owner', usually the object that the
+// timer callback refers to, so that the owner can cancel all its
+// timers when it is destroyed.
+//
+class TimerWheel {
+ public:
+  using Callback = std::function<void()>;
+
+  // The duration of a tick in nanoseconds. A timer callback is called
+  // at most one tick after the timer expires.
+  static constexpr uint64_t kTickNs = 10 * 1000;
+
+  TimerWheel();
+  ~TimerWheel();
+
+  // Return the timer wheel shared by the server.
+  static TimerWheel* Global();
+
+  // Call 'callback' on the timer thread after 'delay_us'
+  // microseconds. The callback must not block as it delays all other
+  // timers.
+  void Schedule(
+      const void* owner, const uint64_t delay_us, Callback&& callback);
+
+  // Cancel the timers of 'owner'. When this returns no callback of
+  // 'owner' is executing or will be called, unless it is called by
+  // a callback of 'owner'. Must not be called while holding a lock
+  // that the callbacks of 'owner' acquire.
+  void Cancel(const void* owner);
+
+  // Return the number of timers that have not expired.
+  size_t TimerCount();
+
+ private:
+  static constexpr size_t kLevelCount = 4;
+  static constexpr size_t kSlotBits = 8;
+  static constexpr size_t kSlotCount = 1 << kSlotBits;
+  static constexpr uint64_t kSlotMask = kSlotCount - 1;
+
+  // The level of a timer that has expired and is waiting for its
+  // callback to be called, and of a timer that is beyond the range
+  // of the highest level.
+  static constexpr size_t kExpiredLevel = kLevelCount + 1;
+  static constexpr size_t kOverflowLevel = kLevelCount;
+
+  struct Timer {
+    const void* owner_;
+    uint64_t tick_;
+    Callback callback_;
+    size_t level_;
+    std::list<uint64_t>* slot_;
+    std::list<uint64_t>::iterator pos_;
+  };
+
+  using Slots = std::array<std::list<uint64_t>, kSlotCount>;
+
+  void TimerThread();
+
+  // Add timer 'id' to the slot of its tick. 'mu_' must be held.
+  void Insert(const uint64_t id, Timer& timer);
+
+  // Remove 'timer' from its slot. 'mu_' must be held.
+  void Remove(Timer& timer);
+
+  // Move the timers of the slots whose time is 'current_tick_' to
+  // lower levels. 'mu_' must be held.
+  void Cascade();
+
+  // Process the ticks up to and including 'now_tick', moving the
+  // timers that expire to 'expired_'. 'mu_' must be held.
+  void Advance(const uint64_t now_tick);
+
+  // Return the next tick at which timers expire or must be moved to a
+  // lower level, or 0 if there are no timers. 'mu_' must be held.
+  uint64_t NextTick() const;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exiting_;
+
+  // The next tick to process. All timers of earlier ticks have
+  // expired.
+  uint64_t current_tick_;
+
+  // The tick that the timer thread sleeps until, or 0 if it sleeps
+  // until it is notified.
+  uint64_t wake_tick_;
+
+  uint64_t next_id_;
+  std::unordered_map<uint64_t, Timer> timers_;
+  std::unordered_map<const void*, std::unordered_set<uint64_t>> owner_timers_;
+  std::array<Slots, kLevelCount> levels_;
+  std::array<size_t, kLevelCount> level_timer_cnts_;
+  std::list<uint64_t> overflow_;
+  std::deque<uint64_t> expired_;
+
+  // The owner of the callback being called, cancellations of the
+  // timers of the owner wait on 'running_cv_' for it to return.
+  const void* running_owner_;
+  std::condition_variable running_cv_;
+
+  std::unique_ptr<std::thread> timer_thread_;
+};
+
+}}  // namespace nvidia::inferenceserver
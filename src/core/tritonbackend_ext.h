@@ -0,0 +1,72 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+// Extensions of the Triton backend API declared in
+// triton/core/tritonbackend.h. The functions follow the conventions of
+// that API and are exported by the Triton server shared library in
+// the same way.
+
+#include <stdbool.h>
+#include "triton/core/tritonbackend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Get whether a request has been cancelled, for example because the
+/// client that sent the request has disconnected. No response is
+/// expected for a cancelled request, so a backend may check this
+/// before, or while, executing a request and stop executing it early.
+/// The backend must still send a response for the request, typically
+/// an error, and release the request as usual.
+///
+/// \param request The inference request.
+/// \param is_cancelled Returns true if the request has been cancelled,
+/// false otherwise.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_RequestIsCancelled(
+    TRITONBACKEND_Request* request, bool* is_cancelled);
+
+/// Set whether the instances of the models of a backend must be
+/// initialized one at a time. By default Triton may call
+/// TRITONBACKEND_ModelInstanceInitialize for several instances of the
+/// same model concurrently, as allowed by the model instance
+/// initialization concurrency. A backend whose instance
+/// initialization is not thread-safe should call this function with
+/// 'serialized' true in TRITONBACKEND_Initialize.
+///
+/// \param backend The backend.
+/// \param serialized True if model instances must be initialized one
+/// at a time, false otherwise.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_BackendSetModelInstanceInitSerialized(
+    TRITONBACKEND_Backend* backend, bool serialized);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1068,6 +1068,50 @@ TRITONSERVER_ServerOptionsSetLogError(
 #endif  // TRITON_ENABLE_LOGGING
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetLogFile(
+    TRITONSERVER_ServerOptions* options, const char* file)
+{
+#ifdef TRITON_ENABLE_LOGGING
+  // Logging is global for now...
+  if (!LOG_SET_FILE(file)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("unable to open log file '") + file + "'").c_str());
+  }
+  return nullptr;  // Success
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "logging not supported");
+#endif  // TRITON_ENABLE_LOGGING
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetLogAsyncQueueSize(
+    TRITONSERVER_ServerOptions* options, uint32_t queue_size)
+{
+#ifdef TRITON_ENABLE_LOGGING
+  // Logging is global for now...
+  LOG_SET_ASYNC_QUEUE_SIZE(queue_size);
+  return nullptr;  // Success
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "logging not supported");
+#endif  // TRITON_ENABLE_LOGGING
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_LogServerMessage(const char* msg)
+{
+#ifdef TRITON_ENABLE_LOGGING
+  LOG_FORWARDED(msg);
+  return nullptr;  // Success
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "logging not supported");
+#endif  // TRITON_ENABLE_LOGGING
+}
+
 // Set verbose logging level. Level zero disables verbose logging.
 TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetLogVerbose(
@@ -1165,8 +1209,8 @@ TRITONSERVER_InferenceRequestNew(
   ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
 
   std::shared_ptr<ni::InferenceBackend> backend;
-  RETURN_IF_STATUS_ERROR(
-      lserver->GetInferenceBackend(model_name, model_version, &backend));
+  RETURN_IF_STATUS_ERROR(lserver->GetInferenceBackend(
+      model_name, model_version, &backend, true /* load_on_demand */));
 
   *inference_request = reinterpret_cast<TRITONSERVER_InferenceRequest*>(
       new ni::InferenceRequest(backend, model_version));
@@ -1184,6 +1228,47 @@ TRITONSERVER_InferenceRequestDelete(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestTemplateNew(
+    TRITONSERVER_InferenceRequestTemplate** request_template,
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  ni::InferenceRequest* lrequest =
+      reinterpret_cast<ni::InferenceRequest*>(inference_request);
+
+  // The template is a request without data that is prepared, and so
+  // validated and normalized, once when the template is created.
+  std::unique_ptr<ni::InferenceRequest> ltemplate(
+      ni::InferenceRequest::CopyWithoutData(*lrequest));
+  RETURN_IF_STATUS_ERROR(ltemplate->PrepareForInference());
+
+  *request_template = reinterpret_cast<TRITONSERVER_InferenceRequestTemplate*>(
+      ltemplate.release());
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestTemplateDelete(
+    TRITONSERVER_InferenceRequestTemplate* request_template)
+{
+  ni::InferenceRequest* ltemplate =
+      reinterpret_cast<ni::InferenceRequest*>(request_template);
+  delete ltemplate;
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestNewFromTemplate(
+    TRITONSERVER_InferenceRequest** inference_request,
+    TRITONSERVER_InferenceRequestTemplate* request_template)
+{
+  ni::InferenceRequest* ltemplate =
+      reinterpret_cast<ni::InferenceRequest*>(request_template);
+  *inference_request = reinterpret_cast<TRITONSERVER_InferenceRequest*>(
+      ni::InferenceRequest::CopyWithoutData(*ltemplate));
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestId(
     TRITONSERVER_InferenceRequest* inference_request, const char** id)
@@ -1284,6 +1369,16 @@ TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  ni::InferenceRequest* lrequest =
+      reinterpret_cast<ni::InferenceRequest*>(inference_request);
+  lrequest->Cancel();
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestAddInput(
     TRITONSERVER_InferenceRequest* inference_request, const char* name,
@@ -1802,8 +1897,8 @@ TRITONSERVER_ServerModelBatchProperties(
   }
 
   std::shared_ptr<ni::InferenceBackend> backend;
-  RETURN_IF_STATUS_ERROR(
-      lserver->GetInferenceBackend(model_name, model_version, &backend));
+  RETURN_IF_STATUS_ERROR(lserver->GetInferenceBackend(
+      model_name, model_version, &backend, true /* load_on_demand */));
 
   if (backend->Config().max_batch_size() > 0) {
     *flags = TRITONSERVER_BATCH_FIRST_DIM;
@@ -1828,8 +1923,8 @@ TRITONSERVER_ServerModelTransactionProperties(
   *txn_flags = 0;
 
   std::shared_ptr<ni::InferenceBackend> backend;
-  RETURN_IF_STATUS_ERROR(
-      lserver->GetInferenceBackend(model_name, model_version, &backend));
+  RETURN_IF_STATUS_ERROR(lserver->GetInferenceBackend(
+      model_name, model_version, &backend, true /* load_on_demand */));
 
   if (backend->Config().model_transaction_policy().decoupled()) {
     *txn_flags = TRITONSERVER_TXN_DECOUPLED;
@@ -1878,8 +1973,8 @@ TRITONSERVER_ServerModelMetadata(
   ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
 
   std::shared_ptr<ni::InferenceBackend> backend;
-  RETURN_IF_STATUS_ERROR(
-      lserver->GetInferenceBackend(model_name, model_version, &backend));
+  RETURN_IF_STATUS_ERROR(lserver->GetInferenceBackend(
+      model_name, model_version, &backend, true /* load_on_demand */));
 
   std::vector<int64_t> ready_versions;
   RETURN_IF_STATUS_ERROR(
@@ -2063,6 +2158,15 @@ TRITONSERVER_ServerModelStatistics(
       SetDurationStat(
           metadata, inference_stats, "compute_output",
           infer_stats.success_count_, infer_stats.compute_output_duration_ns_);
+      SetDurationStat(
+          metadata, inference_stats, "cache_hit", infer_stats.cache_hit_count_,
+          infer_stats.cache_hit_duration_ns_);
+      SetDurationStat(
+          metadata, inference_stats, "cache_miss",
+          infer_stats.cache_miss_count_, infer_stats.cache_miss_duration_ns_);
+      SetDurationStat(
+          metadata, inference_stats, "coalesced", infer_stats.coalesced_count_,
+          infer_stats.coalesced_duration_ns_);
 
       triton::common::TritonJson::Value batch_stats(
           metadata, triton::common::TritonJson::ValueType::ARRAY);
@@ -2095,6 +2199,8 @@ TRITONSERVER_ServerModelStatistics(
           "inference_count", backend->StatsAggregator().InferenceCount()));
       RETURN_IF_STATUS_ERROR(model_stat.AddUInt(
           "execution_count", backend->StatsAggregator().ExecutionCount()));
+      RETURN_IF_STATUS_ERROR(model_stat.AddUInt(
+          "cache_eviction_count", infer_stats.cache_eviction_count_));
 
       RETURN_IF_STATUS_ERROR(
           model_stat.Add("inference_stats", std::move(inference_stats)));
@@ -2123,8 +2229,8 @@ TRITONSERVER_ServerModelConfig(
   ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
 
   std::shared_ptr<ni::InferenceBackend> backend;
-  RETURN_IF_STATUS_ERROR(
-      lserver->GetInferenceBackend(model_name, model_version, &backend));
+  RETURN_IF_STATUS_ERROR(lserver->GetInferenceBackend(
+      model_name, model_version, &backend, true /* load_on_demand */));
 
   std::string model_config_json;
   RETURN_IF_STATUS_ERROR(ni::ModelConfigToJson(
@@ -2136,6 +2242,22 @@ TRITONSERVER_ServerModelConfig(
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_ServerSetModelInstanceCount(
+    TRITONSERVER_Server* server, const char* model_name,
+    const int64_t model_version, const uint32_t instance_count)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+
+  std::shared_ptr<ni::InferenceBackend> backend;
+  RETURN_IF_STATUS_ERROR(
+      lserver->GetInferenceBackend(model_name, model_version, &backend));
+
+  RETURN_IF_STATUS_ERROR(backend->SetInstanceCount(instance_count));
+
+  return nullptr;  // success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_ServerModelIndex(
     TRITONSERVER_Server* server, uint32_t flags,
@@ -2191,6 +2313,34 @@ TRITONSERVER_ServerLoadModel(
   return nullptr;  // success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_ServerLoadModelOnDemand(
+    TRITONSERVER_Server* server, const char* model_name,
+    const int64_t model_version, TRITONSERVER_ModelLoadCompleteFn_t complete_fn,
+    void* userp, bool* ready)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+
+  // Report a failed load the same way as GetInferenceBackend() does.
+  auto load_error = [](const ni::Status& status) -> TRITONSERVER_Error* {
+    return TritonServerError::Create(ni::Status(
+        ni::Status::Code::UNAVAILABLE,
+        "Request for unknown model: " + status.Message()));
+  };
+  ni::Status status = lserver->LoadModelOnDemand(
+      model_name, model_version,
+      [complete_fn, userp, load_error](const ni::Status& load_status) {
+        complete_fn(
+            load_status.IsOk() ? nullptr : load_error(load_status), userp);
+      },
+      ready);
+  if (!status.IsOk()) {
+    return load_error(status);
+  }
+
+  return nullptr;  // success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_ServerUnloadModel(
     TRITONSERVER_Server* server, const char* model_name)
@@ -2290,6 +2440,85 @@ TRITONSERVER_ServerInferAsync(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_ServerInferAsyncMultiple(
+    TRITONSERVER_Server* server,
+    TRITONSERVER_InferenceRequest** inference_requests,
+    const uint32_t request_count, TRITONSERVER_InferenceTrace** traces,
+    uint32_t* submitted_count)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+
+  *submitted_count = 0;
+
+  for (uint32_t i = 0; i < request_count; ++i) {
+    ni::InferenceRequest* lrequest =
+        reinterpret_cast<ni::InferenceRequest*>(inference_requests[i]);
+    RETURN_IF_STATUS_ERROR(lrequest->PrepareForInference());
+  }
+
+  if (traces != nullptr) {
+#ifdef TRITON_ENABLE_TRACING
+    for (uint32_t i = 0; i < request_count; ++i) {
+      if (traces[i] != nullptr) {
+        ni::InferenceRequest* lrequest =
+            reinterpret_cast<ni::InferenceRequest*>(inference_requests[i]);
+        ni::InferenceTrace* ltrace =
+            reinterpret_cast<ni::InferenceTrace*>(traces[i]);
+        ltrace->SetModelName(lrequest->ModelName());
+        ltrace->SetModelVersion(lrequest->ActualModelVersion());
+
+        std::unique_ptr<ni::InferenceTrace> utrace(ltrace);
+        lrequest->SetTrace(std::move(utrace));
+      }
+    }
+#else
+    for (uint32_t i = 0; i < request_count; ++i) {
+      if (traces[i] != nullptr) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_UNSUPPORTED, "inference tracing not supported");
+      }
+    }
+#endif  // TRITON_ENABLE_TRACING
+  }
+
+  std::vector<std::unique_ptr<ni::InferenceRequest>> ureqs;
+  ureqs.reserve(request_count);
+  for (uint32_t i = 0; i < request_count; ++i) {
+    ureqs.emplace_back(
+        reinterpret_cast<ni::InferenceRequest*>(inference_requests[i]));
+  }
+
+  // Run inference...
+  ni::Status status = lserver->InferAsync(ureqs);
+
+  // The requests are submitted in order and so on error the submitted
+  // requests are the leading nullptr entries of 'ureqs'. The caller
+  // retains ownership of the remaining requests so they must be
+  // released from unique_ptr, after releasing any associated trace.
+  uint32_t cnt = 0;
+  while ((cnt < request_count) && (ureqs[cnt] == nullptr)) {
+    cnt++;
+  }
+  *submitted_count = cnt;
+
+  for (auto& ureq : ureqs) {
+    if (ureq == nullptr) {
+      continue;
+    }
+#ifdef TRITON_ENABLE_TRACING
+    std::unique_ptr<ni::InferenceTrace>* trace = ureq->MutableTrace();
+    if (*trace != nullptr) {
+      ni::InferenceTrace::Release(std::move(*trace));
+    }
+#endif  // TRITON_ENABLE_TRACING
+    ureq.release();
+  }
+
+  RETURN_IF_STATUS_ERROR(status);
+  return nullptr;  // Success
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,8 @@
 #define _COMPILING_TRITONBACKEND 1
 #define _COMPILING_TRITONREPOAGENT 1
 
+#include "src/core/tritonbackend_ext.h"
+#include "src/core/tritonserver_ext.h"
 #include "triton/core/tritonbackend.h"
 #include "triton/core/tritonrepoagent.h"
 #include "triton/core/tritonserver.h"
@@ -0,0 +1,228 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+// Extensions of the in-process Triton server API declared in
+// triton/core/tritonserver.h. The functions follow the conventions of
+// that API and are exported by the Triton server shared library in
+// the same way.
+
+#include <stdint.h>
+#include "triton/core/tritonserver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TRITONSERVER_InferenceRequestTemplate;
+
+/// Set the file that log messages are appended to. By default, and
+/// if 'file' is an empty string, log messages are written to stderr.
+///
+/// \param options The server options object.
+/// \param file The path of the log file.
+/// \return a TRITONSERVER_Error indicating success or failure, for
+/// example if the file cannot be opened.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerOptionsSetLogFile(
+    TRITONSERVER_ServerOptions* options, const char* file);
+
+/// Set the number of log messages that can be queued for a background
+/// thread to write. Threads logging a message then only format it and
+/// queue it, and messages logged while the queue is full are dropped.
+/// A size of zero, the default, writes each message synchronously by
+/// the thread that logs it.
+///
+/// \param options The server options object.
+/// \param queue_size The maximum number of queued log messages.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetLogAsyncQueueSize(
+    TRITONSERVER_ServerOptions* options, uint32_t queue_size);
+
+/// Write a log message to the server log, in the same way as the
+/// messages logged by the server: to the file set with
+/// TRITONSERVER_ServerOptionsSetLogFile() and through the queue set
+/// with TRITONSERVER_ServerOptionsSetLogAsyncQueueSize(). The message
+/// must already be formatted, including its prefix. This allows an
+/// application to write its log messages to the server log without
+/// opening the log file itself.
+///
+/// \param msg The log message.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_LogServerMessage(
+    const char* msg);
+
+/// Type for the function that is called when the load of a model that
+/// is loaded on demand completes. 'error' is nullptr if the model is
+/// loaded, otherwise the function takes ownership of 'error' and must
+/// delete it with TRITONSERVER_ErrorDelete.
+typedef void (*TRITONSERVER_ModelLoadCompleteFn_t)(
+    TRITONSERVER_Error* error, void* userp);
+
+/// When the server loads models on demand, start to load a model that
+/// is not loaded without waiting for the load. The requests for the
+/// model can then be set aside until 'complete_fn' is called instead
+/// of blocking in TRITONSERVER_InferenceRequestNew while the model is
+/// loaded. 'complete_fn' is called from a thread of the server once
+/// the load completes, unless 'ready' returns true or an error is
+/// returned.
+///
+/// \param server The inference server object.
+/// \param model_name The name of the model.
+/// \param model_version The version of the model that is requested.
+/// \param complete_fn The function called when the load completes.
+/// \param userp User-provided pointer passed to 'complete_fn'.
+/// \param ready Returns true if the model doesn't need to be loaded,
+/// because it is loaded or models are not loaded on demand.
+/// \return a TRITONSERVER_Error indicating success or failure, for
+/// example if a recent on-demand load of the model failed.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerLoadModelOnDemand(
+    TRITONSERVER_Server* server, const char* model_name,
+    const int64_t model_version, TRITONSERVER_ModelLoadCompleteFn_t complete_fn,
+    void* userp, bool* ready);
+
+///
+/// TRITONSERVER_InferenceRequestTemplate
+///
+/// Object representing the layout of inference requests for a model:
+/// the name, datatype and shape of each input, the requested outputs,
+/// and the flags, correlation ID, priority and timeout of the
+/// requests. The layout is validated against the model once, when the
+/// template is created. Requests created from the template do not need
+/// to be validated again, as long as inputs and requested outputs are
+/// not added to or removed from the request, and so only the input
+/// data and the callbacks need to be set for each request.
+///
+
+/// Create a new inference request template from an inference
+/// request. The ID, input data and callbacks of the inference request
+/// are not part of the template. The template keeps the model version
+/// used by 'inference_request' available until the template is
+/// deleted.
+///
+/// \param request_template Returns the new request template.
+/// \param inference_request The request that provides the layout of
+/// the requests created from the template.
+/// \return a TRITONSERVER_Error indicating success or failure, for
+/// example if the inputs or requested outputs of 'inference_request'
+/// are not valid for the model.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestTemplateNew(
+    TRITONSERVER_InferenceRequestTemplate** request_template,
+    TRITONSERVER_InferenceRequest* inference_request);
+
+/// Delete an inference request template. Requests created from the
+/// template are not affected.
+///
+/// \param request_template The request template.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestTemplateDelete(
+    TRITONSERVER_InferenceRequestTemplate* request_template);
+
+/// Create a new inference request from a request template. The request
+/// has the inputs, without data, and the requested outputs of the
+/// template. Before the request is used for inference the input data
+/// must be appended with TRITONSERVER_InferenceRequestAppendInputData
+/// and the callbacks must be set. The request is used and deleted in
+/// the same way as a request created by
+/// TRITONSERVER_InferenceRequestNew.
+///
+/// \param inference_request Returns the new request object.
+/// \param request_template The request template.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestNewFromTemplate(
+    TRITONSERVER_InferenceRequest** inference_request,
+    TRITONSERVER_InferenceRequestTemplate* request_template);
+
+/// Cancel an inference request, for example because the client that
+/// sent the request has disconnected. If the request is still queued
+/// by the scheduler it is released without being executed, and its
+/// response indicates that it was cancelled. A request that is
+/// already executing is not interrupted, but the backend may check
+/// for the cancellation to stop executing it early. The request may
+/// be cancelled from any thread, but it must not be cancelled after
+/// it is deleted, so the caller must synchronize the cancellation with
+/// the release callback of the request.
+///
+/// \param inference_request The request object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request);
+
+/// Perform inference using a set of requests for the same model and
+/// version. The requests are submitted together so that the scheduler
+/// of the model is locked and signaled once for the whole set instead
+/// of once per request. Each request is otherwise handled as if it was
+/// submitted with TRITONSERVER_ServerInferAsync, in order. On success
+/// Triton takes ownership of all the requests and of the associated
+/// traces. If an error is returned only the first 'submitted_count'
+/// requests, and their traces, are owned by Triton. The caller
+/// retains ownership of the remaining requests and Triton releases
+/// the traces of the remaining requests.
+///
+/// \param server The inference server object.
+/// \param inference_requests The array of request objects.
+/// \param request_count The number of requests in the array.
+/// \param traces The array of trace objects for the requests, with
+/// one entry per request. A nullptr entry, or a nullptr array, indicates
+/// that tracing is not enabled for the request.
+/// \param submitted_count Returns the number of requests, from the
+/// start of the array, that were submitted for inference.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerInferAsyncMultiple(
+    TRITONSERVER_Server* server,
+    TRITONSERVER_InferenceRequest** inference_requests,
+    const uint32_t request_count, TRITONSERVER_InferenceTrace** traces,
+    uint32_t* submitted_count);
+
+/// Change the number of instances that execute a model without
+/// reloading the model. Instances are added by replicating the
+/// instances of the instance groups of the model, in order, and the
+/// most recently added instance is removed first. A removed instance
+/// finishes executing its current batch before it is finalized, and
+/// the requests waiting in the scheduler are executed by the remaining
+/// instances. The count must be within the range set by the
+/// 'instance_count_min' and 'instance_count_max' parameters of the
+/// model configuration. The model configuration reported for the
+/// model is not changed.
+///
+/// \param server The inference server object.
+/// \param model_name The name of the model.
+/// \param model_version The version of the model. If -1 then the
+/// server will choose a version based on the model's policy.
+/// \param instance_count The new number of instances.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerSetModelInstanceCount(
+    TRITONSERVER_Server* server, const char* model_name,
+    const int64_t model_version, const uint32_t instance_count);
+
+#ifdef __cplusplus
+}
+#endif
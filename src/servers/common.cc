@@ -26,6 +26,8 @@
 
 #include "src/servers/common.h"
 
+#include "src/core/logging.h"
+#include "src/core/tritonserver_ext.h"
 #include "triton/core/tritonserver.h"
 
 namespace nvidia { namespace inferenceserver {
@@ -63,4 +65,22 @@ GetModelVersionFromString(const std::string& version_string, int64_t* version)
   return nullptr;  // success
 }
 
+void
+CancellableRequest::Cancel()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (request_ != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestCancel(request_),
+        "cancelling inference request");
+  }
+}
+
+void
+CancellableRequest::Release()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  request_ = nullptr;
+}
+
 }}  // namespace nvidia::inferenceserver
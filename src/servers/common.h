@@ -26,6 +26,7 @@
 #pragma once
 
 #include <iostream>
+#include <mutex>
 #include <string>
 #include "triton/core/tritonserver.h"
 
@@ -106,4 +107,27 @@ namespace nvidia { namespace inferenceserver {
 TRITONSERVER_Error* GetModelVersionFromString(
     const std::string& version_string, int64_t* version);
 
+/// An inference request that is cancelled when the client that sent
+/// it disconnects. Triton may release, and the frontend then delete,
+/// the request at any time after it is submitted, so the frontend
+/// must call Release() from the release callback before deleting the
+/// request, after which Cancel() does nothing.
+class CancellableRequest {
+ public:
+  explicit CancellableRequest(TRITONSERVER_InferenceRequest* request)
+      : request_(request)
+  {
+  }
+
+  /// Cancel the request if it has not been released.
+  void Cancel();
+
+  /// Record that the request has been released.
+  void Release();
+
+ private:
+  std::mutex mu_;
+  TRITONSERVER_InferenceRequest* request_;
+};
+
 }}  // namespace nvidia::inferenceserver
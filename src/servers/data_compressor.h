@@ -25,7 +25,9 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -37,15 +39,148 @@
 #include "src/servers/common.h"
 #include "triton/core/tritonserver.h"
 
+#ifdef TRITON_ENABLE_ZSTD
+#include <zstd.h>
+#endif  // TRITON_ENABLE_ZSTD
+
+#ifdef TRITON_ENABLE_LZ4
+#include <lz4frame.h>
+#include <lz4hc.h>
+#endif  // TRITON_ENABLE_LZ4
+
 namespace nvidia { namespace inferenceserver {
 class DataCompressor {
  public:
-  enum class Type { UNKNOWN, IDENTITY, GZIP, DEFLATE };
+  enum class Type { UNKNOWN, IDENTITY, GZIP, DEFLATE, ZSTD, LZ4 };
+
+  // Compression level that selects the default level of the codec.
+  static constexpr int kDefaultLevel = INT_MIN;
+
+  // Compression settings of a server.
+  struct Options {
+    Options()
+        : gzip_level_(kDefaultLevel), zstd_level_(kDefaultLevel),
+          lz4_level_(kDefaultLevel), threshold_byte_size_(0)
+    {
+    }
+
+    // The compression level to use for 'type'.
+    int Level(const Type type) const
+    {
+      switch (type) {
+        case Type::GZIP:
+        case Type::DEFLATE:
+          return gzip_level_;
+        case Type::ZSTD:
+          return zstd_level_;
+        case Type::LZ4:
+          return lz4_level_;
+        case Type::UNKNOWN:
+        case Type::IDENTITY:
+          break;
+      }
+      return kDefaultLevel;
+    }
+
+    // Level for gzip and deflate, from 0 to 9.
+    int gzip_level_;
+    // Level for zstd, from ZSTD_minCLevel() to ZSTD_maxCLevel().
+    int zstd_level_;
+    // Level for lz4, up to LZ4HC_CLEVEL_MAX. Levels below 3 use the
+    // fast compressor, negative levels trade ratio for more speed.
+    int lz4_level_;
+    // Data smaller than this is not compressed.
+    size_t threshold_byte_size_;
+  };
+
+  // Return the type for a content coding name, UNKNOWN if the coding
+  // is not supported by this build.
+  static Type TypeFromString(const std::string& encoding)
+  {
+    if (encoding == "identity") {
+      return Type::IDENTITY;
+    } else if (encoding == "gzip") {
+      return Type::GZIP;
+    } else if (encoding == "deflate") {
+      return Type::DEFLATE;
+    }
+#ifdef TRITON_ENABLE_ZSTD
+    if (encoding == "zstd") {
+      return Type::ZSTD;
+    }
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+    if (encoding == "lz4") {
+      return Type::LZ4;
+    }
+#endif  // TRITON_ENABLE_LZ4
+    return Type::UNKNOWN;
+  }
+
+  // Return the content coding name of 'type'.
+  static const char* TypeString(const Type type)
+  {
+    switch (type) {
+      case Type::IDENTITY:
+        return "identity";
+      case Type::GZIP:
+        return "gzip";
+      case Type::DEFLATE:
+        return "deflate";
+      case Type::ZSTD:
+        return "zstd";
+      case Type::LZ4:
+        return "lz4";
+      case Type::UNKNOWN:
+        break;
+    }
+    return "<unknown>";
+  }
+
+  // Return the supported content codings, in order of preference, as a
+  // comma-separated list.
+  static const char* SupportedEncodings()
+  {
+    return "gzip, deflate"
+#ifdef TRITON_ENABLE_ZSTD
+           ", zstd"
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+           ", lz4"
+#endif  // TRITON_ENABLE_LZ4
+        ;
+  }
+
+  // Check that the levels in 'options' are valid for their codecs.
+  static TRITONSERVER_Error* ValidateOptions(const Options& options)
+  {
+    if ((options.gzip_level_ != kDefaultLevel) &&
+        ((options.gzip_level_ < 0) || (options.gzip_level_ > 9))) {
+      return InvalidLevel("gzip", options.gzip_level_, 0, 9);
+    }
+#ifdef TRITON_ENABLE_ZSTD
+    if ((options.zstd_level_ != kDefaultLevel) &&
+        ((options.zstd_level_ < ZSTD_minCLevel()) ||
+         (options.zstd_level_ > ZSTD_maxCLevel()))) {
+      return InvalidLevel(
+          "zstd", options.zstd_level_, ZSTD_minCLevel(), ZSTD_maxCLevel());
+    }
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+    if ((options.lz4_level_ != kDefaultLevel) &&
+        (options.lz4_level_ > LZ4HC_CLEVEL_MAX)) {
+      return InvalidLevel(
+          "lz4", options.lz4_level_, INT_MIN + 1, LZ4HC_CLEVEL_MAX);
+    }
+#endif  // TRITON_ENABLE_LZ4
+    return nullptr;  // success
+  }
 
   // Specialization where the source and destination buffer are stored as
   // evbuffer
   static TRITONSERVER_Error* CompressData(
-      const Type type, evbuffer* source, evbuffer* compressed_data)
+      const Type type, evbuffer* source, evbuffer* compressed_data,
+      const int level = kDefaultLevel)
   {
     size_t expected_compressed_size = evbuffer_get_length(source);
     // nothing to be compressed
@@ -54,39 +189,488 @@ class DataCompressor {
           TRITONSERVER_ERROR_INVALID_ARG, "nothing to be compressed");
     }
 
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
     switch (type) {
       case Type::UNKNOWN:
-      case Type::IDENTITY: {
-        return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INVALID_ARG, "nothing to be compressed");
-      }
+      case Type::IDENTITY:
+        break;
+      case Type::GZIP:
+      case Type::DEFLATE:
+        return CompressZlib(type, source, compressed_data, level);
+      case Type::ZSTD:
+#ifdef TRITON_ENABLE_ZSTD
+        return CompressZstd(source, compressed_data, level);
+#else
+        return Unsupported(type);
+#endif  // TRITON_ENABLE_ZSTD
+      case Type::LZ4:
+#ifdef TRITON_ENABLE_LZ4
+        return CompressLz4(source, compressed_data, level);
+#else
+        return Unsupported(type);
+#endif  // TRITON_ENABLE_LZ4
+    }
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "nothing to be compressed");
+  }
+
+  static TRITONSERVER_Error* DecompressData(
+      const Type type, evbuffer* source, evbuffer* decompressed_data)
+  {
+    size_t source_byte_size = evbuffer_get_length(source);
+    // nothing to be decompressed
+    if (evbuffer_get_length(source) == 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG, "nothing to be decompressed");
+    }
+    // Set reasonable size for each output buffer to be allocated
+    size_t output_buffer_size = (source_byte_size > (1 << 20 /* 1MB */))
+                                    ? source_byte_size
+                                    : (1 << 20 /* 1MB */);
+
+    switch (type) {
+      case Type::UNKNOWN:
+      case Type::IDENTITY:
+        break;
       case Type::GZIP:
-        if (deflateInit2(
-                &stream, Z_DEFAULT_COMPRESSION /* level */,
-                Z_DEFLATED /* method */, 15 | 16 /* windowBits */,
-                8 /* memLevel */, Z_DEFAULT_STRATEGY /* strategy */) != Z_OK) {
+      case Type::DEFLATE:
+        // zlib can automatically detect compression type
+        return DecompressZlib(source, decompressed_data, output_buffer_size);
+      case Type::ZSTD:
+#ifdef TRITON_ENABLE_ZSTD
+        return DecompressZstd(source, decompressed_data, output_buffer_size);
+#else
+        return Unsupported(type);
+#endif  // TRITON_ENABLE_ZSTD
+      case Type::LZ4:
+#ifdef TRITON_ENABLE_LZ4
+        return DecompressLz4(source, decompressed_data, output_buffer_size);
+#else
+        return Unsupported(type);
+#endif  // TRITON_ENABLE_LZ4
+    }
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "nothing to be decompressed");
+  }
+
+  // Decompressor that inflates a compressed evbuffer incrementally
+  // into memory provided by the caller, so that each section of the
+  // decompressed data can be written directly to its final location
+  // without materializing the whole decompressed data first. The
+  // compressed data is drained from the source evbuffer as it is
+  // consumed, so the memory holding it is released progressively.
+  class StreamDecompressor {
+   public:
+    static TRITONSERVER_Error* Create(
+        const Type type, evbuffer* source,
+        std::unique_ptr<StreamDecompressor>* decompressor)
+    {
+      std::unique_ptr<StreamDecompressor> local(
+          new StreamDecompressor(type, source));
+      switch (type) {
+        case Type::UNKNOWN:
+        case Type::IDENTITY:
           return TRITONSERVER_ErrorNew(
-              TRITONSERVER_ERROR_INTERNAL,
-              "failed to initialize state for gzip data compression");
+              TRITONSERVER_ERROR_INVALID_ARG, "nothing to be decompressed");
+        case Type::GZIP:
+        case Type::DEFLATE:
+          // zlib can automatically detect compression type
+          if (inflateInit2(&local->zstream_, 15 | 32) != Z_OK) {
+            return TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_INTERNAL,
+                "failed to initialize state for data decompression");
+          }
+          local->zstream_init_ = true;
+          break;
+        case Type::ZSTD:
+#ifdef TRITON_ENABLE_ZSTD
+          local->zstd_ctx_ = ZSTD_createDCtx();
+          if (local->zstd_ctx_ == nullptr) {
+            return TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_INTERNAL,
+                "failed to initialize state for zstd data decompression");
+          }
+          break;
+#else
+          return Unsupported(type);
+#endif  // TRITON_ENABLE_ZSTD
+        case Type::LZ4: {
+#ifdef TRITON_ENABLE_LZ4
+          size_t ret =
+              LZ4F_createDecompressionContext(&local->lz4_ctx_, LZ4F_VERSION);
+          if (LZ4F_isError(ret)) {
+            return Lz4Error(
+                "failed to initialize state for lz4 data decompression", ret);
+          }
+          break;
+#else
+          return Unsupported(type);
+#endif  // TRITON_ENABLE_LZ4
         }
-        break;
-      case Type::DEFLATE: {
-        if (deflateInit(&stream, Z_DEFAULT_COMPRESSION /* level */) != Z_OK) {
+      }
+      *decompressor = std::move(local);
+      return nullptr;  // success
+    }
+
+    ~StreamDecompressor()
+    {
+      if (zstream_init_) {
+        inflateEnd(&zstream_);
+      }
+#ifdef TRITON_ENABLE_ZSTD
+      ZSTD_freeDCtx(zstd_ctx_);
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+      if (lz4_ctx_ != nullptr) {
+        LZ4F_freeDecompressionContext(lz4_ctx_);
+      }
+#endif  // TRITON_ENABLE_LZ4
+    }
+
+    // Decompress exactly 'byte_size' bytes into 'dst'. Return an
+    // error if the decompressed data ends before that.
+    TRITONSERVER_Error* Read(char* dst, size_t byte_size)
+    {
+      while (byte_size > 0) {
+        if (end_) {
           return TRITONSERVER_ErrorNew(
-              TRITONSERVER_ERROR_INTERNAL,
-              "failed to initialize state for deflate data compression");
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "unexpected end of decompressed data, expecting " +
+                  std::to_string(byte_size) + " more bytes")
+                  .c_str());
         }
-        break;
+        size_t produced;
+        RETURN_IF_ERR(Step(dst, byte_size, &produced));
+        dst += produced;
+        byte_size -= produced;
+      }
+      return nullptr;  // success
+    }
+
+    // Decompress exactly 'byte_size' bytes and append them to 'dst'.
+    // 'byte_size' is usually declared by the client, so 'dst' grows
+    // as the data is decompressed instead of being sized up front.
+    // Return an error if the decompressed data ends before that.
+    TRITONSERVER_Error* Read(std::vector<char>* dst, size_t byte_size)
+    {
+      size_t filled = dst->size();
+      const size_t target = filled + byte_size;
+      dst->resize(
+          filled + std::min(
+                       byte_size, std::max(
+                                      evbuffer_get_length(source_),
+                                      (size_t)4096)));
+      while (filled < target) {
+        if (end_) {
+          dst->resize(filled);
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "unexpected end of decompressed data, expecting " +
+                  std::to_string(target - filled) + " more bytes")
+                  .c_str());
+        }
+        if (filled == dst->size()) {
+          dst->resize(std::min(target, dst->size() * 2));
+        }
+        size_t produced;
+        RETURN_IF_ERR(
+            Step(dst->data() + filled, dst->size() - filled, &produced));
+        filled += produced;
+      }
+      return nullptr;  // success
+    }
+
+    // Decompress all remaining data and append it to 'dst'.
+    TRITONSERVER_Error* ReadAll(std::vector<char>* dst)
+    {
+      // Use the compressed size as a first guess of the decompressed
+      // size and grow geometrically from there.
+      size_t filled = dst->size();
+      dst->resize(
+          filled + std::max(evbuffer_get_length(source_), (size_t)4096));
+      while (!end_) {
+        if (filled == dst->size()) {
+          dst->resize(dst->size() * 2);
+        }
+        size_t produced;
+        RETURN_IF_ERR(
+            Step(dst->data() + filled, dst->size() - filled, &produced));
+        filled += produced;
+      }
+      dst->resize(filled);
+      return nullptr;  // success
+    }
+
+    // Return in 'end' whether all data has been decompressed.
+    TRITONSERVER_Error* AtEnd(bool* end)
+    {
+      // The end of the compressed stream may only be detected when
+      // trying to decompress past the data read so far.
+      while (!end_) {
+        char byte;
+        size_t produced;
+        RETURN_IF_ERR(Step(&byte, 1, &produced));
+        if (produced != 0) {
+          *end = false;
+          return nullptr;  // success
+        }
+      }
+      *end = true;
+      return nullptr;  // success
+    }
+
+   private:
+    StreamDecompressor(const Type type, evbuffer* source)
+        : type_(type), source_(source), end_(false), zstream_init_(false)
+    {
+      zstream_.zalloc = Z_NULL;
+      zstream_.zfree = Z_NULL;
+      zstream_.opaque = Z_NULL;
+      zstream_.avail_in = 0;
+      zstream_.next_in = Z_NULL;
+#ifdef TRITON_ENABLE_ZSTD
+      zstd_ctx_ = nullptr;
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+      lz4_ctx_ = nullptr;
+#endif  // TRITON_ENABLE_LZ4
+    }
+
+    // Decompress the first chunk of compressed data in 'source_' into
+    // at most 'byte_size' bytes at 'dst', returning the number of
+    // bytes written in 'produced'. The compressed data consumed is
+    // drained from 'source_'. 'end_' is set when the compressed stream
+    // ends with all of 'source_' consumed.
+    TRITONSERVER_Error* Step(
+        char* dst, const size_t byte_size, size_t* produced)
+    {
+      struct evbuffer_iovec in;
+      in.iov_base = nullptr;
+      in.iov_len = 0;
+      evbuffer_peek(source_, -1, NULL, &in, 1);
+
+      size_t consumed = 0;
+      bool stream_end = false;
+      *produced = 0;
+      switch (type_) {
+        case Type::GZIP:
+        case Type::DEFLATE: {
+          zstream_.next_in = reinterpret_cast<unsigned char*>(in.iov_base);
+          zstream_.avail_in = in.iov_len;
+          zstream_.next_out = reinterpret_cast<unsigned char*>(dst);
+          zstream_.avail_out = byte_size;
+          auto ret = inflate(&zstream_, Z_NO_FLUSH);
+          if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) {
+            return TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_INVALID_ARG,
+                (std::string("failed to decompress data: ") +
+                 ((zstream_.msg != nullptr) ? zstream_.msg
+                                            : std::to_string(ret)))
+                    .c_str());
+          }
+          consumed = in.iov_len - zstream_.avail_in;
+          *produced = byte_size - zstream_.avail_out;
+          stream_end = (ret == Z_STREAM_END);
+          // Concatenated gzip members are decompressed as one stream
+          if (stream_end && (evbuffer_get_length(source_) > consumed)) {
+            inflateReset(&zstream_);
+          }
+          break;
+        }
+        case Type::ZSTD: {
+#ifdef TRITON_ENABLE_ZSTD
+          ZSTD_inBuffer zin{in.iov_base, in.iov_len, 0};
+          ZSTD_outBuffer zout{dst, byte_size, 0};
+          size_t ret = ZSTD_decompressStream(zstd_ctx_, &zout, &zin);
+          if (ZSTD_isError(ret)) {
+            return ZstdError("failed to decompress zstd data", ret);
+          }
+          consumed = zin.pos;
+          *produced = zout.pos;
+          // Zero means that a frame is completely decoded and flushed,
+          // the next call starts the next frame if there is one.
+          stream_end = (ret == 0);
+#endif  // TRITON_ENABLE_ZSTD
+          break;
+        }
+        case Type::LZ4: {
+#ifdef TRITON_ENABLE_LZ4
+          size_t dst_size = byte_size;
+          size_t src_size = in.iov_len;
+          size_t ret = LZ4F_decompress(
+              lz4_ctx_, dst, &dst_size, in.iov_base, &src_size,
+              nullptr /* options */);
+          if (LZ4F_isError(ret)) {
+            return Lz4Error("failed to decompress lz4 data", ret);
+          }
+          consumed = src_size;
+          *produced = dst_size;
+          // Zero hint means that a frame is completely decoded
+          stream_end = (ret == 0);
+#endif  // TRITON_ENABLE_LZ4
+          break;
+        }
+        case Type::UNKNOWN:
+        case Type::IDENTITY:
+          break;
+      }
+
+      if ((consumed != 0) && (evbuffer_drain(source_, consumed) != 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INTERNAL,
+            "unexpected error draining decompressed data");
+      }
+      if (stream_end && (evbuffer_get_length(source_) == 0)) {
+        end_ = true;
+      } else if ((consumed == 0) && (*produced == 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            (in.iov_len == 0)
+                ? "compressed data is truncated"
+                : "failed to decompress data, no progress is made");
+      }
+      return nullptr;  // success
+    }
+
+    const Type type_;
+    evbuffer* source_;
+    bool end_;
+
+    z_stream zstream_;
+    bool zstream_init_;
+#ifdef TRITON_ENABLE_ZSTD
+    ZSTD_DCtx* zstd_ctx_;
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+    LZ4F_dctx* lz4_ctx_;
+#endif  // TRITON_ENABLE_LZ4
+  };
+
+ private:
+  // Output evbuffer that is filled through chunks of memory reserved
+  // in the evbuffer.
+  class EVBufferWriter {
+   public:
+    EVBufferWriter(evbuffer* evb, const size_t chunk_byte_size)
+        : evb_(evb), chunk_byte_size_(chunk_byte_size), filled_(0)
+    {
+      space_.iov_base = nullptr;
+      space_.iov_len = 0;
+    }
+
+    // Make sure that at least 'byte_size' bytes are available at
+    // Data(), reserving a new chunk if needed.
+    TRITONSERVER_Error* Reserve(const size_t byte_size)
+    {
+      if ((space_.iov_base != nullptr) && (Available() >= byte_size)) {
+        return nullptr;  // success
+      }
+      RETURN_IF_ERR(Commit());
+      RETURN_MSG_IF_ERR(
+          AllocEVBuffer(std::max(byte_size, chunk_byte_size_), evb_, &space_),
+          "unexpected error allocating output buffer: ");
+      return nullptr;  // success
+    }
+
+    char* Data() { return reinterpret_cast<char*>(space_.iov_base) + filled_; }
+    size_t Available() const { return space_.iov_len - filled_; }
+    void Advance(const size_t byte_size) { filled_ += byte_size; }
+
+    // Commit the filled part of the current chunk to the evbuffer.
+    TRITONSERVER_Error* Commit()
+    {
+      if (space_.iov_base != nullptr) {
+        RETURN_MSG_IF_ERR(
+            CommitEVBuffer(evb_, &space_, filled_),
+            "unexpected error comitting output buffer: ");
+        space_.iov_len = 0;
+        filled_ = 0;
+      }
+      return nullptr;  // success
+    }
+
+   private:
+    evbuffer* evb_;
+    const size_t chunk_byte_size_;
+    struct evbuffer_iovec space_;
+    size_t filled_;
+  };
+
+  static TRITONSERVER_Error* InvalidLevel(
+      const char* codec, const int level, const int min_level,
+      const int max_level)
+  {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "invalid " + std::string(codec) + " compression level " +
+            std::to_string(level) + ", must be " +
+            ((min_level == INT_MIN + 1)
+                 ? std::string("at most ")
+                 : ("between " + std::to_string(min_level) + " and ")) +
+            std::to_string(max_level))
+            .c_str());
+  }
+
+  static TRITONSERVER_Error* Unsupported(const Type type)
+  {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        std::string(
+            std::string(TypeString(type)) +
+            " compression is not supported by this build")
+            .c_str());
+  }
+
+  // Get the addr and size of each chunk of memory in 'evb'.
+  static TRITONSERVER_Error* PeekEVBuffer(
+      evbuffer* evb, std::vector<struct evbuffer_iovec>* buffers)
+  {
+    int buffer_count = evbuffer_peek(evb, -1, NULL, NULL, 0);
+    if (buffer_count > 0) {
+      buffers->resize(buffer_count);
+      if (evbuffer_peek(evb, -1, NULL, buffers->data(), buffer_count) !=
+          buffer_count) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INTERNAL,
+            "unexpected error getting buffers of evbuffer");
+      }
+    }
+    return nullptr;  // success
+  }
+
+  static TRITONSERVER_Error* CompressZlib(
+      const Type type, evbuffer* source, evbuffer* compressed_data,
+      const int level)
+  {
+    size_t expected_compressed_size = evbuffer_get_length(source);
+    const int zlib_level =
+        (level == kDefaultLevel) ? Z_DEFAULT_COMPRESSION : level;
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (type == Type::GZIP) {
+      if (deflateInit2(
+              &stream, zlib_level /* level */, Z_DEFLATED /* method */,
+              15 | 16 /* windowBits */, 8 /* memLevel */,
+              Z_DEFAULT_STRATEGY /* strategy */) != Z_OK) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INTERNAL,
+            "failed to initialize state for gzip data compression");
+      }
+    } else {
+      if (deflateInit(&stream, zlib_level /* level */) != Z_OK) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INTERNAL,
+            "failed to initialize state for deflate data compression");
       }
     }
     // ensure the internal state are cleaned up on function return
     std::unique_ptr<z_stream, decltype(&deflateEnd)> managed_stream(
         &stream, deflateEnd);
-
     // Get the addr and size of each chunk of memory in 'source'
     struct evbuffer_iovec* buffer_array = nullptr;
     int buffer_count = evbuffer_peek(source, -1, NULL, NULL, 0);
@@ -155,121 +739,304 @@ class DataCompressor {
     return nullptr;  // success
   }
 
-  static TRITONSERVER_Error* DecompressData(
-      const Type type, evbuffer* source, evbuffer* decompressed_data)
+  static TRITONSERVER_Error* DecompressZlib(
+      evbuffer* source, evbuffer* decompressed_data,
+      const size_t output_buffer_size)
   {
-    size_t source_byte_size = evbuffer_get_length(source);
-    // nothing to be decompressed
-    if (evbuffer_get_length(source) == 0) {
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.avail_in = 0;
+    stream.next_in = Z_NULL;
+
+    if (inflateInit2(&stream, 15 | 32) != Z_OK) {
       return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INVALID_ARG, "nothing to be decompressed");
+          TRITONSERVER_ERROR_INTERNAL,
+          "failed to initialize state for data decompression");
     }
-    // Set reasonable size for each output buffer to be allocated
-    size_t output_buffer_size = (source_byte_size > (1 << 20 /* 1MB */))
-                                    ? source_byte_size
-                                    : (1 << 20 /* 1MB */);
+    // ensure the internal state are cleaned up on function return
+    std::unique_ptr<z_stream, decltype(&inflateEnd)> managed_stream(
+        &stream, inflateEnd);
 
-    switch (type) {
-      case Type::UNKNOWN:
-      case Type::IDENTITY: {
+    // Get the addr and size of each chunk of memory in 'source'
+    struct evbuffer_iovec* buffer_array = nullptr;
+    int buffer_count = evbuffer_peek(source, -1, NULL, NULL, 0);
+    if (buffer_count > 0) {
+      buffer_array = static_cast<struct evbuffer_iovec*>(
+          alloca(sizeof(struct evbuffer_iovec) * buffer_count));
+      if (evbuffer_peek(source, -1, NULL, buffer_array, buffer_count) !=
+          buffer_count) {
         return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INVALID_ARG, "nothing to be decompressed");
+            TRITONSERVER_ERROR_INTERNAL,
+            "unexpected error getting buffers to be decompressed");
       }
-      case Type::GZIP:
-      case Type::DEFLATE:
-        // zlib can automatically detect compression type
-        {
-          z_stream stream;
-          stream.zalloc = Z_NULL;
-          stream.zfree = Z_NULL;
-          stream.opaque = Z_NULL;
-          stream.avail_in = 0;
-          stream.next_in = Z_NULL;
-
-          if (inflateInit2(&stream, 15 | 32) != Z_OK) {
-            return TRITONSERVER_ErrorNew(
-                TRITONSERVER_ERROR_INTERNAL,
-                "failed to initialize state for data decompression");
-          }
-          // ensure the internal state are cleaned up on function return
-          std::unique_ptr<z_stream, decltype(&inflateEnd)> managed_stream(
-              &stream, inflateEnd);
-
-          // Get the addr and size of each chunk of memory in 'source'
-          struct evbuffer_iovec* buffer_array = nullptr;
-          int buffer_count = evbuffer_peek(source, -1, NULL, NULL, 0);
-          if (buffer_count > 0) {
-            buffer_array = static_cast<struct evbuffer_iovec*>(
-                alloca(sizeof(struct evbuffer_iovec) * buffer_count));
-            if (evbuffer_peek(source, -1, NULL, buffer_array, buffer_count) !=
-                buffer_count) {
-              return TRITONSERVER_ErrorNew(
-                  TRITONSERVER_ERROR_INTERNAL,
-                  "unexpected error getting buffers to be decompressed");
-            }
-          }
-          // Reserve the same size as source for compressed data, it is less
-          // likely that a negative compression happens.
-          struct evbuffer_iovec current_reserved_space;
+    }
+    // Reserve the same size as source for compressed data, it is less
+    // likely that a negative compression happens.
+    struct evbuffer_iovec current_reserved_space;
+    RETURN_MSG_IF_ERR(
+        AllocEVBuffer(
+            output_buffer_size, decompressed_data,
+            &current_reserved_space),
+        "unexpected error allocating output buffer for decompression: ");
+    stream.next_out =
+        reinterpret_cast<unsigned char*>(current_reserved_space.iov_base);
+    stream.avail_out = output_buffer_size;
+
+    // Compress until end of 'source'
+    for (int idx = 0; idx < buffer_count; ++idx) {
+      stream.next_in =
+          reinterpret_cast<unsigned char*>(buffer_array[idx].iov_base);
+      stream.avail_in = buffer_array[idx].iov_len;
+
+      // run inflate() on input until source has been read in
+      do {
+        // Need additional buffer
+        if (stream.avail_out == 0) {
+          RETURN_MSG_IF_ERR(
+              CommitEVBuffer(
+                  decompressed_data, &current_reserved_space,
+                  output_buffer_size),
+              "unexpected error comitting output buffer for "
+              "decompression: ");
           RETURN_MSG_IF_ERR(
               AllocEVBuffer(
                   output_buffer_size, decompressed_data,
                   &current_reserved_space),
-              "unexpected error allocating output buffer for decompression: ");
-          stream.next_out =
-              reinterpret_cast<unsigned char*>(current_reserved_space.iov_base);
+              "unexpected error allocating output buffer for "
+              "decompression: ");
+          stream.next_out = reinterpret_cast<unsigned char*>(
+              current_reserved_space.iov_base);
           stream.avail_out = output_buffer_size;
-
-          // Compress until end of 'source'
-          for (int idx = 0; idx < buffer_count; ++idx) {
-            stream.next_in =
-                reinterpret_cast<unsigned char*>(buffer_array[idx].iov_base);
-            stream.avail_in = buffer_array[idx].iov_len;
-
-            // run inflate() on input until source has been read in
-            do {
-              // Need additional buffer
-              if (stream.avail_out == 0) {
-                RETURN_MSG_IF_ERR(
-                    CommitEVBuffer(
-                        decompressed_data, &current_reserved_space,
-                        output_buffer_size),
-                    "unexpected error comitting output buffer for "
-                    "decompression: ");
-                RETURN_MSG_IF_ERR(
-                    AllocEVBuffer(
-                        output_buffer_size, decompressed_data,
-                        &current_reserved_space),
-                    "unexpected error allocating output buffer for "
-                    "decompression: ");
-                stream.next_out = reinterpret_cast<unsigned char*>(
-                    current_reserved_space.iov_base);
-                stream.avail_out = output_buffer_size;
-              }
-              auto ret = inflate(&stream, Z_NO_FLUSH);
-              if (ret == Z_STREAM_ERROR) {
-                return TRITONSERVER_ErrorNew(
-                    TRITONSERVER_ERROR_INTERNAL,
-                    "encountered inconsistent stream state during "
-                    "decompression");
-              }
-            } while (stream.avail_out == 0);
-          }
-          // Make sure the last buffer is committed
-          if (current_reserved_space.iov_base != nullptr) {
-            RETURN_MSG_IF_ERR(
-                CommitEVBuffer(
-                    decompressed_data, &current_reserved_space,
-                    output_buffer_size - stream.avail_out),
-                "unexpected error comitting output buffer for compression: ");
-          }
-          break;
         }
+        auto ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INTERNAL,
+              "encountered inconsistent stream state during "
+              "decompression");
+        }
+      } while (stream.avail_out == 0);
+    }
+    // Make sure the last buffer is committed
+    if (current_reserved_space.iov_base != nullptr) {
+      RETURN_MSG_IF_ERR(
+          CommitEVBuffer(
+              decompressed_data, &current_reserved_space,
+              output_buffer_size - stream.avail_out),
+          "unexpected error comitting output buffer for compression: ");
     }
     return nullptr;  // success
   }
 
- private:
+#ifdef TRITON_ENABLE_ZSTD
+  static TRITONSERVER_Error* ZstdError(const char* msg, const size_t code)
+  {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(std::string(msg) + ": " + ZSTD_getErrorName(code))
+            .c_str());
+  }
+
+  static TRITONSERVER_Error* CompressZstd(
+      evbuffer* source, evbuffer* compressed_data, const int level)
+  {
+    const size_t source_byte_size = evbuffer_get_length(source);
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(
+        ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (cctx == nullptr) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          "failed to initialize state for zstd data compression");
+    }
+    size_t ret = ZSTD_CCtx_setParameter(
+        cctx.get(), ZSTD_c_compressionLevel,
+        (level == kDefaultLevel) ? ZSTD_CLEVEL_DEFAULT : level);
+    if (!ZSTD_isError(ret)) {
+      // Record the content size in the frame header so that the
+      // receiver can size its output buffer.
+      ret = ZSTD_CCtx_setPledgedSrcSize(cctx.get(), source_byte_size);
+    }
+    if (ZSTD_isError(ret)) {
+      return ZstdError("failed to configure zstd data compression", ret);
+    }
+
+    std::vector<struct evbuffer_iovec> buffers;
+    RETURN_IF_ERR(PeekEVBuffer(source, &buffers));
+
+    // With the bound the whole frame fits in one chunk of output.
+    EVBufferWriter writer(
+        compressed_data, ZSTD_compressBound(source_byte_size));
+    for (size_t idx = 0; idx < buffers.size(); ++idx) {
+      ZSTD_inBuffer in{buffers[idx].iov_base, buffers[idx].iov_len, 0};
+      const ZSTD_EndDirective mode =
+          ((idx + 1) == buffers.size()) ? ZSTD_e_end : ZSTD_e_continue;
+      bool done = false;
+      do {
+        RETURN_IF_ERR(writer.Reserve(1));
+        ZSTD_outBuffer out{writer.Data(), writer.Available(), 0};
+        ret = ZSTD_compressStream2(cctx.get(), &out, &in, mode);
+        if (ZSTD_isError(ret)) {
+          return ZstdError("failed to compress zstd data", ret);
+        }
+        writer.Advance(out.pos);
+        done = (mode == ZSTD_e_end) ? (ret == 0) : (in.pos == in.size);
+      } while (!done);
+    }
+    return writer.Commit();
+  }
+
+  static TRITONSERVER_Error* DecompressZstd(
+      evbuffer* source, evbuffer* decompressed_data,
+      const size_t output_buffer_size)
+  {
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(
+        ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if (dctx == nullptr) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          "failed to initialize state for zstd data decompression");
+    }
+
+    std::vector<struct evbuffer_iovec> buffers;
+    RETURN_IF_ERR(PeekEVBuffer(source, &buffers));
+
+    EVBufferWriter writer(decompressed_data, output_buffer_size);
+    size_t ret = 0;
+    for (const auto& buffer : buffers) {
+      ZSTD_inBuffer in{buffer.iov_base, buffer.iov_len, 0};
+      bool output_full = false;
+      do {
+        RETURN_IF_ERR(writer.Reserve(1));
+        ZSTD_outBuffer out{writer.Data(), writer.Available(), 0};
+        ret = ZSTD_decompressStream(dctx.get(), &out, &in);
+        if (ZSTD_isError(ret)) {
+          return ZstdError("failed to decompress zstd data", ret);
+        }
+        writer.Advance(out.pos);
+        // A full output buffer may leave decompressed data buffered in
+        // the context, so call again even if all input is consumed.
+        output_full = (out.pos == out.size);
+      } while ((in.pos < in.size) || output_full);
+    }
+    if (ret != 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG, "zstd compressed data is truncated");
+    }
+    return writer.Commit();
+  }
+#endif  // TRITON_ENABLE_ZSTD
+
+#ifdef TRITON_ENABLE_LZ4
+  static TRITONSERVER_Error* Lz4Error(const char* msg, const size_t code)
+  {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(std::string(msg) + ": " + LZ4F_getErrorName(code))
+            .c_str());
+  }
+
+  static TRITONSERVER_Error* CompressLz4(
+      evbuffer* source, evbuffer* compressed_data, const int level)
+  {
+    const size_t source_byte_size = evbuffer_get_length(source);
+    LZ4F_cctx* ctx = nullptr;
+    size_t ret = LZ4F_createCompressionContext(&ctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret)) {
+      return Lz4Error(
+          "failed to initialize state for lz4 data compression", ret);
+    }
+    std::unique_ptr<LZ4F_cctx, decltype(&LZ4F_freeCompressionContext)>
+        managed_ctx(ctx, LZ4F_freeCompressionContext);
+
+    LZ4F_preferences_t preferences;
+    std::memset(&preferences, 0, sizeof(preferences));
+    preferences.compressionLevel = (level == kDefaultLevel) ? 0 : level;
+    preferences.frameInfo.contentSize = source_byte_size;
+
+    std::vector<struct evbuffer_iovec> buffers;
+    RETURN_IF_ERR(PeekEVBuffer(source, &buffers));
+
+    EVBufferWriter writer(
+        compressed_data,
+        LZ4F_compressFrameBound(source_byte_size, &preferences));
+    RETURN_IF_ERR(writer.Reserve(LZ4F_HEADER_SIZE_MAX));
+    ret = LZ4F_compressBegin(
+        ctx, writer.Data(), writer.Available(), &preferences);
+    if (LZ4F_isError(ret)) {
+      return Lz4Error("failed to compress lz4 data", ret);
+    }
+    writer.Advance(ret);
+
+    for (const auto& buffer : buffers) {
+      RETURN_IF_ERR(
+          writer.Reserve(LZ4F_compressBound(buffer.iov_len, &preferences)));
+      ret = LZ4F_compressUpdate(
+          ctx, writer.Data(), writer.Available(), buffer.iov_base,
+          buffer.iov_len, nullptr /* options */);
+      if (LZ4F_isError(ret)) {
+        return Lz4Error("failed to compress lz4 data", ret);
+      }
+      writer.Advance(ret);
+    }
+
+    RETURN_IF_ERR(writer.Reserve(LZ4F_compressBound(0, &preferences)));
+    ret = LZ4F_compressEnd(
+        ctx, writer.Data(), writer.Available(), nullptr /* options */);
+    if (LZ4F_isError(ret)) {
+      return Lz4Error("failed to compress lz4 data", ret);
+    }
+    writer.Advance(ret);
+    return writer.Commit();
+  }
+
+  static TRITONSERVER_Error* DecompressLz4(
+      evbuffer* source, evbuffer* decompressed_data,
+      const size_t output_buffer_size)
+  {
+    LZ4F_dctx* ctx = nullptr;
+    size_t ret = LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret)) {
+      return Lz4Error(
+          "failed to initialize state for lz4 data decompression", ret);
+    }
+    std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)>
+        managed_ctx(ctx, LZ4F_freeDecompressionContext);
+
+    std::vector<struct evbuffer_iovec> buffers;
+    RETURN_IF_ERR(PeekEVBuffer(source, &buffers));
+
+    EVBufferWriter writer(decompressed_data, output_buffer_size);
+    for (const auto& buffer : buffers) {
+      const char* src = reinterpret_cast<const char*>(buffer.iov_base);
+      size_t remaining = buffer.iov_len;
+      bool output_full = false;
+      do {
+        RETURN_IF_ERR(writer.Reserve(1));
+        const size_t available = writer.Available();
+        size_t dst_size = available;
+        size_t src_size = remaining;
+        ret = LZ4F_decompress(
+            ctx, writer.Data(), &dst_size, src, &src_size,
+            nullptr /* options */);
+        if (LZ4F_isError(ret)) {
+          return Lz4Error("failed to decompress lz4 data", ret);
+        }
+        writer.Advance(dst_size);
+        src += src_size;
+        remaining -= src_size;
+        output_full = (dst_size == available);
+      } while ((remaining > 0) || output_full);
+    }
+    // A non-zero hint means that the frame expects more input.
+    if (ret != 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG, "lz4 compressed data is truncated");
+    }
+    return writer.Commit();
+  }
+#endif  // TRITON_ENABLE_LZ4
   static TRITONSERVER_Error* AllocEVBuffer(
       const size_t byte_size, evbuffer* evb,
       struct evbuffer_iovec* current_reserved_space)
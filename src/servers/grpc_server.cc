@@ -161,7 +161,9 @@ typedef enum {
   ISSUED,
   READ,
   WRITEREADY,
-  WRITTEN
+  WRITTEN,
+  DONE,
+  LOADED
 } Steps;
 
 std::ostream&
@@ -189,6 +191,12 @@ operator<<(std::ostream& out, const Steps& step)
     case WRITTEN:
       out << "WRITTEN";
       break;
+    case DONE:
+      out << "DONE";
+      break;
+    case LOADED:
+      out << "LOADED";
+      break;
   }
 
   return out;
@@ -1756,15 +1764,18 @@ struct AllocPayload {
   struct ShmInfo {
     ShmInfo(
         void* base, size_t byte_size, TRITONSERVER_MemoryType memory_type,
-        int64_t memory_type_id)
+        int64_t memory_type_id, SharedMemoryManager::Lease&& lease)
         : base_(base), byte_size_(byte_size), memory_type_(memory_type),
-          memory_type_id_(memory_type_id)
+          memory_type_id_(memory_type_id), lease_(std::move(lease))
     {
     }
     void* base_;
     size_t byte_size_;
     TRITONSERVER_MemoryType memory_type_;
     int64_t memory_type_id_;
+    // Keep the shared memory region mapped while the output may be
+    // written to it.
+    SharedMemoryManager::Lease lease_;
   };
 
   using TensorShmMap = std::unordered_map<std::string, ShmInfo>;
@@ -1958,6 +1969,10 @@ class InferHandlerState {
 
     // True if there is an ongoing write to the grpc stream
     std::atomic<bool> ongoing_write_;
+
+    // The inference request of a ModelInfer RPC, which is cancelled if
+    // the client cancels the RPC.
+    std::shared_ptr<CancellableRequest> cancellable_request_;
   };
 
   explicit InferHandlerState(
@@ -2002,6 +2017,7 @@ class InferHandlerState {
     cb_count_ = 0;
     is_decoupled_ = false;
     complete_ = false;
+    load_err_ = nullptr;
     request_.Clear();
     response_queue_->Reset();
 #ifdef TRITON_ENABLE_TRACING
@@ -2054,6 +2070,10 @@ class InferHandlerState {
   // For inference requests the allocator payload, unused for other
   // requests.
   AllocPayload<ResponseType> alloc_payload_;
+
+  // For ModelInfer requests the result of loading the model on
+  // demand, unused for other requests.
+  TRITONSERVER_Error* load_err_;
 };
 
 //
@@ -2506,12 +2526,14 @@ InferAllocatorPayload(
       void* base;
       TRITONSERVER_MemoryType memory_type;
       int64_t memory_type_id;
+      SharedMemoryManager::Lease lease;
       RETURN_IF_ERR(shm_manager->GetMemoryInfo(
-          region_name, offset, &base, &memory_type, &memory_type_id));
+          region_name, offset, &base, &memory_type, &memory_type_id, &lease));
 
       alloc_payload->shm_map_.emplace(
-          io.name(), typename AllocPayload<ResponseType>::ShmInfo(
-                         base, byte_size, memory_type, memory_type_id));
+          io.name(),
+          typename AllocPayload<ResponseType>::ShmInfo(
+              base, byte_size, memory_type, memory_type_id, std::move(lease)));
     } else if (has_classification) {
       alloc_payload->classification_map_.emplace(
           io.name(), classification_count);
@@ -2557,6 +2579,7 @@ InferGRPCToInput(
     const std::shared_ptr<SharedMemoryManager>& shm_manager,
     const inference::ModelInferRequest& request,
     std::list<std::string>* serialized_data,
+    std::vector<SharedMemoryManager::Lease>* shm_leases,
     TRITONSERVER_InferenceRequest* inference_request)
 {
   // Verify that the batch-byte-size of each input matches the size of
@@ -2587,9 +2610,11 @@ InferGRPCToInput(
                 .c_str());
       }
       void* tmp;
+      SharedMemoryManager::Lease lease;
       RETURN_IF_ERR(shm_manager->GetMemoryInfo(
-          region_name, offset, &tmp, &memory_type, &memory_type_id));
+          region_name, offset, &tmp, &memory_type, &memory_type_id, &lease));
       base = tmp;
+      shm_leases->emplace_back(std::move(lease));
     } else {
       if (io.has_contents() && (!request.raw_input_contents().empty())) {
         return TRITONSERVER_ErrorNew(
@@ -2866,6 +2891,17 @@ SetInferenceRequestMetadata(
   return nullptr;  // Success
 }
 
+// Resources used by an inference request that must remain valid until
+// the request is released.
+struct RequestReleasePayload {
+  // Leases on the shared memory regions used by the inputs.
+  std::vector<SharedMemoryManager::Lease> shm_leases_;
+
+  // The request if it is cancelled when the client cancels the RPC,
+  // in which case it must not be cancelled once it is released.
+  std::shared_ptr<CancellableRequest> cancellable_request_;
+};
+
 void
 InferRequestComplete(
     TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
@@ -2873,9 +2909,20 @@ InferRequestComplete(
   LOG_VERBOSE(1) << "ModelInferHandler::InferRequestComplete";
 
   if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    RequestReleasePayload* release_payload =
+        reinterpret_cast<RequestReleasePayload*>(userp);
+    if ((release_payload != nullptr) &&
+        (release_payload->cancellable_request_ != nullptr)) {
+      release_payload->cancellable_request_->Release();
+    }
+
     LOG_TRITONSERVER_ERROR(
         TRITONSERVER_InferenceRequestDelete(request),
         "deleting GRPC inference request");
+
+    // Release the leases on the shared memory regions used by the
+    // request inputs, if any.
+    delete release_payload;
   }
 }
 
@@ -3102,6 +3149,7 @@ class ModelInferHandler
   bool Process(State* state, bool rpc_ok) override;
 
  private:
+  static void OnDemandLoadComplete(TRITONSERVER_Error* error, void* userp);
   static void InferResponseComplete(
       TRITONSERVER_InferenceResponse* response, const uint32_t flags,
       void* userp);
@@ -3137,6 +3185,12 @@ ModelInferHandler::StartNewRequest()
   }
 #endif  // TRITON_ENABLE_TRACING
 
+  // Get notified when the RPC is done so that the inference request
+  // can be cancelled if the RPC is done because the client cancelled
+  // it. Must be requested before the RPC starts.
+  State* done_state = StateNew(tritonserver_.get(), context, Steps::DONE);
+  context->ctx_->AsyncNotifyWhenDone(done_state);
+
   service_->RequestModelInfer(
       state->context_->ctx_.get(), &state->request_,
       state->context_->responder_.get(), cq_, cq_, state);
@@ -3151,6 +3205,23 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
   LOG_VERBOSE(1) << "Process for " << Name() << ", rpc_ok=" << rpc_ok << ", "
                  << state->unique_id_ << " step " << state->step_;
 
+  // The RPC is done. If it was cancelled by the client the inference
+  // request is cancelled too, unless it has already been released.
+  // 'cancellable_request_' is only set, by this thread, once the RPC
+  // has started.
+  if (state->step_ == Steps::DONE) {
+    const std::shared_ptr<CancellableRequest>& cancellable_request =
+        state->context_->cancellable_request_;
+    if ((cancellable_request != nullptr) &&
+        state->context_->ctx_->IsCancelled()) {
+      LOG_VERBOSE(1) << "ModelInfer RPC cancelled, cancelling inference "
+                        "request, "
+                     << state->unique_id_;
+      cancellable_request->Cancel();
+    }
+    return false;
+  }
+
   // We need an explicit finish indicator. Can't use 'state->step_'
   // because we launch an async thread that could update 'state's
   // step_ to be FINISH before this thread exits this function.
@@ -3159,9 +3230,17 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
   // If RPC failed on a new request then the server is shutting down
   // and so we should do nothing (including not registering for a new
   // request). If RPC failed on a non-START step then there is nothing
-  // we can do since we one execute one step.
-  const bool shutdown = (!rpc_ok && (state->step_ == Steps::START));
+  // we can do since we one execute one step. A request set aside while
+  // its model was loaded on demand is put back on the queue with an
+  // alarm, which fails if the server is shutting down.
+  const bool shutdown =
+      (!rpc_ok &&
+       ((state->step_ == Steps::START) || (state->step_ == Steps::LOADED)));
   if (shutdown) {
+    if (state->load_err_ != nullptr) {
+      TRITONSERVER_ErrorDelete(state->load_err_);
+      state->load_err_ = nullptr;
+    }
     state->step_ = Steps::FINISH;
     finished = true;
   }
@@ -3169,18 +3248,26 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
   const inference::ModelInferRequest& request = state->request_;
   auto response_queue = state->response_queue_;
 
-  if (state->step_ == Steps::START) {
+  // A request that was set aside while its model was loaded on demand
+  // continues as a new request, with the result of the load.
+  if ((state->step_ == Steps::START) || (state->step_ == Steps::LOADED)) {
     TRITONSERVER_Error* err = nullptr;
+    if (state->step_ == Steps::LOADED) {
+      err = state->load_err_;
+      state->load_err_ = nullptr;
+    } else {
 #ifdef TRITON_ENABLE_TRACING
-    if ((state->trace_manager_ != nullptr) && (state->trace_id_ != 0)) {
-      state->trace_manager_->CaptureTimestamp(
-          state->trace_id_, TRITONSERVER_TRACE_LEVEL_MIN, "GRPC_WAITREAD_END");
-    }
+      if ((state->trace_manager_ != nullptr) && (state->trace_id_ != 0)) {
+        state->trace_manager_->CaptureTimestamp(
+            state->trace_id_, TRITONSERVER_TRACE_LEVEL_MIN,
+            "GRPC_WAITREAD_END");
+      }
 #endif  // TRITON_ENABLE_TRACING
 
-    // Start a new request to replace this one...
-    if (!shutdown) {
-      StartNewRequest();
+      // Start a new request to replace this one...
+      if (!shutdown) {
+        StartNewRequest();
+      }
     }
 
     int64_t requested_model_version;
@@ -3189,6 +3276,20 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
           request.model_version(), &requested_model_version);
     }
 
+    // If the model is loaded on demand and isn't loaded, set the
+    // request aside until the load completes instead of blocking this
+    // thread, and the other RPCs on the completion queue, for the load.
+    if (err == nullptr) {
+      bool ready = true;
+      err = TRITONSERVER_ServerLoadModelOnDemand(
+          tritonserver_.get(), request.model_name().c_str(),
+          requested_model_version, OnDemandLoadComplete,
+          reinterpret_cast<void*>(state), &ready);
+      if ((err == nullptr) && !ready) {
+        return true;
+      }
+    }
+
     if (err == nullptr) {
       uint32_t txn_flags;
       err = TRITONSERVER_ServerModelTransactionProperties(
@@ -3219,9 +3320,16 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     // tensors are present in the request.
     std::list<std::string> serialized_data;
 
+    // Leases on the shared memory regions used by the inputs, they are
+    // held until the request is released. The request is cancelled if
+    // the client cancels the RPC before the request is released.
+    std::vector<SharedMemoryManager::Lease> shm_leases;
+    std::unique_ptr<RequestReleasePayload> release_payload;
+
     if (err == nullptr) {
       err = InferGRPCToInput(
-          tritonserver_, shm_manager_, request, &serialized_data, irequest);
+          tritonserver_, shm_manager_, request, &serialized_data, &shm_leases,
+          irequest);
     }
     if (err == nullptr) {
       err = InferAllocatorPayload<inference::ModelInferResponse>(
@@ -3229,8 +3337,15 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
           response_queue, &state->alloc_payload_);
     }
     if (err == nullptr) {
+      release_payload.reset(new RequestReleasePayload());
+      release_payload->shm_leases_ = std::move(shm_leases);
+      release_payload->cancellable_request_ =
+          std::make_shared<CancellableRequest>(irequest);
+      state->context_->cancellable_request_ =
+          release_payload->cancellable_request_;
       err = TRITONSERVER_InferenceRequestSetReleaseCallback(
-          irequest, InferRequestComplete, nullptr /* request_release_userp */);
+          irequest, InferRequestComplete,
+          release_payload.get() /* request_release_userp */);
     }
     if (err == nullptr) {
       err = TRITONSERVER_InferenceRequestSetResponseCallback(
@@ -3249,6 +3364,12 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       state->step_ = ISSUED;
       err = TRITONSERVER_ServerInferAsync(tritonserver_.get(), irequest, trace);
     }
+    if (err == nullptr) {
+      // The release callback owns the leases now.
+      release_payload.release();
+    } else if (release_payload != nullptr) {
+      release_payload->cancellable_request_->Release();
+    }
 
     // If not error then state->step_ == ISSUED and inference request
     // has initiated... completion callback will transition to
@@ -3291,6 +3412,22 @@ ModelInferHandler::Process(InferHandler::State* state, bool rpc_ok)
   return !finished;
 }
 
+void
+ModelInferHandler::OnDemandLoadComplete(TRITONSERVER_Error* error, void* userp)
+{
+  // Called from the thread that loaded the model, put the state back
+  // on the completion queue so that the request is issued by the
+  // handler thread.
+  State* state = reinterpret_cast<State*>(userp);
+
+  LOG_VERBOSE(1) << "ModelInferHandler::OnDemandLoadComplete, "
+                 << state->unique_id_ << " step " << state->step_;
+
+  state->load_err_ = error;
+  state->step_ = Steps::LOADED;
+  state->context_->PutTaskBackToQueue(state);
+}
+
 void
 ModelInferHandler::InferResponseComplete(
     TRITONSERVER_InferenceResponse* iresponse, const uint32_t flags,
@@ -3609,9 +3746,15 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
     // tensors are present in the request.
     std::list<std::string> serialized_data;
 
+    // Leases on the shared memory regions used by the inputs, they are
+    // held until the request is released.
+    std::vector<SharedMemoryManager::Lease> shm_leases;
+    std::unique_ptr<RequestReleasePayload> release_payload;
+
     if (err == nullptr) {
       err = InferGRPCToInput(
-          tritonserver_, shm_manager_, request, &serialized_data, irequest);
+          tritonserver_, shm_manager_, request, &serialized_data, &shm_leases,
+          irequest);
     }
     if (err == nullptr) {
       err = InferAllocatorPayload<inference::ModelStreamInferResponse>(
@@ -3619,8 +3762,13 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
           response_queue_, &state->alloc_payload_);
     }
     if (err == nullptr) {
+      if (!shm_leases.empty()) {
+        release_payload.reset(new RequestReleasePayload());
+        release_payload->shm_leases_ = std::move(shm_leases);
+      }
       err = TRITONSERVER_InferenceRequestSetReleaseCallback(
-          irequest, InferRequestComplete, nullptr /* request_release_userp */);
+          irequest, InferRequestComplete,
+          release_payload.get() /* request_release_userp */);
     }
     if (err == nullptr) {
       err = TRITONSERVER_InferenceRequestSetResponseCallback(
@@ -3639,6 +3787,10 @@ ModelStreamInferHandler::Process(InferHandler::State* state, bool rpc_ok)
       state->step_ = ISSUED;
       err = TRITONSERVER_ServerInferAsync(tritonserver_.get(), irequest, trace);
     }
+    if (err == nullptr) {
+      // The release callback owns the leases now.
+      release_payload.release();
+    }
 
     // If there was not an error in issuing the 'state' request then
     // state->step_ == ISSUED and inference request has
@@ -26,11 +26,15 @@
 
 #include "src/servers/http_server.h"
 
+#include <errno.h>
 #include <event2/buffer.h>
+#include <event2/event.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/json_util.h>
 #include <re2/re2.h>
+#include <sys/socket.h>
 #include <algorithm>
+#include <cstring>
 #include <list>
 #include <thread>
 #include "src/core/constants.h"
@@ -893,7 +897,8 @@ CompressionTypeUsed(const std::string accept_encoding)
         continue;
       }
     }
-    if (((type == "identity") || (type == "deflate") || (type == "gzip")) &&
+    if ((DataCompressor::TypeFromString(type) !=
+         DataCompressor::Type::UNKNOWN) &&
         (type_weight > weight)) {
       res = type;
       weight = type_weight;
@@ -908,10 +913,11 @@ HTTPAPIServer::HTTPAPIServer(
     const std::shared_ptr<TRITONSERVER_Server>& server,
     nvidia::inferenceserver::TraceManager* trace_manager,
     const std::shared_ptr<SharedMemoryManager>& shm_manager, const int32_t port,
-    const int thread_cnt)
+    const int thread_cnt, const DataCompressor::Options& compression_options)
     : HTTPServer(port, thread_cnt), server_(server),
       trace_manager_(trace_manager), shm_manager_(shm_manager),
-      allocator_(nullptr), server_regex_(R"(/v2(?:/health/(live|ready))?)"),
+      compression_options_(compression_options), allocator_(nullptr),
+      server_regex_(R"(/v2(?:/health/(live|ready))?)"),
       model_regex_(
           R"(/v2/models/([^/]+)(?:/versions/([0-9]+))?(?:/(infer|ready|config|stats))?)"),
       modelcontrol_regex_(
@@ -1724,12 +1730,8 @@ HTTPAPIServer::GetRequestCompressionType(evhtp_request_t* req)
       evhtp_kv_find(req->headers_in, kContentEncodingHTTPHeader);
   if (content_encoding_c_str != NULL) {
     std::string content_encoding(content_encoding_c_str);
-    if (content_encoding == "deflate") {
-      return DataCompressor::Type::DEFLATE;
-    } else if (content_encoding == "gzip") {
-      return DataCompressor::Type::GZIP;
-    } else if (!content_encoding.empty() && (content_encoding != "identity")) {
-      return DataCompressor::Type::UNKNOWN;
+    if (!content_encoding.empty()) {
+      return DataCompressor::TypeFromString(content_encoding);
     }
   }
   return DataCompressor::Type::IDENTITY;
@@ -1742,12 +1744,8 @@ HTTPAPIServer::GetResponseCompressionType(evhtp_request_t* req)
   const char* accept_encoding_c_str =
       evhtp_kv_find(req->headers_in, kAcceptEncodingHTTPHeader);
   if (accept_encoding_c_str != NULL) {
-    std::string accept_encoding = CompressionTypeUsed(accept_encoding_c_str);
-    if (accept_encoding == "deflate") {
-      return DataCompressor::Type::DEFLATE;
-    } else if (accept_encoding == "gzip") {
-      return DataCompressor::Type::GZIP;
-    }
+    return DataCompressor::TypeFromString(
+        CompressionTypeUsed(accept_encoding_c_str));
   }
   return DataCompressor::Type::IDENTITY;
 }
@@ -1755,18 +1753,24 @@ HTTPAPIServer::GetResponseCompressionType(evhtp_request_t* req)
 TRITONSERVER_Error*
 HTTPAPIServer::EVBufferToInput(
     const std::string& model_name, TRITONSERVER_InferenceRequest* irequest,
-    evbuffer* input_buffer, InferRequestClass* infer_req, size_t header_length)
+    evbuffer* input_buffer, DataCompressor::StreamDecompressor* decompressor,
+    InferRequestClass* infer_req, size_t header_length,
+    std::vector<SharedMemoryManager::Lease>* shm_leases)
 {
   // Extract individual input data from HTTP body and register in
   // 'irequest'. The HTTP body is not necessarily stored in contiguous
   // memory.
   //
   // Get the addr and size of each chunk of memory holding the HTTP
-  // body.
+  // body. A compressed body is instead read through 'decompressor',
+  // which inflates each section directly into the buffer that holds
+  // it for the lifetime of the request.
   struct evbuffer_iovec* v = nullptr;
   int v_idx = 0;
 
-  int n = evbuffer_peek(input_buffer, -1, NULL, NULL, 0);
+  int n = (decompressor == nullptr)
+              ? evbuffer_peek(input_buffer, -1, NULL, NULL, 0)
+              : 0;
   if (n > 0) {
     v = static_cast<struct evbuffer_iovec*>(
         alloca(sizeof(struct evbuffer_iovec) * n));
@@ -1780,14 +1784,29 @@ HTTPAPIServer::EVBufferToInput(
   // Extract just the json header from the HTTP body. 'header_length'
   // == 0 means that the entire HTTP body should be parsed as json.
   triton::common::TritonJson::Value request_json;
-  int json_header_len = 0;
-  if (header_length == 0) {
-    json_header_len = evbuffer_get_length(input_buffer);
+  if (decompressor != nullptr) {
+    std::vector<char> json_buffer;
+    if (header_length == 0) {
+      RETURN_MSG_IF_ERR(
+          decompressor->ReadAll(&json_buffer),
+          "Unable to decompress request JSON");
+    } else {
+      RETURN_MSG_IF_ERR(
+          decompressor->Read(&json_buffer, header_length),
+          "Unable to decompress request JSON");
+    }
+    RETURN_IF_ERR(request_json.Parse(json_buffer.data(), json_buffer.size()));
   } else {
-    json_header_len = header_length;
-  }
+    int json_header_len = 0;
+    if (header_length == 0) {
+      json_header_len = evbuffer_get_length(input_buffer);
+    } else {
+      json_header_len = header_length;
+    }
 
-  RETURN_IF_ERR(EVBufferToJson(&request_json, v, &v_idx, json_header_len, n));
+    RETURN_IF_ERR(
+        EVBufferToJson(&request_json, v, &v_idx, json_header_len, n));
+  }
 
   // Set InferenceRequest request_id
   triton::common::TritonJson::Value id_json;
@@ -1931,6 +1950,24 @@ HTTPAPIServer::EVBufferToInput(
             "data format");
       }
 
+      // Inflate a compressed input into a buffer of its own, which
+      // is then the only block holding the input. The buffer grows as
+      // the input is inflated, 'byte_size' is only trusted once that
+      // much data has actually been decompressed.
+      if (decompressor != nullptr) {
+        infer_req->serialized_data_.emplace_back();
+        std::vector<char>& decompressed = infer_req->serialized_data_.back();
+        RETURN_MSG_IF_ERR(
+            decompressor->Read(&decompressed, byte_size),
+            std::string(
+                "Unable to decompress input '" + std::string(input_name) +
+                "' for model '" + model_name + "'"));
+        RETURN_IF_ERR(TRITONSERVER_InferenceRequestAppendInputData(
+            irequest, input_name, decompressed.data(), byte_size,
+            TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
+        byte_size = 0;
+      }
+
       // Process one block at a time
       while ((byte_size > 0) && (v_idx < n)) {
         char* base = static_cast<char*>(v[v_idx].iov_base);
@@ -1971,8 +2008,11 @@ HTTPAPIServer::EVBufferToInput(
         void* base;
         TRITONSERVER_MemoryType memory_type;
         int64_t memory_type_id;
+        SharedMemoryManager::Lease lease;
         RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
-            shm_region, shm_offset, &base, &memory_type, &memory_type_id));
+            shm_region, shm_offset, &base, &memory_type, &memory_type_id,
+            &lease));
+        shm_leases->emplace_back(std::move(lease));
         RETURN_IF_ERR(TRITONSERVER_InferenceRequestAppendInputData(
             irequest, input_name, base, byte_size, memory_type,
             memory_type_id));
@@ -2030,7 +2070,13 @@ HTTPAPIServer::EVBufferToInput(
     }
   }
 
-  if (v_idx != n) {
+  bool body_consumed = (v_idx == n);
+  if (decompressor != nullptr) {
+    RETURN_MSG_IF_ERR(
+        decompressor->AtEnd(&body_consumed),
+        "Unable to decompress request body");
+  }
+  if (!body_consumed) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INVALID_ARG,
         std::string(
@@ -2072,13 +2118,15 @@ HTTPAPIServer::EVBufferToInput(
         void* base;
         TRITONSERVER_MemoryType memory_type;
         int64_t memory_type_id;
+        SharedMemoryManager::Lease lease;
         RETURN_IF_ERR(shm_manager_->GetMemoryInfo(
-            shm_region, offset, &base, &memory_type, &memory_type_id));
+            shm_region, offset, &base, &memory_type, &memory_type_id, &lease));
 
         infer_req->alloc_payload_.output_map_.emplace(
             std::piecewise_construct, std::forward_as_tuple(output_name),
             std::forward_as_tuple(new AllocPayload::OutputInfo(
-                base, byte_size, memory_type, memory_type_id)));
+                base, byte_size, memory_type, memory_type_id,
+                std::move(lease))));
       } else {
         bool use_binary;
         RETURN_IF_ERR(CheckBinaryOutputData(request_output, &use_binary));
@@ -2100,19 +2148,38 @@ HTTPAPIServer::EVBufferToInput(
 void
 HTTPAPIServer::HandleInfer(
     evhtp_request_t* req, const std::string& model_name,
-    const std::string& model_version_str)
+    const std::string& model_version_str, const bool paused)
 {
   if (req->method != htp_method_POST) {
     evhtp_send_reply(req, EVHTP_RES_METHNALLOWED);
     return;
   }
 
-  bool connection_paused = false;
+  bool connection_paused = paused;
 
   int64_t requested_model_version;
   auto err = GetModelVersionFromString(
       model_version_str.c_str(), &requested_model_version);
 
+  // If the model is loaded on demand and isn't loaded, set the request
+  // aside until the load completes instead of blocking the evhtp
+  // thread, and the other requests on it, for the load.
+  if (err == nullptr) {
+    std::unique_ptr<OnDemandLoad> load(
+        new OnDemandLoad(this, req, model_name, model_version_str));
+    bool ready = true;
+    err = TRITONSERVER_ServerLoadModelOnDemand(
+        server_.get(), model_name.c_str(), requested_model_version,
+        OnDemandLoadComplete, load.get(), &ready);
+    if ((err == nullptr) && !ready) {
+      if (!connection_paused) {
+        evhtp_request_pause(req);
+      }
+      load.release();
+      return;
+    }
+  }
+
   if (err == nullptr) {
     uint32_t txn_flags;
     err = TRITONSERVER_ServerModelTransactionProperties(
@@ -2156,16 +2223,20 @@ HTTPAPIServer::HandleInfer(
         &irequest, server_.get(), model_name.c_str(), requested_model_version);
   }
 
-  // Decompress request body if it is compressed in supported type
-  evbuffer* decompressed_buffer = nullptr;
+  // Decompress request body if it is compressed in supported type. The
+  // body is decompressed incrementally while the inputs are extracted
+  // so that the decompressed data is written only once, to the buffer
+  // that holds it until the request is released.
+  std::unique_ptr<DataCompressor::StreamDecompressor> decompressor;
   if (err == nullptr) {
     auto compression_type = GetRequestCompressionType(req);
     switch (compression_type) {
       case DataCompressor::Type::DEFLATE:
-      case DataCompressor::Type::GZIP: {
-        decompressed_buffer = evbuffer_new();
-        err = DataCompressor::DecompressData(
-            compression_type, req->buffer_in, decompressed_buffer);
+      case DataCompressor::Type::GZIP:
+      case DataCompressor::Type::ZSTD:
+      case DataCompressor::Type::LZ4: {
+        err = DataCompressor::StreamDecompressor::Create(
+            compression_type, req->buffer_in, &decompressor);
         break;
       }
       case DataCompressor::Type::UNKNOWN: {
@@ -2173,8 +2244,13 @@ HTTPAPIServer::HandleInfer(
         // send 415 error with supported types in Accept-Encoding
         evhtp_headers_add_header(
             req->headers_out,
-            evhtp_header_new(kAcceptEncodingHTTPHeader, "gzip, deflate", 1, 1));
+            evhtp_header_new(
+                kAcceptEncodingHTTPHeader,
+                DataCompressor::SupportedEncodings(), 1, 1));
         evhtp_send_reply(req, EVHTP_RES_UNSUPPORTED);
+        if (connection_paused) {
+          evhtp_request_resume(req);
+        }
         return;
       }
       case DataCompressor::Type::IDENTITY:
@@ -2186,9 +2262,15 @@ HTTPAPIServer::HandleInfer(
   // Get the header length
   size_t header_length;
   if (err == nullptr) {
-    // Set to large value in case there is no Content-Length to compare with
+    // Set to large value in case there is no Content-Length to compare
+    // with. The Content-Length doesn't reflect the actual request body
+    // size if compression is used, and the decompressed size is not
+    // known until the body is decompressed. The buffers for the
+    // inference header and the inputs grow as the body is decompressed
+    // and the request is rejected if the body is shorter or longer
+    // than the sizes declared in the request.
     int32_t content_length = INT32_MAX;
-    if (decompressed_buffer == nullptr) {
+    if (decompressor == nullptr) {
       const char* content_length_c_str =
           evhtp_kv_find(req->headers_in, kContentLengthHeader);
       if (content_length_c_str != nullptr) {
@@ -2203,10 +2285,6 @@ HTTPAPIServer::HandleInfer(
                   .c_str());
         }
       }
-    } else {
-      // The Content-Length doesn't reflect the actual request body size
-      // if compression is used, set 'content_length' to the decompressed size
-      content_length = evbuffer_get_length(decompressed_buffer);
     }
 
     if (err == nullptr) {
@@ -2223,17 +2301,24 @@ HTTPAPIServer::HandleInfer(
     infer_request->trace_id_ = trace_id;
 #endif  // TRITON_ENABLE_TRACING
 
+    std::vector<SharedMemoryManager::Lease> shm_leases;
     if (err == nullptr) {
       err = EVBufferToInput(
-          model_name, irequest,
-          (decompressed_buffer == nullptr) ? req->buffer_in
-                                           : decompressed_buffer,
-          infer_request.get(), header_length);
+          model_name, irequest, req->buffer_in, decompressor.get(),
+          infer_request.get(), header_length, &shm_leases);
     }
+
+    // The shared memory regions used by the inputs must remain valid
+    // until the request is released, and the request must not be
+    // cancelled after it is released.
+    auto cancellable_request = std::make_shared<CancellableRequest>(irequest);
+    std::unique_ptr<RequestReleasePayload> release_payload(
+        new RequestReleasePayload(std::move(shm_leases), cancellable_request));
+
     if (err == nullptr) {
       err = TRITONSERVER_InferenceRequestSetReleaseCallback(
           irequest, InferRequestClass::InferRequestComplete,
-          decompressed_buffer);
+          release_payload.get());
       if (err == nullptr) {
         err = TRITONSERVER_InferenceRequestSetResponseCallback(
             irequest, allocator_,
@@ -2245,7 +2330,9 @@ HTTPAPIServer::HandleInfer(
         err = TRITONSERVER_ServerInferAsync(server_.get(), irequest, trace);
       }
       if (err == nullptr) {
+        infer_request->CancelOnDisconnect(cancellable_request);
         infer_request.release();
+        release_payload.release();
       }
     }
   }
@@ -2268,6 +2355,37 @@ HTTPAPIServer::HandleInfer(
   }
 }
 
+void
+HTTPAPIServer::OnDemandLoadComplete(TRITONSERVER_Error* error, void* userp)
+{
+  // Called from the thread that loaded the model, the request must be
+  // handled by its evhtp thread.
+  OnDemandLoad* load = reinterpret_cast<OnDemandLoad*>(userp);
+  load->err_ = error;
+  evthr_defer(load->thread_, OnDemandLoadCallback, load);
+}
+
+void
+HTTPAPIServer::OnDemandLoadCallback(evthr_t* thr, void* arg, void* shared)
+{
+  std::unique_ptr<OnDemandLoad> load(reinterpret_cast<OnDemandLoad*>(arg));
+  evhtp_request_t* req = load->req_;
+  if (load->err_ != nullptr) {
+    LOG_VERBOSE(1) << "Infer failed: " << TRITONSERVER_ErrorMessage(load->err_);
+    evhtp_headers_add_header(
+        req->headers_out,
+        evhtp_header_new(kContentTypeHeader, "application/json", 1, 1));
+    EVBufferAddErrorJson(req->buffer_out, load->err_);
+    evhtp_send_reply(req, EVHTP_RES_BADREQ);
+    evhtp_request_resume(req);
+    TRITONSERVER_ErrorDelete(load->err_);
+    return;
+  }
+
+  load->server_->HandleInfer(
+      req, load->model_name_, load->model_version_str_, true /* paused */);
+}
+
 void
 HTTPAPIServer::OKReplyCallback(evthr_t* thr, void* arg, void* shared)
 {
@@ -2320,15 +2438,82 @@ HTTPAPIServer::BADReplyCallback(evthr_t* thr, void* arg, void* shared)
 
 HTTPAPIServer::InferRequestClass::InferRequestClass(
     TRITONSERVER_Server* server, evhtp_request_t* req,
-    DataCompressor::Type response_compression_type)
-    : server_(server), req_(req),
-      response_compression_type_(response_compression_type), response_count_(0)
+    DataCompressor::Type response_compression_type,
+    const DataCompressor::Options& compression_options)
+    : server_(server), req_(req), disconnect_event_(nullptr),
+      response_compression_type_(response_compression_type),
+      compression_options_(compression_options), response_count_(0)
 {
   evhtp_connection_t* htpconn = evhtp_request_get_connection(req);
   thread_ = htpconn->thread;
   evhtp_request_pause(req);
 }
 
+HTTPAPIServer::InferRequestClass::~InferRequestClass()
+{
+  // The object is deleted by the evhtp thread of the request, the same
+  // thread that runs 'disconnect_event_', so the event can't be
+  // running.
+  if (disconnect_event_ != nullptr) {
+    event_free(disconnect_event_);
+  }
+}
+
+void
+HTTPAPIServer::InferRequestClass::CancelOnDisconnect(
+    const std::shared_ptr<CancellableRequest>& cancellable_request)
+{
+  // evhtp doesn't read from the connection while the request is
+  // paused, so it doesn't notice that the client disconnected until
+  // it sends the response. Instead wait for the socket to become
+  // readable, which it does when the connection is closed.
+  evhtp_connection_t* htpconn = evhtp_request_get_connection(req_);
+  cancellable_request_ = cancellable_request;
+  disconnect_event_ = event_new(
+      evthr_get_base(thread_), htpconn->sock, EV_READ, DisconnectCallback,
+      this);
+  if ((disconnect_event_ == nullptr) ||
+      (event_add(disconnect_event_, nullptr) != 0)) {
+    LOG_ERROR << "failed to watch for the client disconnecting, the "
+                 "request won't be cancelled if it does";
+  }
+}
+
+void
+HTTPAPIServer::InferRequestClass::DisconnectCallback(
+    evutil_socket_t sock, short events, void* arg)
+{
+  HTTPAPIServer::InferRequestClass* infer_request =
+      reinterpret_cast<HTTPAPIServer::InferRequestClass*>(arg);
+
+  // The socket is also readable if the client sent the next request
+  // on the connection. Peek so that the data is left for evhtp, and
+  // stop watching since the client is still connected.
+  char byte;
+  ssize_t cnt;
+  do {
+    cnt = recv(sock, &byte, 1, MSG_PEEK);
+  } while ((cnt < 0) && (errno == EINTR));
+
+  if ((cnt < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+    event_add(infer_request->disconnect_event_, nullptr);
+  } else if (cnt < 0) {
+    LOG_VERBOSE(1) << "client connection failed: " << strerror(errno)
+                   << ", cancelling HTTP/REST inference request";
+    infer_request->cancellable_request_->Cancel();
+  } else if (cnt == 0) {
+    // The client shut down its side of the connection. A client that
+    // only half-closed the connection and still waits for the
+    // response can't be told apart from one that closed it until the
+    // response is written, the hangup reported by EPOLLRDHUP is the
+    // same end of file. Treat both as a disconnect, half-closing
+    // clients are not supported.
+    LOG_VERBOSE(1) << "client closed the connection, cancelling HTTP/REST "
+                      "inference request";
+    infer_request->cancellable_request_->Cancel();
+  }
+}
+
 void
 HTTPAPIServer::InferRequestClass::InferRequestComplete(
     TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
@@ -2337,12 +2522,13 @@ HTTPAPIServer::InferRequestClass::InferRequestComplete(
   // delete it here.
 
   if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
-    if (userp != nullptr) {
-      evbuffer_free(reinterpret_cast<evbuffer*>(userp));
-    }
+    RequestReleasePayload* release_payload =
+        reinterpret_cast<RequestReleasePayload*>(userp);
+    release_payload->cancellable_request_->Release();
     LOG_TRITONSERVER_ERROR(
         TRITONSERVER_InferenceRequestDelete(request),
         "deleting HTTP/REST inference request");
+    delete release_payload;
   }
 }
 
@@ -2625,13 +2811,22 @@ HTTPAPIServer::InferRequestClass::FinalizeResponse(
     }
   }
 
+  // Small responses are sent uncompressed, the saving in bytes on the
+  // wire doesn't pay for the compression time.
   evbuffer* response_body = response_placeholder;
+  if (evbuffer_get_length(response_placeholder) <
+      compression_options_.threshold_byte_size_) {
+    response_compression_type_ = DataCompressor::Type::IDENTITY;
+  }
   switch (response_compression_type_) {
     case DataCompressor::Type::DEFLATE:
-    case DataCompressor::Type::GZIP: {
+    case DataCompressor::Type::GZIP:
+    case DataCompressor::Type::ZSTD:
+    case DataCompressor::Type::LZ4: {
       auto compressed_buffer = evbuffer_new();
       auto err = DataCompressor::CompressData(
-          response_compression_type_, response_placeholder, compressed_buffer);
+          response_compression_type_, response_placeholder, compressed_buffer,
+          compression_options_.Level(response_compression_type_));
       if (err == nullptr) {
         response_body = compressed_buffer;
         evbuffer_free(response_placeholder);
@@ -2679,14 +2874,14 @@ HTTPAPIServer::InferRequestClass::SetResponseHeader(
 
   switch (response_compression_type_) {
     case DataCompressor::Type::DEFLATE:
-      evhtp_headers_add_header(
-          req_->headers_out,
-          evhtp_header_new(kContentEncodingHTTPHeader, "deflate", 1, 1));
-      break;
     case DataCompressor::Type::GZIP:
+    case DataCompressor::Type::ZSTD:
+    case DataCompressor::Type::LZ4:
       evhtp_headers_add_header(
           req_->headers_out,
-          evhtp_header_new(kContentEncodingHTTPHeader, "gzip", 1, 1));
+          evhtp_header_new(
+              kContentEncodingHTTPHeader,
+              DataCompressor::TypeString(response_compression_type_), 1, 1));
       break;
     case DataCompressor::Type::IDENTITY:
     case DataCompressor::Type::UNKNOWN:
@@ -2786,10 +2981,14 @@ HTTPAPIServer::Create(
     const std::shared_ptr<TRITONSERVER_Server>& server,
     nvidia::inferenceserver::TraceManager* trace_manager,
     const std::shared_ptr<SharedMemoryManager>& shm_manager, const int32_t port,
-    const int thread_cnt, std::unique_ptr<HTTPServer>* http_server)
+    const int thread_cnt, const DataCompressor::Options& compression_options,
+    std::unique_ptr<HTTPServer>* http_server)
 {
-  http_server->reset(
-      new HTTPAPIServer(server, trace_manager, shm_manager, port, thread_cnt));
+  RETURN_IF_ERR(DataCompressor::ValidateOptions(compression_options));
+
+  http_server->reset(new HTTPAPIServer(
+      server, trace_manager, shm_manager, port, thread_cnt,
+      compression_options));
 
   const std::string addr = "0.0.0.0:" + std::to_string(port);
   LOG_INFO << "Started HTTPService at " << addr;
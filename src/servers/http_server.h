@@ -110,6 +110,7 @@ class HTTPAPIServer : public HTTPServer {
       nvidia::inferenceserver::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& smb_manager,
       const int32_t port, const int thread_cnt,
+      const DataCompressor::Options& compression_options,
       std::unique_ptr<HTTPServer>* http_server);
 
   virtual ~HTTPAPIServer();
@@ -132,15 +133,18 @@ class HTTPAPIServer : public HTTPServer {
       }
 
       // For shared memory
-      OutputInfo(void* b, uint64_t s, TRITONSERVER_MemoryType m, int64_t i)
+      OutputInfo(
+          void* b, uint64_t s, TRITONSERVER_MemoryType m, int64_t i,
+          SharedMemoryManager::Lease&& l)
           : kind_(SHM), base_(b), byte_size_(s), memory_type_(m), device_id_(i),
-            evbuffer_(nullptr)
+            lease_(std::move(l)), evbuffer_(nullptr)
       {
       }
       void* base_;
       uint64_t byte_size_;
       TRITONSERVER_MemoryType memory_type_;
       int64_t device_id_;
+      SharedMemoryManager::Lease lease_;
 
       // For non-shared memory
       OutputInfo(Kind k, uint32_t class_cnt)
@@ -163,6 +167,48 @@ class HTTPAPIServer : public HTTPServer {
     AllocPayload::OutputInfo::Kind default_output_kind_;
   };
 
+  // Resources used by the inputs of an inference request that must
+  // remain valid until the request is released.
+  struct RequestReleasePayload {
+    RequestReleasePayload(
+        std::vector<SharedMemoryManager::Lease>&& leases,
+        const std::shared_ptr<CancellableRequest>& cancellable_request)
+        : shm_leases_(std::move(leases)),
+          cancellable_request_(cancellable_request)
+    {
+    }
+
+    // Leases on the shared memory regions used by the inputs.
+    std::vector<SharedMemoryManager::Lease> shm_leases_;
+
+    // The request, which is cancelled if the client disconnects and
+    // must not be cancelled once it is released.
+    std::shared_ptr<CancellableRequest> cancellable_request_;
+  };
+
+  // An inference request that is set aside while the model it is for
+  // is loaded on demand, see HandleInfer().
+  struct OnDemandLoad {
+    OnDemandLoad(
+        HTTPAPIServer* server, evhtp_request_t* req,
+        const std::string& model_name, const std::string& model_version_str)
+        : server_(server), req_(req),
+          thread_(evhtp_request_get_connection(req)->thread),
+          model_name_(model_name), model_version_str_(model_version_str),
+          err_(nullptr)
+    {
+    }
+
+    HTTPAPIServer* server_;
+    evhtp_request_t* req_;
+    evthr_t* thread_;
+    const std::string model_name_;
+    const std::string model_version_str_;
+
+    // The result of the load.
+    TRITONSERVER_Error* err_;
+  };
+
   // Object associated with an inference request. This persists
   // information needed for the request and records the evhtp thread
   // that is bound to the request. This same thread must be used to
@@ -171,11 +217,18 @@ class HTTPAPIServer : public HTTPServer {
    public:
     explicit InferRequestClass(
         TRITONSERVER_Server* server, evhtp_request_t* req,
-        DataCompressor::Type response_compression_type);
-    virtual ~InferRequestClass() = default;
+        DataCompressor::Type response_compression_type,
+        const DataCompressor::Options& compression_options);
+    virtual ~InferRequestClass();
 
     evhtp_request_t* EvHtpRequest() const { return req_; }
 
+    // Cancel 'cancellable_request' if the client closes the
+    // connection before the response is sent. Must be called after
+    // the request is submitted for inference.
+    void CancelOnDisconnect(
+        const std::shared_ptr<CancellableRequest>& cancellable_request);
+
     static void InferRequestComplete(
         TRITONSERVER_InferenceRequest* request, const uint32_t flags,
         void* userp);
@@ -205,11 +258,21 @@ class HTTPAPIServer : public HTTPServer {
     std::list<std::vector<char>> serialized_data_;
 
    protected:
+    static void DisconnectCallback(
+        evutil_socket_t sock, short events, void* arg);
+
     TRITONSERVER_Server* server_;
     evhtp_request_t* req_;
     evthr_t* thread_;
 
+    // The event on the connection socket that is used to detect that
+    // the client disconnected while the request is paused, and the
+    // request to cancel then.
+    struct event* disconnect_event_;
+    std::shared_ptr<CancellableRequest> cancellable_request_;
+
     DataCompressor::Type response_compression_type_;
+    const DataCompressor::Options compression_options_;
 
     // Counter to keep track of number of responses generated.
     std::atomic<uint32_t> response_count_;
@@ -220,13 +283,15 @@ class HTTPAPIServer : public HTTPServer {
       const std::shared_ptr<TRITONSERVER_Server>& server,
       nvidia::inferenceserver::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& shm_manager,
-      const int32_t port, const int thread_cnt);
+      const int32_t port, const int thread_cnt,
+      const DataCompressor::Options& compression_options);
   virtual void Handle(evhtp_request_t* req) override;
   virtual std::unique_ptr<InferRequestClass> CreateInferRequest(
       evhtp_request_t* req)
   {
     return std::unique_ptr<InferRequestClass>(new InferRequestClass(
-        server_.get(), req, GetResponseCompressionType(req)));
+        server_.get(), req, GetResponseCompressionType(req),
+        compression_options_));
   }
 
   // Helper function to retrieve infer request header in the form specified by
@@ -260,9 +325,11 @@ class HTTPAPIServer : public HTTPServer {
   void HandleModelConfig(
       evhtp_request_t* req, const std::string& model_name,
       const std::string& model_version_str);
+  // 'paused' is true if 'req' is already paused, in which case it is
+  // resumed once the reply is sent.
   void HandleInfer(
       evhtp_request_t* req, const std::string& model_name,
-      const std::string& model_version_str);
+      const std::string& model_version_str, const bool paused = false);
   void HandleModelStats(
       evhtp_request_t* req, const std::string& model_name = "",
       const std::string& model_version_str = "");
@@ -278,11 +345,18 @@ class HTTPAPIServer : public HTTPServer {
       evhtp_request_t* req, const std::string& region_name,
       const std::string& action);
 
+  // Extract the inference header and the inputs from 'input_buffer'.
+  // If 'decompressor' is not nullptr the body is compressed and is
+  // decompressed through 'decompressor' as it is parsed.
   TRITONSERVER_Error* EVBufferToInput(
       const std::string& model_name, TRITONSERVER_InferenceRequest* irequest,
-      evbuffer* input_buffer, InferRequestClass* infer_req,
-      size_t header_length);
+      evbuffer* input_buffer,
+      DataCompressor::StreamDecompressor* decompressor,
+      InferRequestClass* infer_req, size_t header_length,
+      std::vector<SharedMemoryManager::Lease>* shm_leases);
 
+  static void OnDemandLoadComplete(TRITONSERVER_Error* error, void* userp);
+  static void OnDemandLoadCallback(evthr_t* thr, void* arg, void* shared);
   static void OKReplyCallback(evthr_t* thr, void* arg, void* shared);
   static void BADReplyCallback(evthr_t* thr, void* arg, void* shared);
 
@@ -295,6 +369,10 @@ class HTTPAPIServer : public HTTPServer {
   TraceManager* trace_manager_;
   std::shared_ptr<SharedMemoryManager> shm_manager_;
 
+  // Compression levels and the response size threshold for the
+  // encodings negotiated with the client.
+  const DataCompressor::Options compression_options_;
+
   // The allocator that will be used to allocate buffers for the
   // inference result tensors.
   TRITONSERVER_ResponseAllocator* allocator_;
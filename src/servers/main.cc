@@ -43,6 +43,7 @@
 #endif  // TRITON_ENABLE_ASAN
 
 #include "src/core/logging.h"
+#include "src/core/tritonserver_ext.h"
 #include "src/servers/common.h"
 #include "src/servers/shared_memory_manager.h"
 #include "src/servers/tracer.h"
@@ -57,6 +58,9 @@
 #ifdef TRITON_ENABLE_GRPC
 #include "src/servers/grpc_server.h"
 #endif  // TRITON_ENABLE_GRPC
+#ifdef TRITON_ENABLE_SHM_RING
+#include "src/servers/shm_ring_server.h"
+#endif  // TRITON_ENABLE_SHM_RING
 
 #ifdef TRITON_ENABLE_GPU
 static_assert(
@@ -86,6 +90,13 @@ bool sagemaker_safe_range_set_ = false;
 std::pair<int32_t, int32_t> sagemaker_safe_range_ = {0, 0};
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#ifdef TRITON_ENABLE_SHM_RING
+std::unique_ptr<nvidia::inferenceserver::ShmRingServer> shm_ring_service_;
+bool allow_shm_ring_ = true;
+std::string shm_ring_name_ = "/triton_shm_ring";
+int32_t shm_ring_slot_count_ = 64;
+#endif  // TRITON_ENABLE_SHM_RING
+
 #ifdef TRITON_ENABLE_GRPC
 std::unique_ptr<nvidia::inferenceserver::GRPCServer> grpc_service_;
 bool allow_grpc_ = true;
@@ -109,6 +120,8 @@ std::string trace_filepath_;
 TRITONSERVER_InferenceTraceLevel trace_level_ =
     TRITONSERVER_TRACE_LEVEL_DISABLED;
 int32_t trace_rate_ = 1000;
+nvidia::inferenceserver::TraceFormat trace_format_ =
+    nvidia::inferenceserver::TraceFormat::JSON;
 #endif  // TRITON_ENABLE_TRACING
 
 #if defined(TRITON_ENABLE_GRPC)
@@ -122,6 +135,10 @@ int grpc_infer_allocation_pool_size_ = 8;
 #if defined(TRITON_ENABLE_HTTP)
 // The number of threads to initialize for the HTTP front-end.
 int http_thread_cnt_ = 8;
+
+// The compression levels and the response size threshold for the
+// encodings negotiated with HTTP clients.
+nvidia::inferenceserver::DataCompressor::Options http_compression_options_;
 #endif  // TRITON_ENABLE_HTTP
 
 
@@ -202,6 +219,8 @@ enum OptionId {
   OPTION_LOG_INFO,
   OPTION_LOG_WARNING,
   OPTION_LOG_ERROR,
+  OPTION_LOG_FILE,
+  OPTION_LOG_ASYNC_QUEUE_SIZE,
 #endif  // TRITON_ENABLE_LOGGING
   OPTION_ID,
   OPTION_MODEL_REPOSITORY,
@@ -212,6 +231,8 @@ enum OptionId {
   OPTION_ALLOW_HTTP,
   OPTION_HTTP_PORT,
   OPTION_HTTP_THREAD_COUNT,
+  OPTION_HTTP_COMPRESSION_LEVEL,
+  OPTION_HTTP_COMPRESSION_THRESHOLD,
 #endif  // TRITON_ENABLE_HTTP
 #if defined(TRITON_ENABLE_GRPC)
   OPTION_ALLOW_GRPC,
@@ -236,15 +257,22 @@ enum OptionId {
   OPTION_SAGEMAKER_SAFE_PORT_RANGE,
   OPTION_SAGEMAKER_THREAD_COUNT,
 #endif  // TRITON_ENABLE_SAGEMAKER
+#if defined(TRITON_ENABLE_SHM_RING)
+  OPTION_ALLOW_SHM_RING,
+  OPTION_SHM_RING_NAME,
+  OPTION_SHM_RING_SLOT_COUNT,
+#endif  // TRITON_ENABLE_SHM_RING
 #ifdef TRITON_ENABLE_METRICS
   OPTION_ALLOW_METRICS,
   OPTION_ALLOW_GPU_METRICS,
   OPTION_METRICS_PORT,
+  OPTION_METRICS_LATENCY_BUCKETS,
 #endif  // TRITON_ENABLE_METRICS
 #ifdef TRITON_ENABLE_TRACING
   OPTION_TRACE_FILEPATH,
   OPTION_TRACE_LEVEL,
   OPTION_TRACE_RATE,
+  OPTION_TRACE_FORMAT,
 #endif  // TRITON_ENABLE_TRACING
   OPTION_MODEL_CONTROL_MODE,
   OPTION_POLL_REPO_SECS,
@@ -255,6 +283,16 @@ enum OptionId {
   OPTION_EXIT_TIMEOUT_SECS,
   OPTION_BACKEND_DIR,
   OPTION_REPOAGENT_DIR,
+  OPTION_LOCALIZE_CACHE_DIR,
+  OPTION_LOCALIZE_CACHE_BYTE_SIZE,
+  OPTION_RESPONSE_CACHE_BYTE_SIZE,
+  OPTION_MODEL_LOAD_ON_DEMAND,
+  OPTION_MODEL_RESIDENCY_MAX_MODELS,
+  OPTION_MODEL_RESIDENCY_HOST_MEMORY_BYTE_SIZE,
+  OPTION_MODEL_RESIDENCY_GPU_MEMORY_BYTE_SIZE,
+  OPTION_MODEL_INSTANCE_INIT_CONCURRENCY,
+  OPTION_SHARED_CPU_EXECUTOR,
+  OPTION_SHARED_CPU_EXECUTOR_THREAD_COUNT,
   OPTION_BUFFER_MANAGER_THREAD_COUNT,
   OPTION_BACKEND_CONFIG,
   OPTION_HOST_POLICY
@@ -300,6 +338,16 @@ std::vector<Option> options_
        "Enable/disable warning-level logging."},
       {OPTION_LOG_ERROR, "log-error", Option::ArgBool,
        "Enable/disable error-level logging."},
+      {OPTION_LOG_FILE, "log-file", Option::ArgStr,
+       "Append log messages to the specified file instead of writing them "
+       "to stderr."},
+      {OPTION_LOG_ASYNC_QUEUE_SIZE, "log-async-queue-size", Option::ArgInt,
+       "The number of log messages that can be queued for a background "
+       "thread to write. Log messages are dropped, and the number of "
+       "dropped messages is logged, when the queue is full. Use this to "
+       "enable verbose logging without slowing down the threads handling "
+       "inference requests. Default is 0, which writes each message "
+       "synchronously."},
 #endif  // TRITON_ENABLE_LOGGING
       {OPTION_ID, "id", Option::ArgStr, "Identifier for this server."},
       {OPTION_MODEL_REPOSITORY, "model-store", Option::ArgStr,
@@ -328,6 +376,18 @@ std::vector<Option> options_
        "The port for the server to listen on for HTTP requests."},
       {OPTION_HTTP_THREAD_COUNT, "http-thread-count", Option::ArgInt,
        "Number of threads handling HTTP requests."},
+      {OPTION_HTTP_COMPRESSION_LEVEL, "http-compression-level",
+       "<string>:<integer>",
+       "The compression level used for an encoding when compressing HTTP "
+       "responses, specified as <encoding>:<level>. The encoding may be "
+       "gzip (also applies to deflate), zstd or lz4, the latter two only if "
+       "the server was built with them. This option can be used multiple "
+       "times. By default, each codec uses its own default level."},
+      {OPTION_HTTP_COMPRESSION_THRESHOLD, "http-compression-threshold",
+       Option::ArgInt,
+       "HTTP responses smaller than this byte size are sent uncompressed "
+       "even if the client accepts a compressed encoding. Default is 0, "
+       "which compresses every response."},
 #endif  // TRITON_ENABLE_HTTP
 #if defined(TRITON_ENABLE_GRPC)
       {OPTION_ALLOW_GRPC, "allow-grpc", Option::ArgBool,
@@ -403,6 +463,17 @@ std::vector<Option> options_
       {OPTION_SAGEMAKER_THREAD_COUNT, "sagemaker-thread-count", Option::ArgInt,
        "Number of threads handling Sagemaker requests."},
 #endif  // TRITON_ENABLE_SAGEMAKER
+#if defined(TRITON_ENABLE_SHM_RING)
+      {OPTION_ALLOW_SHM_RING, "allow-shm-ring", Option::ArgBool,
+       "Allow clients on the same host to submit inference requests through "
+       "a shared-memory request ring."},
+      {OPTION_SHM_RING_NAME, "shm-ring-name", Option::ArgStr,
+       "The name of the POSIX shared memory object that holds the request "
+       "ring. Default is /triton_shm_ring."},
+      {OPTION_SHM_RING_SLOT_COUNT, "shm-ring-slot-count", Option::ArgInt,
+       "The number of requests that can be in flight in the shared-memory "
+       "request ring at once. Must be a power of 2. Default is 64."},
+#endif  // TRITON_ENABLE_SHM_RING
 #ifdef TRITON_ENABLE_METRICS
       {OPTION_ALLOW_METRICS, "allow-metrics", Option::ArgBool,
        "Allow the server to provide prometheus metrics."},
@@ -411,6 +482,12 @@ std::vector<Option> options_
        "--allow-metrics is true."},
       {OPTION_METRICS_PORT, "metrics-port", Option::ArgInt,
        "The port reporting prometheus metrics."},
+      {OPTION_METRICS_LATENCY_BUCKETS, "metrics-latency-buckets",
+       Option::ArgStr,
+       "Comma-separated list of the bucket boundaries, in microseconds, of "
+       "the request, queue and compute latency histograms reported for each "
+       "model. Use 'none' to disable the latency histograms. Default is "
+       "'100,500,1000,5000,10000,50000,100000,500000,1000000'."},
 #endif  // TRITON_ENABLE_METRICS
 #ifdef TRITON_ENABLE_TRACING
       {OPTION_TRACE_FILEPATH, "trace-file", Option::ArgStr,
@@ -420,6 +497,12 @@ std::vector<Option> options_
        "MAX for maximal tracing. Default is OFF."},
       {OPTION_TRACE_RATE, "trace-rate", Option::ArgInt,
        "Set the trace sampling rate. Default is 1000."},
+      {OPTION_TRACE_FORMAT, "trace-format", Option::ArgStr,
+       "Set the format of the trace file. JSON writes the trace as a JSON "
+       "array. BINARY buffers fixed-size trace records per thread and writes "
+       "them from a background thread, use trace_convert to convert the "
+       "result to JSON. CHROME writes the Chrome trace-event format that can "
+       "be loaded into Perfetto or chrome://tracing. Default is JSON."},
 #endif  // TRITON_ENABLE_TRACING
       {OPTION_MODEL_CONTROL_MODE, "model-control-mode", Option::ArgStr,
        "Specify the mode for model management. Options are \"none\", \"poll\" "
@@ -474,6 +557,68 @@ std::vector<Option> options_
       {OPTION_REPOAGENT_DIR, "repoagent-directory", Option::ArgStr,
        "The global directory searched for repository agent shared libraries. "
        "Default is '/opt/tritonserver/repoagents'."},
+      {OPTION_LOCALIZE_CACHE_DIR, "model-localize-cache-directory",
+       Option::ArgStr,
+       "The local directory used to cache the files downloaded when loading "
+       "models from cloud storage. Cached files are identified by the content "
+       "hash reported by the storage service, so reloading a model or "
+       "restarting the server only downloads files that have changed. The "
+       "cache is disabled if not specified."},
+      {OPTION_LOCALIZE_CACHE_BYTE_SIZE, "model-localize-cache-byte-size",
+       Option::ArgInt,
+       "The total byte size of the files kept in the model localize cache. "
+       "Least recently used files are removed from the cache when this size "
+       "is exceeded. Default is 16 GB."},
+      {OPTION_RESPONSE_CACHE_BYTE_SIZE, "response-cache-byte-size",
+       Option::ArgInt,
+       "The total byte size of the inference responses kept in the response "
+       "cache. The cache is shared by the models that enable it with the "
+       "'response_cache' model configuration parameter. Least recently used "
+       "responses are removed from the cache when this size is exceeded. "
+       "Default is 0, which disables the response cache."},
+      {OPTION_MODEL_LOAD_ON_DEMAND, "model-load-on-demand", Option::ArgBool,
+       "Load a model when it receives its first request instead of "
+       "requiring an explicit load request. The request waits until the "
+       "model is loaded. Requires --model-control-mode=explicit. Default "
+       "is false."},
+      {OPTION_MODEL_RESIDENCY_MAX_MODELS, "model-residency-max-models",
+       Option::ArgInt,
+       "The maximum number of models that are loaded at the same time when "
+       "loading models on demand. Least recently used models are unloaded "
+       "when a model load exceeds the limit. Default is 0, which does not "
+       "limit the number of models."},
+      {OPTION_MODEL_RESIDENCY_HOST_MEMORY_BYTE_SIZE,
+       "model-residency-host-memory-byte-size", Option::ArgInt,
+       "The total byte size of host memory that loaded models may use when "
+       "loading models on demand. A model's size is the increase in host "
+       "memory measured while it was loading. Least recently used models "
+       "are unloaded when a model load exceeds the limit. Default is 0, "
+       "which does not limit host memory."},
+      {OPTION_MODEL_RESIDENCY_GPU_MEMORY_BYTE_SIZE,
+       "model-residency-gpu-memory-byte-size", Option::ArgInt,
+       "The total byte size of GPU memory, summed over all GPUs, that loaded "
+       "models may use when loading models on demand. A model's size is the "
+       "increase in GPU memory measured while it was loading. Least "
+       "recently used models are unloaded when a model load exceeds the "
+       "limit. Default is 0, which does not limit GPU memory."},
+      {OPTION_MODEL_INSTANCE_INIT_CONCURRENCY,
+       "model-instance-init-concurrency", Option::ArgInt,
+       "The maximum number of instances of a model that are initialized "
+       "concurrently when the model is loaded. A model can override the "
+       "value with the 'instance_init_concurrency' model configuration "
+       "parameter, and backends whose instance initialization is not "
+       "thread-safe always initialize one instance at a time. Default is 1."},
+      {OPTION_SHARED_CPU_EXECUTOR, "shared-cpu-executor", Option::ArgBool,
+       "Execute the instances of models that only have CPU instances on a "
+       "pool of threads shared by all such models instead of on a dedicated "
+       "thread for each instance. A model can opt out with the "
+       "'dedicated_scheduler_threads' model configuration parameter. "
+       "Sequence batched models always use dedicated threads. Default is "
+       "false."},
+      {OPTION_SHARED_CPU_EXECUTOR_THREAD_COUNT,
+       "shared-cpu-executor-thread-count", Option::ArgInt,
+       "The number of threads of the shared CPU executor. Default is 0, "
+       "which creates a thread for each CPU core."},
       {OPTION_BUFFER_MANAGER_THREAD_COUNT, "buffer-manager-thread-count",
        Option::ArgInt,
        "The number of threads used to accelerate copies and other operations "
@@ -618,7 +763,7 @@ StartHttpService(
 {
   TRITONSERVER_Error* err = nvidia::inferenceserver::HTTPAPIServer::Create(
       server, trace_manager, shm_manager, http_port_, http_thread_cnt_,
-      service);
+      http_compression_options_, service);
   if (err == nullptr) {
     err = (*service)->Start();
   }
@@ -674,6 +819,28 @@ StartSagemakerService(
 }
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#ifdef TRITON_ENABLE_SHM_RING
+TRITONSERVER_Error*
+StartShmRingService(
+    std::unique_ptr<nvidia::inferenceserver::ShmRingServer>* service,
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const std::shared_ptr<nvidia::inferenceserver::SharedMemoryManager>&
+        shm_manager)
+{
+  TRITONSERVER_Error* err = nvidia::inferenceserver::ShmRingServer::Create(
+      server, shm_manager, shm_ring_name_, shm_ring_slot_count_, service);
+  if (err == nullptr) {
+    err = (*service)->Start();
+  }
+
+  if (err != nullptr) {
+    service->reset();
+  }
+
+  return err;
+}
+#endif  // TRITON_ENABLE_SHM_RING
+
 bool
 StartEndpoints(
     const std::shared_ptr<TRITONSERVER_Server>& server,
@@ -718,6 +885,18 @@ StartEndpoints(
   }
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#ifdef TRITON_ENABLE_SHM_RING
+  // Enable the shared-memory request ring if requested...
+  if (allow_shm_ring_) {
+    TRITONSERVER_Error* err =
+        StartShmRingService(&shm_ring_service_, server, shm_manager);
+    if (err != nullptr) {
+      LOG_TRITONSERVER_ERROR(err, "failed to start shared memory ring service");
+      return false;
+    }
+  }
+#endif  // TRITON_ENABLE_SHM_RING
+
 #ifdef TRITON_ENABLE_METRICS
   // Enable metrics endpoint if requested...
   if (allow_metrics_) {
@@ -785,6 +964,18 @@ StopEndpoints()
   }
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#ifdef TRITON_ENABLE_SHM_RING
+  if (shm_ring_service_) {
+    TRITONSERVER_Error* err = shm_ring_service_->Stop();
+    if (err != nullptr) {
+      LOG_TRITONSERVER_ERROR(err, "failed to stop shared memory ring service");
+      ret = false;
+    }
+
+    shm_ring_service_.reset();
+  }
+#endif  // TRITON_ENABLE_SHM_RING
+
   return ret;
 }
 
@@ -799,7 +990,8 @@ StartTracing(nvidia::inferenceserver::TraceManager** trace_manager)
   // Configure tracing if host is specified.
   if (trace_level_ != TRITONSERVER_TRACE_LEVEL_DISABLED) {
     err = nvidia::inferenceserver::TraceManager::Create(
-        trace_manager, trace_level_, trace_rate_, trace_filepath_);
+        trace_manager, trace_level_, trace_rate_, trace_filepath_,
+        trace_format_);
   }
 
   if (err != nullptr) {
@@ -898,6 +1090,13 @@ ParseOption(const std::string& arg)
   return std::stoll(arg);
 }
 
+template <>
+std::string
+ParseOption(const std::string& arg)
+{
+  return arg;
+}
+
 int
 ParseIntOption(const std::string arg)
 {
@@ -967,6 +1166,28 @@ ParseTraceLevelOption(std::string arg)
   std::cerr << Usage() << std::endl;
   exit(1);
 }
+
+nvidia::inferenceserver::TraceFormat
+ParseTraceFormatOption(std::string arg)
+{
+  std::transform(arg.begin(), arg.end(), arg.begin(), [](unsigned char c) {
+    return std::tolower(c);
+  });
+
+  if (arg == "json") {
+    return nvidia::inferenceserver::TraceFormat::JSON;
+  }
+  if (arg == "binary") {
+    return nvidia::inferenceserver::TraceFormat::BINARY;
+  }
+  if (arg == "chrome") {
+    return nvidia::inferenceserver::TraceFormat::CHROME;
+  }
+
+  std::cerr << "invalid value for trace format option: " << arg << std::endl;
+  std::cerr << Usage() << std::endl;
+  exit(1);
+}
 #endif  // TRITON_ENABLE_TRACING
 
 std::tuple<std::string, std::string, std::string>
@@ -1053,6 +1274,19 @@ ParsePairOption(const std::string& arg, const std::string& delim_str)
   return {ParseOption<T1>(first_string), ParseOption<T2>(second_string)};
 }
 
+#ifdef TRITON_ENABLE_LOGGING
+// Write a message of the frontend logger to the server log.
+void
+LogToServer(const char* msg)
+{
+  TRITONSERVER_Error* err = TRITONSERVER_LogServerMessage(msg);
+  if (err != nullptr) {
+    std::cerr << msg << std::endl;
+    TRITONSERVER_ErrorDelete(err);
+  }
+}
+#endif  // TRITON_ENABLE_LOGGING
+
 bool
 Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
 {
@@ -1069,6 +1303,16 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
 
   std::string backend_dir = "/opt/tritonserver/backends";
   std::string repoagent_dir = "/opt/tritonserver/repoagents";
+  std::string localize_cache_dir;
+  int64_t localize_cache_byte_size = 16LL << 30;
+  int64_t response_cache_byte_size = 0;
+  bool model_load_on_demand = false;
+  int64_t model_residency_max_models = 0;
+  int64_t model_residency_host_memory_byte_size = 0;
+  int64_t model_residency_gpu_memory_byte_size = 0;
+  int32_t model_instance_init_concurrency = 1;
+  bool shared_cpu_executor = false;
+  int32_t shared_cpu_executor_thread_count = 0;
   std::vector<std::tuple<std::string, std::string, std::string>>
       backend_config_settings;
   std::vector<std::tuple<std::string, std::string, std::string>> host_policies;
@@ -1082,6 +1326,8 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
 #if defined(TRITON_ENABLE_HTTP)
   int32_t http_port = http_port_;
   int32_t http_thread_cnt = http_thread_cnt_;
+  nvidia::inferenceserver::DataCompressor::Options http_compression_options =
+      http_compression_options_;
 #endif  // TRITON_ENABLE_HTTP
 
 #if defined(TRITON_ENABLE_GRPC)
@@ -1099,15 +1345,22 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   std::pair<int32_t, int32_t> sagemaker_safe_range = sagemaker_safe_range_;
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#if defined(TRITON_ENABLE_SHM_RING)
+  std::string shm_ring_name = shm_ring_name_;
+  int32_t shm_ring_slot_count = shm_ring_slot_count_;
+#endif  // TRITON_ENABLE_SHM_RING
+
 #ifdef TRITON_ENABLE_METRICS
   int32_t metrics_port = metrics_port_;
   bool allow_gpu_metrics = true;
+  std::string metrics_latency_buckets;
 #endif  // TRITON_ENABLE_METRICS
 
 #ifdef TRITON_ENABLE_TRACING
   std::string trace_filepath = trace_filepath_;
   TRITONSERVER_InferenceTraceLevel trace_level = trace_level_;
   int32_t trace_rate = trace_rate_;
+  nvidia::inferenceserver::TraceFormat trace_format = trace_format_;
 #endif  // TRITON_ENABLE_TRACING
 
   TRITONSERVER_ModelControlMode control_mode = TRITONSERVER_MODEL_CONTROL_NONE;
@@ -1118,6 +1371,8 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   bool log_warn = true;
   bool log_error = true;
   int32_t log_verbose = 0;
+  std::string log_file;
+  int32_t log_async_queue_size = 0;
 #endif  // TRITON_ENABLE_LOGGING
 
   std::vector<struct option> long_options;
@@ -1146,6 +1401,12 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_LOG_ERROR:
         log_error = ParseBoolOption(optarg);
         break;
+      case OPTION_LOG_FILE:
+        log_file = optarg;
+        break;
+      case OPTION_LOG_ASYNC_QUEUE_SIZE:
+        log_async_queue_size = ParseIntOption(optarg);
+        break;
 #endif  // TRITON_ENABLE_LOGGING
 
       case OPTION_ID:
@@ -1175,6 +1436,36 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_HTTP_THREAD_COUNT:
         http_thread_cnt = ParseIntOption(optarg);
         break;
+      case OPTION_HTTP_COMPRESSION_LEVEL: {
+        auto level = ParsePairOption<std::string, int>(optarg, ":");
+        switch (nvidia::inferenceserver::DataCompressor::TypeFromString(
+            level.first)) {
+          case nvidia::inferenceserver::DataCompressor::Type::GZIP:
+          case nvidia::inferenceserver::DataCompressor::Type::DEFLATE:
+            http_compression_options.gzip_level_ = level.second;
+            break;
+          case nvidia::inferenceserver::DataCompressor::Type::ZSTD:
+            http_compression_options.zstd_level_ = level.second;
+            break;
+          case nvidia::inferenceserver::DataCompressor::Type::LZ4:
+            http_compression_options.lz4_level_ = level.second;
+            break;
+          case nvidia::inferenceserver::DataCompressor::Type::IDENTITY:
+          case nvidia::inferenceserver::DataCompressor::Type::UNKNOWN:
+            std::cerr << "invalid encoding for --http-compression-level: "
+                      << level.first << ", supported encodings are "
+                      << nvidia::inferenceserver::DataCompressor::
+                             SupportedEncodings()
+                      << std::endl;
+            std::cerr << Usage() << std::endl;
+            return false;
+        }
+        break;
+      }
+      case OPTION_HTTP_COMPRESSION_THRESHOLD:
+        http_compression_options.threshold_byte_size_ =
+            std::max((int64_t)0, ParseLongLongOption(optarg));
+        break;
 #endif  // TRITON_ENABLE_HTTP
 
 #if defined(TRITON_ENABLE_SAGEMAKER)
@@ -1193,6 +1484,18 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
         break;
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#if defined(TRITON_ENABLE_SHM_RING)
+      case OPTION_ALLOW_SHM_RING:
+        allow_shm_ring_ = ParseBoolOption(optarg);
+        break;
+      case OPTION_SHM_RING_NAME:
+        shm_ring_name = optarg;
+        break;
+      case OPTION_SHM_RING_SLOT_COUNT:
+        shm_ring_slot_count = ParseIntOption(optarg);
+        break;
+#endif  // TRITON_ENABLE_SHM_RING
+
 #if defined(TRITON_ENABLE_GRPC)
       case OPTION_ALLOW_GRPC:
         allow_grpc_ = ParseBoolOption(optarg);
@@ -1273,6 +1576,9 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_METRICS_PORT:
         metrics_port = ParseIntOption(optarg);
         break;
+      case OPTION_METRICS_LATENCY_BUCKETS:
+        metrics_latency_buckets = optarg;
+        break;
 #endif  // TRITON_ENABLE_METRICS
 
 #ifdef TRITON_ENABLE_TRACING
@@ -1285,6 +1591,9 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_TRACE_RATE:
         trace_rate = ParseIntOption(optarg);
         break;
+      case OPTION_TRACE_FORMAT:
+        trace_format = ParseTraceFormatOption(optarg);
+        break;
 #endif  // TRITON_ENABLE_TRACING
 
       case OPTION_POLL_REPO_SECS:
@@ -1328,6 +1637,36 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_REPOAGENT_DIR:
         repoagent_dir = optarg;
         break;
+      case OPTION_LOCALIZE_CACHE_DIR:
+        localize_cache_dir = optarg;
+        break;
+      case OPTION_LOCALIZE_CACHE_BYTE_SIZE:
+        localize_cache_byte_size = ParseLongLongOption(optarg);
+        break;
+      case OPTION_RESPONSE_CACHE_BYTE_SIZE:
+        response_cache_byte_size = ParseLongLongOption(optarg);
+        break;
+      case OPTION_MODEL_LOAD_ON_DEMAND:
+        model_load_on_demand = ParseBoolOption(optarg);
+        break;
+      case OPTION_MODEL_RESIDENCY_MAX_MODELS:
+        model_residency_max_models = ParseLongLongOption(optarg);
+        break;
+      case OPTION_MODEL_RESIDENCY_HOST_MEMORY_BYTE_SIZE:
+        model_residency_host_memory_byte_size = ParseLongLongOption(optarg);
+        break;
+      case OPTION_MODEL_RESIDENCY_GPU_MEMORY_BYTE_SIZE:
+        model_residency_gpu_memory_byte_size = ParseLongLongOption(optarg);
+        break;
+      case OPTION_MODEL_INSTANCE_INIT_CONCURRENCY:
+        model_instance_init_concurrency = ParseIntOption(optarg);
+        break;
+      case OPTION_SHARED_CPU_EXECUTOR:
+        shared_cpu_executor = ParseBoolOption(optarg);
+        break;
+      case OPTION_SHARED_CPU_EXECUTOR_THREAD_COUNT:
+        shared_cpu_executor_thread_count = ParseIntOption(optarg);
+        break;
       case OPTION_BUFFER_MANAGER_THREAD_COUNT:
         buffer_manager_thread_count = ParseIntOption(optarg);
         break;
@@ -1349,11 +1688,14 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
 #ifdef TRITON_ENABLE_LOGGING
   // Initialize our own logging instance since it is used by GRPC and
   // HTTP endpoints. This logging instance is separate from the one in
-  // libtritonserver so we must initialize explicitly.
+  // libtritonserver so we must initialize explicitly. Its messages are
+  // written by the libtritonserver logger, which owns the log file and
+  // the asynchronous queue, so that the log file is opened only once.
   LOG_ENABLE_INFO(log_info);
   LOG_ENABLE_WARNING(log_warn);
   LOG_ENABLE_ERROR(log_error);
   LOG_SET_VERBOSE(log_verbose);
+  LOG_SET_FORWARD(LogToServer);
 #endif  // TRITON_ENABLE_LOGGING
 
   repository_poll_secs_ = 0;
@@ -1364,6 +1706,7 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
 #if defined(TRITON_ENABLE_HTTP)
   http_port_ = http_port;
   http_thread_cnt_ = http_thread_cnt;
+  http_compression_options_ = http_compression_options;
 #endif  // TRITON_ENABLE_HTTP
 
 #if defined(TRITON_ENABLE_SAGEMAKER)
@@ -1373,6 +1716,11 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   sagemaker_safe_range_ = sagemaker_safe_range;
 #endif  // TRITON_ENABLE_SAGEMAKER
 
+#if defined(TRITON_ENABLE_SHM_RING)
+  shm_ring_name_ = shm_ring_name;
+  shm_ring_slot_count_ = shm_ring_slot_count;
+#endif  // TRITON_ENABLE_SHM_RING
+
 #if defined(TRITON_ENABLE_GRPC)
   grpc_port_ = grpc_port;
   grpc_infer_allocation_pool_size_ = grpc_infer_allocation_pool_size;
@@ -1389,6 +1737,7 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   trace_filepath_ = trace_filepath;
   trace_level_ = trace_level;
   trace_rate_ = trace_rate;
+  trace_format_ = trace_format;
 #endif  // TRITON_ENABLE_TRACING
 
   // Check if HTTP, GRPC and metrics port clash
@@ -1462,6 +1811,13 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   FAIL_IF_ERR(
       TRITONSERVER_ServerOptionsSetLogVerbose(loptions, log_verbose),
       "setting log verbose level");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetLogFile(loptions, log_file.c_str()),
+      "setting log file");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetLogAsyncQueueSize(
+          loptions, std::max(0, log_async_queue_size)),
+      "setting log async queue size");
 #endif  // TRITON_ENABLE_LOGGING
 
 #ifdef TRITON_ENABLE_METRICS
@@ -1471,6 +1827,15 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   FAIL_IF_ERR(
       TRITONSERVER_ServerOptionsSetGpuMetrics(loptions, allow_gpu_metrics),
       "setting GPU metrics enable");
+  // The latency histograms are implemented in the core and so are
+  // configured using the global (unnamed) backend configuration.
+  if (!metrics_latency_buckets.empty()) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "metrics-latency-buckets",
+            metrics_latency_buckets.c_str()),
+        "setting metrics latency buckets");
+  }
 #endif  // TRITON_ENABLE_METRICS
 
   FAIL_IF_ERR(
@@ -1481,6 +1846,70 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       TRITONSERVER_ServerOptionsSetRepoAgentDirectory(
           loptions, repoagent_dir.c_str()),
       "setting repository agent directory");
+  // The localize and response caches are implemented in the core and
+  // so are communicated using the global (unnamed) backend
+  // configuration.
+  if (!localize_cache_dir.empty()) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "localize-cache-directory",
+            localize_cache_dir.c_str()),
+        "setting model localize cache directory");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "localize-cache-byte-size",
+            std::to_string(std::max((int64_t)0, localize_cache_byte_size))
+                .c_str()),
+        "setting model localize cache byte size");
+  }
+  if (response_cache_byte_size > 0) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "response-cache-byte-size",
+            std::to_string(response_cache_byte_size).c_str()),
+        "setting response cache byte size");
+  }
+  if (model_load_on_demand) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "model-load-on-demand", "true"),
+        "setting model load on demand");
+  }
+  const std::vector<std::pair<std::string, int64_t>> residency_limits{
+      {"model-residency-max-models", model_residency_max_models},
+      {"model-residency-host-memory-byte-size",
+       model_residency_host_memory_byte_size},
+      {"model-residency-gpu-memory-byte-size",
+       model_residency_gpu_memory_byte_size}};
+  for (const auto& limit : residency_limits) {
+    if (limit.second > 0) {
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerOptionsSetBackendConfig(
+              loptions, "", limit.first.c_str(),
+              std::to_string(limit.second).c_str()),
+          "setting model residency limit");
+    }
+  }
+  if (model_instance_init_concurrency != 1) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "model-instance-init-concurrency",
+            std::to_string(model_instance_init_concurrency).c_str()),
+        "setting model instance initialization concurrency");
+  }
+  if (shared_cpu_executor) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendConfig(
+            loptions, "", "shared-cpu-executor", "true"),
+        "setting shared CPU executor");
+    if (shared_cpu_executor_thread_count > 0) {
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerOptionsSetBackendConfig(
+              loptions, "", "shared-cpu-executor-thread-count",
+              std::to_string(shared_cpu_executor_thread_count).c_str()),
+          "setting shared CPU executor thread count");
+    }
+  }
   for (const auto& bcs : backend_config_settings) {
     FAIL_IF_ERR(
         TRITONSERVER_ServerOptionsSetBackendConfig(
@@ -0,0 +1,305 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "src/core/backend.h"
+#include "src/core/infer_request.h"
+#include "src/core/scheduler_utils.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Micro-benchmark of the PriorityQueue used by the dynamic batch
+// scheduler. Each benchmark generates a trace of requests, then
+// replays the trace against a queue and reports the number of
+// requests per second. The requests are enqueued in the order of the
+// trace and whenever the queue holds more than the queue depth a
+// batch is formed the way the scheduler does: reset the cursor, apply
+// the queue policy and advance the cursor until the batch is full or
+// the queue is exhausted, then dequeue the requests of the batch. The
+// request objects are created before the replay and reused so that
+// only the queue is measured.
+//
+//   fifo: a single priority level without timeouts.
+//
+//   priority: requests spread over all priority levels, with the
+//   lower levels more likely.
+//
+//   timeout: a single priority level where some requests time out
+//   and are rejected by the queue policy.
+//
+//   edf: a single priority level ordered by timeout, where every
+//   request has a timeout.
+
+struct TraceRequest {
+  uint32_t priority_level_;
+  uint64_t timeout_us_;
+};
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-n <number of requests for each benchmark>, default 1000000"
+            << std::endl;
+  std::cerr << "\t-l <number of priority levels>, default 16" << std::endl;
+  std::cerr << "\t-b <max batch size>, default 8" << std::endl;
+  std::cerr << "\t-q <queue depth>, default 256" << std::endl;
+
+  exit(1);
+}
+
+// Generate a trace of 'count' requests. 'priority_levels' of 0
+// enqueues all requests to the single queue. Every 'timeout_every'
+// request has a timeout in ['min_timeout_us', 'max_timeout_us'], 0
+// means no timeouts.
+std::vector<TraceRequest>
+GenerateTrace(
+    const size_t count, const uint32_t priority_levels,
+    const size_t timeout_every, const uint64_t min_timeout_us,
+    const uint64_t max_timeout_us)
+{
+  std::mt19937_64 rng(count);
+  std::geometric_distribution<uint32_t> level_dist(0.25);
+  std::uniform_int_distribution<uint64_t> timeout_dist(
+      min_timeout_us, max_timeout_us);
+
+  std::vector<TraceRequest> trace(count, TraceRequest{0, 0});
+  for (size_t i = 0; i < count; i++) {
+    if (priority_levels != 0) {
+      trace[i].priority_level_ = 1 + (level_dist(rng) % priority_levels);
+    }
+    if ((timeout_every != 0) && ((i % timeout_every) == 0)) {
+      trace[i].timeout_us_ = timeout_dist(rng);
+    }
+  }
+
+  return trace;
+}
+
+// Form a batch of up to 'max_batch_size' requests from 'queue' and
+// return the requests to 'pool'. Return the number of requests that
+// were rejected by the queue policy.
+size_t
+FormBatch(
+    const size_t max_batch_size, ni::PriorityQueue* queue,
+    std::vector<std::unique_ptr<ni::InferenceRequest>>* pool)
+{
+  queue->ResetCursor();
+  while (queue->PendingBatchCount() < max_batch_size) {
+    queue->ApplyPolicyAtCursor();
+    if (queue->CursorEnd()) {
+      break;
+    }
+    queue->AdvanceCursor();
+  }
+
+  for (size_t cnt = queue->PendingBatchCount(); cnt > 0; cnt--) {
+    std::unique_ptr<ni::InferenceRequest> request;
+    queue->Dequeue(&request);
+    pool->emplace_back(std::move(request));
+  }
+
+  size_t rejected_count = 0;
+  std::shared_ptr<
+      std::vector<std::deque<std::unique_ptr<ni::InferenceRequest>>>>
+      rejected_requests;
+  queue->ReleaseRejectedRequests(&rejected_requests);
+  if (rejected_requests != nullptr) {
+    for (auto& rejected_queue : *rejected_requests) {
+      for (auto& rejected_request : rejected_queue) {
+        pool->emplace_back(std::move(rejected_request));
+        rejected_count++;
+      }
+    }
+  }
+
+  return rejected_count;
+}
+
+// Replay 'trace' against 'queue' using the requests in 'pool', which
+// must have at least as many requests as the trace. Return the number
+// of requests that were rejected by the queue policy.
+size_t
+Replay(
+    const std::vector<TraceRequest>& trace, const size_t depth,
+    const size_t max_batch_size, ni::PriorityQueue* queue,
+    std::vector<std::unique_ptr<ni::InferenceRequest>>* pool)
+{
+  size_t rejected_count = 0;
+  for (const auto& trace_request : trace) {
+    std::unique_ptr<ni::InferenceRequest> request = std::move(pool->back());
+    pool->pop_back();
+    request->SetTimeoutMicroseconds(trace_request.timeout_us_);
+    ni::Status status = queue->Enqueue(trace_request.priority_level_, request);
+    if (!status.IsOk()) {
+      std::cerr << "error: failed to enqueue request: " << status.AsString()
+                << std::endl;
+      exit(1);
+    }
+
+    while (queue->Size() > depth) {
+      rejected_count += FormBatch(max_batch_size, queue, pool);
+    }
+  }
+
+  // Drain the queue.
+  while (!queue->Empty()) {
+    rejected_count += FormBatch(max_batch_size, queue, pool);
+  }
+
+  return rejected_count;
+}
+
+void
+Benchmark(
+    const std::string& name, const std::vector<TraceRequest>& trace,
+    const size_t depth, const size_t max_batch_size, ni::PriorityQueue* queue,
+    std::vector<std::unique_ptr<ni::InferenceRequest>>* pool)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const size_t rejected_count =
+      Replay(trace, depth, max_batch_size, queue, pool);
+  const auto end = std::chrono::steady_clock::now();
+  const double duration_s =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start)
+          .count();
+  std::cout << name << ": " << trace.size() << " requests (" << rejected_count
+            << " rejected) in " << duration_s << " sec, "
+            << (trace.size() / duration_s) << " requests/sec" << std::endl;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  size_t count = 1000000;
+  uint32_t priority_levels = 16;
+  size_t max_batch_size = 8;
+  size_t depth = 256;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "n:l:b:q:")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = std::stoul(optarg);
+        break;
+      case 'l':
+        priority_levels = std::stoul(optarg);
+        break;
+      case 'b':
+        max_batch_size = std::stoul(optarg);
+        break;
+      case 'q':
+        depth = std::stoul(optarg);
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (count == 0) {
+    Usage(argv, "-n must be greater than 0");
+  }
+  if (priority_levels == 0) {
+    Usage(argv, "-l must be greater than 0");
+  }
+  if (max_batch_size == 0) {
+    Usage(argv, "-b must be greater than 0");
+  }
+
+  // The requests are only used by the queue, so they don't need a
+  // loaded model.
+  ni::InferenceBackend backend(0 /* min_compute_capability */);
+  std::vector<std::unique_ptr<ni::InferenceRequest>> pool;
+  for (size_t i = 0; i < count; i++) {
+    pool.emplace_back(new ni::InferenceRequest(&backend, 1 /* version */));
+  }
+
+  inference::ModelQueuePolicy default_policy;
+  ni::ModelQueuePolicyMap queue_policy_map;
+
+  {
+    ni::PriorityQueue queue(
+        default_policy, 0 /* priority_levels */, queue_policy_map,
+        false /* earliest_deadline_first */);
+    Benchmark(
+        "fifo", GenerateTrace(count, 0, 0, 0, 0), depth, max_batch_size,
+        &queue, &pool);
+  }
+
+  {
+    ni::PriorityQueue queue(
+        default_policy, priority_levels, queue_policy_map,
+        false /* earliest_deadline_first */);
+    Benchmark(
+        "priority", GenerateTrace(count, priority_levels, 0, 0, 0), depth,
+        max_batch_size, &queue, &pool);
+  }
+
+  // Every 4th request has a timeout override of a few microseconds,
+  // which most of them exceed while queued.
+  inference::ModelQueuePolicy timeout_policy;
+  timeout_policy.set_allow_timeout_override(true);
+  timeout_policy.set_default_timeout_microseconds(1000000);
+  {
+    ni::PriorityQueue queue(
+        timeout_policy, 0 /* priority_levels */, queue_policy_map,
+        false /* earliest_deadline_first */);
+    Benchmark(
+        "timeout", GenerateTrace(count, 0, 4, 1, 10), depth, max_batch_size,
+        &queue, &pool);
+  }
+
+  {
+    ni::PriorityQueue queue(
+        timeout_policy, 0 /* priority_levels */, queue_policy_map,
+        true /* earliest_deadline_first */);
+    Benchmark(
+        "edf", GenerateTrace(count, 0, 1, 100000, 1000000), depth,
+        max_batch_size, &queue, &pool);
+  }
+
+  return 0;
+}
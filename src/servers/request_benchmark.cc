@@ -0,0 +1,619 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/core/tritonserver_ext.h"
+#include "src/servers/common.h"
+#include "triton/core/tritonserver.h"
+
+namespace {
+
+// Micro-benchmark of the per-request overhead of the in-process
+// API. Each benchmark is run for the configured number of requests
+// against a model with small, fixed-size inputs (for example the
+// 'simple' model) and reports the number of requests per second:
+//
+//   construct: create a request, add the inputs, input data and
+//   requested outputs, and delete the request.
+//
+//   construct + infer: as 'construct' but run inference for each
+//   request, which includes preparing (normalizing) the request.
+//
+//   reuse + infer: run inference with the same request object, so
+//   the request is prepared but does not need to be normalized
+//   again.
+//
+//   template + infer: create each request from a request template
+//   and append the input data, and run inference for the request.
+//
+//   submit: construct groups of requests and submit the requests of
+//   each group one at a time, then wait for the responses of the
+//   group.
+//
+//   submit multiple: as 'submit' but submit the requests of each
+//   group together with TRITONSERVER_ServerInferAsyncMultiple.
+//
+// Use -p to run only one of the benchmarks, for example against a
+// slow model to check how the requests of a group are executed.
+
+struct Tensor {
+  std::string name_;
+  TRITONSERVER_DataType datatype_;
+  std::vector<int64_t> shape_;
+  std::vector<char> data_;
+};
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-m <model name>, default 'simple'" << std::endl;
+  std::cerr << "\t-n <number of requests for each benchmark>, default 100000"
+            << std::endl;
+  std::cerr << "\t-b <number of requests submitted together>, default 8"
+            << std::endl;
+  std::cerr << "\t-p <benchmark to run>, default all" << std::endl;
+  std::cerr << "\t-v Enable verbose logging" << std::endl;
+  std::cerr << "\t-r [model repository absolute path]" << std::endl;
+
+  exit(1);
+}
+
+TRITONSERVER_Error*
+ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  *buffer = (byte_size == 0) ? nullptr : malloc(byte_size);
+  *buffer_userp = nullptr;
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer, void* buffer_userp,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  free(buffer);
+  return nullptr;  // Success
+}
+
+void
+InferRequestDelete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestDelete(request),
+        "deleting inference request");
+    reinterpret_cast<std::atomic<size_t>*>(userp)->fetch_add(1);
+  }
+}
+
+void
+InferRequestKeep(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  // The request is reused so we don't delete it here.
+  if (((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) && (userp != nullptr)) {
+    reinterpret_cast<std::atomic<size_t>*>(userp)->fetch_add(1);
+  }
+}
+
+void
+InferResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  if (response != nullptr) {
+    std::promise<TRITONSERVER_InferenceResponse*>* p =
+        reinterpret_cast<std::promise<TRITONSERVER_InferenceResponse*>*>(userp);
+    p->set_value(response);
+    delete p;
+  }
+}
+
+TRITONSERVER_Error*
+ParseModelMetadata(
+    const rapidjson::Document& model_metadata, std::vector<Tensor>* inputs,
+    std::vector<std::string>* outputs)
+{
+  for (const auto& input : model_metadata["inputs"].GetArray()) {
+    Tensor tensor;
+    tensor.name_ = input["name"].GetString();
+    tensor.datatype_ =
+        TRITONSERVER_StringToDataType(input["datatype"].GetString());
+    const uint32_t element_byte_size =
+        TRITONSERVER_DataTypeByteSize(tensor.datatype_);
+    if (element_byte_size == 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          ("request benchmark doesn't support the data type of input '" +
+           tensor.name_ + "'")
+              .c_str());
+    }
+
+    // Use 1 for variable-size dimensions, including the batch
+    // dimension.
+    size_t element_count = 1;
+    for (const auto& dim : input["shape"].GetArray()) {
+      const int64_t d = (dim.GetInt64() < 0) ? 1 : dim.GetInt64();
+      tensor.shape_.push_back(d);
+      element_count *= d;
+    }
+    tensor.data_.resize(element_count * element_byte_size);
+    inputs->emplace_back(std::move(tensor));
+  }
+
+  for (const auto& output : model_metadata["outputs"].GetArray()) {
+    outputs->emplace_back(output["name"].GetString());
+  }
+
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+NewRequest(
+    TRITONSERVER_Server* server, const std::string& model_name,
+    const std::vector<Tensor>& inputs, const std::vector<std::string>& outputs,
+    TRITONSERVER_InferenceRequestReleaseFn_t release_fn, void* release_userp,
+    TRITONSERVER_InferenceRequest** request)
+{
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestNew(
+      request, server, model_name.c_str(), -1 /* model_version */));
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestSetReleaseCallback(
+      *request, release_fn, release_userp));
+  for (const auto& input : inputs) {
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAddInput(
+        *request, input.name_.c_str(), input.datatype_, input.shape_.data(),
+        input.shape_.size()));
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAppendInputData(
+        *request, input.name_.c_str(), input.data_.data(), input.data_.size(),
+        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
+  }
+  for (const auto& output : outputs) {
+    RETURN_IF_ERR(TRITONSERVER_InferenceRequestAddRequestedOutput(
+        *request, output.c_str()));
+  }
+
+  return nullptr;  // Success
+}
+
+void
+Infer(
+    TRITONSERVER_Server* server, TRITONSERVER_ResponseAllocator* allocator,
+    TRITONSERVER_InferenceRequest* request)
+{
+  auto p = new std::promise<TRITONSERVER_InferenceResponse*>();
+  std::future<TRITONSERVER_InferenceResponse*> completed = p->get_future();
+
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestSetResponseCallback(
+          request, allocator, nullptr /* response_allocator_userp */,
+          InferResponseComplete, reinterpret_cast<void*>(p)),
+      "setting response callback");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerInferAsync(server, request, nullptr /* trace */),
+      "running inference");
+
+  TRITONSERVER_InferenceResponse* response = completed.get();
+  FAIL_IF_ERR(TRITONSERVER_InferenceResponseError(response), "response status");
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceResponseDelete(response),
+      "deleting inference response");
+}
+
+void
+InferGroup(
+    TRITONSERVER_Server* server, TRITONSERVER_ResponseAllocator* allocator,
+    std::vector<TRITONSERVER_InferenceRequest*>& requests, const bool multiple)
+{
+  std::vector<std::future<TRITONSERVER_InferenceResponse*>> completed;
+  for (auto request : requests) {
+    auto p = new std::promise<TRITONSERVER_InferenceResponse*>();
+    completed.emplace_back(p->get_future());
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestSetResponseCallback(
+            request, allocator, nullptr /* response_allocator_userp */,
+            InferResponseComplete, reinterpret_cast<void*>(p)),
+        "setting response callback");
+  }
+
+  if (multiple) {
+    uint32_t submitted_count = 0;
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerInferAsyncMultiple(
+            server, requests.data(), requests.size(), nullptr /* traces */,
+            &submitted_count),
+        "running inference");
+  } else {
+    for (auto request : requests) {
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerInferAsync(server, request, nullptr /* trace */),
+          "running inference");
+    }
+  }
+
+  for (auto& c : completed) {
+    TRITONSERVER_InferenceResponse* response = c.get();
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceResponseError(response), "response status");
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceResponseDelete(response),
+        "deleting inference response");
+  }
+}
+
+void
+Report(
+    const std::string& name, const size_t count,
+    const std::chrono::steady_clock::time_point& start)
+{
+  const auto end = std::chrono::steady_clock::now();
+  const double duration_s =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start)
+          .count();
+  std::cout << name << ": " << count << " requests in " << duration_s
+            << " sec, " << (count / duration_s) << " requests/sec"
+            << std::endl;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string model_repository_path;
+  std::string model_name("simple");
+  size_t count = 100000;
+  size_t group_size = 8;
+  std::string benchmark;
+  int verbose_level = 0;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "vm:n:r:b:p:")) != -1) {
+    switch (opt) {
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'n':
+        count = std::stoul(optarg);
+        break;
+      case 'r':
+        model_repository_path = optarg;
+        break;
+      case 'b':
+        group_size = std::stoul(optarg);
+        break;
+      case 'p':
+        benchmark = optarg;
+        break;
+      case 'v':
+        verbose_level = 1;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (model_repository_path.empty()) {
+    Usage(argv, "-r must be used to specify model repository path");
+  }
+  if (count == 0) {
+    Usage(argv, "-n must be greater than 0");
+  }
+  if (group_size == 0) {
+    Usage(argv, "-b must be greater than 0");
+  }
+  const std::vector<std::string> benchmarks{
+      "construct",        "construct + infer", "reuse + infer",
+      "template + infer", "submit",            "submit multiple"};
+  if (!benchmark.empty() &&
+      (std::find(benchmarks.begin(), benchmarks.end(), benchmark) ==
+       benchmarks.end())) {
+    Usage(argv, "-p must be the name of a benchmark");
+  }
+  auto run = [&benchmark](const std::string& name) {
+    return benchmark.empty() || (benchmark == name);
+  };
+
+  // Create the server...
+  TRITONSERVER_ServerOptions* server_options = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsNew(&server_options),
+      "creating server options");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetModelRepositoryPath(
+          server_options, model_repository_path.c_str()),
+      "setting model repository path");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetLogVerbose(server_options, verbose_level),
+      "setting verbose logging level");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetBackendDirectory(
+          server_options, "/opt/tritonserver/backends"),
+      "setting backend directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetRepoAgentDirectory(
+          server_options, "/opt/tritonserver/repoagents"),
+      "setting repository agent directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetStrictModelConfig(server_options, true),
+      "setting strict model configuration");
+#ifdef TRITON_ENABLE_GPU
+  double min_compute_capability = TRITON_MIN_COMPUTE_CAPABILITY;
+#else
+  double min_compute_capability = 0;
+#endif  // TRITON_ENABLE_GPU
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetMinSupportedComputeCapability(
+          server_options, min_compute_capability),
+      "setting minimum supported CUDA compute capability");
+
+  TRITONSERVER_Server* server_ptr = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerNew(&server_ptr, server_options), "creating server");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsDelete(server_options),
+      "deleting server options");
+
+  std::shared_ptr<TRITONSERVER_Server> server(
+      server_ptr, TRITONSERVER_ServerDelete);
+
+  // Wait for the model to become available.
+  bool is_ready = false;
+  size_t health_iters = 0;
+  while (!is_ready) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerModelIsReady(
+            server.get(), model_name.c_str(), -1 /* model_version */,
+            &is_ready),
+        "unable to get model readiness");
+    if (!is_ready) {
+      if (++health_iters >= 10) {
+        FAIL("model failed to be ready in 10 iterations");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+  }
+
+  std::vector<Tensor> inputs;
+  std::vector<std::string> outputs;
+  {
+    TRITONSERVER_Message* model_metadata_message;
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerModelMetadata(
+            server.get(), model_name.c_str(), -1 /* model_version */,
+            &model_metadata_message),
+        "unable to get model metadata message");
+    const char* buffer;
+    size_t byte_size;
+    FAIL_IF_ERR(
+        TRITONSERVER_MessageSerializeToJson(
+            model_metadata_message, &buffer, &byte_size),
+        "unable to serialize model metadata message");
+
+    rapidjson::Document model_metadata;
+    model_metadata.Parse(buffer, byte_size);
+    if (model_metadata.HasParseError()) {
+      FAIL(
+          "error: failed to parse model metadata from JSON: " +
+          std::string(GetParseError_En(model_metadata.GetParseError())) +
+          " at " + std::to_string(model_metadata.GetErrorOffset()));
+    }
+
+    FAIL_IF_ERR(
+        TRITONSERVER_MessageDelete(model_metadata_message),
+        "deleting model metadata message");
+
+    FAIL_IF_ERR(
+        ParseModelMetadata(model_metadata, &inputs, &outputs),
+        "parsing model metadata");
+  }
+
+  TRITONSERVER_ResponseAllocator* allocator = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &allocator, ResponseAlloc, ResponseRelease, nullptr /* start_fn */),
+      "creating response allocator");
+
+  // Warm up the model and the allocations made by the server.
+  std::atomic<size_t> released(0);
+  const size_t warmup_count = std::min((size_t)100, count);
+  size_t release_count = warmup_count;
+  for (size_t i = 0; i < warmup_count; ++i) {
+    TRITONSERVER_InferenceRequest* irequest = nullptr;
+    FAIL_IF_ERR(
+        NewRequest(
+            server.get(), model_name, inputs, outputs, InferRequestDelete,
+            &released, &irequest),
+        "creating inference request");
+    Infer(server.get(), allocator, irequest);
+  }
+
+  // construct
+  if (run("construct")) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      TRITONSERVER_InferenceRequest* irequest = nullptr;
+      FAIL_IF_ERR(
+          NewRequest(
+              server.get(), model_name, inputs, outputs, InferRequestKeep,
+              nullptr /* release_userp */, &irequest),
+          "creating inference request");
+      FAIL_IF_ERR(
+          TRITONSERVER_InferenceRequestDelete(irequest),
+          "deleting inference request");
+    }
+    Report("construct", count, start);
+  }
+
+  // construct + infer
+  if (run("construct + infer")) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      TRITONSERVER_InferenceRequest* irequest = nullptr;
+      FAIL_IF_ERR(
+          NewRequest(
+              server.get(), model_name, inputs, outputs, InferRequestDelete,
+              &released, &irequest),
+          "creating inference request");
+      Infer(server.get(), allocator, irequest);
+    }
+    Report("construct + infer", count, start);
+    release_count += count;
+  }
+
+  // reuse + infer
+  if (run("reuse + infer")) {
+    std::atomic<size_t> reused(0);
+    TRITONSERVER_InferenceRequest* irequest = nullptr;
+    FAIL_IF_ERR(
+        NewRequest(
+            server.get(), model_name, inputs, outputs, InferRequestKeep,
+            &reused, &irequest),
+        "creating inference request");
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      // The request can only be reused once it is released.
+      while (reused < i) {
+        std::this_thread::yield();
+      }
+      Infer(server.get(), allocator, irequest);
+    }
+    Report("reuse + infer", count, start);
+
+    while (reused < count) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestDelete(irequest),
+        "deleting inference request");
+  }
+
+  // template + infer
+  if (run("template + infer")) {
+    TRITONSERVER_InferenceRequest* irequest = nullptr;
+    FAIL_IF_ERR(
+        NewRequest(
+            server.get(), model_name, inputs, outputs, InferRequestKeep,
+            nullptr /* release_userp */, &irequest),
+        "creating inference request");
+    TRITONSERVER_InferenceRequestTemplate* request_template = nullptr;
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestTemplateNew(&request_template, irequest),
+        "creating inference request template");
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestDelete(irequest),
+        "deleting inference request");
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      FAIL_IF_ERR(
+          TRITONSERVER_InferenceRequestNewFromTemplate(
+              &irequest, request_template),
+          "creating inference request from template");
+      FAIL_IF_ERR(
+          TRITONSERVER_InferenceRequestSetReleaseCallback(
+              irequest, InferRequestDelete, &released),
+          "setting request release callback");
+      for (const auto& input : inputs) {
+        FAIL_IF_ERR(
+            TRITONSERVER_InferenceRequestAppendInputData(
+                irequest, input.name_.c_str(), input.data_.data(),
+                input.data_.size(), TRITONSERVER_MEMORY_CPU,
+                0 /* memory_type_id */),
+            "assigning input data");
+      }
+      Infer(server.get(), allocator, irequest);
+    }
+    Report("template + infer", count, start);
+    release_count += count;
+
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestTemplateDelete(request_template),
+        "deleting inference request template");
+  }
+
+  // submit, submit multiple
+  const size_t group_cnt = (count + group_size - 1) / group_size;
+  for (const bool multiple : {false, true}) {
+    const std::string name = (multiple) ? "submit multiple" : "submit";
+    if (!run(name)) {
+      continue;
+    }
+
+    std::vector<TRITONSERVER_InferenceRequest*> irequests(group_size);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < group_cnt; ++i) {
+      for (auto& irequest : irequests) {
+        FAIL_IF_ERR(
+            NewRequest(
+                server.get(), model_name, inputs, outputs, InferRequestDelete,
+                &released, &irequest),
+            "creating inference request");
+      }
+      InferGroup(server.get(), allocator, irequests, multiple);
+    }
+    Report(name, group_cnt * group_size, start);
+    release_count += group_cnt * group_size;
+  }
+
+  // The requests may be released after their response is delivered
+  // so wait for all of them before shutting down the server.
+  while (released < release_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorDelete(allocator),
+      "deleting response allocator");
+
+  return 0;
+}
@@ -43,8 +43,10 @@ class SagemakerAPIServer : public HTTPAPIServer {
    public:
     explicit SagemakeInferRequestClass(
         TRITONSERVER_Server* server, evhtp_request_t* req,
-        DataCompressor::Type response_compression_type)
-        : InferRequestClass(server, req, response_compression_type)
+        DataCompressor::Type response_compression_type,
+        const DataCompressor::Options& compression_options)
+        : InferRequestClass(
+              server, req, response_compression_type, compression_options)
     {
     }
 
@@ -65,7 +67,9 @@ class SagemakerAPIServer : public HTTPAPIServer {
       nvidia::inferenceserver::TraceManager* trace_manager,
       const std::shared_ptr<SharedMemoryManager>& shm_manager,
       const int32_t port, const int thread_cnt)
-      : HTTPAPIServer(server, trace_manager, shm_manager, port, thread_cnt),
+      : HTTPAPIServer(
+            server, trace_manager, shm_manager, port, thread_cnt,
+            DataCompressor::Options()),
         ping_regex_(R"(/ping)"), invocations_regex_(R"(/invocations)"),
         ping_mode_("ready"),
         model_name_(SagemakerAPIServer::GetEnvironmentVariableOrDefault(
@@ -81,7 +85,8 @@ class SagemakerAPIServer : public HTTPAPIServer {
       evhtp_request_t* req) override
   {
     return std::unique_ptr<InferRequestClass>(new SagemakeInferRequestClass(
-        server_.get(), req, GetResponseCompressionType(req)));
+        server_.get(), req, GetResponseCompressionType(req),
+        compression_options_));
   }
   TRITONSERVER_Error* GetInferenceHeaderLength(
       evhtp_request_t* req, int32_t content_length,
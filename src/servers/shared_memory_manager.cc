@@ -31,6 +31,8 @@
 namespace nvidia { namespace inferenceserver {
 SharedMemoryManager::~SharedMemoryManager() {}
 
+SharedMemoryManager::SharedMemoryInfo::~SharedMemoryInfo() {}
+
 TRITONSERVER_Error*
 SharedMemoryManager::RegisterSystemSharedMemory(
     const std::string& name, const std::string& shm_key, const size_t offset,
@@ -58,7 +60,7 @@ SharedMemoryManager::RegisterCUDASharedMemory(
 TRITONSERVER_Error*
 SharedMemoryManager::GetMemoryInfo(
     const std::string& name, size_t offset, void** shm_mapped_addr,
-    TRITONSERVER_MemoryType* memory_type, int64_t* device_id)
+    TRITONSERVER_MemoryType* memory_type, int64_t* device_id, Lease* lease)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
@@ -98,13 +100,20 @@ SharedMemoryManager::UnregisterAll(TRITONSERVER_MemoryType memory_type)
 
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterHelper(
-    const std::string& name, TRITONSERVER_MemoryType memory_type)
+    const std::string& name, TRITONSERVER_MemoryType memory_type,
+    SharedMemoryStateMap* shm_map)
 {
   return TRITONSERVER_ErrorNew(
       TRITONSERVER_ERROR_UNSUPPORTED,
       std::string("Shared memory feature is currently not supported on Windows")
           .c_str());
 }
+
+void
+SharedMemoryManager::UpdateMap(
+    std::shared_ptr<const SharedMemoryStateMap>&& shm_map)
+{
+}
 }}  // namespace nvidia::inferenceserver
 #else
 #include <errno.h>
@@ -209,12 +218,37 @@ OpenCudaIPCRegion(
 
 }  // namespace
 
+SharedMemoryManager::SharedMemoryInfo::~SharedMemoryInfo()
+{
+  if (kind_ == TRITONSERVER_MEMORY_CPU) {
+    LOG_TRITONSERVER_ERROR(
+        UnmapSharedMemory(mapped_addr_, byte_size_),
+        "failed to unmap shared memory region '" + name_ + "'");
+  } else {
+#ifdef TRITON_ENABLE_GPU
+    cudaError_t err = cudaIpcCloseMemHandle(mapped_addr_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "failed to close CUDA IPC handle of shared memory region '"
+                << name_ << "': " << cudaGetErrorString(err);
+    }
+#endif  // TRITON_ENABLE_GPU
+  }
+}
+
 SharedMemoryManager::~SharedMemoryManager()
 {
   UnregisterAll(TRITONSERVER_MEMORY_CPU);
   UnregisterAll(TRITONSERVER_MEMORY_GPU);
 }
 
+void
+SharedMemoryManager::UpdateMap(
+    std::shared_ptr<const SharedMemoryStateMap>&& shm_map)
+{
+  // Must hold the lock on mu_ while calling this function.
+  std::atomic_store(&shared_memory_map_, std::move(shm_map));
+}
+
 TRITONSERVER_Error*
 SharedMemoryManager::RegisterSystemSharedMemory(
     const std::string& name, const std::string& shm_key, const size_t offset,
@@ -222,7 +256,7 @@ SharedMemoryManager::RegisterSystemSharedMemory(
 {
   std::lock_guard<std::mutex> lock(mu_);
 
-  if (shared_memory_map_.find(name) != shared_memory_map_.end()) {
+  if (shared_memory_map_->find(name) != shared_memory_map_->end()) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_ALREADY_EXISTS,
         std::string("shared memory region '" + name + "' already in manager")
@@ -234,8 +268,8 @@ SharedMemoryManager::RegisterSystemSharedMemory(
   int shm_fd = -1;
 
   // don't re-open if shared memory is already open
-  for (auto itr = shared_memory_map_.begin(); itr != shared_memory_map_.end();
-       ++itr) {
+  for (auto itr = shared_memory_map_->begin();
+       itr != shared_memory_map_->end(); ++itr) {
     if (itr->second->shm_key_ == shm_key) {
       shm_fd = itr->second->shm_fd_;
       break;
@@ -269,10 +303,13 @@ SharedMemoryManager::RegisterSystemSharedMemory(
             .c_str());
   }
 
-  shared_memory_map_.insert(std::make_pair(
-      name, std::unique_ptr<SharedMemoryInfo>(new SharedMemoryInfo(
+  std::shared_ptr<SharedMemoryStateMap> shm_map(
+      new SharedMemoryStateMap(*shared_memory_map_));
+  shm_map->insert(std::make_pair(
+      name, std::shared_ptr<SharedMemoryInfo>(new SharedMemoryInfo(
                 name, shm_key, offset, byte_size, shm_fd, mapped_addr,
                 TRITONSERVER_MEMORY_CPU, 0))));
+  UpdateMap(std::move(shm_map));
 
   return nullptr;  // success
 }
@@ -288,7 +325,7 @@ SharedMemoryManager::RegisterCUDASharedMemory(
 
   // If name is already in shared_memory_map_ then return error saying already
   // registered
-  if (shared_memory_map_.find(name) != shared_memory_map_.end()) {
+  if (shared_memory_map_->find(name) != shared_memory_map_->end()) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_ALREADY_EXISTS,
         std::string("shared memory region '" + name + "' already in manager")
@@ -309,10 +346,13 @@ SharedMemoryManager::RegisterCUDASharedMemory(
             .c_str());
   }
 
-  shared_memory_map_.insert(std::make_pair(
-      name, std::unique_ptr<SharedMemoryInfo>(new SharedMemoryInfo(
+  std::shared_ptr<SharedMemoryStateMap> shm_map(
+      new SharedMemoryStateMap(*shared_memory_map_));
+  shm_map->insert(std::make_pair(
+      name, std::shared_ptr<SharedMemoryInfo>(new SharedMemoryInfo(
                 name, "", 0, byte_size, 0, mapped_addr, TRITONSERVER_MEMORY_GPU,
                 device_id))));
+  UpdateMap(std::move(shm_map));
 
   return nullptr;  // success
 }
@@ -321,10 +361,14 @@ SharedMemoryManager::RegisterCUDASharedMemory(
 TRITONSERVER_Error*
 SharedMemoryManager::GetMemoryInfo(
     const std::string& name, size_t offset, void** shm_mapped_addr,
-    TRITONSERVER_MemoryType* memory_type, int64_t* device_id)
+    TRITONSERVER_MemoryType* memory_type, int64_t* device_id, Lease* lease)
 {
-  auto it = shared_memory_map_.find(name);
-  if (it == shared_memory_map_.end()) {
+  // The map may be replaced concurrently but the map and the blocks in
+  // it remain valid while 'shm_map' holds a reference to it.
+  std::shared_ptr<const SharedMemoryStateMap> shm_map =
+      std::atomic_load(&shared_memory_map_);
+  auto it = shm_map->find(name);
+  if (it == shm_map->end()) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_NOT_FOUND,
         std::string("Unable to find shared memory region: '" + name + "'")
@@ -339,6 +383,9 @@ SharedMemoryManager::GetMemoryInfo(
 
   *memory_type = it->second->kind_;
   *device_id = it->second->device_id_;
+  if (lease != nullptr) {
+    *lease = it->second;
+  }
 
   return nullptr;
 }
@@ -351,7 +398,7 @@ SharedMemoryManager::GetStatus(
   std::lock_guard<std::mutex> lock(mu_);
 
   if (name.empty()) {
-    for (const auto& shm_info : shared_memory_map_) {
+    for (const auto& shm_info : *shared_memory_map_) {
       if (shm_info.second->kind_ == memory_type) {
         triton::common::TritonJson::Value shm_region(
             *shm_status, triton::common::TritonJson::ValueType::OBJECT);
@@ -372,8 +419,8 @@ SharedMemoryManager::GetStatus(
       }
     }
   } else {
-    auto it = shared_memory_map_.find(name);
-    if (it == shared_memory_map_.end()) {
+    auto it = shared_memory_map_->find(name);
+    if (it == shared_memory_map_->end()) {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_NOT_FOUND,
           std::string(
@@ -426,88 +473,45 @@ SharedMemoryManager::Unregister(
   // Serialize all operations that write/read current shared memory regions
   std::lock_guard<std::mutex> lock(mu_);
 
-  return UnregisterHelper(name, memory_type);
+  std::shared_ptr<SharedMemoryStateMap> shm_map(
+      new SharedMemoryStateMap(*shared_memory_map_));
+  RETURN_IF_ERR(UnregisterHelper(name, memory_type, shm_map.get()));
+  UpdateMap(std::move(shm_map));
+
+  return nullptr;
 }
 
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterAll(TRITONSERVER_MemoryType memory_type)
 {
+  // Serialize all operations that write/read current shared memory regions
   std::lock_guard<std::mutex> lock(mu_);
-  std::string error_message = "Failed to unregister the following ";
-  std::vector<std::string> unregister_fails;
-  if (memory_type == TRITONSERVER_MEMORY_CPU) {
-    // Serialize all operations that write/read current shared memory regions
-    error_message += "system shared memory regions: ";
-    for (auto it = shared_memory_map_.cbegin(), next_it = it;
-         it != shared_memory_map_.cend(); it = next_it) {
-      ++next_it;
-      if (it->second->kind_ == TRITONSERVER_MEMORY_CPU) {
-        TRITONSERVER_Error* err = UnregisterHelper(it->first, memory_type);
-        if (err != nullptr) {
-          unregister_fails.push_back(it->first);
-        }
-      }
-    }
-  } else if (memory_type == TRITONSERVER_MEMORY_GPU) {
-    error_message += "cuda shared memory regions: ";
-    for (auto it = shared_memory_map_.cbegin(), next_it = it;
-         it != shared_memory_map_.cend(); it = next_it) {
-      ++next_it;
-      if (it->second->kind_ == TRITONSERVER_MEMORY_GPU) {
-        TRITONSERVER_Error* err = UnregisterHelper(it->first, memory_type);
-        ;
-        if (err != nullptr) {
-          unregister_fails.push_back(it->first);
-        }
-      }
-    }
-  }
 
-  if (!unregister_fails.empty()) {
-    for (auto unreg_fail : unregister_fails) {
-      error_message += unreg_fail + " ,";
+  std::shared_ptr<SharedMemoryStateMap> shm_map(
+      new SharedMemoryStateMap(*shared_memory_map_));
+  for (auto it = shared_memory_map_->cbegin();
+       it != shared_memory_map_->cend(); ++it) {
+    if (it->second->kind_ == memory_type) {
+      RETURN_IF_ERR(UnregisterHelper(it->first, memory_type, shm_map.get()));
     }
-    LOG_ERROR << error_message;
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_INTERNAL, error_message.c_str());
   }
+  UpdateMap(std::move(shm_map));
 
   return nullptr;
 }
 
 TRITONSERVER_Error*
 SharedMemoryManager::UnregisterHelper(
-    const std::string& name, TRITONSERVER_MemoryType memory_type)
+    const std::string& name, TRITONSERVER_MemoryType memory_type,
+    SharedMemoryStateMap* shm_map)
 {
-  // Must hold the lock on register_mu_ while calling this function.
-  auto it = shared_memory_map_.find(name);
-  if (it != shared_memory_map_.end() && it->second->kind_ == memory_type) {
-    if (it->second->kind_ == TRITONSERVER_MEMORY_CPU) {
-      RETURN_IF_ERR(
-          UnmapSharedMemory(it->second->mapped_addr_, it->second->byte_size_));
-    } else {
-#ifdef TRITON_ENABLE_GPU
-      cudaError_t err = cudaIpcCloseMemHandle(it->second->mapped_addr_);
-      if (err != cudaSuccess) {
-        return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INTERNAL,
-            std::string(
-                "failed to close CUDA IPC handle: " +
-                std::string(cudaGetErrorString(err)))
-                .c_str());
-      }
-#else
-      return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INVALID_ARG,
-          std::string(
-              "failed to unregister CUDA shared memory region: '" + name +
-              "', GPUs not supported")
-              .c_str());
-#endif  // TRITON_ENABLE_GPU
-    }
-
-    // Remove region information from shared_memory_map_
-    shared_memory_map_.erase(it);
+  // Must hold the lock on mu_ while calling this function. The memory of
+  // the block is unmapped when the last reference to it, held by
+  // 'shm_map', a previous map or a lease, is released.
+  auto it = shm_map->find(name);
+  if (it != shm_map->end() && it->second->kind_ == memory_type) {
+    // Remove region information from shm_map
+    shm_map->erase(it);
   }
 
   return nullptr;
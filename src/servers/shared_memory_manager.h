@@ -29,6 +29,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 #include "triton/core/tritonserver.h"
 
 #define TRITONJSON_STATUSTYPE TRITONSERVER_Error*
@@ -43,9 +44,20 @@
 
 namespace nvidia { namespace inferenceserver {
 
+// The registered shared memory blocks are kept in an immutable map
+// that is replaced, while holding 'mu_', each time a block is
+// registered or unregistered. Lookups use the current map without
+// acquiring 'mu_'. Each block is reference counted so that a block
+// that is unregistered while in use by an inference request remains
+// mapped until the last lease on the block is released.
 class SharedMemoryManager {
  public:
-  SharedMemoryManager() = default;
+  /// A lease on a registered shared memory block. The memory of the
+  /// block remains mapped, even if the block is unregistered, until
+  /// all leases on the block are released.
+  using Lease = std::shared_ptr<const void>;
+
+  SharedMemoryManager() : shared_memory_map_(new SharedMemoryStateMap()) {}
   ~SharedMemoryManager();
 
   /// Add a shared memory block representing shared memory in system
@@ -87,10 +99,13 @@ class SharedMemoryManager {
   /// \param memory_type Returns the type of the memory
   /// \param device_id Returns the device id associated with the
   /// memory block
+  /// \param lease If non-nullptr, returns a lease on the memory block
+  /// that must be held for as long as 'shm_mapped_addr' is used.
   /// \return a TRITONSERVER_Error indicating success or failure.
   TRITONSERVER_Error* GetMemoryInfo(
       const std::string& name, size_t offset, void** shm_mapped_addr,
-      TRITONSERVER_MemoryType* memory_type, int64_t* device_id);
+      TRITONSERVER_MemoryType* memory_type, int64_t* device_id,
+      Lease* lease);
 
   /// Populates the status of active system/CUDA shared memory regions
   /// in the status JSON. If 'name' is empty then return status of all
@@ -106,7 +121,8 @@ class SharedMemoryManager {
   /// Removes the named shared memory block of the specified type from
   /// the manager. Any future attempt to get the details of this block
   /// will result in an array till another block with the same name is
-  /// added to the manager.
+  /// added to the manager. The memory of the block is unmapped once all
+  /// leases on the block are released.
   /// \param name The name of the shared memory block to remove.
   /// \param memory_type The type of memory to unregister.
   /// \return a TRITONSERVER_Error indicating success or failure.
@@ -119,10 +135,19 @@ class SharedMemoryManager {
   TRITONSERVER_Error* UnregisterAll(TRITONSERVER_MemoryType memory_type);
 
  private:
+  struct SharedMemoryInfo;
+  using SharedMemoryStateMap =
+      std::map<std::string, std::shared_ptr<SharedMemoryInfo>>;
+
   /// A helper function to remove the named shared memory blocks of
-  /// specified type
+  /// specified type from 'shm_map'.
   TRITONSERVER_Error* UnregisterHelper(
-      const std::string& name, TRITONSERVER_MemoryType memory_type);
+      const std::string& name, TRITONSERVER_MemoryType memory_type,
+      SharedMemoryStateMap* shm_map);
+
+  /// Replace the map of registered shared memory blocks. Must hold the
+  /// lock on 'mu_' while calling this function.
+  void UpdateMap(std::shared_ptr<const SharedMemoryStateMap>&& shm_map);
 
   /// A struct that records the shared memory regions registered by the shared
   /// memory manager.
@@ -138,6 +163,9 @@ class SharedMemoryManager {
     {
     }
 
+    // Unmap the memory of the block.
+    ~SharedMemoryInfo();
+
     std::string name_;
     std::string shm_key_;
     size_t offset_;
@@ -148,12 +176,12 @@ class SharedMemoryManager {
     int64_t device_id_;
   };
 
-  using SharedMemoryStateMap =
-      std::map<std::string, std::unique_ptr<SharedMemoryInfo>>;
   // A map between the name and the details of the associated
-  // shared memory block
-  SharedMemoryStateMap shared_memory_map_;
-  // A mutex to protect the concurrent access to shared_memory_map_
+  // shared memory block. The map is never modified, it is replaced
+  // using std::atomic_store so must be read using std::atomic_load
+  // unless holding 'mu_'.
+  std::shared_ptr<const SharedMemoryStateMap> shared_memory_map_;
+  // A mutex to serialize the changes to shared_memory_map_
   std::mutex mu_;
 };
 
@@ -0,0 +1,513 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+// The layout of the shared-memory request ring and a minimal client
+// for it. The ring lets a client on the same host submit inference
+// requests to the server without a network round-trip. Tensor data is
+// never copied into the ring, a request only references tensors by
+// offset within system shared memory regions registered with the
+// server. This header has no dependencies on the server so that it
+// can be used directly by clients.
+//
+// The segment holds a header, two bounded MPMC queues of slot indices
+// and the slots themselves:
+//
+//   | Header | submit queue cells | free queue cells | slots |
+//
+// A client pops a slot index from the free queue, fills the request
+// in the slot and pushes the index on the submit queue. The server
+// pops the index from the submit queue, executes the request, writes
+// the response into the same slot and marks the slot COMPLETE. The
+// client reads the response and returns the index to the free queue.
+// Both sides block on futexes in the segment when there is nothing to
+// do, so a wakeup is only issued when the other side is sleeping.
+
+namespace nvidia { namespace inferenceserver { namespace shmring {
+
+constexpr uint64_t kMagic = 0x474e495254495254ULL;  // "TRITRING"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMaxNameLength = 64;
+constexpr size_t kMaxModelNameLength = 128;
+constexpr size_t kMaxDatatypeLength = 16;
+constexpr size_t kMaxDims = 8;
+constexpr size_t kMaxTensors = 8;
+constexpr size_t kMaxErrorLength = 256;
+
+enum class RequestKind : uint32_t {
+  INFER = 0,
+  REGISTER_SYSTEM_SHM = 1,
+  UNREGISTER_SYSTEM_SHM = 2
+};
+
+enum SlotState : uint32_t {
+  SLOT_FREE = 0,
+  SLOT_SUBMITTED = 1,
+  SLOT_COMPLETE = 2
+};
+
+// A tensor located at 'offset_' within the registered system shared
+// memory region 'region_'. For requested outputs 'byte_size_' is the
+// space available for the output, in the response it is the actual
+// size of the output.
+struct Tensor {
+  char name_[kMaxNameLength];
+  char datatype_[kMaxDatatypeLength];
+  uint32_t dims_count_;
+  int64_t shape_[kMaxDims];
+  char region_[kMaxNameLength];
+  uint64_t offset_;
+  uint64_t byte_size_;
+};
+
+// A system shared memory region to register or unregister.
+struct RegionInfo {
+  char name_[kMaxNameLength];
+  char key_[kMaxNameLength];
+  uint64_t offset_;
+  uint64_t byte_size_;
+};
+
+struct Request {
+  RequestKind kind_;
+  uint32_t input_count_;
+  uint32_t output_count_;
+  char model_name_[kMaxModelNameLength];
+  int64_t model_version_;
+  Tensor inputs_[kMaxTensors];
+  Tensor outputs_[kMaxTensors];
+  RegionInfo region_;
+};
+
+struct Response {
+  uint32_t error_;
+  uint32_t output_count_;
+  char error_message_[kMaxErrorLength];
+  Tensor outputs_[kMaxTensors];
+};
+
+struct alignas(64) Slot {
+  // SlotState, also used as the futex word the client waits on.
+  std::atomic<uint32_t> state_;
+  // Non-zero if the client is (about to be) sleeping on 'state_'.
+  std::atomic<uint32_t> waiting_;
+  Request request_;
+  Response response_;
+};
+
+// Bounded MPMC queue of slot indices, the cells of the queue follow
+// the header in the segment.
+struct alignas(64) QueueCell {
+  std::atomic<uint64_t> sequence_;
+  uint32_t value_;
+};
+
+struct Queue {
+  alignas(64) std::atomic<uint64_t> enqueue_pos_;
+  alignas(64) std::atomic<uint64_t> dequeue_pos_;
+};
+
+struct alignas(64) Header {
+  uint64_t magic_;
+  uint32_t version_;
+  uint32_t slot_count_;
+  // Incremented on each submission, the futex word the server waits on.
+  alignas(64) std::atomic<uint32_t> server_wake_;
+  std::atomic<uint32_t> server_sleeping_;
+  Queue submit_queue_;
+  Queue free_queue_;
+};
+
+static_assert(
+    sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+    "futex word must be 32 bits");
+static_assert(
+    ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+    "shared memory ring requires lock-free atomics");
+
+inline size_t
+SubmitCellsOffset()
+{
+  return sizeof(Header);
+}
+
+inline size_t
+FreeCellsOffset(const uint32_t slot_count)
+{
+  return SubmitCellsOffset() + slot_count * sizeof(QueueCell);
+}
+
+inline size_t
+SlotsOffset(const uint32_t slot_count)
+{
+  return FreeCellsOffset(slot_count) + slot_count * sizeof(QueueCell);
+}
+
+inline size_t
+SegmentByteSize(const uint32_t slot_count)
+{
+  return SlotsOffset(slot_count) + slot_count * sizeof(Slot);
+}
+
+inline QueueCell*
+SubmitCells(Header* header)
+{
+  return reinterpret_cast<QueueCell*>(
+      reinterpret_cast<char*>(header) + SubmitCellsOffset());
+}
+
+inline QueueCell*
+FreeCells(Header* header)
+{
+  return reinterpret_cast<QueueCell*>(
+      reinterpret_cast<char*>(header) + FreeCellsOffset(header->slot_count_));
+}
+
+inline Slot*
+Slots(Header* header)
+{
+  return reinterpret_cast<Slot*>(
+      reinterpret_cast<char*>(header) + SlotsOffset(header->slot_count_));
+}
+
+// Push 'value' on the queue. Return false if the queue is full.
+inline bool
+QueuePush(
+    Queue* queue, QueueCell* cells, const uint32_t slot_count,
+    const uint32_t value)
+{
+  uint64_t pos = queue->enqueue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    QueueCell* cell = &cells[pos & (slot_count - 1)];
+    const uint64_t seq = cell->sequence_.load(std::memory_order_acquire);
+    const int64_t diff = (int64_t)seq - (int64_t)pos;
+    if (diff == 0) {
+      if (queue->enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        cell->value_ = value;
+        cell->sequence_.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = queue->enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Pop a value from the queue. Return false if the queue is empty.
+inline bool
+QueuePop(
+    Queue* queue, QueueCell* cells, const uint32_t slot_count,
+    uint32_t* value)
+{
+  uint64_t pos = queue->dequeue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    QueueCell* cell = &cells[pos & (slot_count - 1)];
+    const uint64_t seq = cell->sequence_.load(std::memory_order_acquire);
+    const int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+    if (diff == 0) {
+      if (queue->dequeue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        *value = cell->value_;
+        cell->sequence_.store(pos + slot_count, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = queue->dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Initialize a zeroed segment of SegmentByteSize(slot_count) bytes.
+// 'slot_count' must be a power of 2. All slots start on the free queue.
+inline void
+Initialize(void* base, const uint32_t slot_count)
+{
+  Header* header = new (base) Header();
+  header->magic_ = kMagic;
+  header->version_ = kVersion;
+  header->slot_count_ = slot_count;
+  header->server_wake_.store(0);
+  header->server_sleeping_.store(0);
+  for (Queue* queue : {&header->submit_queue_, &header->free_queue_}) {
+    queue->enqueue_pos_.store(0);
+    queue->dequeue_pos_.store(0);
+  }
+
+  QueueCell* submit_cells = SubmitCells(header);
+  QueueCell* free_cells = FreeCells(header);
+  Slot* slots = Slots(header);
+  for (uint32_t i = 0; i < slot_count; ++i) {
+    new (&submit_cells[i]) QueueCell();
+    submit_cells[i].sequence_.store(i);
+    new (&free_cells[i]) QueueCell();
+    free_cells[i].sequence_.store(i);
+    new (&slots[i]) Slot();
+    slots[i].state_.store(SLOT_FREE);
+    slots[i].waiting_.store(0);
+  }
+  for (uint32_t i = 0; i < slot_count; ++i) {
+    QueuePush(&header->free_queue_, free_cells, slot_count, i);
+  }
+}
+
+// Wait on 'word' while it equals 'expected', at most 'timeout_ms'
+// milliseconds if 'timeout_ms' > 0. The futexes are shared between
+// processes so the private futex operations can't be used.
+inline void
+FutexWait(
+    std::atomic<uint32_t>* word, const uint32_t expected,
+    const int64_t timeout_ms = 0)
+{
+  struct timespec ts;
+  struct timespec* timeout = nullptr;
+  if (timeout_ms > 0) {
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+    timeout = &ts;
+  }
+  syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected,
+      timeout, nullptr, 0);
+}
+
+inline void
+FutexWake(std::atomic<uint32_t>* word)
+{
+  syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT32_MAX,
+      nullptr, nullptr, 0);
+}
+
+// Copy 'src' into the fixed-size field 'dst', return false if it
+// doesn't fit.
+template <size_t N>
+inline bool
+CopyName(char (&dst)[N], const std::string& src)
+{
+  if (src.size() >= N) {
+    return false;
+  }
+  std::memcpy(dst, src.c_str(), src.size() + 1);
+  return true;
+}
+
+// Return true if the fixed-size field 'src' is NUL-terminated.
+template <size_t N>
+inline bool
+IsTerminated(const char (&src)[N])
+{
+  return std::memchr(src, '\0', N) != nullptr;
+}
+
+// Copy the request in 'slot' to 'request'. The client can modify the
+// slot at any time, so the server validates and uses only the copy
+// and never reads the request from the segment again.
+inline void
+ReadRequest(const Slot* slot, Request* request)
+{
+  std::memcpy(request, &slot->request_, sizeof(Request));
+}
+
+inline bool
+ValidateTensor(const Tensor& tensor, const char* kind, std::string* error)
+{
+  if (!IsTerminated(tensor.name_) || !IsTerminated(tensor.datatype_) ||
+      !IsTerminated(tensor.region_)) {
+    *error = std::string(kind) +
+             " name, datatype and shared memory region must be "
+             "NUL-terminated";
+    return false;
+  }
+  if (tensor.dims_count_ > kMaxDims) {
+    *error = std::string(kind) + " '" + tensor.name_ + "' has " +
+             std::to_string(tensor.dims_count_) + " dimensions, at most " +
+             std::to_string(kMaxDims) + " are supported";
+    return false;
+  }
+  return true;
+}
+
+// Return true if the inference request 'request', as copied by
+// ReadRequest(), only references fields within the request. Otherwise
+// return false and set 'error'.
+inline bool
+ValidateInferRequest(const Request& request, std::string* error)
+{
+  if (!IsTerminated(request.model_name_)) {
+    *error = "model name must be NUL-terminated";
+    return false;
+  }
+  if ((request.input_count_ > kMaxTensors) ||
+      (request.output_count_ > kMaxTensors)) {
+    *error = "at most " + std::to_string(kMaxTensors) +
+             " inputs and outputs are supported";
+    return false;
+  }
+  for (uint32_t i = 0; i < request.input_count_; ++i) {
+    if (!ValidateTensor(request.inputs_[i], "input", error)) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < request.output_count_; ++i) {
+    if (!ValidateTensor(request.outputs_[i], "output", error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Client side of a ring created by the server. Any number of threads
+// may use the same client concurrently, each request occupies one
+// slot from AcquireSlot() until ReleaseSlot().
+class Client {
+ public:
+  Client() : header_(nullptr), byte_size_(0) {}
+  ~Client()
+  {
+    if (header_ != nullptr) {
+      munmap(header_, byte_size_);
+    }
+  }
+
+  // Map the ring segment named 'name'. Return an empty string on
+  // success, otherwise a description of the error.
+  std::string Open(const std::string& name)
+  {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+      return "unable to open shared memory ring '" + name +
+             "': " + std::strerror(errno);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+      close(fd);
+      return "unable to stat shared memory ring '" + name + "'";
+    }
+    void* base =
+        mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      return "unable to map shared memory ring '" + name + "'";
+    }
+
+    Header* header = reinterpret_cast<Header*>(base);
+    if (((size_t)st.st_size < sizeof(Header)) || (header->magic_ != kMagic) ||
+        (header->version_ != kVersion) ||
+        ((size_t)st.st_size < SegmentByteSize(header->slot_count_))) {
+      munmap(base, st.st_size);
+      return "'" + name + "' is not a compatible shared memory ring";
+    }
+
+    header_ = header;
+    byte_size_ = st.st_size;
+    return std::string();
+  }
+
+  uint32_t SlotCount() const { return header_->slot_count_; }
+
+  // Acquire a free slot, return nullptr if all slots are in use.
+  Slot* AcquireSlot(uint32_t* index)
+  {
+    if (!QueuePop(
+            &header_->free_queue_, FreeCells(header_), header_->slot_count_,
+            index)) {
+      return nullptr;
+    }
+    Slot* slot = &Slots(header_)[*index];
+    slot->waiting_.store(0, std::memory_order_relaxed);
+    return slot;
+  }
+
+  // Submit the request filled in the slot at 'index'.
+  void Submit(const uint32_t index)
+  {
+    Slot* slot = &Slots(header_)[index];
+    slot->state_.store(SLOT_SUBMITTED, std::memory_order_release);
+    QueuePush(
+        &header_->submit_queue_, SubmitCells(header_), header_->slot_count_,
+        index);
+    header_->server_wake_.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->server_sleeping_.load(std::memory_order_seq_cst) != 0) {
+      FutexWake(&header_->server_wake_);
+    }
+  }
+
+  // Wait for the response to the request in the slot at 'index'. Spin
+  // for 'spin_count' iterations before sleeping on the slot futex.
+  Response* Wait(const uint32_t index, const uint32_t spin_count = 4096)
+  {
+    Slot* slot = &Slots(header_)[index];
+    for (uint32_t i = 0; i < spin_count; ++i) {
+      if (slot->state_.load(std::memory_order_acquire) == SLOT_COMPLETE) {
+        return &slot->response_;
+      }
+    }
+    while (slot->state_.load(std::memory_order_acquire) != SLOT_COMPLETE) {
+      slot->waiting_.store(1, std::memory_order_seq_cst);
+      if (slot->state_.load(std::memory_order_seq_cst) == SLOT_COMPLETE) {
+        break;
+      }
+      FutexWait(&slot->state_, SLOT_SUBMITTED);
+    }
+    return &slot->response_;
+  }
+
+  // Return the slot at 'index' to the free queue.
+  void ReleaseSlot(const uint32_t index)
+  {
+    Slot* slot = &Slots(header_)[index];
+    slot->state_.store(SLOT_FREE, std::memory_order_relaxed);
+    QueuePush(
+        &header_->free_queue_, FreeCells(header_), header_->slot_count_,
+        index);
+  }
+
+ private:
+  Header* header_;
+  size_t byte_size_;
+};
+
+}}}  // namespace nvidia::inferenceserver::shmring
@@ -0,0 +1,271 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "src/servers/shm_ring.h"
+
+namespace sr = nvidia::inferenceserver::shmring;
+
+namespace {
+
+// Latency benchmark of the shared-memory request ring. Runs the
+// configured number of requests, one at a time, against a model that
+// has the inputs and outputs of the 'simple' model (INT32 INPUT0 and
+// INPUT1 with shape [1,16], OUTPUT0 their sum and OUTPUT1 their
+// difference) and reports the request latency as seen by the client.
+// The tensors are in a system shared memory region created by the
+// benchmark and registered with the server through the ring. Compare
+// with perf_analyzer using GRPC and system shared memory for the same
+// model to measure the overhead of the GRPC path, see
+// qa/L0_shm_ring/test.sh.
+
+constexpr size_t kElementCount = 16;
+constexpr size_t kTensorByteSize = kElementCount * sizeof(int32_t);
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-m <model name>, default 'simple'" << std::endl;
+  std::cerr << "\t-n <number of requests>, default 10000" << std::endl;
+  std::cerr << "\t-w <number of warmup requests>, default 100" << std::endl;
+  std::cerr << "\t-s <shared memory ring name>, default '/triton_shm_ring'"
+            << std::endl;
+
+  exit(1);
+}
+
+void
+Fail(const std::string& msg)
+{
+  std::cerr << "error: " << msg << std::endl;
+  exit(1);
+}
+
+void
+SetTensor(
+    sr::Tensor* tensor, const std::string& name, const std::string& region,
+    const size_t offset)
+{
+  sr::CopyName(tensor->name_, name);
+  sr::CopyName(tensor->datatype_, "INT32");
+  tensor->dims_count_ = 2;
+  tensor->shape_[0] = 1;
+  tensor->shape_[1] = kElementCount;
+  sr::CopyName(tensor->region_, region);
+  tensor->offset_ = offset;
+  tensor->byte_size_ = kTensorByteSize;
+}
+
+// Run the request in the slot at 'index' and return the response,
+// exit on error.
+sr::Response*
+Run(sr::Client* client, const uint32_t index)
+{
+  client->Submit(index);
+  sr::Response* response = client->Wait(index);
+  if (response->error_ != 0) {
+    Fail(response->error_message_);
+  }
+  return response;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string model_name("simple");
+  std::string ring_name("/triton_shm_ring");
+  int count = 10000;
+  int warmup_count = 100;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "m:n:w:s:")) != -1) {
+    switch (opt) {
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'n':
+        count = std::atoi(optarg);
+        break;
+      case 'w':
+        warmup_count = std::atoi(optarg);
+        break;
+      case 's':
+        ring_name = optarg;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (count <= 0) {
+    Usage(argv, "-n must be > 0");
+  }
+  if (warmup_count < 0) {
+    Usage(argv, "-w must be >= 0");
+  }
+
+  sr::Client client;
+  const std::string open_err = client.Open(ring_name);
+  if (!open_err.empty()) {
+    Fail(open_err);
+  }
+
+  // Create the region holding INPUT0, INPUT1, OUTPUT0 and OUTPUT1, in
+  // that order.
+  const std::string region_name(
+      "shm_ring_benchmark_data_" + std::to_string(getpid()));
+  const std::string region_key("/" + region_name);
+  const size_t region_byte_size = 4 * kTensorByteSize;
+  int fd = shm_open(region_key.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if ((fd == -1) || (ftruncate(fd, region_byte_size) != 0)) {
+    Fail("unable to create shared memory region " + region_key);
+  }
+  void* base = mmap(
+      nullptr, region_byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    Fail("unable to map shared memory region " + region_key);
+  }
+
+  int32_t* input0 = reinterpret_cast<int32_t*>(base);
+  int32_t* input1 = input0 + kElementCount;
+  int32_t* output0 = input1 + kElementCount;
+  int32_t* output1 = output0 + kElementCount;
+  for (size_t i = 0; i < kElementCount; ++i) {
+    input0[i] = i;
+    input1[i] = 1;
+  }
+
+  uint32_t index;
+  sr::Slot* slot = client.AcquireSlot(&index);
+  if (slot == nullptr) {
+    Fail("no free slot in shared memory ring");
+  }
+
+  // Register the region with the server.
+  std::memset(&slot->request_, 0, sizeof(slot->request_));
+  slot->request_.kind_ = sr::RequestKind::REGISTER_SYSTEM_SHM;
+  sr::CopyName(slot->request_.region_.name_, region_name);
+  sr::CopyName(slot->request_.region_.key_, region_key);
+  slot->request_.region_.offset_ = 0;
+  slot->request_.region_.byte_size_ = region_byte_size;
+  Run(&client, index);
+
+  // The same request is submitted repeatedly, only the kind and
+  // tensors need to be set once.
+  std::memset(&slot->request_, 0, sizeof(slot->request_));
+  slot->request_.kind_ = sr::RequestKind::INFER;
+  if (!sr::CopyName(slot->request_.model_name_, model_name)) {
+    Fail("model name '" + model_name + "' is too long");
+  }
+  slot->request_.model_version_ = -1;
+  slot->request_.input_count_ = 2;
+  SetTensor(&slot->request_.inputs_[0], "INPUT0", region_name, 0);
+  SetTensor(
+      &slot->request_.inputs_[1], "INPUT1", region_name, kTensorByteSize);
+  slot->request_.output_count_ = 2;
+  SetTensor(
+      &slot->request_.outputs_[0], "OUTPUT0", region_name,
+      2 * kTensorByteSize);
+  SetTensor(
+      &slot->request_.outputs_[1], "OUTPUT1", region_name,
+      3 * kTensorByteSize);
+
+  for (int i = 0; i < warmup_count; ++i) {
+    Run(&client, index);
+  }
+
+  std::vector<uint64_t> latencies_ns;
+  latencies_ns.reserve(count);
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) {
+    const auto request_start = std::chrono::steady_clock::now();
+    Run(&client, index);
+    latencies_ns.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - request_start)
+            .count());
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < kElementCount; ++i) {
+    if ((output0[i] != input0[i] + input1[i]) ||
+        (output1[i] != input0[i] - input1[i])) {
+      Fail("incorrect output at index " + std::to_string(i));
+    }
+  }
+
+  // Unregister the region.
+  std::memset(&slot->request_, 0, sizeof(slot->request_));
+  slot->request_.kind_ = sr::RequestKind::UNREGISTER_SYSTEM_SHM;
+  sr::CopyName(slot->request_.region_.name_, region_name);
+  Run(&client, index);
+  client.ReleaseSlot(index);
+
+  munmap(base, region_byte_size);
+  shm_unlink(region_key.c_str());
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  uint64_t total_ns = 0;
+  for (const auto ns : latencies_ns) {
+    total_ns += ns;
+  }
+  auto percentile_us = [&latencies_ns](const size_t p) {
+    const size_t idx =
+        std::min(latencies_ns.size() - 1, (latencies_ns.size() * p) / 100);
+    return latencies_ns[idx] / 1000.0;
+  };
+
+  const double duration_s =
+      std::chrono::duration<double>(end - start).count();
+  std::cout << "shm ring: " << count << " requests in " << duration_s
+            << " sec, " << (count / duration_s) << " infer/sec" << std::endl;
+  std::cout << "  avg latency: " << (total_ns / (double)count) / 1000.0
+            << " usec" << std::endl;
+  std::cout << "  p50 latency: " << percentile_us(50) << " usec" << std::endl;
+  std::cout << "  p90 latency: " << percentile_us(90) << " usec" << std::endl;
+  std::cout << "  p99 latency: " << percentile_us(99) << " usec" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,641 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/servers/shm_ring_server.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include "src/core/logging.h"
+#include "src/servers/common.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+// The number of times the poll thread checks for a submitted slot
+// before sleeping on the ring futex.
+constexpr uint32_t kPollSpinCount = 2048;
+
+// The longest the poll thread sleeps before checking for a submitted
+// slot again, in case a wakeup was lost because a client died.
+constexpr int64_t kPollTimeoutMs = 100;
+
+}  // namespace
+
+// The state of an inference request submitted through the ring. It
+// is released once both the request and the final response have been
+// released by the server.
+struct ShmRingServer::RequestState {
+  struct Output {
+    std::string name_;
+    void* base_;
+    size_t byte_size_;
+    TRITONSERVER_MemoryType memory_type_;
+    int64_t memory_type_id_;
+  };
+
+  RequestState(ShmRingServer* server, shmring::Slot* slot)
+      : server_(server), slot_(slot), response_count_(0), err_(nullptr),
+        pending_(2)
+  {
+  }
+
+  ShmRingServer* server_;
+  shmring::Slot* slot_;
+
+  // The requested outputs, in the order of the request in the slot.
+  std::vector<Output> outputs_;
+
+  // Leases on the shared memory regions holding the inputs and the
+  // outputs of the request.
+  std::vector<SharedMemoryManager::Lease> leases_;
+
+  size_t response_count_;
+  TRITONSERVER_Error* err_;
+
+  // The number of request and response callbacks that have not run.
+  std::atomic<int> pending_;
+};
+
+ShmRingServer::ShmRingServer(
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& ring_name, const uint32_t slot_count)
+    : server_(server), shm_manager_(shm_manager), ring_name_(ring_name),
+      slot_count_(slot_count), allocator_(nullptr), header_(nullptr),
+      byte_size_(0), exiting_(false), inflight_(0)
+{
+}
+
+ShmRingServer::~ShmRingServer()
+{
+  if (header_ != nullptr) {
+    IGNORE_ERR(Stop());
+  }
+  if (allocator_ != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_ResponseAllocatorDelete(allocator_),
+        "deleting shared memory ring response allocator");
+  }
+}
+
+TRITONSERVER_Error*
+ShmRingServer::Create(
+    const std::shared_ptr<TRITONSERVER_Server>& server,
+    const std::shared_ptr<SharedMemoryManager>& shm_manager,
+    const std::string& ring_name, const uint32_t slot_count,
+    std::unique_ptr<ShmRingServer>* shm_ring_server)
+{
+  if ((ring_name.size() < 2) || (ring_name[0] != '/') ||
+      (ring_name.find('/', 1) != std::string::npos)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory ring name '" + ring_name +
+            "' must be a '/' followed by one or more characters that are not "
+            "'/'")
+            .c_str());
+  }
+  if ((slot_count == 0) || ((slot_count & (slot_count - 1)) != 0)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "shared memory ring slot count must be a power of 2, got " +
+            std::to_string(slot_count))
+            .c_str());
+  }
+
+  std::unique_ptr<ShmRingServer> ring(
+      new ShmRingServer(server, shm_manager, ring_name, slot_count));
+  RETURN_IF_ERR(TRITONSERVER_ResponseAllocatorNew(
+      &ring->allocator_, ResponseAlloc, ResponseRelease,
+      nullptr /* start_fn */));
+
+  *shm_ring_server = std::move(ring);
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+ShmRingServer::Start()
+{
+  if (header_ != nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_ALREADY_EXISTS,
+        "shared memory ring is already running.");
+  }
+
+  // Remove a segment left behind by a server that didn't exit cleanly,
+  // clients still mapping it are not served by this server anyway.
+  shm_unlink(ring_name_.c_str());
+  int fd = shm_open(
+      ring_name_.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(
+            "unable to create shared memory ring '" + ring_name_ +
+            "': " + std::strerror(errno))
+            .c_str());
+  }
+
+  const size_t byte_size = shmring::SegmentByteSize(slot_count_);
+  void* base = MAP_FAILED;
+  if (ftruncate(fd, byte_size) == 0) {
+    base = mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const int map_errno = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(ring_name_.c_str());
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string(
+            "unable to map shared memory ring '" + ring_name_ +
+            "': " + std::strerror(map_errno))
+            .c_str());
+  }
+
+  shmring::Initialize(base, slot_count_);
+  header_ = reinterpret_cast<shmring::Header*>(base);
+  byte_size_ = byte_size;
+
+  exiting_ = false;
+  poll_thread_.reset(new std::thread([this] { PollRing(); }));
+
+  LOG_INFO << "Started shared memory ring '" << ring_name_ << "' with "
+           << slot_count_ << " slots";
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+ShmRingServer::Stop()
+{
+  if (header_ == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE, "shared memory ring is not running.");
+  }
+
+  exiting_ = true;
+  header_->server_wake_.fetch_add(1);
+  shmring::FutexWake(&header_->server_wake_);
+  poll_thread_->join();
+  poll_thread_.reset();
+
+  // The callbacks of in-flight requests write into the ring so it
+  // must remain mapped until they have all run.
+  {
+    std::unique_lock<std::mutex> lk(inflight_mu_);
+    inflight_cv_.wait(lk, [this] { return inflight_ == 0; });
+  }
+
+  munmap(header_, byte_size_);
+  shm_unlink(ring_name_.c_str());
+  header_ = nullptr;
+  byte_size_ = 0;
+
+  return nullptr;  // success
+}
+
+void
+ShmRingServer::PollRing()
+{
+  shmring::QueueCell* submit_cells = shmring::SubmitCells(header_);
+  shmring::Slot* slots = shmring::Slots(header_);
+
+  uint32_t idle_count = 0;
+  while (!exiting_) {
+    uint32_t index;
+    if (shmring::QueuePop(
+            &header_->submit_queue_, submit_cells, slot_count_, &index)) {
+      idle_count = 0;
+      if (index >= slot_count_) {
+        LOG_ERROR << "shared memory ring: ignoring invalid slot " << index;
+        continue;
+      }
+
+      shmring::Slot* slot = &slots[index];
+      if (slot->state_.load(std::memory_order_acquire) !=
+          shmring::SLOT_SUBMITTED) {
+        LOG_ERROR << "shared memory ring: ignoring slot " << index
+                  << " that is not submitted";
+        continue;
+      }
+
+      HandleSlot(slot);
+      continue;
+    }
+
+    if (++idle_count < kPollSpinCount) {
+      continue;
+    }
+
+    // Nothing submitted for a while, sleep until a client submits. The
+    // sequence number is read before announcing that the thread is
+    // sleeping so a submission racing with the announcement changes
+    // the futex word and FutexWait returns immediately.
+    const uint32_t seq = header_->server_wake_.load();
+    header_->server_sleeping_.store(1);
+    if (shmring::QueuePop(
+            &header_->submit_queue_, submit_cells, slot_count_, &index)) {
+      header_->server_sleeping_.store(0);
+      if ((index < slot_count_) &&
+          (slots[index].state_.load(std::memory_order_acquire) ==
+           shmring::SLOT_SUBMITTED)) {
+        HandleSlot(&slots[index]);
+      } else {
+        LOG_ERROR << "shared memory ring: ignoring invalid slot " << index;
+      }
+      idle_count = 0;
+      continue;
+    }
+
+    shmring::FutexWait(&header_->server_wake_, seq, kPollTimeoutMs);
+    header_->server_sleeping_.store(0);
+    idle_count = 0;
+  }
+}
+
+void
+ShmRingServer::HandleSlot(shmring::Slot* slot)
+{
+  slot->response_.error_ = 0;
+  slot->response_.output_count_ = 0;
+  slot->response_.error_message_[0] = '\0';
+
+  // The request is copied once, the client can't change what has
+  // been validated.
+  shmring::Request request;
+  shmring::ReadRequest(slot, &request);
+
+  switch (request.kind_) {
+    case shmring::RequestKind::INFER: {
+      // On success the slot is completed by the response callback.
+      TRITONSERVER_Error* err = HandleInfer(slot, request);
+      if (err != nullptr) {
+        CompleteSlot(slot, err);
+      }
+      break;
+    }
+    case shmring::RequestKind::REGISTER_SYSTEM_SHM:
+    case shmring::RequestKind::UNREGISTER_SYSTEM_SHM:
+      CompleteSlot(slot, HandleRegion(request));
+      break;
+    default:
+      CompleteSlot(
+          slot, TRITONSERVER_ErrorNew(
+                    TRITONSERVER_ERROR_INVALID_ARG,
+                    std::string(
+                        "unknown shared memory ring request kind " +
+                        std::to_string((uint32_t)request.kind_))
+                        .c_str()));
+      break;
+  }
+}
+
+TRITONSERVER_Error*
+ShmRingServer::HandleRegion(const shmring::Request& request)
+{
+  const shmring::RegionInfo& region = request.region_;
+  if (!shmring::IsTerminated(region.name_) ||
+      !shmring::IsTerminated(region.key_)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "shared memory region name and key must be NUL-terminated");
+  }
+
+  if (request.kind_ == shmring::RequestKind::REGISTER_SYSTEM_SHM) {
+    return shm_manager_->RegisterSystemSharedMemory(
+        region.name_, region.key_, region.offset_, region.byte_size_);
+  }
+
+  // An empty name unregisters all system shared memory regions, as
+  // for the other endpoints.
+  if (region.name_[0] == '\0') {
+    return shm_manager_->UnregisterAll(TRITONSERVER_MEMORY_CPU);
+  }
+  return shm_manager_->Unregister(region.name_, TRITONSERVER_MEMORY_CPU);
+}
+
+TRITONSERVER_Error*
+ShmRingServer::HandleInfer(shmring::Slot* slot, const shmring::Request& request)
+{
+  std::string error;
+  if (!shmring::ValidateInferRequest(request, &error)) {
+    return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, error.c_str());
+  }
+
+  std::unique_ptr<RequestState> state(new RequestState(this, slot));
+
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  RETURN_IF_ERR(TRITONSERVER_InferenceRequestNew(
+      &irequest, server_.get(), request.model_name_, request.model_version_));
+
+  TRITONSERVER_Error* err = nullptr;
+  for (uint32_t i = 0; (err == nullptr) && (i < request.input_count_); ++i) {
+    const shmring::Tensor& input = request.inputs_[i];
+    err = TRITONSERVER_InferenceRequestAddInput(
+        irequest, input.name_, TRITONSERVER_StringToDataType(input.datatype_),
+        input.shape_, input.dims_count_);
+
+    void* base = nullptr;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    SharedMemoryManager::Lease lease;
+    if (err == nullptr) {
+      err = shm_manager_->GetMemoryInfo(
+          input.region_, input.offset_, &base, &memory_type, &memory_type_id,
+          &lease);
+    }
+    if (err == nullptr) {
+      state->leases_.emplace_back(std::move(lease));
+      err = TRITONSERVER_InferenceRequestAppendInputData(
+          irequest, input.name_, base, input.byte_size_, memory_type,
+          memory_type_id);
+    }
+  }
+
+  for (uint32_t i = 0; (err == nullptr) && (i < request.output_count_); ++i) {
+    const shmring::Tensor& output = request.outputs_[i];
+    err = TRITONSERVER_InferenceRequestAddRequestedOutput(
+        irequest, output.name_);
+
+    RequestState::Output info;
+    SharedMemoryManager::Lease lease;
+    if (err == nullptr) {
+      err = shm_manager_->GetMemoryInfo(
+          output.region_, output.offset_, &info.base_, &info.memory_type_,
+          &info.memory_type_id_, &lease);
+    }
+    if (err == nullptr) {
+      info.name_ = output.name_;
+      info.byte_size_ = output.byte_size_;
+      state->outputs_.emplace_back(std::move(info));
+      state->leases_.emplace_back(std::move(lease));
+
+      // Until the response arrives the output is reported as empty.
+      slot->response_.outputs_[i] = output;
+      slot->response_.outputs_[i].byte_size_ = 0;
+    }
+  }
+
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+        irequest, InferRequestComplete, state.get());
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, allocator_, state.get(), InferResponseComplete,
+        state.get());
+  }
+  if (err == nullptr) {
+    // Count the request before submitting it since the callbacks may
+    // run before TRITONSERVER_ServerInferAsync returns.
+    {
+      std::lock_guard<std::mutex> lk(inflight_mu_);
+      ++inflight_;
+    }
+    err = TRITONSERVER_ServerInferAsync(
+        server_.get(), irequest, nullptr /* trace */);
+    if (err == nullptr) {
+      // The callbacks own the state now.
+      state.release();
+    } else {
+      std::lock_guard<std::mutex> lk(inflight_mu_);
+      --inflight_;
+    }
+  }
+
+  if (err != nullptr) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(irequest),
+        "deleting shared memory ring inference request");
+  }
+
+  return err;
+}
+
+void
+ShmRingServer::CompleteSlot(shmring::Slot* slot, TRITONSERVER_Error* err)
+{
+  shmring::Response* response = &slot->response_;
+  if (err != nullptr) {
+    response->error_ = 1;
+    response->output_count_ = 0;
+    std::strncpy(
+        response->error_message_, TRITONSERVER_ErrorMessage(err),
+        shmring::kMaxErrorLength - 1);
+    response->error_message_[shmring::kMaxErrorLength - 1] = '\0';
+    TRITONSERVER_ErrorDelete(err);
+  }
+
+  // The client either sees the slot complete or has announced that it
+  // is waiting before the state changes, see shmring::Client::Wait().
+  slot->state_.store(shmring::SLOT_COMPLETE);
+  if (slot->waiting_.load() != 0) {
+    shmring::FutexWake(&slot->state_);
+  }
+}
+
+TRITONSERVER_Error*
+ShmRingServer::ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  RequestState* state = reinterpret_cast<RequestState*>(userp);
+
+  *buffer = nullptr;
+  *buffer_userp = nullptr;
+  *actual_memory_type = preferred_memory_type;
+  *actual_memory_type_id = preferred_memory_type_id;
+
+  for (const auto& output : state->outputs_) {
+    if (output.name_ != tensor_name) {
+      continue;
+    }
+
+    if (byte_size > output.byte_size_) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          std::string(
+              "shared memory size specified with the request for output '" +
+              std::string(tensor_name) + "' (" +
+              std::to_string(output.byte_size_) +
+              " bytes) should be at least " + std::to_string(byte_size) +
+              " bytes to hold the results")
+              .c_str());
+    }
+
+    *buffer = output.base_;
+    *actual_memory_type = output.memory_type_;
+    *actual_memory_type_id = output.memory_type_id_;
+    return nullptr;  // success
+  }
+
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_INVALID_ARG,
+      std::string(
+          "output '" + std::string(tensor_name) +
+          "' must be requested with a shared memory region")
+          .c_str());
+}
+
+TRITONSERVER_Error*
+ShmRingServer::ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer, void* buffer_userp,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  // Outputs are always written to shared memory owned by the client.
+  return nullptr;  // success
+}
+
+void
+ShmRingServer::InferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  if ((flags & TRITONSERVER_REQUEST_RELEASE_ALL) != 0) {
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestDelete(request),
+        "deleting shared memory ring inference request");
+
+    RequestState* state = reinterpret_cast<RequestState*>(userp);
+    state->server_->RequestDone(state);
+  }
+}
+
+void
+ShmRingServer::InferResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  RequestState* state = reinterpret_cast<RequestState*>(userp);
+  shmring::Response* slot_response = &state->slot_->response_;
+
+  if (response != nullptr) {
+    // The ring carries exactly one response per request.
+    TRITONSERVER_Error* err = nullptr;
+    if (++state->response_count_ > 1) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          "shared memory ring does not support models that produce more "
+          "than one response per request");
+    }
+    if (err == nullptr) {
+      err = TRITONSERVER_InferenceResponseError(response);
+    }
+
+    uint32_t output_count = 0;
+    if (err == nullptr) {
+      err = TRITONSERVER_InferenceResponseOutputCount(response, &output_count);
+    }
+    for (uint32_t idx = 0; (err == nullptr) && (idx < output_count); ++idx) {
+      const char* name;
+      TRITONSERVER_DataType datatype;
+      const int64_t* shape;
+      uint64_t dim_count;
+      const void* base;
+      size_t byte_size;
+      TRITONSERVER_MemoryType memory_type;
+      int64_t memory_type_id;
+      void* output_userp;
+      err = TRITONSERVER_InferenceResponseOutput(
+          response, idx, &name, &datatype, &shape, &dim_count, &base,
+          &byte_size, &memory_type, &memory_type_id, &output_userp);
+      if ((err == nullptr) && (dim_count > shmring::kMaxDims)) {
+        err = TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_UNSUPPORTED,
+            std::string(
+                "output '" + std::string(name) + "' has " +
+                std::to_string(dim_count) + " dimensions, at most " +
+                std::to_string(shmring::kMaxDims) + " are supported")
+                .c_str());
+      }
+      if (err != nullptr) {
+        break;
+      }
+
+      for (size_t i = 0; i < state->outputs_.size(); ++i) {
+        if (state->outputs_[i].name_ != name) {
+          continue;
+        }
+        shmring::Tensor* tensor = &slot_response->outputs_[i];
+        shmring::CopyName(
+            tensor->datatype_, TRITONSERVER_DataTypeString(datatype));
+        tensor->dims_count_ = dim_count;
+        std::copy(shape, shape + dim_count, tensor->shape_);
+        tensor->byte_size_ = byte_size;
+        break;
+      }
+    }
+
+    if (err == nullptr) {
+      slot_response->output_count_ = state->outputs_.size();
+    } else if (state->err_ == nullptr) {
+      state->err_ = err;
+    } else {
+      TRITONSERVER_ErrorDelete(err);
+    }
+
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceResponseDelete(response),
+        "deleting shared memory ring inference response");
+  }
+
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    if ((state->err_ == nullptr) && (state->response_count_ == 0)) {
+      state->err_ = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL, "inference request has no response");
+    }
+    CompleteSlot(state->slot_, state->err_);
+    state->err_ = nullptr;
+    state->server_->RequestDone(state);
+  }
+}
+
+void
+ShmRingServer::RequestDone(RequestState* state)
+{
+  if (--state->pending_ != 0) {
+    return;
+  }
+
+  delete state;
+
+  std::lock_guard<std::mutex> lk(inflight_mu_);
+  if (--inflight_ == 0) {
+    inflight_cv_.notify_all();
+  }
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,124 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "src/servers/shared_memory_manager.h"
+#include "src/servers/shm_ring.h"
+#include "triton/core/tritonserver.h"
+
+namespace nvidia { namespace inferenceserver {
+
+// Serve inference requests submitted by clients on the same host
+// through a shared-memory request ring, see shm_ring.h for the
+// layout of the ring. Inputs and outputs of the requests must be in
+// system shared memory regions registered with 'shm_manager', which
+// is shared with the other endpoints so regions can be registered
+// with any of them.
+class ShmRingServer {
+ public:
+  static TRITONSERVER_Error* Create(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::string& ring_name, const uint32_t slot_count,
+      std::unique_ptr<ShmRingServer>* shm_ring_server);
+
+  ~ShmRingServer();
+
+  TRITONSERVER_Error* Start();
+  TRITONSERVER_Error* Stop();
+
+ private:
+  struct RequestState;
+
+  ShmRingServer(
+      const std::shared_ptr<TRITONSERVER_Server>& server,
+      const std::shared_ptr<SharedMemoryManager>& shm_manager,
+      const std::string& ring_name, const uint32_t slot_count);
+
+  // Wait for submitted slots and execute their requests until the
+  // server is stopped.
+  void PollRing();
+
+  // Execute the request in 'slot' and complete the slot, either
+  // immediately or once the inference response is available.
+  void HandleSlot(shmring::Slot* slot);
+  TRITONSERVER_Error* HandleInfer(
+      shmring::Slot* slot, const shmring::Request& request);
+  TRITONSERVER_Error* HandleRegion(const shmring::Request& request);
+
+  // Write 'err' (if any) into the response of 'slot', mark the slot
+  // complete and wake the client if it is waiting. Takes ownership of
+  // 'err'.
+  static void CompleteSlot(shmring::Slot* slot, TRITONSERVER_Error* err);
+
+  static TRITONSERVER_Error* ResponseAlloc(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+      int64_t preferred_memory_type_id, void* userp, void** buffer,
+      void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+  static TRITONSERVER_Error* ResponseRelease(
+      TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+      void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id);
+  static void InferRequestComplete(
+      TRITONSERVER_InferenceRequest* request, const uint32_t flags,
+      void* userp);
+  static void InferResponseComplete(
+      TRITONSERVER_InferenceResponse* response, const uint32_t flags,
+      void* userp);
+
+  // Called when the last callback of a request has run.
+  void RequestDone(RequestState* state);
+
+  std::shared_ptr<TRITONSERVER_Server> server_;
+  std::shared_ptr<SharedMemoryManager> shm_manager_;
+  const std::string ring_name_;
+  const uint32_t slot_count_;
+
+  TRITONSERVER_ResponseAllocator* allocator_;
+
+  shmring::Header* header_;
+  size_t byte_size_;
+
+  std::unique_ptr<std::thread> poll_thread_;
+  std::atomic<bool> exiting_;
+
+  // The number of inference requests that have been handed to the
+  // server but whose callbacks have not all run yet. The ring can't
+  // be unmapped while this is non-zero.
+  std::mutex inflight_mu_;
+  std::condition_variable inflight_cv_;
+  size_t inflight_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,59 @@
+// Copyright (c) 2019-2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iostream>
+#include "src/servers/tracer.h"
+
+// Convert a trace file written with --trace-format=binary into the
+// JSON trace format.
+int
+main(int argc, char** argv)
+{
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <binary trace file> <JSON trace file>" << std::endl;
+    return 1;
+  }
+
+  uint64_t dropped_cnt = 0;
+  TRITONSERVER_Error* err =
+      nvidia::inferenceserver::TraceManager::ConvertBinaryTrace(
+          argv[1], argv[2], &dropped_cnt);
+  if (err != nullptr) {
+    std::cerr << "error: " << TRITONSERVER_ErrorMessage(err) << std::endl;
+    TRITONSERVER_ErrorDelete(err);
+    return 1;
+  }
+
+  if (dropped_cnt > 0) {
+    std::cerr << "warning: " << dropped_cnt
+              << " trace records were dropped while collecting the trace"
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Single-producer single-consumer ring buffer of fixed-size trace
+// records of type 'T'. The thread that owns the ring is the only
+// producer and the binary writer thread of the trace manager is the
+// only consumer.
+//
+template <typename T>
+class TraceRing {
+ public:
+  // Create a ring that holds 'capacity' records, which must be a
+  // power of 2.
+  explicit TraceRing(const size_t capacity)
+      : capacity_(capacity), records_(new T[capacity]), head_(0), tail_(0)
+  {
+  }
+
+  // Append a record. Return false if the ring is full.
+  bool Push(const T& record)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if ((tail - head_.load(std::memory_order_acquire)) >= capacity_) {
+      return false;
+    }
+
+    records_[tail & (capacity_ - 1)] = record;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Write all the records in the ring to 'out' and remove them from
+  // the ring. Return the number of records written.
+  size_t Drain(std::ostream* out)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    if (head == tail) {
+      return 0;
+    }
+
+    const size_t begin = head & (capacity_ - 1);
+    const size_t end = tail & (capacity_ - 1);
+    if (begin < end) {
+      Write(out, begin, end);
+    } else {
+      Write(out, begin, capacity_);
+      Write(out, 0, end);
+    }
+
+    head_.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+ private:
+  void Write(std::ostream* out, const size_t begin, const size_t end)
+  {
+    out->write(
+        reinterpret_cast<const char*>(&records_[begin]),
+        (end - begin) * sizeof(T));
+  }
+
+  const size_t capacity_;
+  std::unique_ptr<T[]> records_;
+
+  // Keep the consumer and producer positions on separate cache lines.
+  std::atomic<size_t> head_;
+  char pad_[64];
+  std::atomic<size_t> tail_;
+};
+
+}}  // namespace nvidia::inferenceserver
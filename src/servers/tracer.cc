@@ -26,6 +26,11 @@
 
 #include "src/servers/tracer.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
 #include <unordered_map>
 #include "src/core/constants.h"
 #include "src/core/logging.h"
@@ -34,17 +39,190 @@ namespace nvidia { namespace inferenceserver {
 
 namespace {
 struct TraceStreams {
-  TraceStreams(TraceManager* manager) : manager_(manager) {}
+  TraceStreams(TraceManager* manager) : manager_(manager), root_id_(0) {}
   TraceManager* manager_;
   std::mutex mtx_;
   std::unordered_map<uint64_t, std::unique_ptr<std::stringstream>> streams_;
+
+  // Used for TraceFormat::CHROME, the id of the root trace and the
+  // activity collected for each trace until the trace is released.
+  uint64_t root_id_;
+  std::unordered_map<uint64_t, std::unique_ptr<ChromeTrace>> chrome_traces_;
+};
+
+// Trace-event process that holds the request and queue spans.
+constexpr uint32_t kChromeRequestPid = 1;
+
+// The binary trace file is a header followed by a sequence of
+// fixed-size records.
+constexpr char kBinaryTraceMagic[8] = {'T', 'R', 'I', 'T', 'O', 'N', 'T', 'R'};
+constexpr uint32_t kBinaryTraceVersion = 1;
+
+// Size of the name stored in a binary record, including the
+// terminating null. Longer names are truncated.
+constexpr size_t kBinaryTraceNameSize = 88;
+
+// Number of records in the ring buffer of each thread. Must be a
+// power of 2.
+constexpr size_t kTraceRingSize = 1024;
+
+// Interval at which the background thread drains the ring buffers.
+constexpr uint64_t kBinaryTraceFlushIntervalMs = 5;
+
+enum BinaryRecordType : uint32_t {
+  // An activity reported to the trace object. The record for
+  // TRITONSERVER_TRACE_REQUEST_START also holds the model name,
+  // version and parent id of the trace.
+  RECORD_ACTIVITY = 0,
+
+  // A timestamp captured with TraceManager::CaptureTimestamp.
+  RECORD_TIMESTAMP = 1,
+
+  // The number of records, held in 'id_', that were dropped since
+  // the previous record of this type.
+  RECORD_DROPPED = 2
+};
+
+struct BinaryTraceHeader {
+  char magic_[8];
+  uint32_t version_;
+  uint32_t record_size_;
+};
+
+std::atomic<uint64_t> next_manager_id_(1);
+}  // namespace
+
+struct BinaryTraceRecord {
+  uint64_t id_;
+  uint64_t parent_id_;
+  uint64_t timestamp_ns_;
+  int64_t model_version_;
+  uint32_t type_;
+  uint32_t activity_;
+  char name_[kBinaryTraceNameSize];
+};
+
+static_assert(
+    sizeof(BinaryTraceRecord) == 128,
+    "unexpected size for binary trace record");
+
+struct ChromeTrace {
+  ChromeTrace() : model_version_(-1), parent_id_(0) {}
+
+  std::string model_name_;
+  int64_t model_version_;
+  uint64_t parent_id_;
+
+  // The thread that reported the compute activity, which is the
+  // execution thread of the model instance that ran the request.
+  std::thread::id compute_thread_;
+
+  std::map<TRITONSERVER_InferenceTraceActivity, uint64_t> timestamps_;
+};
+
+namespace {
+void
+InitRecord(
+    BinaryTraceRecord* record, const BinaryRecordType type, const uint64_t id,
+    const uint64_t timestamp_ns)
+{
+  record->id_ = id;
+  record->parent_id_ = 0;
+  record->timestamp_ns_ = timestamp_ns;
+  record->model_version_ = 0;
+  record->type_ = type;
+  record->activity_ = 0;
+  record->name_[0] = '\0';
+}
+
+void
+SetRecordName(BinaryTraceRecord* record, const char* name)
+{
+  strncpy(record->name_, name, kBinaryTraceNameSize - 1);
+  record->name_[kBinaryTraceNameSize - 1] = '\0';
+}
+
+// Trace-event timestamps and durations are in microseconds.
+void
+WriteChromeTime(std::ostream& out, const uint64_t ns)
+{
+  char buf[32];
+  snprintf(
+      buf, sizeof(buf), "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+  out << buf;
+}
+
+// Collects a comma-separated list of trace events.
+class ChromeEvents {
+ public:
+  ChromeEvents() : cnt_(0) {}
+
+  // Return the stream to write the next event to.
+  std::ostream& Next()
+  {
+    if (cnt_++ > 0) {
+      ss_ << ",";
+    }
+    return ss_;
+  }
+
+  // Write a metadata event that names a process or thread.
+  void Name(
+      const char* kind, const uint32_t pid, const uint32_t tid,
+      const std::string& name)
+  {
+    Next() << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid
+           << ",\"tid\":" << tid << ",\"args\":{\"name\":\"" << name
+           << "\"}}";
+  }
+
+  // Write the begin and end events of an async span.
+  void AsyncSpan(
+      const std::string& name, const uint64_t id, const uint64_t start_ns,
+      const uint64_t end_ns, const std::string& args)
+  {
+    std::ostream& begin = Next();
+    begin << "{\"name\":\"" << name << "\",\"cat\":\"request\",\"ph\":\"b\""
+          << ",\"id\":" << id << ",\"pid\":" << kChromeRequestPid
+          << ",\"tid\":0,\"ts\":";
+    WriteChromeTime(begin, start_ns);
+    begin << ",\"args\":{" << args << "}}";
+
+    std::ostream& end = Next();
+    end << "{\"name\":\"" << name << "\",\"cat\":\"request\",\"ph\":\"e\""
+        << ",\"id\":" << id << ",\"pid\":" << kChromeRequestPid
+        << ",\"tid\":0,\"ts\":";
+    WriteChromeTime(end, end_ns);
+    end << "}";
+  }
+
+  // Write a complete event on a thread track.
+  void Span(
+      const char* name, const uint32_t pid, const uint32_t tid,
+      const uint64_t start_ns, const uint64_t end_ns, const uint64_t id)
+  {
+    std::ostream& out = Next();
+    out << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":" << pid
+        << ",\"tid\":" << tid << ",\"ts\":";
+    WriteChromeTime(out, start_ns);
+    out << ",\"dur\":";
+    WriteChromeTime(out, (end_ns > start_ns) ? (end_ns - start_ns) : 0);
+    out << ",\"args\":{\"id\":" << id << "}}";
+  }
+
+  bool Empty() const { return cnt_ == 0; }
+  const std::stringstream& Stream() const { return ss_; }
+
+ private:
+  size_t cnt_;
+  std::stringstream ss_;
 };
 }  // namespace
 
 TRITONSERVER_Error*
 TraceManager::Create(
     TraceManager** manager, const TRITONSERVER_InferenceTraceLevel level,
-    const uint32_t rate, const std::string& filepath)
+    const uint32_t rate, const std::string& filepath, const TraceFormat format)
 {
   if (filepath.empty()) {
     return TRITONSERVER_ErrorNew(
@@ -54,10 +232,19 @@ TraceManager::Create(
 
   try {
     std::unique_ptr<std::ofstream> trace_file(new std::ofstream);
-    trace_file->open(filepath);
+    if (format == TraceFormat::BINARY) {
+      trace_file->open(filepath, std::ios::out | std::ios::binary);
+    } else {
+      trace_file->open(filepath);
+    }
 
     LOG_INFO << "Configure trace: " << filepath;
-    *manager = new TraceManager(level, rate, std::move(trace_file));
+    *manager = new TraceManager(level, rate, format, std::move(trace_file));
+    if (format == TraceFormat::CHROME) {
+      ChromeEvents events;
+      events.Name("process_name", kChromeRequestPid, 0, "requests");
+      (*manager)->WriteTrace(events.Stream());
+    }
   }
   catch (const std::ofstream::failure& e) {
     return TRITONSERVER_ErrorNew(
@@ -76,15 +263,41 @@ TraceManager::Create(
 
 TraceManager::TraceManager(
     const TRITONSERVER_InferenceTraceLevel level, const uint32_t rate,
-    std::unique_ptr<std::ofstream>&& trace_file)
-    : level_(level), rate_(rate), trace_file_(std::move(trace_file)),
-      trace_cnt_(0), sample_(1)
+    const TraceFormat format, std::unique_ptr<std::ofstream>&& trace_file)
+    : level_(level), rate_(rate), format_(format),
+      trace_file_(std::move(trace_file)), trace_cnt_(0), sample_(1),
+      id_(next_manager_id_.fetch_add(1)), dropped_cnt_(0),
+      reported_dropped_cnt_(0), writer_exit_(false)
 {
+  if (format_ == TraceFormat::BINARY) {
+    BinaryTraceHeader header;
+    memcpy(header.magic_, kBinaryTraceMagic, sizeof(header.magic_));
+    header.version_ = kBinaryTraceVersion;
+    header.record_size_ = sizeof(BinaryTraceRecord);
+    trace_file_->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writer_thread_ = std::thread([this]() { BinaryWriterThread(); });
+  }
 }
 
 TraceManager::~TraceManager()
 {
-  if (trace_cnt_ > 0) {
+  if (writer_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(writer_mu_);
+      writer_exit_ = true;
+    }
+    writer_cv_.notify_all();
+    writer_thread_.join();
+
+    // Write any records appended after the last pass of the writer
+    // thread.
+    DrainRings();
+    if (reported_dropped_cnt_ > 0) {
+      LOG_WARNING << "binary trace dropped " << reported_dropped_cnt_
+                  << " trace records because of ring buffer overflow";
+    }
+  } else if (trace_cnt_ > 0) {
     *trace_file_ << "]";
   }
 
@@ -112,6 +325,10 @@ TraceManager::SampleTrace(void** userp)
     return nullptr;
   }
 
+  LOG_TRITONSERVER_ERROR(
+      TRITONSERVER_InferenceTraceId(trace, &luserp->root_id_),
+      "getting trace id");
+
   if (userp != nullptr) {
     *userp = luserp.get();
   }
@@ -136,6 +353,284 @@ TraceManager::WriteTrace(const std::stringstream& ss)
   *trace_file_ << ss.rdbuf();
 }
 
+uint32_t
+TraceManager::ChromeProcessId(const std::string& model_name, bool* created)
+{
+  std::lock_guard<std::mutex> lk(chrome_mu_);
+  auto itr = chrome_pids_.find(model_name);
+  *created = (itr == chrome_pids_.end());
+  if (*created) {
+    const uint32_t pid = kChromeRequestPid + 1 + chrome_pids_.size();
+    itr = chrome_pids_.emplace(model_name, pid).first;
+  }
+
+  return itr->second;
+}
+
+uint32_t
+TraceManager::ChromeThreadId(
+    const uint32_t pid, const std::thread::id thread, bool* created)
+{
+  std::lock_guard<std::mutex> lk(chrome_mu_);
+  auto itr = chrome_tids_.find(thread);
+  if (itr == chrome_tids_.end()) {
+    itr = chrome_tids_.emplace(thread, chrome_tids_.size() + 1).first;
+  }
+
+  *created = chrome_named_threads_.emplace(pid, itr->second).second;
+  return itr->second;
+}
+
+void
+TraceManager::WriteChromeTrace(
+    const uint64_t id, const uint64_t root_id, const ChromeTrace& trace)
+{
+  auto Timestamp = [&trace](TRITONSERVER_InferenceTraceActivity activity) {
+    const auto itr = trace.timestamps_.find(activity);
+    return (itr == trace.timestamps_.end()) ? 0 : itr->second;
+  };
+
+  const uint64_t request_start_ns = Timestamp(TRITONSERVER_TRACE_REQUEST_START);
+  const uint64_t request_end_ns = Timestamp(TRITONSERVER_TRACE_REQUEST_END);
+  const uint64_t queue_start_ns = Timestamp(TRITONSERVER_TRACE_QUEUE_START);
+  const uint64_t compute_start_ns = Timestamp(TRITONSERVER_TRACE_COMPUTE_START);
+  const uint64_t input_end_ns = Timestamp(TRITONSERVER_TRACE_COMPUTE_INPUT_END);
+  const uint64_t output_start_ns =
+      Timestamp(TRITONSERVER_TRACE_COMPUTE_OUTPUT_START);
+  const uint64_t compute_end_ns = Timestamp(TRITONSERVER_TRACE_COMPUTE_END);
+
+  ChromeEvents events;
+
+  // The request and queue spans use the id of the root trace so that
+  // the requests made by an ensemble are nested within the ensemble
+  // request.
+  if ((request_start_ns != 0) && (request_end_ns != 0)) {
+    std::stringstream args;
+    args << "\"id\":" << id << ",\"model_version\":" << trace.model_version_;
+    if (trace.parent_id_ != 0) {
+      args << ",\"parent_id\":" << trace.parent_id_;
+    }
+    events.AsyncSpan(
+        trace.model_name_, root_id, request_start_ns, request_end_ns,
+        args.str());
+  }
+  if ((queue_start_ns != 0) && (compute_start_ns != 0)) {
+    events.AsyncSpan(
+        "queue", root_id, queue_start_ns, compute_start_ns,
+        "\"id\":" + std::to_string(id));
+  }
+
+  if ((compute_start_ns != 0) && (compute_end_ns != 0)) {
+    bool created;
+    const uint32_t pid = ChromeProcessId(trace.model_name_, &created);
+    if (created) {
+      events.Name("process_name", pid, 0, trace.model_name_);
+    }
+    const uint32_t tid = ChromeThreadId(pid, trace.compute_thread_, &created);
+    if (created) {
+      events.Name(
+          "thread_name", pid, tid, "execution thread " + std::to_string(tid));
+    }
+
+    // Requests executed in the same batch have the same compute
+    // timestamps, so they show as stacked spans on the thread track.
+    events.Span("compute", pid, tid, compute_start_ns, compute_end_ns, id);
+    if ((input_end_ns != 0) && (output_start_ns != 0)) {
+      events.Span(
+          "compute_input", pid, tid, compute_start_ns, input_end_ns, id);
+      events.Span("infer", pid, tid, input_end_ns, output_start_ns, id);
+      events.Span("output", pid, tid, output_start_ns, compute_end_ns, id);
+    }
+  }
+
+  if (!events.Empty()) {
+    WriteTrace(events.Stream());
+  }
+}
+
+TraceRing<BinaryTraceRecord>*
+TraceManager::ThreadRing()
+{
+  // Each thread caches its ring for each manager it has traced for,
+  // so a thread that alternates between managers keeps using the same
+  // ring of each manager. Manager ids are never reused, so the ring of
+  // a destroyed manager is never found.
+  thread_local std::unordered_map<uint64_t, TraceRing<BinaryTraceRecord>*>
+      rings;
+
+  auto& ring = rings[id_];
+  if (ring == nullptr) {
+    std::unique_ptr<TraceRing<BinaryTraceRecord>> lring(
+        new TraceRing<BinaryTraceRecord>(kTraceRingSize));
+    ring = lring.get();
+    std::lock_guard<std::mutex> lk(rings_mu_);
+    rings_.emplace_back(std::move(lring));
+  }
+
+  return ring;
+}
+
+void
+TraceManager::AppendRecord(const BinaryTraceRecord& record)
+{
+  if (!ThreadRing()->Push(record)) {
+    dropped_cnt_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void
+TraceManager::BinaryWriterThread()
+{
+  std::unique_lock<std::mutex> lk(writer_mu_);
+  while (!writer_exit_) {
+    lk.unlock();
+    DrainRings();
+    lk.lock();
+
+    writer_cv_.wait_for(
+        lk, std::chrono::milliseconds(kBinaryTraceFlushIntervalMs),
+        [this] { return writer_exit_; });
+  }
+}
+
+size_t
+TraceManager::DrainRings()
+{
+  std::vector<TraceRing<BinaryTraceRecord>*> rings;
+  {
+    std::lock_guard<std::mutex> lk(rings_mu_);
+    rings.reserve(rings_.size());
+    for (const auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+  }
+
+  size_t cnt = 0;
+  for (auto ring : rings) {
+    cnt += ring->Drain(trace_file_.get());
+  }
+
+  // Record the overflow in the trace file so that it is reported when
+  // the trace is converted.
+  const uint64_t dropped_cnt = dropped_cnt_.load(std::memory_order_relaxed);
+  if (dropped_cnt != reported_dropped_cnt_) {
+    if (reported_dropped_cnt_ == 0) {
+      LOG_WARNING << "binary trace ring buffer overflow, dropping trace "
+                  << "records; consider increasing the trace rate";
+    }
+
+    BinaryTraceRecord record;
+    InitRecord(
+        &record, RECORD_DROPPED, dropped_cnt - reported_dropped_cnt_,
+        0 /* timestamp_ns */);
+    trace_file_->write(reinterpret_cast<const char*>(&record), sizeof(record));
+    reported_dropped_cnt_ = dropped_cnt;
+    cnt++;
+  }
+
+  return cnt;
+}
+
+TRITONSERVER_Error*
+TraceManager::ConvertBinaryTrace(
+    const std::string& binary_filepath, const std::string& json_filepath,
+    uint64_t* dropped_cnt)
+{
+  *dropped_cnt = 0;
+
+  std::ifstream in(binary_filepath, std::ios::in | std::ios::binary);
+  if (!in) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "failed to open binary trace file '" + binary_filepath + "'")
+            .c_str());
+  }
+
+  BinaryTraceHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      (memcmp(header.magic_, kBinaryTraceMagic, sizeof(header.magic_)) != 0) ||
+      (header.version_ != kBinaryTraceVersion) ||
+      (header.record_size_ != sizeof(BinaryTraceRecord))) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("'" + binary_filepath + "' is not a binary trace file")
+            .c_str());
+  }
+
+  std::ofstream out(json_filepath);
+  if (!out) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("failed to open JSON trace file '" + json_filepath + "'")
+            .c_str());
+  }
+
+  // A partial record at the end of the file, left if the server did
+  // not exit cleanly, is ignored.
+  std::vector<BinaryTraceRecord> records;
+  BinaryTraceRecord record;
+  while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+    record.name_[kBinaryTraceNameSize - 1] = '\0';
+
+    if (record.type_ == RECORD_DROPPED) {
+      *dropped_cnt += record.id_;
+      continue;
+    }
+
+    records.push_back(record);
+  }
+
+  // The rings of different threads are drained one after another, so
+  // the records of a trace are not in time order in the file. Write
+  // them in time order, as the JSON format would have them.
+  std::stable_sort(
+      records.begin(), records.end(),
+      [](const BinaryTraceRecord& lhs, const BinaryTraceRecord& rhs) {
+        return lhs.timestamp_ns_ < rhs.timestamp_ns_;
+      });
+
+  // Each record becomes one object of the JSON array, the objects of a
+  // trace are tied together by their "id".
+  size_t object_cnt = 0;
+  for (const auto& record : records) {
+    out << ((object_cnt++ == 0) ? "[" : ",");
+
+    const char* name = record.name_;
+    if (record.type_ == RECORD_ACTIVITY) {
+      const auto activity =
+          static_cast<TRITONSERVER_InferenceTraceActivity>(record.activity_);
+      if (activity == TRITONSERVER_TRACE_REQUEST_START) {
+        out << "{\"id\":" << record.id_ << ",\"model_name\":\"" << record.name_
+            << "\",\"model_version\":" << record.model_version_;
+        if (record.parent_id_ != 0) {
+          out << ",\"parent_id\":" << record.parent_id_;
+        }
+        out << "},";
+      }
+      name = TRITONSERVER_InferenceTraceActivityString(activity);
+    }
+
+    out << "{\"id\":" << record.id_ << ",\"timestamps\":["
+        << "{\"name\":\"" << name << "\",\"ns\":" << record.timestamp_ns_
+        << "}]}";
+  }
+
+  if (object_cnt > 0) {
+    out << "]";
+  }
+
+  out.close();
+  if (!out) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string("failed to write JSON trace file '" + json_filepath + "'")
+            .c_str());
+  }
+
+  return nullptr;  // success
+}
+
 void
 TraceManager::CaptureTimestamp(
     const uint64_t trace_id, TRITONSERVER_InferenceTraceLevel level,
@@ -148,6 +643,28 @@ TraceManager::CaptureTimestamp(
                          .count();
     }
 
+    if (format_ == TraceFormat::BINARY) {
+      BinaryTraceRecord record;
+      InitRecord(&record, RECORD_TIMESTAMP, trace_id, timestamp_ns);
+      SetRecordName(&record, name.c_str());
+      AppendRecord(record);
+      return;
+    }
+
+    // Timestamps are captured for the root trace, show them as
+    // instant events on the track of the request.
+    if (format_ == TraceFormat::CHROME) {
+      ChromeEvents events;
+      std::ostream& out = events.Next();
+      out << "{\"name\":\"" << name << "\",\"cat\":\"request\",\"ph\":\"n\""
+          << ",\"id\":" << trace_id << ",\"pid\":" << kChromeRequestPid
+          << ",\"tid\":0,\"ts\":";
+      WriteChromeTime(out, timestamp_ns);
+      out << "}";
+      WriteTrace(events.Stream());
+      return;
+    }
+
     std::stringstream ss;
     ss << "{\"id\":" << trace_id << ",\"timestamps\":["
        << "{\"name\":\"" << name << "\",\"ns\":" << timestamp_ns << "}]}";
@@ -161,7 +678,7 @@ TraceManager::TraceRelease(TRITONSERVER_InferenceTrace* trace, void* userp)
 {
   auto ts = reinterpret_cast<TraceStreams*>(userp);
   std::stringstream* ss = nullptr;
-  {
+  if (ts->manager_->format_ == TraceFormat::JSON) {
     uint64_t id;
     LOG_TRITONSERVER_ERROR(
         TRITONSERVER_InferenceTraceId(trace, &id), "getting trace id");
@@ -172,6 +689,24 @@ TraceManager::TraceRelease(TRITONSERVER_InferenceTrace* trace, void* userp)
     ts->manager_->WriteTrace(*ss);
   }
 
+  if (ts->manager_->format_ == TraceFormat::CHROME) {
+    uint64_t id;
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceTraceId(trace, &id), "getting trace id");
+    std::unique_ptr<ChromeTrace> chrome_trace;
+    {
+      std::lock_guard<std::mutex> lk(ts->mtx_);
+      auto itr = ts->chrome_traces_.find(id);
+      if (itr != ts->chrome_traces_.end()) {
+        chrome_trace = std::move(itr->second);
+        ts->chrome_traces_.erase(itr);
+      }
+    }
+    if (chrome_trace != nullptr) {
+      ts->manager_->WriteChromeTrace(id, ts->root_id_, *chrome_trace);
+    }
+  }
+
   uint64_t parent_id;
   LOG_TRITONSERVER_ERROR(
       TRITONSERVER_InferenceTraceParentId(trace, &parent_id),
@@ -196,9 +731,64 @@ TraceManager::TraceActivity(
   LOG_TRITONSERVER_ERROR(
       TRITONSERVER_InferenceTraceId(trace, &id), "getting trace id");
 
+  auto ts = reinterpret_cast<TraceStreams*>(userp);
+
+  // In binary format each activity is a self-contained record appended
+  // to the ring buffer of the calling thread.
+  if (ts->manager_->format_ == TraceFormat::BINARY) {
+    BinaryTraceRecord record;
+    InitRecord(&record, RECORD_ACTIVITY, id, timestamp_ns);
+    record.activity_ = activity;
+    if (activity == TRITONSERVER_TRACE_REQUEST_START) {
+      const char* model_name;
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelName(trace, &model_name),
+          "getting model name");
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelVersion(
+              trace, &record.model_version_),
+          "getting model version");
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceParentId(trace, &record.parent_id_),
+          "getting trace parent id");
+      SetRecordName(&record, model_name);
+    }
+
+    ts->manager_->AppendRecord(record);
+    return;
+  }
+
+  // In Chrome format the activity is collected until the trace is
+  // released, when the complete spans can be written.
+  if (ts->manager_->format_ == TraceFormat::CHROME) {
+    std::lock_guard<std::mutex> lk(ts->mtx_);
+    auto& chrome_trace = ts->chrome_traces_[id];
+    if (chrome_trace == nullptr) {
+      chrome_trace.reset(new ChromeTrace());
+    }
+    if (activity == TRITONSERVER_TRACE_REQUEST_START) {
+      const char* model_name;
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelName(trace, &model_name),
+          "getting model name");
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceModelVersion(
+              trace, &chrome_trace->model_version_),
+          "getting model version");
+      LOG_TRITONSERVER_ERROR(
+          TRITONSERVER_InferenceTraceParentId(
+              trace, &chrome_trace->parent_id_),
+          "getting trace parent id");
+      chrome_trace->model_name_ = model_name;
+    } else if (activity == TRITONSERVER_TRACE_COMPUTE_START) {
+      chrome_trace->compute_thread_ = std::this_thread::get_id();
+    }
+    chrome_trace->timestamps_[activity] = timestamp_ns;
+    return;
+  }
+
   // The function may be called with different traces but the same 'userp',
   // group the activity of the same trace together for more readable output.
-  auto ts = reinterpret_cast<TraceStreams*>(userp);
   std::stringstream* ss = nullptr;
   {
     if (activity == TRITONSERVER_TRACE_REQUEST_START) {
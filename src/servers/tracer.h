@@ -26,15 +26,45 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "src/servers/trace_ring.h"
 #include "triton/core/tritonserver.h"
 
 namespace nvidia { namespace inferenceserver {
 
+// The format of the file written by a trace manager.
+enum class TraceFormat {
+  // A JSON array of trace objects, written as each trace completes.
+  JSON,
+
+  // Fixed-size binary records. Each thread appends the records for
+  // the trace activity it observes to its own lock-free ring buffer
+  // and a background thread drains the rings to the file. Use
+  // TraceManager::ConvertBinaryTrace (or the trace_convert tool) to
+  // produce the JSON format from the binary file.
+  BINARY,
+
+  // The Chrome trace-event format, which can be loaded into Perfetto
+  // or chrome://tracing. Each request is shown as a span, with a
+  // nested queue span, on the track of its root trace so that the
+  // requests of an ensemble nest within the ensemble request. The
+  // compute phases are shown on a track per model execution thread.
+  CHROME
+};
+
+struct BinaryTraceRecord;
+struct ChromeTrace;
+
 //
 // Manager for tracing to a file.
 //
@@ -44,7 +74,16 @@ class TraceManager {
   // to a specified file.
   static TRITONSERVER_Error* Create(
       TraceManager** manager, const TRITONSERVER_InferenceTraceLevel level,
-      const uint32_t rate, const std::string& filepath);
+      const uint32_t rate, const std::string& filepath,
+      const TraceFormat format = TraceFormat::JSON);
+
+  // Convert a trace file written in TraceFormat::BINARY into the
+  // JSON format. Return in 'dropped_cnt' the number of trace records
+  // that were dropped because a ring buffer overflowed while the
+  // binary trace was being collected.
+  static TRITONSERVER_Error* ConvertBinaryTrace(
+      const std::string& binary_filepath, const std::string& json_filepath,
+      uint64_t* dropped_cnt);
 
   ~TraceManager();
 
@@ -65,10 +104,42 @@ class TraceManager {
  private:
   TraceManager(
       const TRITONSERVER_InferenceTraceLevel level, const uint32_t rate,
-      std::unique_ptr<std::ofstream>&& trace_file);
+      const TraceFormat format, std::unique_ptr<std::ofstream>&& trace_file);
 
   void WriteTrace(const std::stringstream& ss);
 
+  // Return the ring buffer that the calling thread appends binary
+  // trace records to, creating it on the first call from the thread.
+  TraceRing<BinaryTraceRecord>* ThreadRing();
+
+  // Append a binary trace record to the ring buffer of the calling
+  // thread, dropping the record if the ring buffer is full.
+  void AppendRecord(const BinaryTraceRecord& record);
+
+  // Background thread that drains the ring buffers into the trace
+  // file when using TraceFormat::BINARY.
+  void BinaryWriterThread();
+
+  // Write all the records currently held by the ring buffers, and a
+  // record of any newly dropped records, to the trace file. Return
+  // the number of records written.
+  size_t DrainRings();
+
+  // Write the trace events for a completed trace when using
+  // TraceFormat::CHROME. 'root_id' is the id of the trace that
+  // started the request, which is 'id' itself unless the trace is
+  // for a model run as part of an ensemble.
+  void WriteChromeTrace(
+      const uint64_t id, const uint64_t root_id, const ChromeTrace& trace);
+
+  // Return the trace-event process id for a model and the thread id
+  // for an execution thread of the model. 'created' returns true the
+  // first time an id is returned, in which case the caller must write
+  // the event that names the process or thread.
+  uint32_t ChromeProcessId(const std::string& model_name, bool* created);
+  uint32_t ChromeThreadId(
+      const uint32_t pid, const std::thread::id thread, bool* created);
+
   static void TraceActivity(
       TRITONSERVER_InferenceTrace* trace,
       TRITONSERVER_InferenceTraceActivity activity, uint64_t timestamp_ns,
@@ -76,6 +147,7 @@ class TraceManager {
 
   const TRITONSERVER_InferenceTraceLevel level_;
   const uint32_t rate_;
+  const TraceFormat format_;
   std::unique_ptr<std::ofstream> trace_file_;
 
   std::mutex mu_;
@@ -83,6 +155,31 @@ class TraceManager {
 
   // Atomically incrementing counter used to implement sampling rate.
   std::atomic<uint64_t> sample_;
+
+  // Unique id of this manager, used to find the ring buffer of this
+  // manager among the ring buffers cached by each thread.
+  const uint64_t id_;
+
+  // Ring buffers used for TraceFormat::BINARY, one per thread that
+  // has produced a trace record.
+  std::mutex rings_mu_;
+  std::vector<std::unique_ptr<TraceRing<BinaryTraceRecord>>> rings_;
+
+  // Number of records dropped because a ring buffer was full, and the
+  // portion of that count already written to the trace file.
+  std::atomic<uint64_t> dropped_cnt_;
+  uint64_t reported_dropped_cnt_;
+
+  bool writer_exit_;
+  std::mutex writer_mu_;
+  std::condition_variable writer_cv_;
+  std::thread writer_thread_;
+
+  // Process and thread ids assigned for TraceFormat::CHROME.
+  std::mutex chrome_mu_;
+  std::unordered_map<std::string, uint32_t> chrome_pids_;
+  std::unordered_map<std::thread::id, uint32_t> chrome_tids_;
+  std::set<std::pair<uint32_t, uint32_t>> chrome_named_threads_;
 };
 
 }}  // namespace nvidia::inferenceserver
@@ -36,8 +36,10 @@
 
 #include <event2/buffer.h>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <fstream>
+#include <iostream>
 #include <future>
 #include <limits>
 #include <mutex>
@@ -615,6 +617,524 @@ TEST_F(DataCompressorTest, CompressGzipBuffer)
   WriteEVBufferToFile("generated_gzip_compressed_data", compressed);
 }
 
+
+// Compress 'data' with 'type' at 'level', with the source split into
+// 'split_count' evbuffer chunks, and check that decompressing the
+// result gives back 'data'. Return the compressed size in
+// 'compressed_byte_size' if non-nullptr.
+void
+CheckRoundTrip(
+    const ni::DataCompressor::Type type, const int level, const char* data,
+    const size_t byte_size, const size_t split_count,
+    size_t* compressed_byte_size = nullptr)
+{
+  auto source = evbuffer_new();
+  ASSERT_TRUE((source != nullptr)) << "Failed to create source evbuffer";
+  const size_t split_byte_size = byte_size / split_count;
+  for (size_t idx = 0; idx < split_count; ++idx) {
+    const size_t offset = idx * split_byte_size;
+    const size_t length = ((idx + 1) == split_count) ? (byte_size - offset)
+                                                     : split_byte_size;
+    auto chunk = evbuffer_new();
+    ASSERT_EQ(evbuffer_add(chunk, data + offset, length), 0)
+        << "Failed to initialize source evbuffer";
+    ASSERT_EQ(evbuffer_add_buffer(source, chunk), 0)
+        << "Failed to initialize source evbuffer";
+    evbuffer_free(chunk);
+  }
+  ASSERT_EQ(evbuffer_peek(source, -1, NULL, NULL, 0), (int)split_count)
+      << "Expect " << split_count << " buffers as source";
+
+  auto compressed = evbuffer_new();
+  auto decompressed = evbuffer_new();
+  auto err =
+      ni::DataCompressor::CompressData(type, source, compressed, level);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to compress data: " << TRITONSERVER_ErrorMessage(err);
+  if (compressed_byte_size != nullptr) {
+    *compressed_byte_size = evbuffer_get_length(compressed);
+  }
+
+  err = ni::DataCompressor::DecompressData(type, compressed, decompressed);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+  ASSERT_EQ(evbuffer_get_length(decompressed), byte_size)
+      << "Mismatched byte size";
+
+  std::vector<char> res;
+  EVBufferToContiguousBuffer(decompressed, &res);
+  ASSERT_EQ(memcmp(data, res.data(), byte_size), 0) << "Mismatched data";
+
+  evbuffer_free(source);
+  evbuffer_free(compressed);
+  evbuffer_free(decompressed);
+}
+
+// Generate 'byte_size' bytes that look like the output tensors of a
+// model: FP32 values that vary smoothly, INT32 class indices or
+// uniformly random bytes that don't compress.
+enum class Payload { FP32, INT32, RANDOM };
+
+std::vector<char>
+GeneratePayload(const Payload payload, const size_t byte_size)
+{
+  std::vector<char> data(byte_size);
+  std::mt19937 rng(0);
+  switch (payload) {
+    case Payload::FP32: {
+      std::normal_distribution<float> noise(0.0f, 0.01f);
+      float* values = reinterpret_cast<float*>(data.data());
+      for (size_t i = 0; i < byte_size / sizeof(float); ++i) {
+        values[i] = std::sin(i / 64.0f) + noise(rng);
+      }
+      break;
+    }
+    case Payload::INT32: {
+      std::uniform_int_distribution<int32_t> classes(0, 999);
+      int32_t* values = reinterpret_cast<int32_t*>(data.data());
+      for (size_t i = 0; i < byte_size / sizeof(int32_t); ++i) {
+        values[i] = classes(rng);
+      }
+      break;
+    }
+    case Payload::RANDOM: {
+      std::uniform_int_distribution<int> bytes(0, 255);
+      for (auto& b : data) {
+        b = bytes(rng);
+      }
+      break;
+    }
+  }
+  return data;
+}
+
+TEST_F(DataCompressorTest, TypeFromString)
+{
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("identity"),
+      ni::DataCompressor::Type::IDENTITY);
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("gzip"),
+      ni::DataCompressor::Type::GZIP);
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("deflate"),
+      ni::DataCompressor::Type::DEFLATE);
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("br"),
+      ni::DataCompressor::Type::UNKNOWN);
+#ifdef TRITON_ENABLE_ZSTD
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("zstd"),
+      ni::DataCompressor::Type::ZSTD);
+#else
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("zstd"),
+      ni::DataCompressor::Type::UNKNOWN);
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("lz4"),
+      ni::DataCompressor::Type::LZ4);
+#else
+  ASSERT_EQ(
+      ni::DataCompressor::TypeFromString("lz4"),
+      ni::DataCompressor::Type::UNKNOWN);
+#endif  // TRITON_ENABLE_LZ4
+}
+
+TEST_F(DataCompressorTest, ValidateOptions)
+{
+  ni::DataCompressor::Options options;
+  ASSERT_TRUE((ni::DataCompressor::ValidateOptions(options) == nullptr));
+
+  options.gzip_level_ = 9;
+  ASSERT_TRUE((ni::DataCompressor::ValidateOptions(options) == nullptr));
+  options.gzip_level_ = 10;
+  auto err = ni::DataCompressor::ValidateOptions(options);
+  ASSERT_TRUE((err != nullptr)) << "Expect error for gzip level 10";
+  ASSERT_EQ(TRITONSERVER_ErrorCode(err), TRITONSERVER_ERROR_INVALID_ARG);
+  options.gzip_level_ = ni::DataCompressor::kDefaultLevel;
+
+#ifdef TRITON_ENABLE_ZSTD
+  options.zstd_level_ = ZSTD_maxCLevel() + 1;
+  ASSERT_TRUE((ni::DataCompressor::ValidateOptions(options) != nullptr))
+      << "Expect error for zstd level " << options.zstd_level_;
+  options.zstd_level_ = ni::DataCompressor::kDefaultLevel;
+#endif  // TRITON_ENABLE_ZSTD
+
+#ifdef TRITON_ENABLE_LZ4
+  options.lz4_level_ = LZ4HC_CLEVEL_MAX + 1;
+  ASSERT_TRUE((ni::DataCompressor::ValidateOptions(options) != nullptr))
+      << "Expect error for lz4 level " << options.lz4_level_;
+#endif  // TRITON_ENABLE_LZ4
+}
+
+TEST_F(DataCompressorTest, GzipLevels)
+{
+  for (const int level : {0, 1, 9}) {
+    CheckRoundTrip(
+        ni::DataCompressor::Type::GZIP, level, raw_data_.get(),
+        raw_data_length_, 1);
+  }
+}
+
+#ifdef TRITON_ENABLE_ZSTD
+TEST_F(DataCompressorTest, ZstdOneBuffer)
+{
+  CheckRoundTrip(
+      ni::DataCompressor::Type::ZSTD, ni::DataCompressor::kDefaultLevel,
+      raw_data_.get(), raw_data_length_, 1);
+}
+
+TEST_F(DataCompressorTest, ZstdTwoBuffer)
+{
+  CheckRoundTrip(
+      ni::DataCompressor::Type::ZSTD, ni::DataCompressor::kDefaultLevel,
+      raw_data_.get(), raw_data_length_, 2);
+}
+
+TEST_F(DataCompressorTest, ZstdLargeBuffer)
+{
+  // Larger than the decompression output buffer so that it is filled
+  // more than once, in several source chunks.
+  const auto data = GeneratePayload(Payload::FP32, 8 << 20);
+  for (const int level : {-5, 1, 3, 19}) {
+    CheckRoundTrip(
+        ni::DataCompressor::Type::ZSTD, level, data.data(), data.size(), 3);
+  }
+}
+
+TEST_F(DataCompressorTest, ZstdTruncated)
+{
+  const auto data = GeneratePayload(Payload::INT32, 1 << 16);
+  auto source = evbuffer_new();
+  ASSERT_EQ(evbuffer_add(source, data.data(), data.size()), 0);
+  auto compressed = evbuffer_new();
+  auto err = ni::DataCompressor::CompressData(
+      ni::DataCompressor::Type::ZSTD, source, compressed);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to compress data: " << TRITONSERVER_ErrorMessage(err);
+
+  // Drop the end of the frame
+  const size_t truncated_byte_size = evbuffer_get_length(compressed) / 2;
+  auto truncated = evbuffer_new();
+  ASSERT_EQ(
+      evbuffer_remove_buffer(compressed, truncated, truncated_byte_size),
+      (int)truncated_byte_size);
+  auto decompressed = evbuffer_new();
+  err = ni::DataCompressor::DecompressData(
+      ni::DataCompressor::Type::ZSTD, truncated, decompressed);
+  ASSERT_TRUE((err != nullptr)) << "Expect error for truncated data";
+}
+#endif  // TRITON_ENABLE_ZSTD
+
+#ifdef TRITON_ENABLE_LZ4
+TEST_F(DataCompressorTest, Lz4OneBuffer)
+{
+  CheckRoundTrip(
+      ni::DataCompressor::Type::LZ4, ni::DataCompressor::kDefaultLevel,
+      raw_data_.get(), raw_data_length_, 1);
+}
+
+TEST_F(DataCompressorTest, Lz4TwoBuffer)
+{
+  CheckRoundTrip(
+      ni::DataCompressor::Type::LZ4, ni::DataCompressor::kDefaultLevel,
+      raw_data_.get(), raw_data_length_, 2);
+}
+
+TEST_F(DataCompressorTest, Lz4LargeBuffer)
+{
+  const auto data = GeneratePayload(Payload::FP32, 8 << 20);
+  for (const int level : {-5, 0, 9}) {
+    CheckRoundTrip(
+        ni::DataCompressor::Type::LZ4, level, data.data(), data.size(), 3);
+  }
+}
+#endif  // TRITON_ENABLE_LZ4
+
+// Compress 'data' with 'type' into a new evbuffer
+evbuffer*
+CompressPayload(
+    const ni::DataCompressor::Type type, const std::vector<char>& data)
+{
+  auto source = evbuffer_new();
+  evbuffer_add(source, data.data(), data.size());
+  auto compressed = evbuffer_new();
+  auto err = ni::DataCompressor::CompressData(type, source, compressed);
+  EXPECT_TRUE((err == nullptr))
+      << "Failed to compress data: " << TRITONSERVER_ErrorMessage(err);
+  evbuffer_free(source);
+  return compressed;
+}
+
+// Decompress 'data' compressed with 'type' section by section, as the
+// HTTP endpoint does for the inference header and each binary input.
+void
+CheckStreamDecompress(
+    const ni::DataCompressor::Type type, const std::vector<char>& data)
+{
+  auto compressed = CompressPayload(type, data);
+  std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+  auto err = ni::DataCompressor::StreamDecompressor::Create(
+      type, compressed, &decompressor);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to create decompressor: " << TRITONSERVER_ErrorMessage(err);
+
+  std::vector<char> res(data.size());
+  size_t offset = 0;
+  size_t section_byte_size = 1;
+  while (offset < data.size()) {
+    const size_t byte_size =
+        std::min(section_byte_size, data.size() - offset);
+    err = decompressor->Read(res.data() + offset, byte_size);
+    ASSERT_TRUE((err == nullptr))
+        << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+    offset += byte_size;
+    section_byte_size = section_byte_size * 7 + 3;
+  }
+  ASSERT_EQ(memcmp(data.data(), res.data(), data.size()), 0)
+      << "Mismatched data";
+
+  bool end = false;
+  err = decompressor->AtEnd(&end);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to check end of data: " << TRITONSERVER_ErrorMessage(err);
+  ASSERT_TRUE(end) << "Expect end of decompressed data";
+  ASSERT_EQ(evbuffer_get_length(compressed), (size_t)0)
+      << "Expect compressed data to be drained";
+
+  char byte;
+  err = decompressor->Read(&byte, 1);
+  ASSERT_TRUE((err != nullptr)) << "Expect error reading past the end";
+  evbuffer_free(compressed);
+}
+
+// Check that reading more than the decompressed data, or checking for
+// the end before all data is read, is detected.
+void
+CheckStreamDecompressSize(
+    const ni::DataCompressor::Type type, const std::vector<char>& data)
+{
+  {
+    auto compressed = CompressPayload(type, data);
+    std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+    auto err = ni::DataCompressor::StreamDecompressor::Create(
+        type, compressed, &decompressor);
+    ASSERT_TRUE((err == nullptr));
+    std::vector<char> res(data.size() + 1);
+    err = decompressor->Read(res.data(), res.size());
+    ASSERT_TRUE((err != nullptr)) << "Expect error reading past the end";
+    evbuffer_free(compressed);
+  }
+  {
+    auto compressed = CompressPayload(type, data);
+    std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+    auto err = ni::DataCompressor::StreamDecompressor::Create(
+        type, compressed, &decompressor);
+    ASSERT_TRUE((err == nullptr));
+    std::vector<char> res(data.size() - 1);
+    err = decompressor->Read(res.data(), res.size());
+    ASSERT_TRUE((err == nullptr))
+        << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+    bool end = true;
+    err = decompressor->AtEnd(&end);
+    ASSERT_TRUE((err == nullptr))
+        << "Failed to check end of data: " << TRITONSERVER_ErrorMessage(err);
+    ASSERT_FALSE(end) << "Expect additional decompressed data";
+    evbuffer_free(compressed);
+  }
+  {
+    // A declared size far beyond the decompressed data must fail
+    // without allocating the declared size.
+    auto compressed = CompressPayload(type, data);
+    std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+    auto err = ni::DataCompressor::StreamDecompressor::Create(
+        type, compressed, &decompressor);
+    ASSERT_TRUE((err == nullptr));
+    std::vector<char> res;
+    err = decompressor->Read(&res, (size_t)1 << 40);
+    ASSERT_TRUE((err != nullptr)) << "Expect error reading past the end";
+    ASSERT_LE(res.capacity(), 4 * (data.size() + 4096));
+    evbuffer_free(compressed);
+  }
+  {
+    // Read into a growing buffer, in two sections
+    auto compressed = CompressPayload(type, data);
+    std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+    auto err = ni::DataCompressor::StreamDecompressor::Create(
+        type, compressed, &decompressor);
+    ASSERT_TRUE((err == nullptr));
+    std::vector<char> res;
+    err = decompressor->Read(&res, data.size() / 2);
+    ASSERT_TRUE((err == nullptr))
+        << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+    err = decompressor->Read(&res, data.size() - data.size() / 2);
+    ASSERT_TRUE((err == nullptr))
+        << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+    ASSERT_EQ(res.size(), data.size()) << "Mismatched byte size";
+    ASSERT_EQ(memcmp(data.data(), res.data(), data.size()), 0)
+        << "Mismatched data";
+    bool end = false;
+    err = decompressor->AtEnd(&end);
+    ASSERT_TRUE((err == nullptr));
+    ASSERT_TRUE(end) << "Expect end of decompressed data";
+    evbuffer_free(compressed);
+  }
+  {
+    // Drop the end of the compressed data
+    auto compressed = CompressPayload(type, data);
+    auto truncated = evbuffer_new();
+    evbuffer_remove_buffer(
+        compressed, truncated, evbuffer_get_length(compressed) - 4);
+    std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+    auto err = ni::DataCompressor::StreamDecompressor::Create(
+        type, truncated, &decompressor);
+    ASSERT_TRUE((err == nullptr));
+    std::vector<char> res;
+    err = decompressor->ReadAll(&res);
+    ASSERT_TRUE((err != nullptr)) << "Expect error for truncated data";
+    evbuffer_free(compressed);
+    evbuffer_free(truncated);
+  }
+}
+
+TEST_F(DataCompressorTest, StreamDecompressGzip)
+{
+  CheckStreamDecompress(
+      ni::DataCompressor::Type::GZIP,
+      GeneratePayload(Payload::INT32, 3 << 20));
+  CheckStreamDecompressSize(
+      ni::DataCompressor::Type::GZIP, GeneratePayload(Payload::INT32, 4096));
+}
+
+TEST_F(DataCompressorTest, StreamDecompressDeflate)
+{
+  CheckStreamDecompress(
+      ni::DataCompressor::Type::DEFLATE,
+      GeneratePayload(Payload::FP32, 3 << 20));
+  CheckStreamDecompressSize(
+      ni::DataCompressor::Type::DEFLATE, GeneratePayload(Payload::FP32, 4096));
+}
+
+TEST_F(DataCompressorTest, StreamDecompressReadAll)
+{
+  const auto data = GeneratePayload(Payload::FP32, 1 << 20);
+  auto compressed = CompressPayload(ni::DataCompressor::Type::GZIP, data);
+  std::unique_ptr<ni::DataCompressor::StreamDecompressor> decompressor;
+  auto err = ni::DataCompressor::StreamDecompressor::Create(
+      ni::DataCompressor::Type::GZIP, compressed, &decompressor);
+  ASSERT_TRUE((err == nullptr));
+  std::vector<char> res;
+  err = decompressor->ReadAll(&res);
+  ASSERT_TRUE((err == nullptr))
+      << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+  ASSERT_EQ(res.size(), data.size()) << "Mismatched byte size";
+  ASSERT_EQ(memcmp(data.data(), res.data(), data.size()), 0)
+      << "Mismatched data";
+  evbuffer_free(compressed);
+}
+
+#ifdef TRITON_ENABLE_ZSTD
+TEST_F(DataCompressorTest, StreamDecompressZstd)
+{
+  CheckStreamDecompress(
+      ni::DataCompressor::Type::ZSTD,
+      GeneratePayload(Payload::INT32, 3 << 20));
+  CheckStreamDecompressSize(
+      ni::DataCompressor::Type::ZSTD, GeneratePayload(Payload::INT32, 4096));
+}
+#endif  // TRITON_ENABLE_ZSTD
+
+#ifdef TRITON_ENABLE_LZ4
+TEST_F(DataCompressorTest, StreamDecompressLz4)
+{
+  CheckStreamDecompress(
+      ni::DataCompressor::Type::LZ4, GeneratePayload(Payload::INT32, 3 << 20));
+  CheckStreamDecompressSize(
+      ni::DataCompressor::Type::LZ4, GeneratePayload(Payload::INT32, 4096));
+}
+#endif  // TRITON_ENABLE_LZ4
+
+// Compression and decompression throughput, and compression ratio, of
+// each codec on tensor-like payloads. Only reports the numbers, the
+// round trip is checked by the tests above.
+TEST_F(DataCompressorTest, Benchmark)
+{
+  const size_t byte_size = 4 << 20;
+  const int iterations = 3;
+
+  struct Codec {
+    ni::DataCompressor::Type type_;
+    int level_;
+  };
+  std::vector<Codec> codecs{
+      {ni::DataCompressor::Type::GZIP, 1},
+      {ni::DataCompressor::Type::GZIP, ni::DataCompressor::kDefaultLevel}};
+#ifdef TRITON_ENABLE_ZSTD
+  codecs.push_back({ni::DataCompressor::Type::ZSTD, 1});
+  codecs.push_back(
+      {ni::DataCompressor::Type::ZSTD, ni::DataCompressor::kDefaultLevel});
+#endif  // TRITON_ENABLE_ZSTD
+#ifdef TRITON_ENABLE_LZ4
+  codecs.push_back(
+      {ni::DataCompressor::Type::LZ4, ni::DataCompressor::kDefaultLevel});
+  codecs.push_back({ni::DataCompressor::Type::LZ4, 9});
+#endif  // TRITON_ENABLE_LZ4
+
+  const std::vector<std::pair<std::string, Payload>> payloads{
+      {"fp32", Payload::FP32},
+      {"int32", Payload::INT32},
+      {"random", Payload::RANDOM}};
+  for (const auto& payload : payloads) {
+    const auto data = GeneratePayload(payload.second, byte_size);
+    for (const auto& codec : codecs) {
+      double compress_s = 0;
+      double decompress_s = 0;
+      size_t compressed_byte_size = 0;
+      for (int i = 0; i < iterations; ++i) {
+        auto source = evbuffer_new();
+        ASSERT_EQ(evbuffer_add(source, data.data(), data.size()), 0);
+        auto compressed = evbuffer_new();
+        auto decompressed = evbuffer_new();
+
+        auto start = std::chrono::steady_clock::now();
+        auto err = ni::DataCompressor::CompressData(
+            codec.type_, source, compressed, codec.level_);
+        auto end = std::chrono::steady_clock::now();
+        ASSERT_TRUE((err == nullptr))
+            << "Failed to compress data: " << TRITONSERVER_ErrorMessage(err);
+        compress_s += std::chrono::duration<double>(end - start).count();
+        compressed_byte_size = evbuffer_get_length(compressed);
+
+        start = std::chrono::steady_clock::now();
+        err = ni::DataCompressor::DecompressData(
+            codec.type_, compressed, decompressed);
+        end = std::chrono::steady_clock::now();
+        ASSERT_TRUE((err == nullptr))
+            << "Failed to decompress data: " << TRITONSERVER_ErrorMessage(err);
+        decompress_s += std::chrono::duration<double>(end - start).count();
+        ASSERT_EQ(evbuffer_get_length(decompressed), byte_size);
+
+        evbuffer_free(source);
+        evbuffer_free(compressed);
+        evbuffer_free(decompressed);
+      }
+
+      const double mb = (byte_size * iterations) / (1024.0 * 1024.0);
+      std::cout << payload.first << " "
+                << ni::DataCompressor::TypeString(codec.type_) << " level "
+                << ((codec.level_ == ni::DataCompressor::kDefaultLevel)
+                        ? std::string("default")
+                        : std::to_string(codec.level_))
+                << ": ratio "
+                << (double)byte_size / (double)compressed_byte_size
+                << ", compress " << (mb / compress_s) << " MB/s, decompress "
+                << (mb / decompress_s) << " MB/s" << std::endl;
+    }
+  }
+}
+
 }  // namespace
 
 int
@@ -0,0 +1,229 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+#include "src/core/infer_stats.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Report the statistics of 'request_cnt' requests with batch sizes
+// cycling from 1 to 4. Request 'i' is reported with durations derived
+// from 'i' so that the expected totals can be calculated.
+void
+ReportStatistics(
+    ni::InferenceStatsAggregator* aggregator, const size_t request_cnt)
+{
+  for (size_t i = 0; i < request_cnt; ++i) {
+    const size_t batch_size = 1 + (i % 4);
+    aggregator->UpdateSuccess(
+        nullptr /* metric_reporter */, batch_size, 0 /* request_start_ns */,
+        1 /* queue_start_ns */, 3 /* compute_start_ns */,
+        6 /* compute_input_end_ns */, 10 /* compute_output_start_ns */,
+        15 /* compute_end_ns */, 21 /* request_end_ns */);
+    aggregator->UpdateInferBatchStats(
+        nullptr /* metric_reporter */, batch_size, 0 /* compute_start_ns */,
+        i /* compute_input_end_ns */, 2 * i /* compute_output_start_ns */,
+        3 * i /* compute_end_ns */);
+    if ((i % 3) == 0) {
+      aggregator->UpdateFailure(
+          nullptr /* metric_reporter */, 0 /* request_start_ns */,
+          7 /* request_end_ns */);
+    }
+  }
+}
+
+void
+ExpectEqualStatistics(
+    const ni::InferenceStatsAggregator& expected,
+    const ni::InferenceStatsAggregator& actual)
+{
+  EXPECT_EQ(expected.InferenceCount(), actual.InferenceCount());
+  EXPECT_EQ(expected.ExecutionCount(), actual.ExecutionCount());
+
+  const auto expected_stats = expected.ImmutableInferStats();
+  const auto actual_stats = actual.ImmutableInferStats();
+  EXPECT_EQ(expected_stats.failure_count_, actual_stats.failure_count_);
+  EXPECT_EQ(
+      expected_stats.failure_duration_ns_, actual_stats.failure_duration_ns_);
+  EXPECT_EQ(expected_stats.success_count_, actual_stats.success_count_);
+  EXPECT_EQ(
+      expected_stats.request_duration_ns_, actual_stats.request_duration_ns_);
+  EXPECT_EQ(expected_stats.queue_duration_ns_, actual_stats.queue_duration_ns_);
+  EXPECT_EQ(
+      expected_stats.compute_input_duration_ns_,
+      actual_stats.compute_input_duration_ns_);
+  EXPECT_EQ(
+      expected_stats.compute_infer_duration_ns_,
+      actual_stats.compute_infer_duration_ns_);
+  EXPECT_EQ(
+      expected_stats.compute_output_duration_ns_,
+      actual_stats.compute_output_duration_ns_);
+
+  const auto expected_batch_stats = expected.ImmutableInferBatchStats();
+  const auto actual_batch_stats = actual.ImmutableInferBatchStats();
+  ASSERT_EQ(expected_batch_stats.size(), actual_batch_stats.size());
+  for (const auto& pr : expected_batch_stats) {
+    const auto itr = actual_batch_stats.find(pr.first);
+    ASSERT_NE(itr, actual_batch_stats.end())
+        << "missing batch size " << pr.first;
+    EXPECT_EQ(pr.second.count_, itr->second.count_);
+    EXPECT_EQ(
+        pr.second.compute_input_duration_ns_,
+        itr->second.compute_input_duration_ns_);
+    EXPECT_EQ(
+        pr.second.compute_infer_duration_ns_,
+        itr->second.compute_infer_duration_ns_);
+    EXPECT_EQ(
+        pr.second.compute_output_duration_ns_,
+        itr->second.compute_output_duration_ns_);
+  }
+}
+
+TEST(InferStatsTest, Empty)
+{
+  ni::InferenceStatsAggregator aggregator;
+  EXPECT_EQ(aggregator.LastInferenceMs(), (uint64_t)0);
+  EXPECT_EQ(aggregator.InferenceCount(), (uint64_t)0);
+  EXPECT_EQ(aggregator.ExecutionCount(), (uint64_t)0);
+  EXPECT_EQ(aggregator.ImmutableInferStats().success_count_, (uint64_t)0);
+  EXPECT_TRUE(aggregator.ImmutableInferBatchStats().empty());
+}
+
+TEST(InferStatsTest, SingleThread)
+{
+  ni::InferenceStatsAggregator aggregator;
+  ReportStatistics(&aggregator, 8);
+
+  EXPECT_GT(aggregator.LastInferenceMs(), (uint64_t)0);
+  EXPECT_EQ(aggregator.InferenceCount(), (uint64_t)20);
+  EXPECT_EQ(aggregator.ExecutionCount(), (uint64_t)8);
+
+  const auto stats = aggregator.ImmutableInferStats();
+  EXPECT_EQ(stats.success_count_, (uint64_t)8);
+  EXPECT_EQ(stats.request_duration_ns_, (uint64_t)(8 * 21));
+  EXPECT_EQ(stats.queue_duration_ns_, (uint64_t)(8 * 2));
+  EXPECT_EQ(stats.compute_input_duration_ns_, (uint64_t)(8 * 3));
+  EXPECT_EQ(stats.compute_infer_duration_ns_, (uint64_t)(8 * 4));
+  EXPECT_EQ(stats.compute_output_duration_ns_, (uint64_t)(8 * 5));
+  EXPECT_EQ(stats.failure_count_, (uint64_t)3);
+  EXPECT_EQ(stats.failure_duration_ns_, (uint64_t)(3 * 7));
+
+  // Requests 1 and 5 have batch size 2.
+  const auto batch_stats = aggregator.ImmutableInferBatchStats();
+  ASSERT_EQ(batch_stats.size(), (size_t)4);
+  const auto& bs2 = batch_stats.at(2);
+  EXPECT_EQ(bs2.count_, (uint64_t)2);
+  EXPECT_EQ(bs2.compute_input_duration_ns_, (uint64_t)(1 + 5));
+  EXPECT_EQ(bs2.compute_infer_duration_ns_, (uint64_t)(1 + 5));
+  EXPECT_EQ(bs2.compute_output_duration_ns_, (uint64_t)(1 + 5));
+}
+
+TEST(InferStatsTest, ResponseCache)
+{
+  ni::InferenceStatsAggregator aggregator;
+  aggregator.UpdateCacheHit(
+      nullptr /* metric_reporter */, 1 /* batch_size */,
+      10 /* request_start_ns */, 14 /* request_end_ns */);
+  aggregator.UpdateCacheHit(
+      nullptr /* metric_reporter */, 4 /* batch_size */,
+      20 /* request_start_ns */, 26 /* request_end_ns */);
+  aggregator.UpdateCacheMiss(
+      nullptr /* metric_reporter */, 3 /* cache_miss_duration_ns */);
+  aggregator.UpdateCacheEviction(nullptr /* metric_reporter */);
+
+  // Responses served from the cache are counted as successful
+  // inferences that spend no time in the queue or in compute.
+  EXPECT_EQ(aggregator.InferenceCount(), (uint64_t)(1 + 4));
+
+  const auto stats = aggregator.ImmutableInferStats();
+  EXPECT_EQ(stats.success_count_, (uint64_t)2);
+  EXPECT_EQ(stats.request_duration_ns_, (uint64_t)(4 + 6));
+  EXPECT_EQ(stats.queue_duration_ns_, (uint64_t)0);
+  EXPECT_EQ(stats.compute_infer_duration_ns_, (uint64_t)0);
+  EXPECT_EQ(stats.cache_hit_count_, (uint64_t)2);
+  EXPECT_EQ(stats.cache_hit_duration_ns_, (uint64_t)(4 + 6));
+  EXPECT_EQ(stats.cache_miss_count_, (uint64_t)1);
+  EXPECT_EQ(stats.cache_miss_duration_ns_, (uint64_t)3);
+  EXPECT_EQ(stats.cache_eviction_count_, (uint64_t)1);
+}
+
+TEST(InferStatsTest, Coalesced)
+{
+  ni::InferenceStatsAggregator aggregator;
+  aggregator.UpdateCoalesced(
+      nullptr /* metric_reporter */, 2 /* batch_size */,
+      10 /* request_start_ns */, 15 /* request_end_ns */);
+  aggregator.UpdateCoalesced(
+      nullptr /* metric_reporter */, 1 /* batch_size */,
+      12 /* request_start_ns */, 15 /* request_end_ns */);
+
+  EXPECT_EQ(aggregator.InferenceCount(), (uint64_t)(2 + 1));
+
+  const auto stats = aggregator.ImmutableInferStats();
+  EXPECT_EQ(stats.success_count_, (uint64_t)2);
+  EXPECT_EQ(stats.request_duration_ns_, (uint64_t)(5 + 3));
+  EXPECT_EQ(stats.coalesced_count_, (uint64_t)2);
+  EXPECT_EQ(stats.coalesced_duration_ns_, (uint64_t)(5 + 3));
+}
+
+TEST(InferStatsTest, MultiThreadMatchesSingleShard)
+{
+  // Statistics reported from many threads to a sharded aggregator
+  // must merge to the same values as the same statistics reported to
+  // an aggregator with a single shard.
+  const size_t thread_cnt = 24;
+  const size_t request_cnt = 1000;
+
+  ni::InferenceStatsAggregator single(1 /* shard_cnt */);
+  for (size_t t = 0; t < thread_cnt; ++t) {
+    ReportStatistics(&single, request_cnt);
+  }
+
+  ni::InferenceStatsAggregator sharded;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_cnt; ++t) {
+    threads.emplace_back(
+        [&sharded, request_cnt]() { ReportStatistics(&sharded, request_cnt); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ExpectEqualStatistics(single, sharded);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,255 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/core/filesystem.h"
+#include "src/core/localize_cache.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+class LocalizeCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(
+        ni::MakeTemporaryDirectory(ni::FileSystemType::LOCAL, &work_dir_)
+            .IsOk());
+    cache_dir_ = ni::JoinPath({work_dir_, "cache"});
+  }
+
+  void TearDown() override { ni::DeleteDirectory(work_dir_); }
+
+  // Write 'contents' to the file 'name' in the work directory and
+  // return its path.
+  std::string WriteFile(const std::string& name, const std::string& contents)
+  {
+    const std::string path = ni::JoinPath({work_dir_, name});
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    out << contents;
+    EXPECT_TRUE(out.good());
+    return path;
+  }
+
+  std::string ReadFile(const std::string& path)
+  {
+    std::string contents;
+    EXPECT_TRUE(ni::ReadTextFile(path, &contents).IsOk());
+    return contents;
+  }
+
+  bool Exists(const std::string& path)
+  {
+    bool exists = false;
+    EXPECT_TRUE(ni::FileExists(path, &exists).IsOk());
+    return exists;
+  }
+
+  std::string work_dir_;
+  std::string cache_dir_;
+};
+
+TEST_F(LocalizeCacheTest, Key)
+{
+  // Base64 characters that can't be used in a file name are mapped
+  // and quotes and padding are dropped.
+  EXPECT_EQ(
+      ni::LocalizeCache::Key("gcs", "ab+/cd==", 12), "gcs_ab-_cd_12");
+  EXPECT_EQ(
+      ni::LocalizeCache::Key("s3", "\"0123abcd\"", 34), "s3_0123abcd_34");
+
+  // An object without a usable hash can't be cached.
+  EXPECT_TRUE(ni::LocalizeCache::Key("gcs", "", 12).empty());
+  EXPECT_TRUE(ni::LocalizeCache::Key("s3", "\"\"", 12).empty());
+}
+
+TEST_F(LocalizeCacheTest, Hit)
+{
+  std::unique_ptr<ni::LocalizeCache> cache;
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 1024, &cache).IsOk());
+
+  const std::string dst_path = ni::JoinPath({work_dir_, "dst"});
+  bool hit = true;
+  ASSERT_TRUE(cache->Get("s3_abc_5", dst_path, &hit).IsOk());
+  EXPECT_FALSE(hit);
+  EXPECT_FALSE(Exists(dst_path));
+
+  const std::string src_path = WriteFile("src", "hello");
+  ASSERT_TRUE(cache->Put("s3_abc_5", src_path).IsOk());
+  EXPECT_EQ(cache->FileCount(), 1u);
+  EXPECT_EQ(cache->ByteSize(), 5u);
+
+  // Adding the same key again is a no-op.
+  ASSERT_TRUE(cache->Put("s3_abc_5", src_path).IsOk());
+  EXPECT_EQ(cache->FileCount(), 1u);
+
+  // The cached file outlives the file it was added from.
+  ASSERT_EQ(remove(src_path.c_str()), 0);
+  ASSERT_TRUE(cache->Get("s3_abc_5", dst_path, &hit).IsOk());
+  EXPECT_TRUE(hit);
+  EXPECT_EQ(ReadFile(dst_path), "hello");
+}
+
+TEST_F(LocalizeCacheTest, RemovedFile)
+{
+  std::unique_ptr<ni::LocalizeCache> cache;
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 1024, &cache).IsOk());
+  ASSERT_TRUE(cache->Put("s3_abc_5", WriteFile("src", "hello")).IsOk());
+
+  // A file removed from outside of the server is dropped from the
+  // cache and reported as a miss.
+  ASSERT_EQ(remove(ni::JoinPath({cache_dir_, "s3_abc_5"}).c_str()), 0);
+  const std::string dst_path = ni::JoinPath({work_dir_, "dst"});
+  bool hit = true;
+  ASSERT_TRUE(cache->Get("s3_abc_5", dst_path, &hit).IsOk());
+  EXPECT_FALSE(hit);
+  EXPECT_EQ(cache->FileCount(), 0u);
+  EXPECT_EQ(cache->ByteSize(), 0u);
+
+  // The file can be added again.
+  ASSERT_TRUE(cache->Put("s3_abc_5", WriteFile("src2", "hello")).IsOk());
+  ASSERT_TRUE(cache->Get("s3_abc_5", dst_path, &hit).IsOk());
+  EXPECT_TRUE(hit);
+  EXPECT_EQ(ReadFile(dst_path), "hello");
+}
+
+TEST_F(LocalizeCacheTest, Evict)
+{
+  std::unique_ptr<ni::LocalizeCache> cache;
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 10, &cache).IsOk());
+  ASSERT_TRUE(cache->Put("gcs_a_4", WriteFile("a", "aaaa")).IsOk());
+  ASSERT_TRUE(cache->Put("gcs_b_4", WriteFile("b", "bbbb")).IsOk());
+
+  // Using 'a' makes 'b' the least-recently-used file.
+  bool hit = false;
+  ASSERT_TRUE(
+      cache->Get("gcs_a_4", ni::JoinPath({work_dir_, "dst_a"}), &hit).IsOk());
+  EXPECT_TRUE(hit);
+
+  ASSERT_TRUE(cache->Put("gcs_c_4", WriteFile("c", "cccc")).IsOk());
+  EXPECT_EQ(cache->FileCount(), 2u);
+  EXPECT_EQ(cache->ByteSize(), 8u);
+  EXPECT_FALSE(Exists(ni::JoinPath({cache_dir_, "gcs_b_4"})));
+
+  const std::string dst_path = ni::JoinPath({work_dir_, "dst"});
+  ASSERT_TRUE(cache->Get("gcs_b_4", dst_path, &hit).IsOk());
+  EXPECT_FALSE(hit);
+  ASSERT_TRUE(cache->Get("gcs_c_4", dst_path, &hit).IsOk());
+  EXPECT_TRUE(hit);
+
+  // A file larger than the cache is not added.
+  ASSERT_TRUE(cache->Put("gcs_d_11", WriteFile("d", "ddddddddddd")).IsOk());
+  EXPECT_FALSE(Exists(ni::JoinPath({cache_dir_, "gcs_d_11"})));
+  EXPECT_EQ(cache->FileCount(), 2u);
+}
+
+TEST_F(LocalizeCacheTest, Restart)
+{
+  {
+    std::unique_ptr<ni::LocalizeCache> cache;
+    ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 1024, &cache).IsOk());
+    ASSERT_TRUE(cache->Put("s3_abc_5", WriteFile("src", "hello")).IsOk());
+  }
+
+  // A partially added file left by a previous run is removed and the
+  // completed files are found again.
+  const std::string tmp_path = WriteFile("cache/s3_def_3.tmp1_0", "abc");
+
+  std::unique_ptr<ni::LocalizeCache> cache;
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 1024, &cache).IsOk());
+  EXPECT_FALSE(Exists(tmp_path));
+  EXPECT_EQ(cache->FileCount(), 1u);
+  EXPECT_EQ(cache->ByteSize(), 5u);
+
+  const std::string dst_path = ni::JoinPath({work_dir_, "dst"});
+  bool hit = false;
+  ASSERT_TRUE(cache->Get("s3_abc_5", dst_path, &hit).IsOk());
+  EXPECT_TRUE(hit);
+  EXPECT_EQ(ReadFile(dst_path), "hello");
+
+  // A smaller cache evicts the files that no longer fit.
+  cache.reset();
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 4, &cache).IsOk());
+  EXPECT_EQ(cache->FileCount(), 0u);
+  EXPECT_FALSE(Exists(ni::JoinPath({cache_dir_, "s3_abc_5"})));
+}
+
+TEST_F(LocalizeCacheTest, Concurrent)
+{
+  std::unique_ptr<ni::LocalizeCache> cache;
+  ASSERT_TRUE(ni::LocalizeCache::Create(cache_dir_, 16, &cache).IsOk());
+
+  // Files are added, used and evicted by several threads at once.
+  // Every hit must produce the complete file.
+  const size_t thread_cnt = 4;
+  std::vector<std::string> src_paths;
+  for (size_t i = 0; i < thread_cnt; ++i) {
+    src_paths.push_back(
+        WriteFile("src" + std::to_string(i), std::string(6, 'a' + i)));
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_cnt; ++i) {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0; j < 100; ++j) {
+        const size_t k = (i + j) % thread_cnt;
+        const std::string key = "gcs_" + std::to_string(k) + "_6";
+        const std::string dst_path = ni::JoinPath(
+            {work_dir_, "dst" + std::to_string(i) + "_" + std::to_string(j)});
+        bool hit = false;
+        EXPECT_TRUE(cache->Get(key, dst_path, &hit).IsOk());
+        if (hit) {
+          EXPECT_EQ(ReadFile(dst_path), std::string(6, 'a' + k));
+        } else {
+          EXPECT_TRUE(cache->Put(key, src_paths[k]).IsOk());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_LE(cache->ByteSize(), 16u);
+  EXPECT_EQ(cache->ByteSize(), cache->FileCount() * 6);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,274 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "src/core/response_cache.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Return a response with a single output holding 'byte_size' bytes.
+std::shared_ptr<const ni::ResponseCache::Response>
+MakeResponse(const size_t byte_size, const char value = 'a')
+{
+  std::shared_ptr<ni::ResponseCache::Response> response =
+      std::make_shared<ni::ResponseCache::Response>();
+  response->outputs_.emplace_back();
+  auto& output = response->outputs_.back();
+  output.name_ = "OUTPUT0";
+  output.datatype_ = inference::DataType::TYPE_UINT8;
+  output.shape_ = {(int64_t)byte_size};
+  output.data_.assign(byte_size, value);
+  return response;
+}
+
+// The tests use the key string as the normalized request.
+uint64_t
+KeyHash(const std::string& key)
+{
+  return std::hash<std::string>()(key);
+}
+
+ni::Status
+Insert(
+    ni::ResponseCache& cache, const void* owner, const std::string& key,
+    std::shared_ptr<const ni::ResponseCache::Response>&& response,
+    const uint64_t hash)
+{
+  std::string request(key);
+  return cache.Insert(owner, hash, std::move(request), std::move(response));
+}
+
+ni::Status
+Insert(
+    ni::ResponseCache& cache, const void* owner, const std::string& key,
+    std::shared_ptr<const ni::ResponseCache::Response>&& response)
+{
+  return Insert(cache, owner, key, std::move(response), KeyHash(key));
+}
+
+std::shared_ptr<const ni::ResponseCache::Response>
+Find(
+    ni::ResponseCache& cache, const void* owner, const std::string& key,
+    const uint64_t hash)
+{
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  cache.Lookup(
+      owner, hash,
+      [&key](const std::string& request) { return request == key; }, &found);
+  return found;
+}
+
+std::shared_ptr<const ni::ResponseCache::Response>
+Find(ni::ResponseCache& cache, const void* owner, const std::string& key)
+{
+  return Find(cache, owner, key, KeyHash(key));
+}
+
+TEST(ResponseCacheTest, HitAndMiss)
+{
+  ni::ResponseCache cache(1 << 20);
+  int owner;
+  cache.AddOwner(&owner, nullptr);
+
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  found = Find(cache, &owner, "key0");
+  EXPECT_EQ(found, nullptr);
+
+  auto response = MakeResponse(64);
+  const auto* expected = response.get();
+  ASSERT_TRUE(Insert(cache, &owner, "key0", std::move(response)).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)1);
+  EXPECT_GT(cache.UsedByteSize(), (uint64_t)64);
+
+  found = Find(cache, &owner, "key0");
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found.get(), expected);
+  ASSERT_EQ(found->outputs_.size(), (size_t)1);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(64, 'a'));
+
+  found = Find(cache, &owner, "key1");
+  EXPECT_EQ(found, nullptr);
+}
+
+TEST(ResponseCacheTest, OwnersAreIsolated)
+{
+  ni::ResponseCache cache(1 << 20);
+  int owner0, owner1;
+  cache.AddOwner(&owner0, nullptr);
+  cache.AddOwner(&owner1, nullptr);
+
+  ASSERT_TRUE(Insert(cache, &owner0, "key", MakeResponse(8, 'a')).IsOk());
+  ASSERT_TRUE(Insert(cache, &owner1, "key", MakeResponse(8, 'b')).IsOk());
+
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  found = Find(cache, &owner0, "key");
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(8, 'a'));
+  found = Find(cache, &owner1, "key");
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(8, 'b'));
+
+  // Removing an owner removes only its entries.
+  cache.RemoveOwner(&owner0);
+  EXPECT_EQ(cache.EntryCount(), (size_t)1);
+  found = Find(cache, &owner1, "key");
+  EXPECT_NE(found, nullptr);
+
+  // Inserting for a removed owner fails.
+  EXPECT_FALSE(Insert(cache, &owner0, "key", MakeResponse(8)).IsOk());
+
+  cache.RemoveOwner(&owner1);
+  EXPECT_EQ(cache.EntryCount(), (size_t)0);
+  EXPECT_EQ(cache.UsedByteSize(), (uint64_t)0);
+}
+
+TEST(ResponseCacheTest, DuplicateInsertKeepsEntry)
+{
+  ni::ResponseCache cache(1 << 20);
+  int owner;
+  cache.AddOwner(&owner, nullptr);
+
+  auto response = MakeResponse(8, 'a');
+  const auto* expected = response.get();
+  ASSERT_TRUE(Insert(cache, &owner, "key", std::move(response)).IsOk());
+  const uint64_t used_byte_size = cache.UsedByteSize();
+  ASSERT_TRUE(Insert(cache, &owner, "key", MakeResponse(8, 'b')).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)1);
+  EXPECT_EQ(cache.UsedByteSize(), used_byte_size);
+
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  found = Find(cache, &owner, "key");
+  EXPECT_EQ(found.get(), expected);
+}
+
+TEST(ResponseCacheTest, HashCollision)
+{
+  ni::ResponseCache cache(1 << 20);
+  int owner;
+  cache.AddOwner(&owner, nullptr);
+
+  // Different requests with the same hash are separate entries.
+  ASSERT_TRUE(Insert(cache, &owner, "key0", MakeResponse(8, 'a'), 7).IsOk());
+  EXPECT_EQ(Find(cache, &owner, "key1", 7), nullptr);
+  ASSERT_TRUE(Insert(cache, &owner, "key1", MakeResponse(8, 'b'), 7).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)2);
+
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  found = Find(cache, &owner, "key0", 7);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(8, 'a'));
+  found = Find(cache, &owner, "key1", 7);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(8, 'b'));
+  EXPECT_EQ(Find(cache, &owner, "key0", 8), nullptr);
+
+  // Inserting one of the requests again keeps its entry.
+  ASSERT_TRUE(Insert(cache, &owner, "key1", MakeResponse(8, 'c'), 7).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)2);
+  found = Find(cache, &owner, "key1", 7);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(8, 'b'));
+}
+
+TEST(ResponseCacheTest, LeastRecentlyUsedEviction)
+{
+  // Find the byte size charged for an entry so that the cache can be
+  // sized to hold exactly three entries.
+  uint64_t entry_byte_size;
+  {
+    ni::ResponseCache cache(1 << 20);
+    int owner;
+    cache.AddOwner(&owner, nullptr);
+    ASSERT_TRUE(Insert(cache, &owner, "key0", MakeResponse(100)).IsOk());
+    entry_byte_size = cache.UsedByteSize();
+  }
+
+  ni::ResponseCache cache(3 * entry_byte_size);
+  int owner;
+  size_t eviction_cnt = 0;
+  cache.AddOwner(&owner, [&eviction_cnt]() { eviction_cnt++; });
+
+  ASSERT_TRUE(Insert(cache, &owner, "key0", MakeResponse(100)).IsOk());
+  ASSERT_TRUE(Insert(cache, &owner, "key1", MakeResponse(100)).IsOk());
+  ASSERT_TRUE(Insert(cache, &owner, "key2", MakeResponse(100)).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)3);
+  EXPECT_EQ(eviction_cnt, (size_t)0);
+
+  // Using 'key0' makes 'key1' the least recently used entry.
+  std::shared_ptr<const ni::ResponseCache::Response> found;
+  found = Find(cache, &owner, "key0");
+  ASSERT_NE(found, nullptr);
+
+  ASSERT_TRUE(Insert(cache, &owner, "key3", MakeResponse(100)).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)3);
+  EXPECT_EQ(eviction_cnt, (size_t)1);
+  EXPECT_LE(cache.UsedByteSize(), cache.ByteSize());
+
+  found = Find(cache, &owner, "key1");
+  EXPECT_EQ(found, nullptr);
+  for (const auto& key : {"key0", "key2", "key3"}) {
+    found = Find(cache, &owner, key);
+    EXPECT_NE(found, nullptr) << "missing " << key;
+  }
+
+  // An evicted response remains valid while it is referenced.
+  found = Find(cache, &owner, "key2");
+  ASSERT_TRUE(Insert(cache, &owner, "key4", MakeResponse(100)).IsOk());
+  ASSERT_TRUE(Insert(cache, &owner, "key5", MakeResponse(100)).IsOk());
+  ASSERT_TRUE(Insert(cache, &owner, "key6", MakeResponse(100)).IsOk());
+  EXPECT_EQ(eviction_cnt, (size_t)4);
+  EXPECT_EQ(found->outputs_[0].data_, std::string(100, 'a'));
+}
+
+TEST(ResponseCacheTest, OversizedResponse)
+{
+  ni::ResponseCache cache(1024);
+  int owner;
+  size_t eviction_cnt = 0;
+  cache.AddOwner(&owner, [&eviction_cnt]() { eviction_cnt++; });
+
+  ASSERT_TRUE(Insert(cache, &owner, "small", MakeResponse(16)).IsOk());
+
+  // A response larger than the cache is rejected without evicting
+  // the existing entries.
+  EXPECT_FALSE(Insert(cache, &owner, "large", MakeResponse(2048)).IsOk());
+  EXPECT_EQ(cache.EntryCount(), (size_t)1);
+  EXPECT_EQ(eviction_cnt, (size_t)0);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,199 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "src/core/shared_executor.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Counts down completed tasks and wakes the test when all are done.
+class Latch {
+ public:
+  explicit Latch(const size_t count) : count_(count) {}
+
+  void CountDown()
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (--count_ == 0) {
+      cv_.notify_all();
+    }
+  }
+
+  bool Wait(const std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    return cv_.wait_for(lk, timeout, [this] { return count_ == 0; });
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t count_;
+};
+
+TEST(SharedExecutorTest, RunsAllTasks)
+{
+  ni::SharedExecutor executor(4);
+  EXPECT_EQ(executor.ThreadCount(), (size_t)4);
+
+  constexpr size_t kTaskCnt = 10000;
+  std::atomic<size_t> run_cnt(0);
+  Latch latch(kTaskCnt);
+  for (size_t i = 0; i < kTaskCnt; ++i) {
+    // Alternate between tasks for any node and tasks for node 0,
+    // which must also run on a host without NUMA.
+    executor.Submit(((i % 2) == 0) ? -1 : 0, [&run_cnt, &latch] {
+      run_cnt++;
+      latch.CountDown();
+    });
+  }
+
+  ASSERT_TRUE(latch.Wait(std::chrono::seconds(30)));
+  EXPECT_EQ(run_cnt, kTaskCnt);
+}
+
+TEST(SharedExecutorTest, TasksSubmittedFromTasks)
+{
+  ni::SharedExecutor executor(2);
+
+  // Each task submits the next one, as a scheduler does when a batch
+  // completes.
+  constexpr size_t kChainLength = 1000;
+  Latch latch(1);
+  std::function<void(size_t)> chain;
+  chain = [&executor, &latch, &chain](size_t remaining) {
+    if (remaining == 0) {
+      latch.CountDown();
+    } else {
+      executor.Submit(-1, [&chain, remaining] { chain(remaining - 1); });
+    }
+  };
+  executor.Submit(-1, [&chain] { chain(kChainLength); });
+
+  ASSERT_TRUE(latch.Wait(std::chrono::seconds(30)));
+}
+
+TEST(SharedExecutorTest, BlockedWorkerDoesNotBlockOthers)
+{
+  ni::SharedExecutor executor(4);
+
+  // Block one worker, the tasks submitted after it must be executed
+  // by the other workers.
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> blocked;
+  executor.Submit(-1, [&blocked, released] {
+    blocked.set_value();
+    released.wait();
+  });
+  blocked.get_future().wait();
+
+  constexpr size_t kTaskCnt = 100;
+  std::mutex mu;
+  std::set<std::thread::id> thread_ids;
+  Latch latch(kTaskCnt);
+  for (size_t i = 0; i < kTaskCnt; ++i) {
+    executor.Submit(-1, [&mu, &thread_ids, &latch] {
+      {
+        std::lock_guard<std::mutex> lk(mu);
+        thread_ids.insert(std::this_thread::get_id());
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      latch.CountDown();
+    });
+  }
+
+  EXPECT_TRUE(latch.Wait(std::chrono::seconds(30)));
+  release.set_value();
+  EXPECT_GT(thread_ids.size(), (size_t)1);
+}
+
+TEST(SharedExecutorTest, SubmitAfter)
+{
+  ni::SharedExecutor executor(2);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::chrono::steady_clock::time_point> run_times(3);
+  std::vector<size_t> order;
+  std::mutex mu;
+  Latch latch(3);
+  const std::vector<uint64_t> delays_us{30000, 10000, 20000};
+  for (size_t i = 0; i < delays_us.size(); ++i) {
+    executor.SubmitAfter(
+        delays_us[i], -1, [i, &run_times, &order, &mu, &latch] {
+          {
+            std::lock_guard<std::mutex> lk(mu);
+            run_times[i] = std::chrono::steady_clock::now();
+            order.push_back(i);
+          }
+          latch.CountDown();
+        });
+  }
+
+  ASSERT_TRUE(latch.Wait(std::chrono::seconds(30)));
+  for (size_t i = 0; i < delays_us.size(); ++i) {
+    EXPECT_GE(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            run_times[i] - start)
+            .count(),
+        (int64_t)delays_us[i]);
+  }
+  EXPECT_EQ(order, (std::vector<size_t>{1, 2, 0}));
+}
+
+TEST(SharedExecutorTest, DestroyWithDelayedTasks)
+{
+  // Delayed tasks that have not expired are dropped when the executor
+  // is destroyed.
+  std::atomic<bool> ran(false);
+  {
+    ni::SharedExecutor executor(1);
+    executor.SubmitAfter(60 * 1000 * 1000, -1, [&ran] { ran = true; });
+  }
+  EXPECT_FALSE(ran);
+}
+
+TEST(SharedExecutorTest, GlobalExecutor)
+{
+  EXPECT_EQ(ni::SharedExecutor::Global(), nullptr);
+  ni::SharedExecutor::SetGlobalThreadCount(3);
+  ASSERT_NE(ni::SharedExecutor::Global(), nullptr);
+  EXPECT_EQ(ni::SharedExecutor::Global()->ThreadCount(), (size_t)3);
+  ni::SharedExecutor::SetGlobalThreadCount(0);
+  EXPECT_EQ(ni::SharedExecutor::Global(), nullptr);
+}
+
+}  // namespace
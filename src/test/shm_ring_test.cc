@@ -0,0 +1,185 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "src/servers/shm_ring.h"
+
+namespace sr = nvidia::inferenceserver::shmring;
+
+namespace {
+
+// Fill 'request' with a valid inference request for 'input_count'
+// inputs and outputs of 'dims_count' dimensions.
+void
+FillRequest(
+    sr::Request* request, const uint32_t input_count,
+    const uint32_t dims_count)
+{
+  std::memset(request, 0, sizeof(sr::Request));
+  request->kind_ = sr::RequestKind::INFER;
+  sr::CopyName(request->model_name_, "simple");
+  request->input_count_ = input_count;
+  request->output_count_ = input_count;
+  for (uint32_t i = 0; i < input_count; ++i) {
+    for (sr::Tensor* tensor : {&request->inputs_[i], &request->outputs_[i]}) {
+      sr::CopyName(tensor->name_, "T" + std::to_string(i));
+      sr::CopyName(tensor->datatype_, "INT32");
+      sr::CopyName(tensor->region_, "region");
+      tensor->dims_count_ = dims_count;
+      for (uint32_t d = 0; d < dims_count; ++d) {
+        tensor->shape_[d] = 1;
+      }
+    }
+  }
+}
+
+TEST(ShmRingTest, ValidRequest)
+{
+  sr::Request request;
+  FillRequest(&request, sr::kMaxTensors, sr::kMaxDims);
+  std::string error;
+  EXPECT_TRUE(sr::ValidateInferRequest(request, &error)) << error;
+}
+
+TEST(ShmRingTest, TooManyTensors)
+{
+  sr::Request request;
+  FillRequest(&request, 1, 1);
+  request.input_count_ = sr::kMaxTensors + 1;
+  std::string error;
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+
+  FillRequest(&request, 1, 1);
+  request.output_count_ = sr::kMaxTensors + 1;
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+}
+
+TEST(ShmRingTest, TooManyDims)
+{
+  sr::Request request;
+  FillRequest(&request, 2, 1);
+  request.inputs_[1].dims_count_ = sr::kMaxDims + 1;
+  std::string error;
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+
+  FillRequest(&request, 2, 1);
+  request.outputs_[1].dims_count_ = sr::kMaxDims + 1;
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+}
+
+TEST(ShmRingTest, UnterminatedNames)
+{
+  sr::Request request;
+  FillRequest(&request, 1, 1);
+  std::memset(request.model_name_, 'm', sizeof(request.model_name_));
+  std::string error;
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+
+  FillRequest(&request, 1, 1);
+  std::memset(request.inputs_[0].name_, 'n', sizeof(request.inputs_[0].name_));
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+
+  FillRequest(&request, 1, 1);
+  std::memset(
+      request.outputs_[0].region_, 'r', sizeof(request.outputs_[0].region_));
+  EXPECT_FALSE(sr::ValidateInferRequest(request, &error));
+}
+
+// The fields of the slot are only validated for a tensor that is
+// within the counts, so a tensor past the count is never checked.
+TEST(ShmRingTest, UnusedTensorsIgnored)
+{
+  sr::Request request;
+  FillRequest(&request, 1, 1);
+  request.inputs_[1].dims_count_ = 1000;
+  std::string error;
+  EXPECT_TRUE(sr::ValidateInferRequest(request, &error)) << error;
+}
+
+// A client that keeps changing the counts of a submitted request
+// while the server handles it. Every copy that passes validation
+// must stay within the bounds of the request, however the counts in
+// the slot change after the copy was made.
+TEST(ShmRingTest, CountsChangedWhileHandled)
+{
+  sr::Slot slot{};
+  FillRequest(&slot.request_, 2, 2);
+
+  std::atomic<bool> stop(false);
+  std::thread client([&slot, &stop]() {
+    volatile uint32_t* input_count = &slot.request_.input_count_;
+    volatile uint32_t* output_count = &slot.request_.output_count_;
+    volatile uint32_t* dims_count = &slot.request_.inputs_[1].dims_count_;
+    uint32_t i = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      const bool valid = ((++i & 1) == 0);
+      *input_count = valid ? 2 : 0x7fffffff;
+      *output_count = valid ? 2 : 1000;
+      *dims_count = valid ? 2 : 0xffffffff;
+    }
+  });
+
+  size_t valid_count = 0;
+  for (size_t iter = 0; iter < 200000; ++iter) {
+    sr::Request request;
+    sr::ReadRequest(&slot, &request);
+    std::string error;
+    if (!sr::ValidateInferRequest(request, &error)) {
+      continue;
+    }
+
+    ++valid_count;
+    ASSERT_LE(request.input_count_, sr::kMaxTensors);
+    ASSERT_LE(request.output_count_, sr::kMaxTensors);
+
+    // Use the request the way the server does. Any access past the
+    // end of the copy is reported when run with a sanitizer.
+    int64_t element_count = 0;
+    for (uint32_t i = 0; i < request.input_count_; ++i) {
+      const sr::Tensor& input = request.inputs_[i];
+      ASSERT_LE(input.dims_count_, sr::kMaxDims);
+      for (uint32_t d = 0; d < input.dims_count_; ++d) {
+        element_count += input.shape_[d];
+      }
+    }
+    for (uint32_t i = 0; i < request.output_count_; ++i) {
+      ASSERT_LE(request.outputs_[i].dims_count_, sr::kMaxDims);
+    }
+    EXPECT_GE(element_count, 0);
+  }
+
+  stop = true;
+  client.join();
+
+  // The test is only meaningful if some of the copies were valid.
+  EXPECT_GT(valid_count, 0u);
+}
+
+}  // namespace
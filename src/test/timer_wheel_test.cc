@@ -0,0 +1,212 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "src/core/timer_wheel.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records when the callbacks of a test are called.
+class Recorder {
+ public:
+  explicit Recorder(const size_t count) : times_(count), remaining_(count) {}
+
+  ni::TimerWheel::Callback Callback(const size_t idx)
+  {
+    return [this, idx]() {
+      std::lock_guard<std::mutex> lk(mu_);
+      times_[idx] = Clock::now();
+      order_.push_back(idx);
+      if (--remaining_ == 0) {
+        cv_.notify_all();
+      }
+    };
+  }
+
+  bool Wait(const std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    return cv_.wait_for(lk, timeout, [this] { return remaining_ == 0; });
+  }
+
+  std::vector<Clock::time_point> times_;
+  std::vector<size_t> order_;
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t remaining_;
+};
+
+int64_t
+ElapsedUs(const Clock::time_point& start, const Clock::time_point& end)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+      .count();
+}
+
+TEST(TimerWheelTest, CallbacksAfterDelay)
+{
+  ni::TimerWheel wheel;
+  int owner;
+
+  // Delays that expire in each level of the wheel, with 10 us ticks.
+  const std::vector<uint64_t> delays_us{0,    30,    900,    2000,
+                                        5000, 40000, 300000, 700000};
+  Recorder recorder(delays_us.size());
+  const auto start = Clock::now();
+  for (size_t i = delays_us.size(); i > 0; --i) {
+    wheel.Schedule(&owner, delays_us[i - 1], recorder.Callback(i - 1));
+  }
+
+  ASSERT_TRUE(recorder.Wait(std::chrono::seconds(30)));
+  for (size_t i = 0; i < delays_us.size(); ++i) {
+    EXPECT_GE(ElapsedUs(start, recorder.times_[i]), (int64_t)delays_us[i])
+        << "timer " << i;
+  }
+  EXPECT_EQ(recorder.order_, (std::vector<size_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+  EXPECT_EQ(wheel.TimerCount(), (size_t)0);
+}
+
+TEST(TimerWheelTest, ManyTimers)
+{
+  ni::TimerWheel wheel;
+  int owner;
+
+  constexpr size_t kTimerCnt = 10000;
+  Recorder recorder(kTimerCnt);
+  const auto start = Clock::now();
+  std::vector<uint64_t> delays_us(kTimerCnt);
+  for (size_t i = 0; i < kTimerCnt; ++i) {
+    delays_us[i] = (i * 7919) % 50000;
+    wheel.Schedule(&owner, delays_us[i], recorder.Callback(i));
+  }
+
+  ASSERT_TRUE(recorder.Wait(std::chrono::seconds(30)));
+  for (size_t i = 0; i < kTimerCnt; ++i) {
+    ASSERT_GE(ElapsedUs(start, recorder.times_[i]), (int64_t)delays_us[i])
+        << "timer " << i;
+  }
+}
+
+TEST(TimerWheelTest, CancelOwner)
+{
+  ni::TimerWheel wheel;
+  int owner0, owner1;
+
+  std::atomic<size_t> cnt0(0), cnt1(0);
+  for (size_t i = 0; i < 100; ++i) {
+    wheel.Schedule(&owner0, 20000 + i, [&cnt0]() { cnt0++; });
+    wheel.Schedule(&owner1, 20000 + i, [&cnt1]() { cnt1++; });
+  }
+  EXPECT_EQ(wheel.TimerCount(), (size_t)200);
+
+  wheel.Cancel(&owner0);
+  EXPECT_EQ(wheel.TimerCount(), (size_t)100);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(cnt0, (size_t)0);
+  EXPECT_EQ(cnt1, (size_t)100);
+}
+
+TEST(TimerWheelTest, CancelWaitsForCallback)
+{
+  ni::TimerWheel wheel;
+  int owner;
+
+  std::atomic<bool> started(false), finished(false);
+  wheel.Schedule(&owner, 0, [&started, &finished]() {
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    finished = true;
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  wheel.Cancel(&owner);
+  EXPECT_TRUE(finished);
+}
+
+TEST(TimerWheelTest, ScheduleFromCallback)
+{
+  ni::TimerWheel wheel;
+  int owner;
+
+  // A callback that schedules itself again, as the sequence reaper
+  // does, and that may cancel its own timers.
+  constexpr size_t kRepeatCnt = 20;
+  Recorder recorder(1);
+  std::atomic<size_t> cnt(0);
+  std::function<void()> repeat;
+  repeat = [&]() {
+    if (++cnt == kRepeatCnt) {
+      wheel.Cancel(&owner);
+      recorder.Callback(0)();
+    } else {
+      wheel.Schedule(&owner, 100, std::function<void()>(repeat));
+    }
+  };
+  wheel.Schedule(&owner, 100, std::function<void()>(repeat));
+
+  ASSERT_TRUE(recorder.Wait(std::chrono::seconds(30)));
+  EXPECT_EQ(cnt, kRepeatCnt);
+}
+
+TEST(TimerWheelTest, EarlierTimerWakesThread)
+{
+  ni::TimerWheel wheel;
+  int owner;
+
+  // The timer thread sleeps until the first timer, scheduling an
+  // earlier timer must wake it.
+  std::atomic<bool> late_called(false);
+  Recorder recorder(1);
+  wheel.Schedule(&owner, 10 * 1000 * 1000, [&late_called]() {
+    late_called = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const auto start = Clock::now();
+  wheel.Schedule(&owner, 1000, recorder.Callback(0));
+
+  ASSERT_TRUE(recorder.Wait(std::chrono::seconds(1)));
+  EXPECT_GE(ElapsedUs(start, recorder.times_[0]), 1000);
+  EXPECT_FALSE(late_called);
+  wheel.Cancel(&owner);
+  EXPECT_EQ(wheel.TimerCount(), (size_t)0);
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/servers/trace_ring.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Write all the records in 'ring' and return them.
+std::vector<uint64_t>
+DrainRing(ni::TraceRing<uint64_t>* ring)
+{
+  std::stringstream ss;
+  const size_t cnt = ring->Drain(&ss);
+  const std::string bytes = ss.str();
+  EXPECT_EQ(bytes.size(), cnt * sizeof(uint64_t));
+
+  std::vector<uint64_t> records(cnt);
+  memcpy(records.data(), bytes.data(), bytes.size());
+  return records;
+}
+
+TEST(TraceRingTest, Overflow)
+{
+  ni::TraceRing<uint64_t> ring(4);
+  for (uint64_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.Push(i));
+  }
+
+  // A full ring drops the record and keeps the records it holds.
+  EXPECT_FALSE(ring.Push(4));
+  EXPECT_EQ(DrainRing(&ring), (std::vector<uint64_t>{0, 1, 2, 3}));
+
+  // Draining makes room for new records.
+  EXPECT_TRUE(ring.Push(5));
+  EXPECT_EQ(DrainRing(&ring), (std::vector<uint64_t>{5}));
+  EXPECT_TRUE(DrainRing(&ring).empty());
+}
+
+TEST(TraceRingTest, Wraparound)
+{
+  ni::TraceRing<uint64_t> ring(4);
+  for (uint64_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(ring.Push(i));
+  }
+  EXPECT_EQ(DrainRing(&ring), (std::vector<uint64_t>{0, 1, 2}));
+
+  // The next records wrap around the end of the buffer and are
+  // drained in the order they were pushed.
+  for (uint64_t i = 3; i < 7; ++i) {
+    EXPECT_TRUE(ring.Push(i));
+  }
+  EXPECT_FALSE(ring.Push(7));
+  EXPECT_EQ(DrainRing(&ring), (std::vector<uint64_t>{3, 4, 5, 6}));
+
+  // Wrap around many times.
+  for (uint64_t i = 0; i < 100; ++i) {
+    EXPECT_TRUE(ring.Push(i));
+    EXPECT_TRUE(ring.Push(i + 1));
+    EXPECT_TRUE(ring.Push(i + 2));
+    EXPECT_EQ(DrainRing(&ring), (std::vector<uint64_t>{i, i + 1, i + 2}));
+  }
+}
+
+TEST(TraceRingTest, ProducerConsumer)
+{
+  // The consumer receives every record in order while the producer
+  // wraps around the ring many times.
+  const uint64_t record_cnt = 100000;
+  ni::TraceRing<uint64_t> ring(64);
+
+  std::thread producer([&ring, record_cnt]() {
+    for (uint64_t i = 0; i < record_cnt; ++i) {
+      while (!ring.Push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t next = 0;
+  bool in_order = true;
+  while (next < record_cnt) {
+    for (const uint64_t record : DrainRing(&ring)) {
+      in_order &= (record == next++);
+    }
+  }
+  producer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(next, record_cnt);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}